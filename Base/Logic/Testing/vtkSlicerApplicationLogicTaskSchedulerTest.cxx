@@ -0,0 +1,396 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Slicer includes
+#include "vtkSlicerApplicationLogic.h"
+#include "vtkSlicerTask.h"
+
+// MRML includes
+#include "vtkMRMLAbstractLogic.h"
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+class vtkTaskSchedulerTestLogic : public vtkMRMLAbstractLogic
+{
+public:
+  static vtkTaskSchedulerTestLogic* New();
+  vtkTypeMacro(vtkTaskSchedulerTestLogic, vtkMRMLAbstractLogic);
+
+  /// Record the task identifier passed as client data
+  void RecordTask(void* clientData)
+  {
+    std::lock_guard<std::mutex> lock(this->Lock);
+    this->ExecutionOrder.push_back(static_cast<int>(reinterpret_cast<intptr_t>(clientData)));
+  }
+
+  /// Block until released, keeping track of the number of tasks running
+  /// at the same time.
+  void BlockingTask(void* vtkNotUsed(clientData))
+  {
+    int running = ++this->NumberOfRunningTasks;
+    int maximum = this->MaximumNumberOfRunningTasks.load();
+    while (running > maximum
+           && !this->MaximumNumberOfRunningTasks.compare_exchange_weak(maximum, running))
+      {
+      }
+    for (int i = 0; i < 500 && !this->Released; ++i)
+      {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    --this->NumberOfRunningTasks;
+  }
+
+  /// Report half of the progress, then block until released
+  void ProgressTask(void* clientData)
+  {
+    vtkSlicerTask::GetCurrentTask()->SetProgress(0.5);
+    this->BlockingTask(clientData);
+  }
+
+  /// Request a Modified call on this logic from the processing thread
+  void RequestModifiedTask(void* vtkNotUsed(clientData))
+  {
+    this->AppLogic->RequestModified(this);
+  }
+
+  vtkSlicerApplicationLogic* AppLogic{nullptr};
+  std::mutex Lock;
+  std::vector<int> ExecutionOrder;
+  std::atomic<bool> Released{false};
+  std::atomic<int> NumberOfRunningTasks{0};
+  std::atomic<int> MaximumNumberOfRunningTasks{0};
+
+protected:
+  vtkTaskSchedulerTestLogic() = default;
+  ~vtkTaskSchedulerTestLogic() override = default;
+};
+vtkStandardNewMacro(vtkTaskSchedulerTestLogic);
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkSlicerTask> newTask(vtkTaskSchedulerTestLogic* logic,
+                                       vtkSlicerTask::TaskFunctionPointer function,
+                                       int id, int priority = 0)
+{
+  vtkSmartPointer<vtkSlicerTask> task = vtkSmartPointer<vtkSlicerTask>::New();
+  task->SetTypeToProcessing();
+  task->SetPriority(priority);
+  task->SetTaskFunction(logic, function, reinterpret_cast<void*>(static_cast<intptr_t>(id)));
+  return task;
+}
+
+//----------------------------------------------------------------------------
+bool waitForTasks(const std::vector<vtkSlicerTask*>& tasks)
+{
+  for (int i = 0; i < 500; ++i)
+    {
+    bool finished = true;
+    for (vtkSlicerTask* task : tasks)
+      {
+      finished = finished && task->IsFinished();
+      }
+    if (finished)
+      {
+      return true;
+      }
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+int testConcurrentTasks()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetNumberOfProcessingThreads(2);
+  CHECK_INT(appLogic->GetNumberOfProcessingThreads(), 2);
+  appLogic->CreateProcessingThread();
+
+  vtkNew<vtkTaskSchedulerTestLogic> logic;
+  vtkSlicerTask::TaskFunctionPointer blockingTask =
+    (vtkSlicerTask::TaskFunctionPointer)&vtkTaskSchedulerTestLogic::BlockingTask;
+  vtkSmartPointer<vtkSlicerTask> task1 = newTask(logic, blockingTask, 1);
+  vtkSmartPointer<vtkSlicerTask> task2 = newTask(logic, blockingTask, 2);
+  CHECK_BOOL(appLogic->ScheduleTask(task1) != 0, true);
+  CHECK_BOOL(appLogic->ScheduleTask(task2) != 0, true);
+
+  // Both tasks must be running at the same time
+  for (int i = 0; i < 500 && logic->MaximumNumberOfRunningTasks < 2; ++i)
+    {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  CHECK_INT(logic->MaximumNumberOfRunningTasks.load(), 2);
+  CHECK_INT(task1->GetStatus(), vtkSlicerTask::Running);
+  logic->Released = true;
+  CHECK_BOOL(waitForTasks({task1, task2}), true);
+  CHECK_INT(task1->GetStatus(), vtkSlicerTask::Completed);
+  CHECK_INT(task2->GetStatus(), vtkSlicerTask::Completed);
+
+  appLogic->TerminateProcessingThread();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int testPrioritiesDependenciesAndCancellation()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetNumberOfProcessingThreads(1);
+  appLogic->CreateProcessingThread();
+
+  vtkNew<vtkTaskSchedulerTestLogic> logic;
+  vtkSlicerTask::TaskFunctionPointer blockingTask =
+    (vtkSlicerTask::TaskFunctionPointer)&vtkTaskSchedulerTestLogic::BlockingTask;
+  vtkSlicerTask::TaskFunctionPointer recordTask =
+    (vtkSlicerTask::TaskFunctionPointer)&vtkTaskSchedulerTestLogic::RecordTask;
+
+  // Keep the only processing thread busy while the other tasks are scheduled
+  vtkSmartPointer<vtkSlicerTask> busyTask = newTask(logic, blockingTask, 0);
+  appLogic->ScheduleTask(busyTask);
+  for (int i = 0; i < 500 && busyTask->GetStatus() != vtkSlicerTask::Running; ++i)
+    {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  CHECK_INT(busyTask->GetStatus(), vtkSlicerTask::Running);
+
+  vtkSmartPointer<vtkSlicerTask> lowPriorityTask = newTask(logic, recordTask, 1, 0);
+  vtkSmartPointer<vtkSlicerTask> highPriorityTask = newTask(logic, recordTask, 2, 10);
+  // Highest priority but can't run before the low priority task
+  vtkSmartPointer<vtkSlicerTask> dependentTask = newTask(logic, recordTask, 3, 20);
+  dependentTask->AddDependency(lowPriorityTask);
+  CHECK_INT(dependentTask->GetNumberOfDependencies(), 1);
+  CHECK_POINTER(dependentTask->GetNthDependency(0), lowPriorityTask.GetPointer());
+  vtkSmartPointer<vtkSlicerTask> cancelledTask = newTask(logic, recordTask, 4, 30);
+  vtkSmartPointer<vtkSlicerTask> taskDependingOnCancelledTask = newTask(logic, recordTask, 5, 30);
+  taskDependingOnCancelledTask->AddDependency(cancelledTask);
+
+  appLogic->ScheduleTask(lowPriorityTask);
+  appLogic->ScheduleTask(dependentTask);
+  appLogic->ScheduleTask(highPriorityTask);
+  appLogic->ScheduleTask(cancelledTask);
+  appLogic->ScheduleTask(taskDependingOnCancelledTask);
+  CHECK_INT(appLogic->GetNumberOfScheduledTasks(), 5);
+  CHECK_INT(lowPriorityTask->GetStatus(), vtkSlicerTask::Scheduled);
+
+  CHECK_BOOL(appLogic->CancelTask(cancelledTask), true);
+  CHECK_INT(cancelledTask->GetStatus(), vtkSlicerTask::Cancelled);
+  // A running task is not interrupted
+  CHECK_BOOL(appLogic->CancelTask(busyTask), false);
+
+  logic->Released = true;
+  CHECK_BOOL(waitForTasks({busyTask, lowPriorityTask, highPriorityTask,
+                           dependentTask, taskDependingOnCancelledTask}), true);
+  CHECK_INT(busyTask->GetStatus(), vtkSlicerTask::Completed);
+  CHECK_INT(taskDependingOnCancelledTask->GetStatus(), vtkSlicerTask::Cancelled);
+  CHECK_INT(appLogic->GetNumberOfScheduledTasks(), 0);
+
+  std::vector<int> expectedOrder = {2, 1, 3};
+  CHECK_BOOL(logic->ExecutionOrder == expectedOrder, true);
+
+  appLogic->TerminateProcessingThread();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int testInvalidDependenciesAndProgress()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetNumberOfProcessingThreads(1);
+  appLogic->CreateProcessingThread();
+
+  vtkNew<vtkTaskSchedulerTestLogic> logic;
+  vtkSlicerTask::TaskFunctionPointer progressTask =
+    (vtkSlicerTask::TaskFunctionPointer)&vtkTaskSchedulerTestLogic::ProgressTask;
+  vtkSlicerTask::TaskFunctionPointer recordTask =
+    (vtkSlicerTask::TaskFunctionPointer)&vtkTaskSchedulerTestLogic::RecordTask;
+
+  // A task depending on a task that is not scheduled would never run
+  vtkSmartPointer<vtkSlicerTask> unscheduledTask = newTask(logic, recordTask, 1);
+  vtkSmartPointer<vtkSlicerTask> taskDependingOnUnscheduledTask = newTask(logic, recordTask, 2);
+  taskDependingOnUnscheduledTask->AddDependency(unscheduledTask);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(appLogic->ScheduleTask(taskDependingOnUnscheduledTask) != 0, false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(taskDependingOnUnscheduledTask->GetStatus(), vtkSlicerTask::Failed);
+  CHECK_BOOL(taskDependingOnUnscheduledTask->IsFinished(), true);
+  CHECK_INT(appLogic->GetNumberOfScheduledTasks(), 0);
+
+  // Progress is reported while the task is running
+  CHECK_NULL(vtkSlicerTask::GetCurrentTask());
+  vtkSmartPointer<vtkSlicerTask> busyTask = newTask(logic, progressTask, 0);
+  CHECK_DOUBLE(busyTask->GetProgress(), 0.);
+  appLogic->ScheduleTask(busyTask);
+  for (int i = 0; i < 500 && busyTask->GetProgress() != 0.5; ++i)
+    {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+  CHECK_DOUBLE(busyTask->GetProgress(), 0.5);
+  CHECK_INT(busyTask->GetStatus(), vtkSlicerTask::Running);
+
+  // A task that is scheduled again must not depend on itself through a
+  // task waiting for it
+  vtkSmartPointer<vtkSlicerTask> firstTask = newTask(logic, recordTask, 3);
+  firstTask->SetStatus(vtkSlicerTask::Completed);
+  vtkSmartPointer<vtkSlicerTask> secondTask = newTask(logic, recordTask, 4);
+  secondTask->AddDependency(firstTask);
+  CHECK_BOOL(appLogic->ScheduleTask(secondTask) != 0, true);
+  firstTask->AddDependency(secondTask);
+  CHECK_BOOL(firstTask->DependsOn(firstTask), true);
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(appLogic->ScheduleTask(firstTask) != 0, false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+  CHECK_INT(firstTask->GetStatus(), vtkSlicerTask::Failed);
+
+  // Tasks depending on a failed task are cancelled
+  logic->Released = true;
+  CHECK_BOOL(waitForTasks({busyTask, secondTask}), true);
+  CHECK_INT(busyTask->GetStatus(), vtkSlicerTask::Completed);
+  CHECK_DOUBLE(busyTask->GetProgress(), 1.);
+  CHECK_INT(secondTask->GetStatus(), vtkSlicerTask::Cancelled);
+  CHECK_BOOL(logic->ExecutionOrder.empty(), true);
+
+  appLogic->TerminateProcessingThread();
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+struct WakeUpCounts
+{
+  std::thread::id MainThreadID;
+  std::atomic<int> NumberOfWakeUps{0};
+  std::atomic<int> NumberOfEventsInOtherThreads{0};
+};
+
+//----------------------------------------------------------------------------
+void countWakeUp(void* clientData, unsigned long requestEvent)
+{
+  WakeUpCounts* counts = reinterpret_cast<WakeUpCounts*>(clientData);
+  if (requestEvent == vtkSlicerApplicationLogic::RequestModifiedEvent)
+    {
+    ++counts->NumberOfWakeUps;
+    }
+}
+
+//----------------------------------------------------------------------------
+void countRequestEvent(vtkObject* vtkNotUsed(caller), unsigned long vtkNotUsed(eid),
+                       void* clientData, void* vtkNotUsed(callData))
+{
+  WakeUpCounts* counts = reinterpret_cast<WakeUpCounts*>(clientData);
+  if (std::this_thread::get_id() != counts->MainThreadID)
+    {
+    ++counts->NumberOfEventsInOtherThreads;
+    }
+}
+
+//----------------------------------------------------------------------------
+int testWakeUpMainThread()
+{
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  WakeUpCounts counts;
+  counts.MainThreadID = std::this_thread::get_id();
+  appLogic->SetWakeUpMainThreadCallback(countWakeUp, &counts);
+  vtkNew<vtkCallbackCommand> requestEventCallback;
+  requestEventCallback->SetCallback(countRequestEvent);
+  requestEventCallback->SetClientData(&counts);
+  appLogic->AddObserver(vtkSlicerApplicationLogic::RequestModifiedEvent, requestEventCallback);
+  appLogic->CreateProcessingThread();
+  // Processing the queue resets the processing requested flag
+  appLogic->ProcessModified();
+
+  vtkNew<vtkTaskSchedulerTestLogic> logic;
+  logic->AppLogic = appLogic;
+  vtkSlicerTask::TaskFunctionPointer requestModifiedTask =
+    (vtkSlicerTask::TaskFunctionPointer)&vtkTaskSchedulerTestLogic::RequestModifiedTask;
+  vtkSmartPointer<vtkSlicerTask> task1 = newTask(logic, requestModifiedTask, 1);
+  vtkSmartPointer<vtkSlicerTask> task2 = newTask(logic, requestModifiedTask, 2);
+  appLogic->ScheduleTask(task1);
+  appLogic->ScheduleTask(task2);
+  CHECK_BOOL(waitForTasks({task1, task2}), true);
+
+  // Requests from the processing threads call the wake up function once
+  // until the queue is processed, and never invoke events
+  CHECK_INT(counts.NumberOfWakeUps.load(), 1);
+  CHECK_INT(counts.NumberOfEventsInOtherThreads.load(), 0);
+  appLogic->ProcessModified();
+  appLogic->ProcessModified();
+  CHECK_INT(counts.NumberOfEventsInOtherThreads.load(), 0);
+
+  appLogic->TerminateProcessingThread();
+  appLogic->SetWakeUpMainThreadCallback(nullptr, nullptr);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int testSchedulingPerformance(int numberOfTasks)
+{
+  // This test is for performance: idle processing threads must pick up
+  // new tasks right away instead of polling the queue.
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->CreateProcessingThread();
+
+  vtkNew<vtkTaskSchedulerTestLogic> logic;
+  vtkSlicerTask::TaskFunctionPointer recordTask =
+    (vtkSlicerTask::TaskFunctionPointer)&vtkTaskSchedulerTestLogic::RecordTask;
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  std::vector<vtkSmartPointer<vtkSlicerTask> > tasks;
+  std::vector<vtkSlicerTask*> taskPointers;
+  for (int i = 0; i < numberOfTasks; ++i)
+    {
+    tasks.push_back(newTask(logic, recordTask, i));
+    taskPointers.push_back(tasks.back());
+    appLogic->ScheduleTask(tasks.back());
+    }
+  CHECK_BOOL(waitForTasks(taskPointers), true);
+  timer->StopTimer();
+  CHECK_INT(static_cast<int>(logic->ExecutionOrder.size()), numberOfTasks);
+
+  std::cout << "<DartMeasurement name=\"vtkSlicerApplicationLogic-TaskSchedulingPerformance-"
+            << numberOfTasks << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  appLogic->TerminateProcessingThread();
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogicTaskSchedulerTest(int vtkNotUsed(argc),
+                                               char * vtkNotUsed(argv)[] )
+{
+  CHECK_EXIT_SUCCESS(testConcurrentTasks());
+  CHECK_EXIT_SUCCESS(testPrioritiesDependenciesAndCancellation());
+  CHECK_EXIT_SUCCESS(testInvalidDependenciesAndProgress());
+  CHECK_EXIT_SUCCESS(testWakeUpMainThread());
+  CHECK_EXIT_SUCCESS(testSchedulingPerformance(1000));
+  return EXIT_SUCCESS;
+}
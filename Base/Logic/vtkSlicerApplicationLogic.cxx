@@ -41,16 +41,30 @@
 # include <sys/resource.h>
 #endif
 
+#include <deque>
 #include <queue>
 
 #include "vtkSlicerApplicationLogicRequests.h"
 
 //----------------------------------------------------------------------------
-class ProcessingTaskQueue : public std::queue<vtkSmartPointer<vtkSlicerTask> > {};
+class ProcessingTaskQueue : public std::deque<vtkSmartPointer<vtkSlicerTask> > {};
 class ModifiedQueue : public std::queue<vtkSmartPointer<vtkObject> > {};
 class ReadDataQueue : public std::queue<DataRequest*> {};
 class WriteDataQueue : public std::queue<DataRequest*> {};
 
+//----------------------------------------------------------------------------
+namespace
+{
+// Flag the processing of a request queue as requested. Return true if the
+// main thread must be woken up. The queue lock must be locked.
+bool RequestQueueProcessing(bool& processingRequested)
+{
+  bool wakeUp = !processingRequested;
+  processingRequested = true;
+  return wakeUp;
+}
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerApplicationLogic);
 
@@ -58,14 +72,20 @@ vtkStandardNewMacro(vtkSlicerApplicationLogic);
 vtkSlicerApplicationLogic::vtkSlicerApplicationLogic()
 {
   this->ProcessingThreader = itk::PlatformMultiThreader::New();
-  this->ProcessingThreadId = -1;
+  this->NumberOfProcessingThreads = 4;
   this->ProcessingThreadActive = false;
 
   this->ModifiedQueueActive = false;
+  this->ModifiedQueueProcessingRequested = false;
 
   this->ReadDataQueueActive = false;
+  this->ReadDataQueueProcessingRequested = false;
 
   this->WriteDataQueueActive = false;
+  this->WriteDataQueueProcessingRequested = false;
+
+  this->WakeUpMainThreadCallback = nullptr;
+  this->WakeUpMainThreadClientData = nullptr;
 
   this->InternalTaskQueue = new ProcessingTaskQueue;
   this->InternalModifiedQueue = new ModifiedQueue;
@@ -82,17 +102,22 @@ vtkSlicerApplicationLogic::~vtkSlicerApplicationLogic()
   // Note that TerminateThread does not kill a thread, it only waits
   // for the thread to finish.  We need to signal the thread that we
   // want to terminate
-  if (this->ProcessingThreadId != -1 && this->ProcessingThreader)
+  if (!this->ProcessingThreadIDs.empty() && this->ProcessingThreader)
     {
-    // Signal the processingThread that we are terminating.
+    // Signal the processing threads that we are terminating.
     this->ProcessingThreadActiveLock.lock();
     this->ProcessingThreadActive = false;
     this->ProcessingThreadActiveLock.unlock();
+    this->ProcessingTaskQueueLock.lock();
+    this->ProcessingTaskQueueCondition.notify_all();
+    this->ProcessingTaskQueueLock.unlock();
 
-    // Wait for the thread to finish and clean up the state of the threader
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-
-    this->ProcessingThreadId = -1;
+    // Wait for the threads to finish and clean up the state of the threader
+    for (int threadID : this->ProcessingThreadIDs)
+      {
+      this->ProcessingThreader->TerminateThread( threadID );
+      }
+    this->ProcessingThreadIDs.clear();
     }
 
   delete this->InternalTaskQueue;
@@ -171,21 +196,47 @@ void vtkSlicerApplicationLogic::PrintSelf(ostream& os, vtkIndent indent)
   this->vtkObject::PrintSelf(os, indent);
 
   os << indent << "SlicerApplicationLogic:             " << this->GetClassName() << "\n";
+  os << indent << "NumberOfProcessingThreads:          " << this->NumberOfProcessingThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::SetNumberOfProcessingThreads(int numberOfThreads)
+{
+  numberOfThreads = std::max(numberOfThreads, 1);
+  if (this->NumberOfProcessingThreads == numberOfThreads)
+    {
+    return;
+    }
+  if (!this->ProcessingThreadIDs.empty())
+    {
+    vtkWarningMacro("SetNumberOfProcessingThreads: processing threads are already running,"
+                    " the new number of threads will be used the next time they are created.");
+    }
+  this->NumberOfProcessingThreads = numberOfThreads;
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetNumberOfProcessingThreads()
+{
+  return this->NumberOfProcessingThreads;
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::CreateProcessingThread()
 {
-  if (this->ProcessingThreadId == -1)
+  if (this->ProcessingThreadIDs.empty())
     {
     this->ProcessingThreadActiveLock.lock();
     this->ProcessingThreadActive = true;
     this->ProcessingThreadActiveLock.unlock();
 
-    this->ProcessingThreadId
-      = this->ProcessingThreader
-      ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
-                    this);
+    for (int i = 0; i < this->NumberOfProcessingThreads; ++i)
+      {
+      this->ProcessingThreadIDs.push_back( this->ProcessingThreader
+        ->SpawnThread(vtkSlicerApplicationLogic::ProcessingThreaderCallback,
+                      this) );
+      }
 
     // Start four network threads (TODO: make the number of threads a setting)
     this->NetworkingThreadIDs.push_back ( this->ProcessingThreader
@@ -217,6 +268,15 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
     this->WriteDataQueueActiveLock.lock();
     this->WriteDataQueueActive = true;
     this->WriteDataQueueActiveLock.unlock();
+    this->ModifiedQueueLock.lock();
+    this->ModifiedQueueProcessingRequested = true;
+    this->ModifiedQueueLock.unlock();
+    this->ReadDataQueueLock.lock();
+    this->ReadDataQueueProcessingRequested = true;
+    this->ReadDataQueueLock.unlock();
+    this->WriteDataQueueLock.lock();
+    this->WriteDataQueueProcessingRequested = true;
+    this->WriteDataQueueLock.unlock();
 
     int delay = 1000;
     this->InvokeEvent(vtkSlicerApplicationLogic::RequestModifiedEvent, &delay);
@@ -228,7 +288,7 @@ void vtkSlicerApplicationLogic::CreateProcessingThread()
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::TerminateProcessingThread()
 {
-  if (this->ProcessingThreadId != -1)
+  if (!this->ProcessingThreadIDs.empty())
     {
     this->ModifiedQueueActiveLock.lock();
     this->ModifiedQueueActive = false;
@@ -246,8 +306,16 @@ void vtkSlicerApplicationLogic::TerminateProcessingThread()
     this->ProcessingThreadActive = false;
     this->ProcessingThreadActiveLock.unlock();
 
-    this->ProcessingThreader->TerminateThread( this->ProcessingThreadId );
-    this->ProcessingThreadId = -1;
+    // Wake up the threads waiting for a task so that they can exit
+    this->ProcessingTaskQueueLock.lock();
+    this->ProcessingTaskQueueCondition.notify_all();
+    this->ProcessingTaskQueueLock.unlock();
+
+    for (int threadID : this->ProcessingThreadIDs)
+      {
+      this->ProcessingThreader->TerminateThread( threadID );
+      }
+    this->ProcessingThreadIDs.clear();
 
     std::vector<int>::const_iterator idIterator;
     idIterator = this->NetworkingThreadIDs.begin();
@@ -300,48 +368,7 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessProcessingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = nullptr;
-
-  while (active)
-    {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock.lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock.unlock();
-
-    if (active)
-      {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock.lock();
-      if ((*this->InternalTaskQueue).size() > 0)
-        {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-
-        // only handle processing tasks in this thread
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Processing )
-          {
-          (*this->InternalTaskQueue).pop();
-          }
-        else
-          {
-          task = nullptr;
-          }
-        }
-      this->ProcessingTaskQueueLock.unlock();
-
-      // process the task (should this be in a separate thread?)
-      if (task)
-        {
-        task->Execute();
-        task = nullptr;
-        }
-      }
-
-    // busy wait
-    itksys::SystemTools::Delay(100);
-    }
+  this->ProcessTasks(vtkSlicerTask::Processing);
 }
 
 itk::ITK_THREAD_RETURN_TYPE
@@ -382,46 +409,97 @@ vtkSlicerApplicationLogic
 //----------------------------------------------------------------------------
 void vtkSlicerApplicationLogic::ProcessNetworkingTasks()
 {
-  int active = true;
-  vtkSmartPointer<vtkSlicerTask> task = nullptr;
+  this->ProcessTasks(vtkSlicerTask::Networking);
+}
 
-  while (active)
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::ProcessTasks(int taskType)
+{
+  while (true)
     {
-    // Check to see if we should be shutting down
-    this->ProcessingThreadActiveLock.lock();
-    active = this->ProcessingThreadActive;
-    this->ProcessingThreadActiveLock.unlock();
-
-    if (active)
+    vtkSmartPointer<vtkSlicerTask> task;
       {
-      // pull a task off the queue
-      this->ProcessingTaskQueueLock.lock();
-      if ((*this->InternalTaskQueue).size() > 0)
+      // Wait for a task to be ready instead of polling the queue
+      std::unique_lock<std::mutex> lock(this->ProcessingTaskQueueLock);
+      while (!task)
         {
-        // std::cout << "Number of queued tasks: " << (*this->InternalTaskQueue).size() << std::endl;
-        task = (*this->InternalTaskQueue).front();
-        if ( task->GetType() == vtkSlicerTask::Networking )
+        // Check to see if we should be shutting down
+        this->ProcessingThreadActiveLock.lock();
+        int active = this->ProcessingThreadActive;
+        this->ProcessingThreadActiveLock.unlock();
+        if (!active)
           {
-          (*this->InternalTaskQueue).pop();
+          return;
           }
-        else
+        task = vtkSmartPointer<vtkSlicerTask>::Take(this->TakeNextTask(taskType));
+        if (!task)
           {
-          task = nullptr;
+          this->ProcessingTaskQueueCondition.wait(lock);
           }
         }
-      this->ProcessingTaskQueueLock.unlock();
+      }
 
-      // process the task (should this be in a separate thread?)
-      if (task)
+    task->SetProgress(0.);
+    task->SetStatus(vtkSlicerTask::Running);
+    task->Execute();
+    task->SetProgress(1.);
+    task->SetStatus(vtkSlicerTask::Completed);
+    task = nullptr;
+
+    // Tasks depending on the completed task may be ready to run now
+    this->ProcessingTaskQueueLock.lock();
+    this->ProcessingTaskQueueCondition.notify_all();
+    this->ProcessingTaskQueueLock.unlock();
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTask* vtkSlicerApplicationLogic::TakeNextTask(int taskType)
+{
+  // Cancel the tasks that won't run first, so that the iterators of the
+  // remaining tasks stay valid.
+  bool cancelledTasks = true;
+  while (cancelledTasks)
+    {
+    cancelledTasks = false;
+    for (ProcessingTaskQueue::iterator it = this->InternalTaskQueue->begin();
+         it != this->InternalTaskQueue->end(); ++it)
+      {
+      vtkSlicerTask* task = *it;
+      if (task->IsCancelled() || task->IsAnyDependencyCancelled())
         {
-        task->Execute();
-        task = nullptr;
+        task->SetStatus(vtkSlicerTask::Cancelled);
+        this->InternalTaskQueue->erase(it);
+        // tasks depending on the cancelled task must be cancelled too
+        cancelledTasks = true;
+        break;
         }
       }
+    }
 
-    // busy wait
-    itksys::SystemTools::Delay(100);
+  ProcessingTaskQueue::iterator nextTaskIt = this->InternalTaskQueue->end();
+  for (ProcessingTaskQueue::iterator it = this->InternalTaskQueue->begin();
+       it != this->InternalTaskQueue->end(); ++it)
+    {
+    vtkSlicerTask* task = *it;
+    // Oldest task first among the ready tasks of the same priority
+    if (task->GetType() == taskType
+        && task->AreDependenciesCompleted()
+        && (nextTaskIt == this->InternalTaskQueue->end()
+            || task->GetPriority() > (*nextTaskIt)->GetPriority()))
+      {
+      nextTaskIt = it;
+      }
+    }
+  if (nextTaskIt == this->InternalTaskQueue->end())
+    {
+    return nullptr;
     }
+  // The caller takes the reference held by the queue
+  vtkSlicerTask* nextTask = *nextTaskIt;
+  nextTask->Register(this);
+  this->InternalTaskQueue->erase(nextTaskIt);
+  return nextTask;
 }
 
 //----------------------------------------------------------------------------
@@ -436,12 +514,91 @@ int vtkSlicerApplicationLogic::ScheduleTask( vtkSlicerTask *task )
     return false;
     }
 
+  // A task waiting for a dependency that is never scheduled, or for itself
+  // through a dependency cycle, would stay in the queue forever
+  for (int dependencyIndex = 0; dependencyIndex < task->GetNumberOfDependencies(); ++dependencyIndex)
+    {
+    if (task->GetNthDependency(dependencyIndex)->GetStatus() == vtkSlicerTask::Idle)
+      {
+      vtkErrorMacro("ScheduleTask: dependency " << dependencyIndex << " of the task is not scheduled");
+      task->SetStatus(vtkSlicerTask::Failed);
+      return false;
+      }
+    }
+  if (task->DependsOn(task))
+    {
+    vtkErrorMacro("ScheduleTask: the task depends on itself through its dependencies");
+    task->SetStatus(vtkSlicerTask::Failed);
+    return false;
+    }
+
   this->ProcessingTaskQueueLock.lock();
-  (*this->InternalTaskQueue).push( task );
+  task->SetStatus(vtkSlicerTask::Scheduled);
+  (*this->InternalTaskQueue).push_back( task );
+  // Processing and networking threads wait on the same condition
+  this->ProcessingTaskQueueCondition.notify_all();
   this->ProcessingTaskQueueLock.unlock();
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkSlicerApplicationLogic::CancelTask( vtkSlicerTask *task )
+{
+  if (!task)
+    {
+    return false;
+    }
+  task->Cancel();
+  bool removed = false;
+  this->ProcessingTaskQueueLock.lock();
+  ProcessingTaskQueue::iterator it = std::find(
+    this->InternalTaskQueue->begin(), this->InternalTaskQueue->end(), task);
+  if (it != this->InternalTaskQueue->end())
+    {
+    task->SetStatus(vtkSlicerTask::Cancelled);
+    this->InternalTaskQueue->erase(it);
+    removed = true;
+    // tasks depending on the cancelled task must be cancelled too
+    this->ProcessingTaskQueueCondition.notify_all();
+    }
+  this->ProcessingTaskQueueLock.unlock();
+  return removed;
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerApplicationLogic::GetNumberOfScheduledTasks()
+{
+  this->ProcessingTaskQueueLock.lock();
+  int numberOfTasks = static_cast<int>(this->InternalTaskQueue->size());
+  this->ProcessingTaskQueueLock.unlock();
+  return numberOfTasks;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::SetWakeUpMainThreadCallback(WakeUpMainThreadCallbackType callback, void* clientData)
+{
+  std::lock_guard<std::mutex> lock(this->WakeUpMainThreadCallbackLock);
+  this->WakeUpMainThreadCallback = callback;
+  this->WakeUpMainThreadClientData = clientData;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerApplicationLogic::IsWakeUpMainThreadCallbackSet()
+{
+  std::lock_guard<std::mutex> lock(this->WakeUpMainThreadCallbackLock);
+  return this->WakeUpMainThreadCallback != nullptr;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerApplicationLogic::WakeUpMainThread(unsigned long requestEvent)
+{
+  std::lock_guard<std::mutex> lock(this->WakeUpMainThreadCallbackLock);
+  if (this->WakeUpMainThreadCallback)
+    {
+    this->WakeUpMainThreadCallback(this->WakeUpMainThreadClientData, requestEvent);
+    }
+}
+
 //----------------------------------------------------------------------------
 vtkMTimeType vtkSlicerApplicationLogic::RequestModified(vtkObject *obj)
 {
@@ -460,7 +617,14 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestModified(vtkObject *obj)
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalModifiedQueue).push(obj);
+  bool wakeUp = RequestQueueProcessing(this->ModifiedQueueProcessingRequested);
   this->ModifiedQueueLock.unlock();
+  if (wakeUp)
+    {
+    // Requests are made from the processing threads: events must not be
+    // invoked here, observers are not thread-safe.
+    this->WakeUpMainThread(vtkSlicerApplicationLogic::RequestModifiedEvent);
+    }
   return uid;
 }
 
@@ -482,7 +646,14 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestReadFile(const char *refNode, con
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(
     new ReadDataRequestFile(refNode, filename, displayData, deleteFile, uid));
+  bool wakeUp = RequestQueueProcessing(this->ReadDataQueueProcessingRequested);
   this->ReadDataQueueLock.unlock();
+  if (wakeUp)
+    {
+    // Requests are made from the processing threads: events must not be
+    // invoked here, observers are not thread-safe.
+    this->WakeUpMainThread(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -503,7 +674,14 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestUpdateParentTransform(const std::
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(new ReadDataRequestUpdateParentTransform(refNode, parentTransformNode, uid));
+  bool wakeUp = RequestQueueProcessing(this->ReadDataQueueProcessingRequested);
   this->ReadDataQueueLock.unlock();
+  if (wakeUp)
+    {
+    // Requests are made from the processing threads: events must not be
+    // invoked here, observers are not thread-safe.
+    this->WakeUpMainThread(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -524,7 +702,14 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestUpdateSubjectHierarchyLocation(co
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(new ReadDataRequestUpdateSubjectHierarchyLocation(updatedNode, siblingNode, uid));
+  bool wakeUp = RequestQueueProcessing(this->ReadDataQueueProcessingRequested);
   this->ReadDataQueueLock.unlock();
+  if (wakeUp)
+    {
+    // Requests are made from the processing threads: events must not be
+    // invoked here, observers are not thread-safe.
+    this->WakeUpMainThread(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -545,7 +730,14 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestAddNodeReference(const std::strin
   this->RequestTimeStamp.Modified();
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(new ReadDataRequestAddNodeReference(referencingNode, referencedNode, role, uid));
+  bool wakeUp = RequestQueueProcessing(this->ReadDataQueueProcessingRequested);
   this->ReadDataQueueLock.unlock();
+  if (wakeUp)
+    {
+    // Requests are made from the processing threads: events must not be
+    // invoked here, observers are not thread-safe.
+    this->WakeUpMainThread(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -567,7 +759,14 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestWriteData(const char *refNode, co
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalWriteDataQueue).push(
     new WriteDataRequestFile(refNode, filename, uid) );
+  bool wakeUp = RequestQueueProcessing(this->WriteDataQueueProcessingRequested);
   this->WriteDataQueueLock.unlock();
+  if (wakeUp)
+    {
+    // Requests are made from the processing threads: events must not be
+    // invoked here, observers are not thread-safe.
+    this->WakeUpMainThread(vtkSlicerApplicationLogic::RequestWriteDataEvent);
+    }
   return uid;
 }
 
@@ -593,7 +792,14 @@ vtkMTimeType vtkSlicerApplicationLogic::RequestReadScene(
   vtkMTimeType uid = this->RequestTimeStamp.GetMTime();
   (*this->InternalReadDataQueue).push(
     new ReadDataRequestScene(targetIDs, sourceIDs, filename, displayData, deleteFile, uid));
+  bool wakeUp = RequestQueueProcessing(this->ReadDataQueueProcessingRequested);
   this->ReadDataQueueLock.unlock();
+  if (wakeUp)
+    {
+    // Requests are made from the processing threads: events must not be
+    // invoked here, observers are not thread-safe.
+    this->WakeUpMainThread(vtkSlicerApplicationLogic::RequestReadDataEvent);
+    }
   return uid;
 }
 
@@ -636,10 +842,23 @@ void vtkSlicerApplicationLogic::ProcessModified()
     obj = nullptr;
     }
 
-  // schedule the next timer sooner in case there is stuff in the queue
-  // otherwise for a while later
-  int delay = (*this->InternalModifiedQueue).size() > 0 ? 0: 200;
-  this->InvokeEvent(vtkSlicerApplicationLogic::RequestModifiedEvent, &delay);
+  // schedule the next processing right away in case there is stuff in the
+  // queue, otherwise the next request will wake up the main thread
+  this->ModifiedQueueLock.lock();
+  bool moreRequests = !(*this->InternalModifiedQueue).empty();
+  this->ModifiedQueueProcessingRequested = moreRequests;
+  this->ModifiedQueueLock.unlock();
+  if (moreRequests)
+    {
+    int delay = 0;
+    this->InvokeEvent(vtkSlicerApplicationLogic::RequestModifiedEvent, &delay);
+    }
+  else if (!this->IsWakeUpMainThreadCallbackSet())
+    {
+    // Requests can't wake up the main thread, poll the queue
+    int delay = 200;
+    this->InvokeEvent(vtkSlicerApplicationLogic::RequestModifiedEvent, &delay);
+    }
 }
 
 //----------------------------------------------------------------------------
@@ -672,10 +891,23 @@ void vtkSlicerApplicationLogic::ProcessReadData()
     delete req;
     }
 
-  int delay = (*this->InternalReadDataQueue).size() > 0 ? 0: 200;
-  // schedule the next timer sooner in case there is stuff in the queue
-  // otherwise for a while later
-  this->InvokeEvent(vtkSlicerApplicationLogic::RequestReadDataEvent, &delay);
+  // schedule the next processing right away in case there is stuff in the
+  // queue, otherwise the next request will wake up the main thread
+  this->ReadDataQueueLock.lock();
+  bool moreRequests = !(*this->InternalReadDataQueue).empty();
+  this->ReadDataQueueProcessingRequested = moreRequests;
+  this->ReadDataQueueLock.unlock();
+  if (moreRequests)
+    {
+    int delay = 0;
+    this->InvokeEvent(vtkSlicerApplicationLogic::RequestReadDataEvent, &delay);
+    }
+  else if (!this->IsWakeUpMainThreadCallbackSet())
+    {
+    // Requests can't wake up the main thread, poll the queue
+    int delay = 200;
+    this->InvokeEvent(vtkSlicerApplicationLogic::RequestReadDataEvent, &delay);
+    }
   if (uid)
     {
     this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
@@ -705,22 +937,36 @@ void vtkSlicerApplicationLogic::ProcessWriteData()
     }
   this->WriteDataQueueLock.unlock();
 
+  vtkMTimeType uid = 0;
   if (req)
-  {
-    vtkMTimeType uid = req->GetUID();
+    {
+    uid = req->GetUID();
     req->Execute(this);
     delete req;
+    }
 
-    // schedule the next timer sooner in case there is stuff in the queue
-    // otherwise for a while later
-    int delay = (*this->InternalWriteDataQueue).size() > 0 ? 0 : 200;
+  // schedule the next processing right away in case there is stuff in the
+  // queue, otherwise the next request will wake up the main thread
+  this->WriteDataQueueLock.lock();
+  bool moreRequests = !(*this->InternalWriteDataQueue).empty();
+  this->WriteDataQueueProcessingRequested = moreRequests;
+  this->WriteDataQueueLock.unlock();
+  if (moreRequests)
+    {
+    int delay = 0;
     this->InvokeEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent, &delay);
-    if (uid)
-      {
-      this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
-        reinterpret_cast<void*>(uid));
-      }
-  }
+    }
+  else if (!this->IsWakeUpMainThreadCallbackSet())
+    {
+    // Requests can't wake up the main thread, poll the queue
+    int delay = 200;
+    this->InvokeEvent(vtkSlicerApplicationLogic::RequestWriteDataEvent, &delay);
+    }
+  if (uid)
+    {
+    this->InvokeEvent(vtkSlicerApplicationLogic::RequestProcessedEvent,
+                      reinterpret_cast<void*>(uid));
+    }
 }
 
 //----------------------------------------------------------------------------
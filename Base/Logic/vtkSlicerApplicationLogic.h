@@ -31,6 +31,7 @@
 #include <itkPlatformMultiThreader.h>
 
 // STL includes
+#include <condition_variable>
 #include <mutex>
 
 class vtkMRMLSelectionNode;
@@ -72,11 +73,23 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
   /// (display it in the Fiducials GUI)
   void PropagateFiducialListSelection();
 
-  /// Create a thread for processing
+  /// Create the threads for processing
+  /// \sa SetNumberOfProcessingThreads()
   void CreateProcessingThread();
 
-  /// Shutdown the processing thread
+  /// Shutdown the processing threads
   void TerminateProcessingThread();
+
+  /// Number of threads running the processing tasks concurrently.
+  /// Must be set before the processing threads are created.
+  /// Default is 4.
+  /// Tasks (e.g. CLI module executions) then run at the same time in
+  /// different threads: they must not modify the MRML scene or nodes, nor
+  /// invoke events on them. Changes must be made in the main thread through
+  /// RequestModified(), RequestReadFile(), RequestReadScene(), etc.
+  /// \sa CreateProcessingThread(), ScheduleTask()
+  void SetNumberOfProcessingThreads(int numberOfThreads);
+  int GetNumberOfProcessingThreads();
   /// List of events potentially fired by the application logic
   enum RequestEvents
     {
@@ -90,11 +103,40 @@ class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerApplicationLogic
       RequestProcessedEvent
     };
 
-  /// Schedule a task to run in the processing thread. Returns true if
+  /// Schedule a task to run in a processing thread. Returns true if
   /// task was successfully scheduled. ScheduleTask() is called from the
-  /// main thread to run something in the processing thread.
+  /// main thread to run something in a processing thread.
+  /// Idle processing threads are woken up immediately. Among the
+  /// scheduled tasks whose dependencies are completed, the one with the
+  /// highest priority is run first.
+  /// Scheduling fails and the task status is set to vtkSlicerTask::Failed
+  /// if a dependency has not been scheduled or if the dependencies form
+  /// a cycle, as the task could never run.
+  /// \sa vtkSlicerTask::SetPriority(), vtkSlicerTask::AddDependency()
   int ScheduleTask( vtkSlicerTask* );
 
+  /// Cancel a scheduled task. Returns true if the task had not started
+  /// yet and will not run. A running task is flagged as cancelled but is
+  /// not interrupted.
+  bool CancelTask( vtkSlicerTask* );
+
+  /// Return the number of scheduled tasks that have not started yet.
+  int GetNumberOfScheduledTasks();
+
+  /// Function that wakes up the main thread to process the requests.
+  /// \sa SetWakeUpMainThreadCallback()
+  typedef void (*WakeUpMainThreadCallbackType)(void* clientData, unsigned long requestEvent);
+
+  /// Set the function called when a request is queued while the main thread
+  /// is not already going to process the queue. requestEvent is
+  /// RequestModifiedEvent, RequestReadDataEvent or RequestWriteDataEvent.
+  /// The function is called from the processing threads: it must be
+  /// thread-safe and must only post the processing to the main thread
+  /// (e.g. a queued call to ProcessModified(), ProcessReadData() or
+  /// ProcessWriteData()). Request events are only invoked from the main
+  /// thread. If no function is set, the main thread polls the queues.
+  void SetWakeUpMainThreadCallback(WakeUpMainThreadCallbackType callback, void* clientData);
+
   /// Request a Modified call on an object.  This method allows a
   /// processing thread to request a Modified call on an object to be
   /// performed in the main thread.  This allows the call to Modified
@@ -232,12 +274,20 @@ protected:
    /// Callback used by a MultiThreader to start a networking thread
   static itk::ITK_THREAD_RETURN_TYPE NetworkingThreaderCallback( void * );
 
-  /// Task processing loop that is run in the processing thread
+  /// Task processing loop that is run in the processing threads
   void ProcessProcessingTasks();
 
   /// Networking Task processing loop that is run in a networking thread
   void ProcessNetworkingTasks();
 
+  /// Run the tasks of the given type until the threads are terminated.
+  void ProcessTasks(int taskType);
+
+  /// Remove from the queue and return the next task of the given type
+  /// that is ready to run, nullptr if there is none. Cancelled tasks are
+  /// removed from the queue. ProcessingTaskQueueLock must be locked.
+  vtkSlicerTask* TakeNextTask(int taskType);
+
   /// Process a request to read data into a scene.  This method is
   /// called by ProcessReadData() in the application main thread
   /// because calls to load data will cause a Modified() on a node
@@ -245,6 +295,11 @@ protected:
   void ProcessReadSceneData( ReadDataRequest &req );
   void ProcessWriteSceneData( WriteDataRequest &req );
 
+  /// Call the wake up callback, if any. Thread-safe.
+  /// \sa SetWakeUpMainThreadCallback()
+  void WakeUpMainThread(unsigned long requestEvent);
+  bool IsWakeUpMainThreadCallbackSet();
+
 private:
   vtkSlicerApplicationLogic(const vtkSlicerApplicationLogic&);
   void operator=(const vtkSlicerApplicationLogic&);
@@ -252,6 +307,7 @@ private:
   itk::PlatformMultiThreader::Pointer ProcessingThreader;
   std::mutex ProcessingThreadActiveLock;
   std::mutex ProcessingTaskQueueLock;
+  std::condition_variable ProcessingTaskQueueCondition;
   std::mutex ModifiedQueueActiveLock;
   std::mutex ModifiedQueueLock;
   std::mutex ReadDataQueueActiveLock;
@@ -259,13 +315,25 @@ private:
   std::mutex WriteDataQueueActiveLock;
   std::mutex WriteDataQueueLock;
   vtkTimeStamp RequestTimeStamp;
-  int ProcessingThreadId;
+  std::vector<int> ProcessingThreadIDs;
   std::vector<int> NetworkingThreadIDs;
+  int NumberOfProcessingThreads;
   int ProcessingThreadActive;
   int ModifiedQueueActive;
   int ReadDataQueueActive;
   int WriteDataQueueActive;
 
+  /// Set when the main thread has been asked to process the queue.
+  /// A new request only wakes up the main thread if it is not set, the
+  /// queues are not polled when there is no request.
+  bool ModifiedQueueProcessingRequested;
+  bool ReadDataQueueProcessingRequested;
+  bool WriteDataQueueProcessingRequested;
+
+  std::mutex WakeUpMainThreadCallbackLock;
+  WakeUpMainThreadCallbackType WakeUpMainThreadCallback;
+  void* WakeUpMainThreadClientData;
+
   ProcessingTaskQueue* InternalTaskQueue;
   ModifiedQueue*       InternalModifiedQueue;
   ReadDataQueue*       InternalReadDataQueue;
@@ -3,6 +3,16 @@
 // VTK includes
 #include <vtkObjectFactory.h>
 
+// STD includes
+#include <algorithm>
+#include <set>
+
+namespace
+{
+// Task executed in the current thread
+thread_local vtkSlicerTask* CurrentTask = nullptr;
+}
+
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkSlicerTask);
 
@@ -13,6 +23,10 @@ vtkSlicerTask::vtkSlicerTask()
   this->TaskFunction = nullptr;
   this->TaskClientData = nullptr;
   this->Type = vtkSlicerTask::Undefined;
+  this->Priority = 0;
+  this->Status = vtkSlicerTask::Idle;
+  this->CancelRequested = false;
+  this->Progress = 0.;
 }
 //----------------------------------------------------------------------------
 vtkSlicerTask::~vtkSlicerTask()
@@ -33,12 +47,124 @@ void vtkSlicerTask::Execute()
 {
   if (this->TaskObject)
     {
+    vtkSlicerTask* previousTask = CurrentTask;
+    CurrentTask = this;
     ((*this->TaskObject).*(this->TaskFunction))(this->TaskClientData);
+    CurrentTask = previousTask;
+    }
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTask* vtkSlicerTask::GetCurrentTask()
+{
+  return CurrentTask;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTask::SetProgress(double progress)
+{
+  this->Progress.store(std::min(std::max(progress, 0.), 1.));
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTask::AddDependency(vtkSlicerTask* task)
+{
+  if (!task || task == this)
+    {
+    vtkErrorMacro("AddDependency: invalid task");
+    return;
+    }
+  this->Dependencies.push_back(task);
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerTask::GetNumberOfDependencies()
+{
+  return static_cast<int>(this->Dependencies.size());
+}
+
+//----------------------------------------------------------------------------
+vtkSlicerTask* vtkSlicerTask::GetNthDependency(int n)
+{
+  if (n < 0 || n >= static_cast<int>(this->Dependencies.size()))
+    {
+    return nullptr;
+    }
+  return this->Dependencies[n];
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTask::DependsOn(vtkSlicerTask* task) const
+{
+  std::set<const vtkSlicerTask*> visitedTasks;
+  std::vector<const vtkSlicerTask*> tasksToVisit(1, this);
+  while (!tasksToVisit.empty())
+    {
+    const vtkSlicerTask* visitedTask = tasksToVisit.back();
+    tasksToVisit.pop_back();
+    for (const vtkSmartPointer<vtkSlicerTask>& dependency : visitedTask->Dependencies)
+      {
+      if (dependency == task)
+        {
+        return true;
+        }
+      if (!dependency->IsFinished() && visitedTasks.insert(dependency).second)
+        {
+        tasksToVisit.push_back(dependency);
+        }
+      }
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerTask::Cancel()
+{
+  this->CancelRequested = true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTask::IsFinished() const
+{
+  int status = this->GetStatus();
+  return status == vtkSlicerTask::Completed || status == vtkSlicerTask::Cancelled
+    || status == vtkSlicerTask::Failed;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTask::AreDependenciesCompleted() const
+{
+  for (const vtkSmartPointer<vtkSlicerTask>& dependency : this->Dependencies)
+    {
+    if (dependency->GetStatus() != vtkSlicerTask::Completed)
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool vtkSlicerTask::IsAnyDependencyCancelled() const
+{
+  for (const vtkSmartPointer<vtkSlicerTask>& dependency : this->Dependencies)
+    {
+    int status = dependency->GetStatus();
+    if (status == vtkSlicerTask::Cancelled || status == vtkSlicerTask::Failed)
+      {
+      return true;
+      }
     }
+  return false;
 }
 
 //----------------------------------------------------------------------------
 void vtkSlicerTask::PrintSelf(ostream& os, vtkIndent indent)
 {
   Superclass::PrintSelf(os, indent);
+  os << indent << "Type: " << this->GetTypeAsString() << "\n";
+  os << indent << "Priority: " << this->Priority << "\n";
+  os << indent << "Status: " << this->GetStatus() << "\n";
+  os << indent << "Progress: " << this->GetProgress() << "\n";
+  os << indent << "NumberOfDependencies: " << this->Dependencies.size() << "\n";
 }
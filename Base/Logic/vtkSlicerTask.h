@@ -6,6 +6,10 @@
 #include "vtkMRMLAbstractLogic.h"
 #include "vtkSlicerBaseLogic.h"
 
+// STD includes
+#include <atomic>
+#include <vector>
+
 class VTK_SLICER_BASE_LOGIC_EXPORT vtkSlicerTask : public vtkObject
 {
 public:
@@ -48,6 +52,77 @@ public:
     return "Unknown";
   }
 
+  ///
+  /// Priority of the task. Among the tasks ready to run, the scheduler
+  /// picks the one with the highest priority first, then the oldest one.
+  /// Default is 0.
+  vtkSetMacro(Priority, int);
+  vtkGetMacro(Priority, int);
+
+  ///
+  /// Add a task that must be completed before this task can run.
+  /// If a dependency is cancelled, this task is cancelled too.
+  /// Dependencies must be added and scheduled before the task is scheduled,
+  /// otherwise scheduling fails.
+  /// \sa vtkSlicerApplicationLogic::ScheduleTask()
+  void AddDependency(vtkSlicerTask* task);
+  int GetNumberOfDependencies();
+  vtkSlicerTask* GetNthDependency(int n);
+
+  ///
+  /// Return true if the task is one of the dependencies, directly or through
+  /// other dependencies. Dependencies that are already finished are not
+  /// searched, as they do not wait for other tasks anymore.
+  bool DependsOn(vtkSlicerTask* task) const;
+
+  ///
+  /// Status of the task, updated by the scheduler.
+  enum
+    {
+    Idle = 0,
+    Scheduled,
+    Running,
+    Completed,
+    Cancelled,
+    /// The task could not be scheduled, because one of its dependencies
+    /// was not scheduled or depends on the task.
+    Failed
+    };
+  int GetStatus() const { return this->Status.load(); }
+  void SetStatus(int status) { this->Status.store(status); }
+
+  ///
+  /// Request the task to be cancelled. A task that has not started yet is
+  /// not run. A running task is not interrupted.
+  /// \sa vtkSlicerApplicationLogic::CancelTask()
+  void Cancel();
+  bool IsCancelled() const { return this->CancelRequested.load(); }
+
+  ///
+  /// Progress of the task, between 0 and 1. It is set to 0 when the task
+  /// starts running and to 1 when it is completed. The task function may
+  /// report intermediate progress, by calling SetProgress() on
+  /// GetCurrentTask(). Progress can be read from any thread.
+  void SetProgress(double progress);
+  double GetProgress() const { return this->Progress.load(); }
+
+  ///
+  /// Return the task that is being executed in the calling thread,
+  /// nullptr if the calling thread is not executing a task.
+  static vtkSlicerTask* GetCurrentTask();
+
+  ///
+  /// Return true if the task has been completed, cancelled, or failed.
+  bool IsFinished() const;
+
+  ///
+  /// Return true if all the dependencies of the task are completed.
+  bool AreDependenciesCompleted() const;
+
+  ///
+  /// Return true if any of the dependencies was cancelled or failed.
+  bool IsAnyDependencyCancelled() const;
+
 protected:
   vtkSlicerTask();
   ~vtkSlicerTask() override;
@@ -60,6 +135,12 @@ private:
   void *TaskClientData;
 
   int Type;
+  int Priority;
+
+  std::vector<vtkSmartPointer<vtkSlicerTask> > Dependencies;
+  std::atomic<int> Status;
+  std::atomic<bool> CancelRequested;
+  std::atomic<double> Progress;
 
 };
 #endif
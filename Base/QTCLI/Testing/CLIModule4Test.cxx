@@ -23,7 +23,10 @@
 #include "CLIModule4TestCLP.h"
 
 // STD includes
+#include <chrono>
+#include <cstdlib>
 #include <fstream>
+#include <thread>
 
 // Use an anonymous namespace to keep class types and function names
 // from colliding when module is used as shared object module.  Every
@@ -69,6 +72,14 @@ int main(int argc, char * argv[])
     {
     result = InputValue1 * InputValue2;
     }
+  else if (OperationType == std::string("Crash"))
+    {
+    abort();
+    }
+  else if (OperationType == std::string("Wait"))
+    {
+    std::this_thread::sleep_for(std::chrono::seconds(60));
+    }
   else
     {
     std::cerr << "Unknown OperationType:" << OperationType << std::endl;
@@ -0,0 +1,254 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SlicerLogic includes
+#include <vtkSlicerApplicationLogic.h>
+
+// MRMLCLI includes
+#include <vtkMRMLCommandLineModuleNode.h>
+#include <vtkSlicerCLIModuleLogic.h>
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include <vtkMRMLScene.h>
+
+// ModuleDescriptionParser includes
+#include <ModuleDescriptionParser.h>
+
+// VTK includes
+#include <vtkNew.h>
+
+// ITKSYS includes
+#include <itksys/Process.h>
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <unistd.h>
+
+// Test persistent CLI workers with the CLIModule4Test executable, which is
+// built with the CLI library wrapper (SEMCommandLineLibraryWrapper.cxx.in).
+
+namespace
+{
+
+std::string ExecutablePath;
+std::string OutputFile;
+
+//----------------------------------------------------------------------------
+std::string readOutputFile()
+{
+  std::ifstream file(OutputFile.c_str());
+  std::string content;
+  file >> content;
+  return content;
+}
+
+//----------------------------------------------------------------------------
+bool sendWorkerRequest(int requestPipe, const std::vector<std::string>& arguments)
+{
+  std::ostringstream request;
+  request << arguments.size() << "\n";
+  for (const std::string& argument : arguments)
+    {
+    request << argument.size() << "\n" << argument << "\n";
+    }
+  const std::string data = request.str();
+  return write(requestPipe, data.data(), data.size()) == static_cast<ssize_t>(data.size());
+}
+
+//----------------------------------------------------------------------------
+bool waitForWorkerOutput(itksysProcess* process, const std::string& stdoutTag, const std::string& stderrTag,
+                         std::string& stdoutBuffer, std::string& stderrBuffer)
+{
+  double timeout = 30.;
+  char* data = nullptr;
+  int length = 0;
+  int pipeId;
+  while ((stdoutBuffer.find(stdoutTag) == std::string::npos || stderrBuffer.find(stderrTag) == std::string::npos)
+    && (pipeId = itksysProcess_WaitForData(process, &data, &length, &timeout)) != 0
+    && pipeId != itksysProcess_Pipe_Timeout)
+    {
+    (pipeId == itksysProcess_Pipe_STDOUT ? stdoutBuffer : stderrBuffer).append(data, length);
+    }
+  return stdoutBuffer.find(stdoutTag) != std::string::npos && stderrBuffer.find(stderrTag) != std::string::npos;
+}
+
+//----------------------------------------------------------------------------
+int testWorkerProtocol()
+{
+  int requestPipe[2];
+  CHECK_INT(pipe(requestPipe), 0);
+  const char* command[] = { ExecutablePath.c_str(), "--slicer-cli-worker", nullptr };
+  itksysProcess* process = itksysProcess_New();
+  itksysProcess_SetCommand(process, command);
+  itksysProcess_SetPipeNative(process, itksysProcess_Pipe_STDIN, requestPipe);
+  itksysProcess_Execute(process);
+  close(requestPipe[0]);
+
+  // The worker announces itself
+  std::string stdoutBuffer;
+  std::string stderrBuffer;
+  CHECK_BOOL(waitForWorkerOutput(process, "<slicer-cli-worker-ready/>", "", stdoutBuffer, stderrBuffer), true);
+
+  // Each request runs the module and reports the exit value and the end of the run
+  std::vector<std::string> arguments = {
+    "--inputvalue1", "4", "--inputvalue2", "3", "--operationtype", "Addition", OutputFile };
+  CHECK_BOOL(sendWorkerRequest(requestPipe[1], arguments), true);
+  stdoutBuffer.clear();
+  CHECK_BOOL(waitForWorkerOutput(process, "</slicer-cli-worker-exit>", "<slicer-cli-worker-end/>",
+    stdoutBuffer, stderrBuffer), true);
+  CHECK_BOOL(stdoutBuffer.find("<slicer-cli-worker-exit>0</slicer-cli-worker-exit>") != std::string::npos, true);
+  CHECK_STD_STRING(readOutputFile(), "7");
+
+  // The same process runs the next request, failure is reported in the exit value
+  arguments[5] = "Fail";
+  CHECK_BOOL(sendWorkerRequest(requestPipe[1], arguments), true);
+  stdoutBuffer.clear();
+  stderrBuffer.clear();
+  CHECK_BOOL(waitForWorkerOutput(process, "</slicer-cli-worker-exit>", "<slicer-cli-worker-end/>",
+    stdoutBuffer, stderrBuffer), true);
+  CHECK_BOOL(stdoutBuffer.find("<slicer-cli-worker-exit>1</slicer-cli-worker-exit>") != std::string::npos, true);
+  CHECK_BOOL(stderrBuffer.find("Unknown OperationType:Fail") != std::string::npos, true);
+
+  // A request without arguments stops the worker
+  CHECK_BOOL(sendWorkerRequest(requestPipe[1], std::vector<std::string>()), true);
+  close(requestPipe[1]);
+  double timeout = 30.;
+  CHECK_INT(itksysProcess_WaitForExit(process, &timeout), 1);
+  CHECK_INT(itksysProcess_GetState(process), itksysProcess_State_Exited);
+  CHECK_INT(itksysProcess_GetExitValue(process), 0);
+  itksysProcess_Delete(process);
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+vtkMRMLCommandLineModuleNode* runModule(vtkSlicerCLIModuleLogic* logic, const char* operationType)
+{
+  vtkMRMLCommandLineModuleNode* node = logic->CreateNodeInScene();
+  node->SetParameterAsInt("InputValue1", 4);
+  node->SetParameterAsInt("InputValue2", 3);
+  node->SetParameterAsString("OperationType", operationType);
+  node->SetParameterAsString("OutputFile", OutputFile);
+  logic->ApplyAndWait(node, false);
+  return node;
+}
+
+//----------------------------------------------------------------------------
+int testPersistentWorkers(const std::string& xmlFile)
+{
+  std::ifstream xmlStream(xmlFile.c_str());
+  std::stringstream xml;
+  xml << xmlStream.rdbuf();
+  ModuleDescription description;
+  ModuleDescriptionParser parser;
+  CHECK_INT(parser.Parse(xml.str(), description), 0);
+  description.SetType("CommandLineModule");
+  description.SetTarget(ExecutablePath);
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkSlicerApplicationLogic> appLogic;
+  appLogic->SetMRMLScene(scene.GetPointer());
+  vtkNew<vtkSlicerCLIModuleLogic> logic;
+  logic->SetMRMLApplicationLogic(appLogic.GetPointer());
+  logic->SetMRMLScene(scene.GetPointer());
+  logic->SetDefaultModuleDescription(description);
+  logic->SetUsePersistentWorkers(1);
+  logic->SetMaximumNumberOfWorkerRuns(2);
+
+  // The worker is kept after the run
+  vtkMRMLCommandLineModuleNode* node = runModule(logic.GetPointer(), "Addition");
+  CHECK_INT(node->GetStatus(), vtkMRMLCommandLineModuleNode::Completed);
+  CHECK_STD_STRING(readOutputFile(), "7");
+  CHECK_INT(logic->GetNumberOfIdleWorkers(), 1);
+
+  // The same worker runs the second execution, then it is recycled
+  node = runModule(logic.GetPointer(), "Multiplication");
+  CHECK_INT(node->GetStatus(), vtkMRMLCommandLineModuleNode::Completed);
+  CHECK_STD_STRING(readOutputFile(), "12");
+  CHECK_INT(logic->GetNumberOfIdleWorkers(), 0);
+
+  // Module failure is reported, the worker is kept
+  node = runModule(logic.GetPointer(), "Fail");
+  CHECK_INT(node->GetStatus(), vtkMRMLCommandLineModuleNode::CompletedWithErrors);
+  CHECK_INT(logic->GetNumberOfIdleWorkers(), 1);
+
+  // A crashed worker is not reused, next run starts a new worker
+  node = runModule(logic.GetPointer(), "Crash");
+  CHECK_INT(node->GetStatus(), vtkMRMLCommandLineModuleNode::CompletedWithErrors);
+  CHECK_INT(logic->GetNumberOfIdleWorkers(), 0);
+  node = runModule(logic.GetPointer(), "Addition");
+  CHECK_INT(node->GetStatus(), vtkMRMLCommandLineModuleNode::Completed);
+  CHECK_STD_STRING(readOutputFile(), "7");
+  CHECK_INT(logic->GetNumberOfIdleWorkers(), 1);
+
+  // A cancelled worker is killed and not reused
+  vtkMRMLCommandLineModuleNode* waitNode = logic->CreateNodeInScene();
+  waitNode->SetParameterAsString("OperationType", "Wait");
+  waitNode->SetParameterAsString("OutputFile", OutputFile);
+  std::thread cancelThread([waitNode]()
+    {
+    for (int i = 0; i < 1000 && waitNode->GetStatus() != vtkMRMLCommandLineModuleNode::Running; ++i)
+      {
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+      }
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    waitNode->Cancel();
+    });
+  std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();
+  logic->ApplyAndWait(waitNode, false);
+  cancelThread.join();
+  std::chrono::duration<double> runTime = std::chrono::steady_clock::now() - startTime;
+  CHECK_INT(waitNode->GetStatus(), vtkMRMLCommandLineModuleNode::Cancelled);
+  CHECK_BOOL(runTime.count() < 30., true);
+  CHECK_INT(logic->GetNumberOfIdleWorkers(), 0);
+  node = runModule(logic.GetPointer(), "Multiplication");
+  CHECK_INT(node->GetStatus(), vtkMRMLCommandLineModuleNode::Completed);
+  CHECK_STD_STRING(readOutputFile(), "12");
+
+  logic->StopIdleWorkers();
+  CHECK_INT(logic->GetNumberOfIdleWorkers(), 0);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogicTest1(int argc, char * argv[])
+{
+  if (argc < 4)
+    {
+    std::cerr << "Usage: vtkSlicerCLIModuleLogicTest1 /path/to/CLIModule4Test /path/to/CLIModule4Test.xml /path/to/temp"
+              << std::endl;
+    return EXIT_FAILURE;
+    }
+  ExecutablePath = argv[1];
+  OutputFile = std::string(argv[3]) + "/vtkSlicerCLIModuleLogicTest1.txt";
+  itksys::SystemTools::RemoveFile(OutputFile);
+
+  CHECK_EXIT_SUCCESS(testWorkerProtocol());
+  CHECK_EXIT_SUCCESS(testPersistentWorkers(argv[2]));
+
+  itksys::SystemTools::RemoveFile(OutputFile);
+  return EXIT_SUCCESS;
+}
@@ -105,6 +105,11 @@ vtkMRMLAbstractLogic* qSlicerCLIModule::createLogic()
     logic->SetAllowInMemoryTransfer(0);
     }
 
+  if (d->Desc.GetParameterValue("PersistentWorker") == "true")
+    {
+    logic->SetUsePersistentWorkers(1);
+    }
+
   return logic;
 }
 
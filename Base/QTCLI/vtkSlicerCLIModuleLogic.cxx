@@ -55,16 +55,50 @@
 // STL includes
 #include <algorithm>
 #include <cassert>
+#include <cerrno>
+#include <chrono>
 #include <ctime>
+#include <map>
 #include <mutex>
 #include <set>
+#include <thread>
 
 #ifdef _WIN32
 #else
+#include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
 #endif
 
+//----------------------------------------------------------------------------
+// Persistent worker protocol, must match SEMCommandLineLibraryWrapper.cxx.in
+namespace
+{
+const char WorkerFlag[] = "--slicer-cli-worker";
+const char WorkerReadyTag[] = "<slicer-cli-worker-ready/>";
+const char WorkerExitEndTag[] = "</slicer-cli-worker-exit>";
+const char WorkerEndTag[] = "<slicer-cli-worker-end/>";
+// Time given to a worker to start and announce itself
+const double WorkerStartupTimeout = 10.;
+// Time given to a worker to exit when stopped
+const double WorkerStopTimeout = 1.;
+
+// Modules may run concurrently in the application processing threads,
+// while the process environment and the standard streams are shared.
+std::mutex ProcessEnvironmentLock;
+std::mutex StandardStreamsLock;
+
+// Report the progress of a module as the progress of the task that runs it
+void UpdateCurrentTaskProgress(vtkMRMLCommandLineModuleNode* node)
+{
+  vtkSlicerTask* task = vtkSlicerTask::GetCurrentTask();
+  if (task)
+    {
+    task->SetProgress(node->GetModuleDescription().GetProcessInformation()->Progress);
+    }
+}
+}
+
 //----------------------------------------------------------------------------
 struct DigitsToCharacters
 {
@@ -205,6 +239,239 @@ public:
   std::mutex ProcessesKillLock;
   std::vector<itksysProcess*> Processes;
 
+  /// Long-lived process running successive executions of a module
+  struct Worker
+  {
+    std::string Key;
+    itksysProcess* Process = nullptr;
+    /// Socket connected to the standard input of the worker
+    int RequestSocket = -1;
+    int NumberOfRuns = 0;
+    std::chrono::steady_clock::time_point LastRunTime;
+  };
+
+  int UsePersistentWorkers;
+  int MaximumNumberOfWorkerRuns;
+  double WorkerIdleTimeout;
+
+  std::mutex WorkersLock;
+  std::multimap<std::string, Worker> IdleWorkers;
+  /// Commands that failed to start in worker mode
+  std::set<std::string> UnsupportedWorkerCommands;
+
+  /// Get an idle worker for the command or start a new one.
+  /// Return false if the command does not support the worker mode.
+  bool AcquireWorker(const std::vector<std::string>& command, Worker& worker)
+  {
+#ifdef _WIN32
+    (void)command;
+    (void)worker;
+    return false;
+#else
+    std::string key;
+    for (const std::string& argument : command)
+      {
+      key += argument + "\n";
+      }
+      {
+      std::lock_guard<std::mutex> lock(this->WorkersLock);
+      this->StopExpiredWorkers();
+      if (this->UnsupportedWorkerCommands.count(key))
+        {
+        return false;
+        }
+      std::multimap<std::string, Worker>::iterator it = this->IdleWorkers.find(key);
+      if (it != this->IdleWorkers.end())
+        {
+        worker = it->second;
+        this->IdleWorkers.erase(it);
+        return true;
+        }
+      }
+    if (!this->StartWorker(command, worker))
+      {
+      std::lock_guard<std::mutex> lock(this->WorkersLock);
+      this->UnsupportedWorkerCommands.insert(key);
+      return false;
+      }
+    worker.Key = key;
+    return true;
+#endif
+  }
+
+  /// Give back a worker that completed a run, it is recycled if it ran
+  /// too many times.
+  void ReleaseWorker(Worker& worker)
+  {
+    ++worker.NumberOfRuns;
+    worker.LastRunTime = std::chrono::steady_clock::now();
+    if (worker.NumberOfRuns >= this->MaximumNumberOfWorkerRuns)
+      {
+      vtkInternal::StopWorker(worker);
+      return;
+      }
+    std::lock_guard<std::mutex> lock(this->WorkersLock);
+    this->IdleWorkers.insert(std::make_pair(worker.Key, worker));
+  }
+
+  /// Stop the idle workers that have not run for longer than the timeout.
+  /// WorkersLock must be locked by the caller.
+  void StopExpiredWorkers()
+  {
+    std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    std::multimap<std::string, Worker>::iterator it = this->IdleWorkers.begin();
+    while (it != this->IdleWorkers.end())
+      {
+      std::chrono::duration<double> idleTime = now - it->second.LastRunTime;
+      if (idleTime.count() > this->WorkerIdleTimeout)
+        {
+        vtkInternal::StopWorker(it->second);
+        it = this->IdleWorkers.erase(it);
+        }
+      else
+        {
+        ++it;
+        }
+      }
+  }
+
+  void StopIdleWorkers()
+  {
+    std::lock_guard<std::mutex> lock(this->WorkersLock);
+    for (std::pair<const std::string, Worker>& idleWorker : this->IdleWorkers)
+      {
+      vtkInternal::StopWorker(idleWorker.second);
+      }
+    this->IdleWorkers.clear();
+  }
+
+#ifndef _WIN32
+  /// Start the command in worker mode and wait for it to be ready.
+  static bool StartWorker(const std::vector<std::string>& command, Worker& worker)
+  {
+    int sockets[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, sockets) != 0)
+      {
+      return false;
+      }
+#ifdef SO_NOSIGPIPE
+    int noSigPipe = 1;
+    setsockopt(sockets[1], SOL_SOCKET, SO_NOSIGPIPE, &noSigPipe, sizeof(noSigPipe));
+#endif
+
+    std::vector<const char*> workerCommand;
+    for (const std::string& argument : command)
+      {
+      workerCommand.push_back(argument.c_str());
+      }
+    workerCommand.push_back(WorkerFlag);
+    workerCommand.push_back(nullptr);
+
+    itksysProcess* process = itksysProcess_New();
+    itksysProcess_SetCommand(process, &workerCommand[0]);
+    itksysProcess_SetOption(process, itksysProcess_Option_Detach, 0);
+    itksysProcess_SetOption(process, itksysProcess_Option_HideWindow, 1);
+    itksysProcess_SetPipeNative(process, itksysProcess_Pipe_STDIN, sockets);
+    itksysProcess_Execute(process);
+    close(sockets[0]);
+
+    // Executables that do not support the worker mode exit (or time out)
+    // without announcing themselves.
+    std::string output;
+    bool ready = false;
+    double timeout = WorkerStartupTimeout;
+    char* data = nullptr;
+    int length = 0;
+    int pipe;
+    while (!ready
+           && (pipe = itksysProcess_WaitForData(process, &data, &length, &timeout)) != 0
+           && pipe != itksysProcess_Pipe_Timeout)
+      {
+      if (pipe == itksysProcess_Pipe_STDOUT)
+        {
+        output.append(data, length);
+        ready = (output.find(WorkerReadyTag) != std::string::npos);
+        }
+      }
+    if (!ready)
+      {
+      itksysProcess_Kill(process);
+      itksysProcess_WaitForExit(process, nullptr);
+      itksysProcess_Delete(process);
+      close(sockets[1]);
+      return false;
+      }
+    worker.Process = process;
+    worker.RequestSocket = sockets[1];
+    worker.NumberOfRuns = 0;
+    worker.LastRunTime = std::chrono::steady_clock::now();
+    return true;
+  }
+#endif
+
+  /// Send the arguments of a module execution to the worker
+  static bool SendWorkerRequest(Worker& worker, const std::vector<std::string>& arguments)
+  {
+#ifdef _WIN32
+    (void)worker;
+    (void)arguments;
+    return false;
+#else
+    std::ostringstream request;
+    request << arguments.size() << "\n";
+    for (const std::string& argument : arguments)
+      {
+      request << argument.size() << "\n" << argument << "\n";
+      }
+    const std::string data = request.str();
+#ifdef MSG_NOSIGNAL
+    const int flags = MSG_NOSIGNAL;
+#else
+    const int flags = 0;
+#endif
+    size_t written = 0;
+    while (written < data.size())
+      {
+      ssize_t result = send(worker.RequestSocket, data.data() + written, data.size() - written, flags);
+      if (result < 0)
+        {
+        if (errno == EINTR)
+          {
+          continue;
+          }
+        return false;
+        }
+      written += static_cast<size_t>(result);
+      }
+    return true;
+#endif
+  }
+
+  /// Ask the worker to exit, kill it if it does not.
+  static void StopWorker(Worker& worker)
+  {
+    if (worker.RequestSocket >= 0)
+      {
+      std::vector<std::string> noArguments;
+      vtkInternal::SendWorkerRequest(worker, noArguments);
+#ifndef _WIN32
+      close(worker.RequestSocket);
+#endif
+      worker.RequestSocket = -1;
+      }
+    if (worker.Process)
+      {
+      double timeout = WorkerStopTimeout;
+      if (!itksysProcess_WaitForExit(worker.Process, &timeout))
+        {
+        itksysProcess_Kill(worker.Process);
+        itksysProcess_WaitForExit(worker.Process, nullptr);
+        }
+      itksysProcess_Delete(worker.Process);
+      worker.Process = nullptr;
+      }
+  }
+
   typedef std::vector<std::pair<vtkMTimeType, vtkMRMLCommandLineModuleNode*> > RequestType;
   struct FindRequest
   {
@@ -300,6 +567,9 @@ vtkSlicerCLIModuleLogic::vtkSlicerCLIModuleLogic()
 
   this->Internal->DeleteTemporaryFiles = 1;
   this->Internal->AllowInMemoryTransfer = 1;
+  this->Internal->UsePersistentWorkers = 0;
+  this->Internal->MaximumNumberOfWorkerRuns = 100;
+  this->Internal->WorkerIdleTimeout = 300.;
   this->Internal->RedirectModuleStreams = 1;
   this->Internal->RescheduleCallback =
     vtkSmartPointer<vtkSlicerCLIRescheduleCallback>::New();
@@ -316,6 +586,7 @@ vtkSlicerCLIModuleLogic::~vtkSlicerCLIModuleLogic()
 {
   this->RemoveObserver(this->Internal->OneShotCallbackCallback);
 
+  this->Internal->StopIdleWorkers();
   delete this->Internal;
 }
 
@@ -432,6 +703,75 @@ int vtkSlicerCLIModuleLogic::GetRedirectModuleStreams() const
   return this->Internal->RedirectModuleStreams;
 }
 
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetUsePersistentWorkers(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting UsePersistentWorkers to " << value);
+  if (this->Internal->UsePersistentWorkers != value)
+    {
+    this->Internal->UsePersistentWorkers = value;
+    this->Modified();
+    }
+  if (!value)
+    {
+    this->StopIdleWorkers();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetUsePersistentWorkers() const
+{
+  return this->Internal->UsePersistentWorkers;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetMaximumNumberOfWorkerRuns(int value)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting MaximumNumberOfWorkerRuns to " << value);
+  value = std::max(value, 1);
+  if (this->Internal->MaximumNumberOfWorkerRuns != value)
+    {
+    this->Internal->MaximumNumberOfWorkerRuns = value;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetMaximumNumberOfWorkerRuns() const
+{
+  return this->Internal->MaximumNumberOfWorkerRuns;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::SetWorkerIdleTimeout(double seconds)
+{
+  vtkDebugMacro(<< this->GetClassName() << " (" << this << "): setting WorkerIdleTimeout to " << seconds);
+  if (this->Internal->WorkerIdleTimeout != seconds)
+    {
+    this->Internal->WorkerIdleTimeout = seconds;
+    this->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+double vtkSlicerCLIModuleLogic::GetWorkerIdleTimeout() const
+{
+  return this->Internal->WorkerIdleTimeout;
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerCLIModuleLogic::StopIdleWorkers()
+{
+  this->Internal->StopIdleWorkers();
+}
+
+//----------------------------------------------------------------------------
+int vtkSlicerCLIModuleLogic::GetNumberOfIdleWorkers()
+{
+  std::lock_guard<std::mutex> lock(this->Internal->WorkersLock);
+  return static_cast<int>(this->Internal->IdleWorkers.size());
+}
+
 //----------------------------------------------------------------------------
 std::string
 vtkSlicerCLIModuleLogic
@@ -510,12 +850,11 @@ vtkSlicerCLIModuleLogic
   // running instances of slicer will not collide).  The filename
   // will be unique to the node in the process (the same node will be
   // encoded to the same filename every time within that running
-  // instance of Slicer).  This last point is an optimization to
-  // minimize the number of times a file is written when running a
-  // module.  However, if we change the execution model such that more
-  // than one module can run at the same time within the same Slicer
-  // process, then this encoding will need to be changed to be unique
-  // per module execution.
+  // instance of Slicer and processing thread).  This last point is an
+  // optimization to minimize the number of times a file is written when
+  // running a module.  As more than one module can run at the same time
+  // within the same Slicer process, the thread running the module is
+  // encoded too so that the filename is unique per module execution.
   //
 
   // Encode process id into a string.  To avoid confusing the
@@ -525,6 +864,7 @@ vtkSlicerCLIModuleLogic
 #else
   pidString << getpid();
 #endif
+  pidString << "_" << std::hash<std::thread::id>()(std::this_thread::get_id());
   pid = pidString.str();
   std::transform(pid.begin(), pid.end(), pid.begin(), DigitsToCharacters());
 
@@ -1836,6 +2176,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     // statically linked to the executable.
     // Historically, there was an nvidia driver bug that causes the module
     // to fail on exit with undefined symbol.
+     std::unique_lock<std::mutex> environmentLock(ProcessEnvironmentLock);
      std::string saveITKAutoLoadPath;
      itksys::SystemTools::GetEnv("ITK_AUTOLOAD_PATH", saveITKAutoLoadPath);
      std::string emptyString("ITK_AUTOLOAD_PATH=");
@@ -1848,20 +2189,50 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     //
     // now run the process
     //
-    itksysProcess *process = itksysProcess_New();
+    itksysProcess *process = nullptr;
+
+    // If enabled, hand the arguments over to a persistent worker started
+    // with the executable (and its location) instead of starting a new process
+    vtkInternal::Worker worker;
+    bool useWorker = false;
+    if (this->GetUsePersistentWorkers())
+      {
+      size_t numberOfCommandArguments = (commandLineAsString[0] != node0->GetModuleDescription().GetTarget()) ? 2 : 1;
+      std::vector<std::string> workerCommand(
+        commandLineAsString.begin(), commandLineAsString.begin() + numberOfCommandArguments);
+      std::vector<std::string> workerArguments(
+        commandLineAsString.begin() + numberOfCommandArguments, commandLineAsString.end());
+      useWorker = this->Internal->AcquireWorker(workerCommand, worker);
+      if (useWorker && !vtkInternal::SendWorkerRequest(worker, workerArguments))
+        {
+        vtkWarningMacro("Failed to send the request to the "
+                        << node0->GetModuleDescription().GetTitle() << " worker, starting a new process.");
+        vtkInternal::StopWorker(worker);
+        useWorker = false;
+        }
+      if (useWorker)
+        {
+        process = worker.Process;
+        }
+      }
 
-    this->Internal->Processes.push_back(process);
+    if (!process)
+      {
+      process = itksysProcess_New();
 
-    // setup the command
-    itksysProcess_SetCommand(process, command);
-    itksysProcess_SetOption(process,
-                            itksysProcess_Option_Detach, 0);
-    itksysProcess_SetOption(process,
-                            itksysProcess_Option_HideWindow, 1);
-    // itksysProcess_SetTimeout(process, 5.0); // 5 seconds
+      // setup the command
+      itksysProcess_SetCommand(process, command);
+      itksysProcess_SetOption(process,
+                              itksysProcess_Option_Detach, 0);
+      itksysProcess_SetOption(process,
+                              itksysProcess_Option_HideWindow, 1);
+      // itksysProcess_SetTimeout(process, 5.0); // 5 seconds
 
-    // execute the command
-    itksysProcess_Execute(process);
+      // execute the command
+      itksysProcess_Execute(process);
+      }
+
+    this->Internal->Processes.push_back(process);
 
     // restore the load path
     std::string putEnvString = ("ITK_AUTOLOAD_PATH=");
@@ -1872,6 +2243,7 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       {
       vtkErrorMacro( "Unable to restore ITK_AUTOLOAD_PATH. ");
       }
+    environmentLock.unlock();
 
     // Wait for the command to finish
     char *tbuffer;
@@ -1883,6 +2255,11 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     std::string stderrbuffer;
     std::string::size_type tagend;
     std::string::size_type tagstart;
+    bool workerRunCompleted = false;
+    bool workerExitTagFound = false;
+    bool workerEndTagFound = false;
+    const std::string::size_type workerExitEndTagLength = strlen(WorkerExitEndTag);
+    const std::string::size_type workerEndTagLength = strlen(WorkerEndTag);
     while ((pipe = itksysProcess_WaitForData(process ,&tbuffer,
                                              &length, &timeout)) != 0)
       {
@@ -1900,6 +2277,13 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
         itksysProcess_Kill(process);
         this->Internal->Processes.erase(
               std::find(this->Internal->Processes.begin(), this->Internal->Processes.end(), process));
+        if (useWorker)
+          {
+          // the killed worker can't be reused
+          useWorker = false;
+          worker.Process = nullptr;
+          vtkInternal::StopWorker(worker);
+          }
         node0->GetModuleDescription().GetProcessInformation()->Progress = 0;
         node0->GetModuleDescription().GetProcessInformation()->StageProgress =0;
         this->GetApplicationLogic()->RequestModified( node0 );
@@ -1912,7 +2296,14 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
         if (pipe == itksysProcess_Pipe_STDOUT)
           {
           //std::cout << "STDOUT: " << std::string(tbuffer, length) << std::endl;
+          // the tag may span the previous and the new data
+          std::string::size_type tagSearchStart =
+            stdoutbuffer.size() > workerExitEndTagLength ? stdoutbuffer.size() - workerExitEndTagLength : 0;
           stdoutbuffer = stdoutbuffer.append(tbuffer, length);
+          if (useWorker && !workerExitTagFound)
+            {
+            workerExitTagFound = (stdoutbuffer.find(WorkerExitEndTag, tagSearchStart) != std::string::npos);
+            }
 
           bool foundTag = false;
           // search for the last occurrence of </filter-progress>
@@ -1971,18 +2362,48 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
             }
           if (foundTag)
             {
+            UpdateCurrentTaskProgress(node0);
             this->GetApplicationLogic()->RequestModified( node0 );
             }
           }
         else if (pipe == itksysProcess_Pipe_STDERR)
           {
+          std::string::size_type tagSearchStart =
+            stderrbuffer.size() > workerEndTagLength ? stderrbuffer.size() - workerEndTagLength : 0;
           stderrbuffer = stderrbuffer.append(tbuffer, length);
+          if (useWorker && !workerEndTagFound)
+            {
+            workerEndTagFound = (stderrbuffer.find(WorkerEndTag, tagSearchStart) != std::string::npos);
+            }
           }
         }
+
+      // A worker does not exit after the run, it reports the end of
+      // the run on both streams instead.
+      if (useWorker && workerExitTagFound && workerEndTagFound)
+        {
+        workerRunCompleted = true;
+        break;
+        }
+      }
+    int workerExitValue = 0;
+    if (workerRunCompleted)
+      {
+      itksys::RegularExpression workerExitRegExp("[ \t\n\r]*<slicer-cli-worker-exit>([^<]*)</slicer-cli-worker-exit>[ \t\n\r]*");
+      if (workerExitRegExp.find(stdoutbuffer))
+        {
+        workerExitValue = atoi(workerExitRegExp.match(1).c_str());
+        stdoutbuffer.erase(workerExitRegExp.start(),
+                           workerExitRegExp.end() - workerExitRegExp.start());
+        }
+      stderrbuffer.erase(stderrbuffer.find(WorkerEndTag), strlen(WorkerEndTag) + 1);
+      }
+    else
+      {
+      this->Internal->ProcessesKillLock.lock();
+      itksysProcess_WaitForExit(process, nullptr);
+      this->Internal->ProcessesKillLock.unlock();
       }
-    this->Internal->ProcessesKillLock.lock();
-    itksysProcess_WaitForExit(process, nullptr);
-    this->Internal->ProcessesKillLock.unlock();
 
     // remove the embedded XML from the stdout stream
     //
@@ -2063,6 +2484,32 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       node0->SetStatus(vtkMRMLCommandLineModuleNode::Cancelled, false);
       this->GetApplicationLogic()->RequestModified(node0);
       }
+    else if (workerRunCompleted)
+      {
+      if (workerExitValue == 0)
+        {
+        std::stringstream information;
+        information << node0->GetModuleDescription().GetTitle()
+                    << " completed without errors" << std::endl;
+        qDebug() << information.str().c_str();
+        }
+      else
+        {
+        std::stringstream information;
+        information << node0->GetModuleDescription().GetTitle()
+                    << " completed with errors" << std::endl;
+        vtkErrorMacro( << information.str().c_str() );
+        node0->SetStatus(vtkMRMLCommandLineModuleNode::CompletedWithErrors, false);
+        this->GetApplicationLogic()->RequestModified( node0 );
+        }
+
+      // give the worker back to the pool
+      this->Internal->ProcessesKillLock.lock();
+      this->Internal->Processes.erase(
+            std::find(this->Internal->Processes.begin(), this->Internal->Processes.end(), process));
+      this->Internal->ProcessesKillLock.unlock();
+      this->Internal->ReleaseWorker(worker);
+      }
     else
       {
       int result = itksysProcess_GetState(process);
@@ -2146,6 +2593,12 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
       this->Internal->ProcessesKillLock.lock();
       this->Internal->Processes.erase(
             std::find(this->Internal->Processes.begin(), this->Internal->Processes.end(), process));
+      if (useWorker)
+        {
+        // the worker exited during the run
+        worker.Process = nullptr;
+        vtkInternal::StopWorker(worker);
+        }
       itksysProcess_Delete(process);
       this->Internal->ProcessesKillLock.unlock();
       }
@@ -2156,6 +2609,13 @@ void vtkSlicerCLIModuleLogic::ApplyTask(void *clientdata)
     //
     //
 
+    // std::cout and std::cerr are redirected for the whole process
+    std::unique_lock<std::mutex> streamsLock(StandardStreamsLock, std::defer_lock);
+    if (this->Internal->RedirectModuleStreams)
+      {
+      streamsLock.lock();
+      }
+
     std::ostringstream coutstringstream;
     std::ostringstream cerrstringstream;
     std::streambuf* origcoutrdbuf = std::cout.rdbuf();
@@ -2615,6 +3075,7 @@ void vtkSlicerCLIModuleLogic::ProgressCallback ( void *who )
 
   // All we need to do is tell the node that it was Modified.  The
   // shared object plugin modifies fields in the ProcessInformation directly.
+  UpdateCurrentTaskProgress(lnp->second);
   lnp->first->GetApplicationLogic()->RequestModified(lnp->second);
 }
 
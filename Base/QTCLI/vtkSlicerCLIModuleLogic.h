@@ -86,6 +86,33 @@ public:
   void SetRedirectModuleStreams(int value);
   int GetRedirectModuleStreams() const;
 
+  /// Control use of persistent worker processes for command line module
+  /// executables. When enabled, the executable is started once in worker
+  /// mode and runs the successive executions of the module, which saves the
+  /// process startup cost (loading libraries, registering ITK factories...)
+  /// for each run. Only executables built with the CLI library wrapper
+  /// support worker mode; others are run as usual. Disabled by default
+  /// because the module must not keep global state between runs.
+  /// \sa SetMaximumNumberOfWorkerRuns(), SetWorkerIdleTimeout()
+  void SetUsePersistentWorkers(int value);
+  int GetUsePersistentWorkers() const;
+
+  /// Number of executions after which a worker process is recycled (stopped
+  /// and replaced by a new process on next run). Default is 100.
+  void SetMaximumNumberOfWorkerRuns(int value);
+  int GetMaximumNumberOfWorkerRuns() const;
+
+  /// Time in seconds after which an idle worker process is stopped.
+  /// Default is 300s.
+  void SetWorkerIdleTimeout(double seconds);
+  double GetWorkerIdleTimeout() const;
+
+  /// Stop all the worker processes that are not running the module.
+  void StopIdleWorkers();
+
+  /// Number of worker processes that are waiting for the next execution.
+  int GetNumberOfIdleWorkers();
+
   /// Schedules the command line module to run.
   /// The CLI is scheduled to be run in a separate thread. This methods
   /// is non blocking and returns immediately.
@@ -132,7 +159,12 @@ protected:
   std::string FindHiddenNodeID(const ModuleDescription& d,
                                const ModuleParameter& p);
 
-  // The method that runs the command line module
+  // The method that runs the command line module.
+  // It runs in a processing thread, possibly at the same time as other
+  // modules (see vtkSlicerApplicationLogic::SetNumberOfProcessingThreads()).
+  // It must not modify the MRML scene or invoke events on nodes: node
+  // changes are made without invoking events (e.g. SetStatus(status, false))
+  // and are signaled in the main thread using RequestModified().
   void ApplyTask(void *clientdata);
 
   // Communicate progress back to the node
@@ -86,6 +86,7 @@
 
 // MRML includes
 #include <vtkCacheManager.h>
+#include <vtkEventBroker.h>
 #include <vtkMRMLCrosshairNode.h>
 #ifdef Slicer_BUILD_CLI_SUPPORT
 # include <vtkMRMLCommandLineModuleNode.h>
@@ -161,6 +162,29 @@ qSlicerCoreApplicationPrivate::~qSlicerCoreApplicationPrivate()
 #endif
 
   this->AppLogic->TerminateProcessingThread();
+  this->AppLogic->SetWakeUpMainThreadCallback(nullptr, nullptr);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCoreApplicationPrivate::wakeUpMainThreadForAppLogicRequest(void* clientData, unsigned long requestEvent)
+{
+  // Called from the processing threads: only post a call to the main event loop,
+  // which is thread-safe.
+  qSlicerCoreApplication* app = reinterpret_cast<qSlicerCoreApplication*>(clientData);
+  switch(requestEvent)
+    {
+    case vtkSlicerApplicationLogic::RequestModifiedEvent:
+      QMetaObject::invokeMethod(app, "processAppLogicModified", Qt::QueuedConnection);
+      break;
+    case vtkSlicerApplicationLogic::RequestReadDataEvent:
+      QMetaObject::invokeMethod(app, "processAppLogicReadData", Qt::QueuedConnection);
+      break;
+    case vtkSlicerApplicationLogic::RequestWriteDataEvent:
+      QMetaObject::invokeMethod(app, "processAppLogicWriteData", Qt::QueuedConnection);
+      break;
+    default:
+      break;
+    }
 }
 
 //-----------------------------------------------------------------------------
@@ -313,6 +337,10 @@ void qSlicerCoreApplicationPrivate::init()
               q, SLOT(onSlicerApplicationLogicRequest(vtkObject*,void*,ulong)));
   q->qvtkConnect(this->AppLogic, vtkSlicerApplicationLogic::RequestWriteDataEvent,
               q, SLOT(onSlicerApplicationLogicRequest(vtkObject*,void*,ulong)));
+  // Requests made by the processing threads wake up the main thread
+  // through the event loop instead of events.
+  this->AppLogic->SetWakeUpMainThreadCallback(
+    &qSlicerCoreApplicationPrivate::wakeUpMainThreadForAppLogicRequest, q);
   q->qvtkConnect(this->AppLogic, vtkMRMLApplicationLogic::PauseRenderEvent,
               q, SLOT(pauseRender()));
   q->qvtkConnect(this->AppLogic, vtkMRMLApplicationLogic::ResumeRenderEvent,
@@ -320,6 +348,14 @@ void qSlicerCoreApplicationPrivate::init()
   q->qvtkConnect(this->AppLogic->GetUserInformation(), vtkCommand::ModifiedEvent,
     q, SLOT(onUserInformationModified()));
 
+  // Events of observers that opted in for coalescing are deferred by the
+  // event broker and delivered at once in the next event loop iteration,
+  // before the views are rendered.
+  vtkEventBroker* eventBroker = vtkEventBroker::GetInstance();
+  q->qvtkConnect(eventBroker, vtkEventBroker::EventQueueProcessingRequestEvent,
+              q, SLOT(onEventBrokerQueueProcessingRequested()));
+  eventBroker->EventCoalescingOn();
+
   vtkMRMLThreeDViewDisplayableManagerFactory::GetInstance()->SetMRMLApplicationLogic(
     this->AppLogic.GetPointer());
   vtkMRMLSliceViewDisplayableManagerFactory::GetInstance()->SetMRMLApplicationLogic(
@@ -1655,6 +1691,20 @@ void qSlicerCoreApplication
     }
 }
 
+//-----------------------------------------------------------------------------
+void qSlicerCoreApplication::onEventBrokerQueueProcessingRequested()
+{
+  // Post the processing so that all events of the current call stack
+  // (e.g., a scripted batch of edits) are coalesced.
+  QMetaObject::invokeMethod(this, "processEventBrokerQueue", Qt::QueuedConnection);
+}
+
+//-----------------------------------------------------------------------------
+void qSlicerCoreApplication::processEventBrokerQueue()
+{
+  vtkEventBroker::GetInstance()->ProcessEventQueue();
+}
+
 //-----------------------------------------------------------------------------
 void qSlicerCoreApplication::processAppLogicModified()
 {
@@ -1690,6 +1740,9 @@ void qSlicerCoreApplication::onAboutToQuit()
 {
   Q_D(qSlicerCoreApplication);
 
+  // Deliver deferred events while modules are still loaded
+  vtkEventBroker::GetInstance()->EventCoalescingOff();
+
   d->ModuleManager->factoryManager()->unloadModules();
 
 #ifdef Slicer_USE_PYTHONQT
@@ -507,6 +507,12 @@ protected slots:
   virtual void onUserInformationModified();
   void onSlicerApplicationLogicRequest(vtkObject*, void* , unsigned long);
   void processAppLogicModified();
+
+  /// Called when the event broker has deferred events to deliver.
+  /// \sa vtkEventBroker::EventQueueProcessingRequestEvent, processEventBrokerQueue()
+  void onEventBrokerQueueProcessingRequested();
+  /// Deliver the events deferred by the event broker.
+  void processEventBrokerQueue();
   void processAppLogicReadData();
   void processAppLogicWriteData();
 
@@ -68,6 +68,11 @@ public:
 
   virtual void init();
 
+  /// Post the processing of the application logic requests to the main
+  /// thread. Called from the processing threads.
+  /// \sa vtkSlicerApplicationLogic::SetWakeUpMainThreadCallback()
+  static void wakeUpMainThreadForAppLogicRequest(void* clientData, unsigned long requestEvent);
+
   /// Terminates the calling process "immediately".
   void quickExit(int exitCode);
 
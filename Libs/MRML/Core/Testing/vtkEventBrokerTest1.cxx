@@ -0,0 +1,245 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Program:   3D Slicer
+
+=========================================================================auto=*/
+
+// MRML includes
+#include "vtkEventBroker.h"
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkObservation.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkCollection.h>
+#include <vtkIntArray.h>
+#include <vtkNew.h>
+
+// STD includes
+#include <fstream>
+#include <sstream>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void ModifyClientDataCallback(vtkObject* vtkNotUsed(caller),
+  unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+{
+  vtkObject* objectToModify = reinterpret_cast<vtkObject*>(clientData);
+  if (objectToModify)
+    {
+    objectToModify->Modified();
+    }
+}
+
+//----------------------------------------------------------------------------
+void CountCallback(vtkObject* vtkNotUsed(caller),
+  unsigned long vtkNotUsed(eid), void* clientData, void* vtkNotUsed(callData))
+{
+  int* count = reinterpret_cast<int*>(clientData);
+  ++(*count);
+}
+
+//----------------------------------------------------------------------------
+int TestEventProfiling(const std::string& tempDir)
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  CHECK_NOT_NULL(broker);
+
+  vtkNew<vtkIntArray> subject1;
+  vtkNew<vtkIntArray> subject2;
+  vtkNew<vtkCollection> observer;
+
+  // subject1 modified -> modifies subject2 -> nested invocation of the second observation
+  vtkNew<vtkCallbackCommand> modifySubject2Callback;
+  modifySubject2Callback->SetCallback(ModifyClientDataCallback);
+  modifySubject2Callback->SetClientData(subject2.GetPointer());
+  vtkObservation* observation1 = broker->AddObservation(
+    subject1.GetPointer(), vtkCommand::ModifiedEvent, observer.GetPointer(), modifySubject2Callback.GetPointer());
+  vtkNew<vtkCallbackCommand> emptyCallback;
+  emptyCallback->SetCallback(ModifyClientDataCallback);
+  vtkObservation* observation2 = broker->AddObservation(
+    subject2.GetPointer(), vtkCommand::ModifiedEvent, observer.GetPointer(), emptyCallback.GetPointer());
+  CHECK_NOT_NULL(observation1);
+  CHECK_NOT_NULL(observation2);
+
+  // Invocations are not recorded when profiling is off
+  subject1->Modified();
+  CHECK_INT(broker->GetNumberOfTraceEvents(), 0);
+  CHECK_INT(observation1->GetNumberOfInvocations(), 1);
+  CHECK_INT(observation2->GetNumberOfInvocations(), 1);
+
+  broker->EventProfilingOn();
+  const int numberOfModifications = 5;
+  for (int i = 0; i < numberOfModifications; ++i)
+    {
+    subject1->Modified();
+    }
+  broker->EventProfilingOff();
+  subject1->Modified();
+
+  CHECK_INT(observation1->GetNumberOfInvocations(), numberOfModifications + 2);
+  CHECK_INT(observation2->GetNumberOfInvocations(), numberOfModifications + 2);
+  CHECK_BOOL(observation1->GetMaxElapsedTime() >= observation1->GetLastElapsedTime(), true);
+  CHECK_BOOL(observation1->GetTotalElapsedTime() >= observation1->GetMaxElapsedTime(), true);
+  CHECK_INT(broker->GetNumberOfTraceEvents(), 2 * numberOfModifications);
+
+  // Summary: one line per subject class, event, observer class combination.
+  // Both observations have the same classes but the nested one has different depth,
+  // so they are merged into a single line with maximum depth of 2.
+  std::string summary = broker->GetEventProfileSummary();
+  std::cout << summary << std::endl;
+  std::stringstream summaryStream(summary);
+  std::string line;
+  int numberOfLines = 0;
+  while (std::getline(summaryStream, line))
+    {
+    ++numberOfLines;
+    }
+  CHECK_INT(numberOfLines, 2); // header + one combination
+  CHECK_BOOL(summary.find("vtkIntArray:ModifiedEvent -> vtkCollection") != std::string::npos, true);
+  std::stringstream expectedCounts;
+  expectedCounts << 2 * numberOfModifications << "      2  vtkIntArray";
+  CHECK_BOOL(summary.find(expectedCounts.str()) != std::string::npos, true);
+
+  // Chrome trace
+  std::string traceFileName = tempDir + "/vtkEventBrokerTest1.json";
+  CHECK_INT(broker->WriteEventProfileTraceFile(traceFileName.c_str()), 0);
+  std::ifstream traceFile(traceFileName.c_str());
+  std::stringstream traceStream;
+  traceStream << traceFile.rdbuf();
+  std::string trace = traceStream.str();
+  CHECK_BOOL(trace.compare(0, 15, "{\"traceEvents\":") == 0, true);
+  CHECK_BOOL(trace.find("\"ph\":\"X\"") != std::string::npos, true);
+  CHECK_BOOL(trace.find("\"depth\":2") != std::string::npos, true);
+
+  std::string summaryFileName = tempDir + "/vtkEventBrokerTest1.txt";
+  CHECK_INT(broker->WriteEventProfileSummaryFile(summaryFileName.c_str()), 0);
+
+  // Trace length limit
+  broker->ResetEventProfile();
+  CHECK_INT(broker->GetNumberOfTraceEvents(), 0);
+  broker->SetMaximumNumberOfTraceEvents(3);
+  broker->EventProfilingOn();
+  for (int i = 0; i < numberOfModifications; ++i)
+    {
+    subject1->Modified();
+    }
+  broker->EventProfilingOff();
+  CHECK_INT(broker->GetNumberOfTraceEvents(), 3);
+  expectedCounts.str("");
+  expectedCounts << 2 * numberOfModifications << "      2  vtkIntArray";
+  CHECK_BOOL(broker->GetEventProfileSummary().find(expectedCounts.str()) != std::string::npos, true);
+
+  broker->ResetEventProfile();
+  broker->SetMaximumNumberOfTraceEvents(1000000);
+  broker->RemoveObservations(observer.GetPointer());
+  CHECK_INT(broker->GetNumberOfObservations(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestEventCoalescing()
+{
+  vtkEventBroker* broker = vtkEventBroker::GetInstance();
+  CHECK_INT(broker->GetEventCoalescing(), 0);
+
+  vtkNew<vtkIntArray> subject;
+  vtkNew<vtkCollection> coalescedObserver;
+  vtkNew<vtkIntArray> immediateObserver;
+
+  int coalescedModifiedCount = 0;
+  vtkNew<vtkCallbackCommand> coalescedModifiedCallback;
+  coalescedModifiedCallback->SetCallback(CountCallback);
+  coalescedModifiedCallback->SetClientData(&coalescedModifiedCount);
+  broker->AddObservation(subject.GetPointer(), vtkCommand::ModifiedEvent,
+    coalescedObserver.GetPointer(), coalescedModifiedCallback.GetPointer());
+
+  int immediateModifiedCount = 0;
+  vtkNew<vtkCallbackCommand> immediateModifiedCallback;
+  immediateModifiedCallback->SetCallback(CountCallback);
+  immediateModifiedCallback->SetClientData(&immediateModifiedCount);
+  broker->AddObservation(subject.GetPointer(), vtkCommand::ModifiedEvent,
+    immediateObserver.GetPointer(), immediateModifiedCallback.GetPointer());
+
+  // Count requests for processing the queue
+  int processingRequestCount = 0;
+  vtkNew<vtkCallbackCommand> processingRequestCallback;
+  processingRequestCallback->SetCallback(CountCallback);
+  processingRequestCallback->SetClientData(&processingRequestCount);
+  broker->AddObserver(vtkEventBroker::EventQueueProcessingRequestEvent, processingRequestCallback.GetPointer());
+
+  // Opting in without enabling coalescing has no effect
+  broker->AddCoalescedObserverClass("vtkCollection");
+  subject->Modified();
+  CHECK_INT(coalescedModifiedCount, 1);
+  CHECK_INT(immediateModifiedCount, 1);
+  CHECK_INT(broker->GetNumberOfQueuedObservations(), 0);
+
+  // Many modifications result in a single invocation for the opted in class
+  broker->EventCoalescingOn();
+  const int numberOfModifications = 10;
+  for (int i = 0; i < numberOfModifications; ++i)
+    {
+    subject->Modified();
+    }
+  CHECK_INT(coalescedModifiedCount, 1);
+  CHECK_INT(immediateModifiedCount, 1 + numberOfModifications);
+  CHECK_INT(broker->GetNumberOfQueuedObservations(), 1);
+  CHECK_INT(processingRequestCount, 1);
+  broker->ProcessEventQueue();
+  CHECK_INT(coalescedModifiedCount, 2);
+  CHECK_INT(broker->GetNumberOfQueuedObservations(), 0);
+
+  // Disabling coalescing delivers pending events
+  subject->Modified();
+  CHECK_INT(processingRequestCount, 2);
+  broker->EventCoalescingOff();
+  CHECK_INT(coalescedModifiedCount, 3);
+  CHECK_INT(broker->GetNumberOfQueuedObservations(), 0);
+
+  // Removed opt-in
+  broker->EventCoalescingOn();
+  broker->RemoveCoalescedObserverClass("vtkCollection");
+  subject->Modified();
+  CHECK_INT(coalescedModifiedCount, 4);
+  CHECK_INT(broker->GetNumberOfQueuedObservations(), 0);
+
+  // Pending invocations are dropped when the subject is deleted
+  // (DeleteEvent is processed immediately)
+  broker->AddCoalescedObserverClass("vtkCollection");
+  subject->Modified();
+  CHECK_INT(broker->GetNumberOfQueuedObservations(), 1);
+  subject.Reset();
+  CHECK_INT(broker->GetNumberOfQueuedObservations(), 0);
+  broker->ProcessEventQueue();
+
+  broker->RemoveAllCoalescedObserverClasses();
+  broker->EventCoalescingOff();
+  broker->RemoveObserver(processingRequestCallback.GetPointer());
+  CHECK_INT(broker->GetNumberOfObservations(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkEventBrokerTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkEventBrokerTest1 /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  CHECK_EXIT_SUCCESS(TestEventProfiling(argv[1]));
+  CHECK_EXIT_SUCCESS(TestEventCoalescing());
+  return EXIT_SUCCESS;
+}
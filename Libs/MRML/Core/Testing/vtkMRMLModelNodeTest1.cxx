@@ -15,16 +15,32 @@
 #include "vtkMRMLModelNode.h"
 #include "vtkMRMLScene.h"
 
+// vtkAddon includes
+#include <vtkOrientedGridTransform.h>
+
 // VTK includes
 #include <vtkDataSetAttributes.h>
+#include <vtkGeneralTransform.h>
+#include <vtkImageData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkPointData.h>
+#include <vtkPoints.h>
 #include <vtkPolyData.h>
 #include <vtkSphereSource.h>
+#include <vtkThinPlateSplineTransform.h>
+#include <vtkTransform.h>
+#include <vtkTransformFilter.h>
 #include <vtkUnstructuredGrid.h>
 
+// STD includes
+#include <algorithm>
+
 //---------------------------------------------------------------------------
 int ExerciseBasicMethods();
 int TestActiveScalars();
 int TestGetSetMesh();
+int TestApplyNonLinearTransform();
 
 //---------------------------------------------------------------------------
 int vtkMRMLModelNodeTest1(int , char * [] )
@@ -32,6 +48,7 @@ int vtkMRMLModelNodeTest1(int , char * [] )
   CHECK_EXIT_SUCCESS(ExerciseBasicMethods());
   CHECK_EXIT_SUCCESS(TestActiveScalars());
   CHECK_EXIT_SUCCESS(TestGetSetMesh());
+  CHECK_EXIT_SUCCESS(TestApplyNonLinearTransform());
   return EXIT_SUCCESS;
 }
 
@@ -153,3 +170,109 @@ int TestGetSetMesh()
 
   return EXIT_SUCCESS;
 }
+
+//---------------------------------------------------------------------------
+int CheckApplyNonLinearTransform(vtkAbstractTransform* transform)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(50.0);
+  sphere->SetThetaResolution(60);
+  sphere->SetPhiResolution(60);
+  sphere->Update();
+
+  // Reference result
+  vtkNew<vtkTransformFilter> transformFilter;
+  transformFilter->SetInputConnection(sphere->GetOutputPort());
+  transformFilter->SetTransform(transform);
+  transformFilter->Update();
+  vtkPointSet* expectedMesh = transformFilter->GetOutput();
+
+  vtkNew<vtkPolyData> poly;
+  poly->DeepCopy(sphere->GetOutput());
+  vtkNew<vtkMRMLModelNode> modelNode;
+  modelNode->SetAndObserveMesh(poly.GetPointer());
+  modelNode->ApplyTransform(transform);
+
+  vtkPointSet* mesh = modelNode->GetMesh();
+  CHECK_POINTER(mesh, poly.GetPointer());
+  CHECK_INT(mesh->GetNumberOfPoints(), expectedMesh->GetNumberOfPoints());
+  CHECK_NOT_NULL(mesh->GetPointData()->GetNormals());
+  double maxPointDifference = 0.0;
+  double maxNormalDifference = 0.0;
+  for (vtkIdType pointId = 0; pointId < mesh->GetNumberOfPoints(); ++pointId)
+    {
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double expectedPoint[3] = { 0.0, 0.0, 0.0 };
+    mesh->GetPoint(pointId, point);
+    expectedMesh->GetPoint(pointId, expectedPoint);
+    maxPointDifference = std::max(maxPointDifference, sqrt(vtkMath::Distance2BetweenPoints(point, expectedPoint)));
+    double normal[3] = { 0.0, 0.0, 0.0 };
+    double expectedNormal[3] = { 0.0, 0.0, 0.0 };
+    mesh->GetPointData()->GetNormals()->GetTuple(pointId, normal);
+    expectedMesh->GetPointData()->GetNormals()->GetTuple(pointId, expectedNormal);
+    maxNormalDifference = std::max(maxNormalDifference, sqrt(vtkMath::Distance2BetweenPoints(normal, expectedNormal)));
+    }
+  std::cout << "Maximum point difference: " << maxPointDifference << std::endl;
+  std::cout << "Maximum normal difference: " << maxNormalDifference << std::endl;
+  CHECK_BOOL(maxPointDifference < 1e-3, true);
+  CHECK_BOOL(maxNormalDifference < 1e-4, true);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int TestApplyNonLinearTransform()
+{
+  // Inverse thin-plate spline transform, as it is typically the case for hardening.
+  // It is not thread-safe, therefore it is applied using vtkTransformFilter.
+  vtkNew<vtkPoints> sourceLandmarks;
+  vtkNew<vtkPoints> targetLandmarks;
+  const double landmarks[4][3] = { {-50, 0, 0}, {50, 0, 0}, {0, 50, 0}, {0, 0, 50} };
+  for (int i = 0; i < 4; ++i)
+    {
+    sourceLandmarks->InsertNextPoint(landmarks[i]);
+    targetLandmarks->InsertNextPoint(landmarks[i][0] * 1.2, landmarks[i][1] + 5.0, landmarks[i][2] * 0.8);
+    }
+  vtkNew<vtkThinPlateSplineTransform> tps;
+  tps->SetSourceLandmarks(sourceLandmarks.GetPointer());
+  tps->SetTargetLandmarks(targetLandmarks.GetPointer());
+  tps->SetBasisToR();
+  vtkNew<vtkGeneralTransform> tpsTransform;
+  tpsTransform->Concatenate(tps->GetInverse());
+  CHECK_EXIT_SUCCESS(CheckApplyNonLinearTransform(tpsTransform.GetPointer()));
+
+  // Linear transform concatenated with an inverse grid transform,
+  // transformed in parallel by the model node.
+  vtkNew<vtkImageData> displacementGrid;
+  displacementGrid->SetDimensions(12, 12, 12);
+  displacementGrid->SetOrigin(-80.0, -80.0, -80.0);
+  displacementGrid->SetSpacing(15.0, 15.0, 15.0);
+  displacementGrid->AllocateScalars(VTK_DOUBLE, 3);
+  for (int k = 0; k < 12; ++k)
+    {
+    for (int j = 0; j < 12; ++j)
+      {
+      for (int i = 0; i < 12; ++i)
+        {
+        double* displacement = static_cast<double*>(displacementGrid->GetScalarPointer(i, j, k));
+        displacement[0] = 3.0 * sin(j * 0.3);
+        displacement[1] = 2.0 * cos(k * 0.2);
+        displacement[2] = 0.05 * (i * 15.0 - 80.0);
+        }
+      }
+    }
+  vtkNew<vtkMatrix4x4> gridDirectionMatrix;
+  vtkNew<vtkOrientedGridTransform> gridTransform;
+  gridTransform->SetDisplacementGridData(displacementGrid.GetPointer());
+  gridTransform->SetGridDirectionMatrix(gridDirectionMatrix.GetPointer());
+  gridTransform->SetInterpolationModeToCubic();
+  vtkNew<vtkTransform> linearTransform;
+  linearTransform->Translate(5.0, -3.0, 2.0);
+  linearTransform->RotateZ(10.0);
+  vtkNew<vtkGeneralTransform> gridConcatenatedTransform;
+  gridConcatenatedTransform->Concatenate(linearTransform.GetPointer());
+  gridConcatenatedTransform->Concatenate(gridTransform->GetInverse());
+  CHECK_EXIT_SUCCESS(CheckApplyNonLinearTransform(gridConcatenatedTransform.GetPointer()));
+
+  return EXIT_SUCCESS;
+}
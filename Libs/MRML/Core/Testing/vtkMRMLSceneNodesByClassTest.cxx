@@ -0,0 +1,169 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLLinearTransformNode.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+namespace
+{
+
+int nodesByClass();
+int nodesByClassAfterInsert();
+int nodesByClassPerformance(int numberOfNodes);
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodesByClassTest(int vtkNotUsed(argc),
+                                 char * vtkNotUsed(argv)[] )
+{
+  CHECK_EXIT_SUCCESS(nodesByClass());
+  CHECK_EXIT_SUCCESS(nodesByClassAfterInsert());
+  CHECK_EXIT_SUCCESS(nodesByClassPerformance(1000));
+  CHECK_EXIT_SUCCESS(nodesByClassPerformance(4000));
+  CHECK_EXIT_SUCCESS(nodesByClassPerformance(8000));
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+int nodesByClass()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  // Query before adding nodes, to make sure the index is kept up-to-date
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTransformNode"), 0);
+  CHECK_NULL(scene->GetFirstNodeByClass("vtkMRMLTransformNode"));
+
+  vtkNew<vtkMRMLLinearTransformNode> transformNode1;
+  scene->AddNode(transformNode1.GetPointer());
+  vtkNew<vtkMRMLModelNode> modelNode;
+  scene->AddNode(modelNode.GetPointer());
+  vtkNew<vtkMRMLLinearTransformNode> transformNode2;
+  scene->AddNode(transformNode2.GetPointer());
+
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTransformNode"), 2);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLLinearTransformNode"), 2);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 1);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLNode"), 3);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLVolumeNode"), 0);
+  CHECK_POINTER(scene->GetNthNodeByClass(0, "vtkMRMLTransformNode"), transformNode1.GetPointer());
+  CHECK_POINTER(scene->GetNthNodeByClass(1, "vtkMRMLTransformNode"), transformNode2.GetPointer());
+  CHECK_NULL(scene->GetNthNodeByClass(2, "vtkMRMLTransformNode"));
+  CHECK_POINTER(scene->GetNthNodeByClass(1, "vtkMRMLNode"), modelNode.GetPointer());
+
+  std::vector<vtkMRMLNode*> nodes;
+  CHECK_INT(scene->GetNodesByClass("vtkMRMLDisplayableNode", nodes), 3);
+  // previous content of the vector is replaced
+  CHECK_INT(scene->GetNodesByClass("vtkMRMLTransformNode", nodes), 2);
+  CHECK_INT(static_cast<int>(nodes.size()), 2);
+
+  scene->RemoveNode(transformNode1.GetPointer());
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLTransformNode"), 1);
+  CHECK_POINTER(scene->GetFirstNodeByClass("vtkMRMLTransformNode"), transformNode2.GetPointer());
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLNode"), 2);
+
+  vtkSmartPointer<vtkCollection> collection = vtkSmartPointer<vtkCollection>::Take(
+    scene->GetNodesByClass("vtkMRMLNode"));
+  CHECK_INT(collection->GetNumberOfItems(), 2);
+  CHECK_POINTER(collection->GetItemAsObject(0), modelNode.GetPointer());
+
+  scene->Clear(1);
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLNode"), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int nodesByClassAfterInsert()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkMRMLModelNode> modelNode1;
+  scene->AddNode(modelNode1.GetPointer());
+  vtkNew<vtkMRMLModelNode> modelNode2;
+  scene->AddNode(modelNode2.GetPointer());
+  CHECK_POINTER(scene->GetFirstNodeByClass("vtkMRMLModelNode"), modelNode1.GetPointer());
+
+  // Inserted nodes must be returned in scene order
+  vtkNew<vtkMRMLModelNode> modelNode3;
+  scene->InsertBeforeNode(modelNode1.GetPointer(), modelNode3.GetPointer());
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 3);
+  CHECK_POINTER(scene->GetNthNodeByClass(0, "vtkMRMLModelNode"), modelNode3.GetPointer());
+  CHECK_POINTER(scene->GetNthNodeByClass(1, "vtkMRMLModelNode"), modelNode1.GetPointer());
+  CHECK_POINTER(scene->GetNthNodeByClass(2, "vtkMRMLModelNode"), modelNode2.GetPointer());
+
+  // Nodes added directly to the collection are picked up too
+  vtkNew<vtkMRMLModelNode> modelNode4;
+  scene->GetNodes()->AddItem(modelNode4.GetPointer());
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 4);
+  scene->GetNodes()->RemoveItem(modelNode4.GetPointer());
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), 3);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int nodesByClassPerformance(int numberOfNodes)
+{
+  // This test is for performance: the cost of looking up nodes by class
+  // should depend on the number of matching nodes, not on the scene size.
+  vtkNew<vtkMRMLScene> scene;
+
+  const int numberOfModelNodes = 10;
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkNew<vtkMRMLScriptedModuleNode> node;
+    scene->AddNode(node.GetPointer());
+    if (i % (numberOfNodes / numberOfModelNodes) == 0)
+      {
+      vtkNew<vtkMRMLModelNode> modelNode;
+      scene->AddNode(modelNode.GetPointer());
+      }
+    }
+  CHECK_INT(scene->GetNumberOfNodesByClass("vtkMRMLModelNode"), numberOfModelNodes);
+
+  const int numberOfQueries = 1000;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  std::vector<vtkMRMLNode*> nodes;
+  for (int i = 0; i < numberOfQueries; ++i)
+    {
+    scene->GetNumberOfNodesByClass("vtkMRMLModelNode");
+    scene->GetNthNodeByClass(numberOfModelNodes - 1, "vtkMRMLModelNode");
+    scene->GetNodesByClass("vtkMRMLDisplayableNode", nodes);
+    }
+  timer->StopTimer();
+
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-NodesByClassPerformance-"
+            << numberOfNodes << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
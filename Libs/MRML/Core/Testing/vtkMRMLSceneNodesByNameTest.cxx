@@ -0,0 +1,165 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLModelNode.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+
+// VTK includes
+#include <vtkCollection.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <sstream>
+
+namespace
+{
+
+int nodesByName();
+int nodesByNameAfterRename();
+int nodesByNamePerformance(int numberOfNodes);
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneNodesByNameTest(int vtkNotUsed(argc),
+                                char * vtkNotUsed(argv)[] )
+{
+  CHECK_EXIT_SUCCESS(nodesByName());
+  CHECK_EXIT_SUCCESS(nodesByNameAfterRename());
+  CHECK_EXIT_SUCCESS(nodesByNamePerformance(1000));
+  CHECK_EXIT_SUCCESS(nodesByNamePerformance(4000));
+  CHECK_EXIT_SUCCESS(nodesByNamePerformance(8000));
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+int nodesByName()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  CHECK_NULL(scene->GetFirstNodeByName("Model"));
+
+  vtkNew<vtkMRMLModelNode> modelNode1;
+  modelNode1->SetName("Model");
+  scene->AddNode(modelNode1.GetPointer());
+  vtkNew<vtkMRMLScriptedModuleNode> scriptedNode;
+  scriptedNode->SetName("Model");
+  scene->AddNode(scriptedNode.GetPointer());
+  vtkNew<vtkMRMLModelNode> modelNode2;
+  modelNode2->SetName("Model");
+  scene->AddNode(modelNode2.GetPointer());
+
+  CHECK_POINTER(scene->GetFirstNodeByName("Model"), modelNode1.GetPointer());
+  vtkSmartPointer<vtkCollection> nodes = vtkSmartPointer<vtkCollection>::Take(
+    scene->GetNodesByName("Model"));
+  CHECK_INT(nodes->GetNumberOfItems(), 3);
+  nodes = vtkSmartPointer<vtkCollection>::Take(
+    scene->GetNodesByClassByName("vtkMRMLModelNode", "Model"));
+  CHECK_INT(nodes->GetNumberOfItems(), 2);
+  CHECK_POINTER(nodes->GetItemAsObject(1), modelNode2.GetPointer());
+
+  CHECK_POINTER(scene->GetFirstNode("Model", "vtkMRMLScriptedModuleNode"), scriptedNode.GetPointer());
+  CHECK_POINTER(scene->GetFirstNode("Mod", "vtkMRMLScriptedModuleNode", nullptr, false), scriptedNode.GetPointer());
+  CHECK_NULL(scene->GetFirstNode("Mod", "vtkMRMLScriptedModuleNode"));
+
+  // Node IDs are found after the node is removed and added again
+  scene->RemoveNode(modelNode1.GetPointer());
+  CHECK_POINTER(scene->GetFirstNodeByName("Model"), scriptedNode.GetPointer());
+  scene->AddNode(modelNode1.GetPointer());
+  CHECK_POINTER(scene->GetNodeByID(modelNode1->GetID()), modelNode1.GetPointer());
+  CHECK_POINTER(scene->GetFirstNodeByName("Model"), scriptedNode.GetPointer());
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int nodesByNameAfterRename()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkMRMLModelNode> modelNode1;
+  modelNode1->SetName("First");
+  scene->AddNode(modelNode1.GetPointer());
+  vtkNew<vtkMRMLModelNode> modelNode2;
+  modelNode2->SetName("Second");
+  scene->AddNode(modelNode2.GetPointer());
+
+  // Rename with a unique name
+  modelNode2->SetName("Third");
+  CHECK_NULL(scene->GetFirstNodeByName("Second"));
+  CHECK_POINTER(scene->GetFirstNodeByName("Third"), modelNode2.GetPointer());
+
+  // Rename with an existing name: scene order must be preserved
+  modelNode1->SetName("Third");
+  CHECK_POINTER(scene->GetFirstNodeByName("Third"), modelNode1.GetPointer());
+  CHECK_NULL(scene->GetFirstNodeByName("First"));
+
+  // Renamed node is not tracked after it has been removed from the scene
+  scene->RemoveNode(modelNode1.GetPointer());
+  modelNode1->SetName("Removed");
+  CHECK_NULL(scene->GetFirstNodeByName("Removed"));
+  CHECK_POINTER(scene->GetFirstNodeByName("Third"), modelNode2.GetPointer());
+
+  // Unique names are generated using the name index
+  CHECK_STD_STRING(scene->GenerateUniqueName("Third"), "Third_1");
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int nodesByNamePerformance(int numberOfNodes)
+{
+  // This test is for performance: the cost of looking up nodes by name
+  // or ID should not depend on the scene size.
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    vtkNew<vtkMRMLScriptedModuleNode> node;
+    scene->AddNode(node.GetPointer());
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-AddNodePerformance-"
+            << numberOfNodes << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  const int numberOfQueries = 1000;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfQueries; ++i)
+    {
+    std::stringstream name;
+    name << "ScriptedModule_" << (i * numberOfNodes / numberOfQueries);
+    scene->GetFirstNodeByName(name.str().c_str());
+    scene->GetFirstNode(name.str().c_str(), "vtkMRMLScriptedModuleNode");
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-NodesByNamePerformance-"
+            << numberOfNodes << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
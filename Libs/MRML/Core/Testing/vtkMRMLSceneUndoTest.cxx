@@ -0,0 +1,330 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLScriptedModuleNode.h"
+#include "vtkMRMLSegmentationNode.h"
+#include "vtkMRMLTransformNode.h"
+
+// SegmentationCore includes
+#include <vtkOrientedImageData.h>
+#include <vtkSegment.h>
+#include <vtkSegmentationConverter.h>
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <string>
+#include <vector>
+
+namespace
+{
+
+int undoModifiedNodes();
+int undoAddRemoveNode();
+int undoMemoryLimit();
+int undoCustomModifiedEvent();
+int undoCopiedDataMemorySize();
+int undoPerformance(int numberOfNodes);
+
+vtkMRMLScriptedModuleNode* addUndoEnabledNode(vtkMRMLScene* scene, const std::string& value);
+
+} // end of anonymous namespace
+
+//---------------------------------------------------------------------------
+int vtkMRMLSceneUndoTest(int vtkNotUsed(argc),
+                         char * vtkNotUsed(argv)[] )
+{
+  CHECK_EXIT_SUCCESS(undoModifiedNodes());
+  CHECK_EXIT_SUCCESS(undoAddRemoveNode());
+  CHECK_EXIT_SUCCESS(undoMemoryLimit());
+  CHECK_EXIT_SUCCESS(undoCustomModifiedEvent());
+  CHECK_EXIT_SUCCESS(undoCopiedDataMemorySize());
+  CHECK_EXIT_SUCCESS(undoPerformance(1000));
+  CHECK_EXIT_SUCCESS(undoPerformance(4000));
+  return EXIT_SUCCESS;
+}
+
+namespace
+{
+
+//---------------------------------------------------------------------------
+vtkMRMLScriptedModuleNode* addUndoEnabledNode(vtkMRMLScene* scene, const std::string& value)
+{
+  vtkNew<vtkMRMLScriptedModuleNode> node;
+  node->SetUndoEnabled(true);
+  node->SetParameter("Value", value);
+  scene->AddNode(node.GetPointer());
+  return node.GetPointer();
+}
+
+//---------------------------------------------------------------------------
+int undoModifiedNodes()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  vtkMRMLScriptedModuleNode* nodeA = addUndoEnabledNode(scene.GetPointer(), "A1");
+  vtkMRMLScriptedModuleNode* nodeB = addUndoEnabledNode(scene.GetPointer(), "B1");
+  vtkNew<vtkMRMLScriptedModuleNode> notUndoableNode;
+  notUndoableNode->SetParameter("Value", "C1");
+  scene->AddNode(notUndoableNode.GetPointer());
+
+  scene->SaveStateForUndo();
+  nodeA->SetParameter("Value", "A2");
+  notUndoableNode->SetParameter("Value", "C2");
+  scene->SaveStateForUndo();
+  nodeB->SetParameter("Value", "B2");
+  scene->SaveStateForUndo();
+  nodeA->SetParameter("Value", "A3");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 3);
+
+  // Only the states of the nodes that changed are saved in the
+  // second and third levels, the others are found in the levels below.
+  scene->Undo();
+  CHECK_STD_STRING(nodeA->GetParameter("Value"), "A2");
+  CHECK_STD_STRING(nodeB->GetParameter("Value"), "B2");
+  scene->Undo();
+  CHECK_STD_STRING(nodeA->GetParameter("Value"), "A2");
+  CHECK_STD_STRING(nodeB->GetParameter("Value"), "B1");
+  scene->Undo();
+  CHECK_STD_STRING(nodeA->GetParameter("Value"), "A1");
+  CHECK_STD_STRING(nodeB->GetParameter("Value"), "B1");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 3);
+  // Nodes that are not undo-enabled are not restored
+  CHECK_STD_STRING(notUndoableNode->GetParameter("Value"), "C2");
+
+  scene->Redo();
+  CHECK_STD_STRING(nodeA->GetParameter("Value"), "A2");
+  CHECK_STD_STRING(nodeB->GetParameter("Value"), "B1");
+  scene->Redo();
+  scene->Redo();
+  CHECK_STD_STRING(nodeA->GetParameter("Value"), "A3");
+  CHECK_STD_STRING(nodeB->GetParameter("Value"), "B2");
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 3);
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 0);
+
+  // Undo after redo
+  scene->Undo();
+  CHECK_STD_STRING(nodeA->GetParameter("Value"), "A2");
+  CHECK_STD_STRING(nodeB->GetParameter("Value"), "B2");
+
+  // Saving a new state clears the redo stack
+  nodeB->SetParameter("Value", "B3");
+  scene->SaveStateForUndo();
+  CHECK_INT(scene->GetNumberOfRedoLevels(), 0);
+  nodeA->SetParameter("Value", "A4");
+  scene->Undo();
+  CHECK_STD_STRING(nodeA->GetParameter("Value"), "A2");
+  CHECK_STD_STRING(nodeB->GetParameter("Value"), "B3");
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int undoAddRemoveNode()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  addUndoEnabledNode(scene.GetPointer(), "A1");
+
+  // Undo node addition
+  scene->SaveStateForUndo();
+  vtkSmartPointer<vtkMRMLScriptedModuleNode> nodeB = addUndoEnabledNode(scene.GetPointer(), "B1");
+  std::string nodeBID = nodeB->GetID();
+  scene->Undo();
+  CHECK_NULL(scene->GetNodeByID(nodeBID));
+  scene->Redo();
+  CHECK_POINTER(scene->GetNodeByID(nodeBID), nodeB.GetPointer());
+
+  // Undo node removal
+  nodeB->SetParameter("Value", "B2");
+  scene->SaveStateForUndo();
+  scene->RemoveNode(nodeB);
+  CHECK_NULL(scene->GetNodeByID(nodeBID));
+  scene->Undo();
+  vtkMRMLScriptedModuleNode* restoredNodeB =
+    vtkMRMLScriptedModuleNode::SafeDownCast(scene->GetNodeByID(nodeBID));
+  CHECK_NOT_NULL(restoredNodeB);
+  CHECK_STD_STRING(restoredNodeB->GetParameter("Value"), "B2");
+  scene->Redo();
+  CHECK_NULL(scene->GetNodeByID(nodeBID));
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int undoMemoryLimit()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  std::vector<vtkMRMLScriptedModuleNode*> nodes;
+  for (int i = 0; i < 100; ++i)
+    {
+    nodes.push_back(addUndoEnabledNode(scene.GetPointer(), "0"));
+    }
+
+  scene->SaveStateForUndo();
+  size_t firstLevelMemorySize = scene->GetUndoStackMemorySize();
+  CHECK_BOOL(firstLevelMemorySize > 0, true);
+
+  // Each additional level only stores the modified node
+  for (int i = 1; i <= 10; ++i)
+    {
+    nodes[0]->SetParameter("Value", std::to_string(i));
+    scene->SaveStateForUndo();
+    }
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 11);
+  CHECK_BOOL(scene->GetUndoStackMemorySize() < 2 * firstLevelMemorySize, true);
+
+  // Memory limit removes the oldest levels, but the unchanged
+  // node states are kept for the remaining levels.
+  scene->SetMaximumUndoStackMemorySize(firstLevelMemorySize);
+  CHECK_BOOL(scene->GetNumberOfUndoLevels() < 11, true);
+  CHECK_BOOL(scene->GetNumberOfUndoLevels() >= 1, true);
+  nodes[0]->SetParameter("Value", "modified");
+  nodes[1]->SetParameter("Value", "modified");
+  scene->Undo();
+  CHECK_STD_STRING(nodes[0]->GetParameter("Value"), "10");
+  CHECK_STD_STRING(nodes[1]->GetParameter("Value"), "0");
+
+  // Maximum number of levels is still respected
+  scene->SetMaximumUndoStackMemorySize(0);
+  scene->SetMaximumNumberOfSavedUndoStates(2);
+  for (int i = 0; i < 5; ++i)
+    {
+    scene->SaveStateForUndo();
+    }
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 2);
+
+  scene->ClearUndoStack();
+  CHECK_INT(scene->GetNumberOfUndoLevels(), 0);
+  CHECK_INT(static_cast<int>(scene->GetUndoStackMemorySize()), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int undoCustomModifiedEvent()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  vtkNew<vtkMRMLTransformNode> transformNode;
+  transformNode->SetUndoEnabled(true);
+  scene->AddNode(transformNode.GetPointer());
+  scene->SaveStateForUndo();
+
+  // Changing the matrix only invokes TransformModifiedEvent,
+  // the change must still be detected and saved.
+  vtkNew<vtkMatrix4x4> matrix;
+  matrix->SetElement(0, 3, 10.0);
+  transformNode->SetMatrixTransformToParent(matrix.GetPointer());
+  scene->SaveStateForUndo();
+  matrix->SetElement(0, 3, 20.0);
+  transformNode->SetMatrixTransformToParent(matrix.GetPointer());
+
+  vtkNew<vtkMatrix4x4> currentMatrix;
+  scene->Undo();
+  transformNode->GetMatrixTransformToParent(currentMatrix.GetPointer());
+  CHECK_DOUBLE(currentMatrix->GetElement(0, 3), 10.0);
+  scene->Undo();
+  transformNode->GetMatrixTransformToParent(currentMatrix.GetPointer());
+  CHECK_DOUBLE(currentMatrix->GetElement(0, 3), 0.0);
+  scene->Redo();
+  transformNode->GetMatrixTransformToParent(currentMatrix.GetPointer());
+  CHECK_DOUBLE(currentMatrix->GetElement(0, 3), 10.0);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int undoCopiedDataMemorySize()
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  vtkNew<vtkMRMLSegmentationNode> segmentationNode;
+  segmentationNode->SetUndoEnabled(true);
+  scene->AddNode(segmentationNode.GetPointer());
+  scene->SaveStateForUndo();
+  size_t emptyMemorySize = scene->GetUndoStackMemorySize();
+
+  // Segment representations are duplicated in the undo stack, they must be counted
+  const size_t labelmapSize = 100 * 100 * 10;
+  vtkNew<vtkOrientedImageData> labelmap;
+  labelmap->SetDimensions(100, 100, 10);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap.GetPointer());
+  segmentationNode->GetSegmentation()->AddSegment(segment.GetPointer());
+  scene->SaveStateForUndo();
+  CHECK_BOOL(scene->GetUndoStackMemorySize() >= emptyMemorySize + labelmapSize, true);
+  CHECK_BOOL(segmentationNode->GetCopiedDataMemorySize() >= labelmapSize, true);
+
+  return EXIT_SUCCESS;
+}
+
+//---------------------------------------------------------------------------
+int undoPerformance(int numberOfNodes)
+{
+  // This test is for performance: once the state of all nodes has been
+  // saved, the cost of saving a state should not depend on the scene size
+  // but on the number of modified nodes.
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+
+  std::vector<vtkMRMLScriptedModuleNode*> nodes;
+  for (int i = 0; i < numberOfNodes; ++i)
+    {
+    nodes.push_back(addUndoEnabledNode(scene.GetPointer(), "0"));
+    }
+  scene->SaveStateForUndo();
+
+  const int numberOfStates = 100;
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int i = 0; i < numberOfStates; ++i)
+    {
+    nodes[i % numberOfNodes]->SetParameter("Value", "1");
+    scene->SaveStateForUndo();
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-SaveStateForUndoPerformance-"
+            << numberOfNodes << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  timer->StartTimer();
+  while (scene->GetNumberOfUndoLevels() > 0)
+    {
+    scene->Undo();
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkMRMLScene-UndoPerformance-"
+            << numberOfNodes << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
@@ -22,6 +22,8 @@
 #include "vtkImageData.h"
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
+#include "vtkPoints.h"
+#include "vtkTimerLog.h"
 
 typedef double itkVectorComponentType;
 typedef itk::Vector<itkVectorComponentType, 3> itkVectorPixelType;
@@ -286,6 +288,95 @@ double getInverseErrorVtk(const double inputPoint[3], vtkOrientedGridTransform*
   return errorOfInverseComputation;
 }
 
+//----------------------------------------------------------------------------
+// Compare points transformed in a batch (in parallel) to points transformed one by one
+int getNumberOfBatchTransformMismatchesVtk(const double origin[3], const double spacing[3], const double dims[3],
+  vtkOrientedGridTransform* gridVtk, const char* measurementName)
+{
+  const int numberOfSamplesPerAxis = 50;
+  vtkNew<vtkPoints> inputPoints;
+  inputPoints->SetDataTypeToDouble();
+  for (int k = 0; k < numberOfSamplesPerAxis; k++)
+    {
+    for (int j = 0; j < numberOfSamplesPerAxis; j++)
+      {
+      for (int i = 0; i < numberOfSamplesPerAxis; i++)
+        {
+        inputPoints->InsertNextPoint(
+          origin[0] + spacing[0] * (dims[0] - 1) * i / numberOfSamplesPerAxis,
+          origin[1] + spacing[1] * (dims[1] - 1) * j / numberOfSamplesPerAxis,
+          origin[2] + spacing[2] * (dims[2] - 1) * k / numberOfSamplesPerAxis);
+        }
+      }
+    }
+
+  int numberOfMismatches = 0;
+  vtkNew<vtkTimerLog> timer;
+  for (int inverse = 0; inverse < 2; inverse++)
+    {
+    if (inverse)
+      {
+      gridVtk->Inverse();
+      }
+
+    vtkNew<vtkPoints> expectedOutputPoints;
+    expectedOutputPoints->SetDataTypeToDouble();
+    expectedOutputPoints->SetNumberOfPoints(inputPoints->GetNumberOfPoints());
+    timer->StartTimer();
+    for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); pointId++)
+      {
+      double outputPoint[3] = { 0.0, 0.0, 0.0 };
+      gridVtk->TransformPoint(inputPoints->GetPoint(pointId), outputPoint);
+      expectedOutputPoints->SetPoint(pointId, outputPoint);
+      }
+    timer->StopTimer();
+    double singlePointTime = timer->GetElapsedTime();
+
+    // Batch results are appended to existing points
+    vtkNew<vtkPoints> outputPoints;
+    outputPoints->SetDataTypeToDouble();
+    outputPoints->InsertNextPoint(1.0, 2.0, 3.0);
+    timer->StartTimer();
+    gridVtk->TransformPoints(inputPoints.GetPointer(), outputPoints.GetPointer());
+    timer->StopTimer();
+    double batchTime = timer->GetElapsedTime();
+
+    std::cout << "<DartMeasurement name=\"" << measurementName << (inverse ? "-Inverse" : "-Forward") << "-SinglePoint\" "
+              << "type=\"numeric/double\">" << singlePointTime << "</DartMeasurement>" << std::endl;
+    std::cout << "<DartMeasurement name=\"" << measurementName << (inverse ? "-Inverse" : "-Forward") << "-Batch\" "
+              << "type=\"numeric/double\">" << batchTime << "</DartMeasurement>" << std::endl;
+
+    if (outputPoints->GetNumberOfPoints() != inputPoints->GetNumberOfPoints() + 1
+      || outputPoints->GetPoint(0)[0] != 1.0)
+      {
+      std::cout << "ERROR: Batch transform output point list is invalid" << std::endl;
+      numberOfMismatches++;
+      }
+    else
+      {
+      for (vtkIdType pointId = 0; pointId < inputPoints->GetNumberOfPoints(); pointId++)
+        {
+        double* expectedOutputPoint = expectedOutputPoints->GetPoint(pointId);
+        double* outputPoint = outputPoints->GetPoint(pointId + 1);
+        if (fabs(outputPoint[0] - expectedOutputPoint[0]) > 1e-6
+          || fabs(outputPoint[1] - expectedOutputPoint[1]) > 1e-6
+          || fabs(outputPoint[2] - expectedOutputPoint[2]) > 1e-6)
+          {
+          std::cout << "ERROR: Batch transform result mismatch at point " << pointId << std::endl;
+          numberOfMismatches++;
+          }
+        }
+      }
+
+    if (inverse)
+      {
+      gridVtk->Inverse();
+      }
+    }
+
+  return numberOfMismatches;
+}
+
 //----------------------------------------------------------------------------
 int vtkOrientedGridTransformTest1(int , char * [] )
 {
@@ -418,13 +509,18 @@ int vtkOrientedGridTransformTest1(int , char * [] )
       }
     }
 
+  int numberOfBatchTransformMismatches = getNumberOfBatchTransformMismatchesVtk(origin, spacing, dims,
+    gridVtk.GetPointer(), "vtkOrientedGridTransform");
+
   std::cout << "Number of points tested: " << numberOfPointsTested << std::endl;
   std::cout << "Number of ITK/VTK mismatches: " << numberOfItkVtkPointMismatches << std::endl;
   std::cout << "Number of single/double precision mismatches: " << numberOfSingleDoubleVtkPointMismatches << std::endl;
   std::cout << "Number of derivative mismatches: " << numberOfDerivativeMismatches << std::endl;
   std::cout << "Number of inverse mismatches: " << numberOfInverseMismatches << std::endl;
+  std::cout << "Number of batch transform mismatches: " << numberOfBatchTransformMismatches << std::endl;
 
-  if (numberOfItkVtkPointMismatches==0 && numberOfDerivativeMismatches==0 && numberOfInverseMismatches==0)
+  if (numberOfItkVtkPointMismatches==0 && numberOfDerivativeMismatches==0 && numberOfInverseMismatches==0
+    && numberOfBatchTransformMismatches==0)
     {
     std::cout << "Test result: PASSED" << std::endl;
     return EXIT_SUCCESS;
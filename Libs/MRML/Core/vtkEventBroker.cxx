@@ -22,8 +22,59 @@
 #include <vtkObjectFactory.h>
 #include <vtkTimerLog.h>
 
+// STD includes
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
 vtkCxxSetObjectMacro(vtkEventBroker, TimerLog, vtkTimerLog);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+std::string GetEventName(unsigned long eid)
+{
+  const char* eventString = vtkCommand::GetStringFromEventId(eid);
+  if (!strcmp(eventString, "NoEvent"))
+    {
+    std::stringstream ss;
+    ss << eid;
+    return ss.str();
+    }
+  return eventString;
+}
+
+//----------------------------------------------------------------------------
+std::string EscapeJSONString(const std::string& str)
+{
+  std::string escaped;
+  escaped.reserve(str.size());
+  for (std::string::const_iterator it = str.begin(); it != str.end(); ++it)
+    {
+    switch (*it)
+      {
+      case '"': escaped += "\\\""; break;
+      case '\\': escaped += "\\\\"; break;
+      case '\n': escaped += "\\n"; break;
+      case '\r': escaped += "\\r"; break;
+      case '\t': escaped += "\\t"; break;
+      default:
+        if (static_cast<unsigned char>(*it) < 0x20)
+          {
+          escaped += ' ';
+          }
+        else
+          {
+          escaped += *it;
+          }
+      }
+    }
+  return escaped;
+}
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 // The IO manager singleton.
 // This MUST be default initialized to zero by the compiler and is
@@ -98,6 +149,10 @@ vtkEventBroker::vtkEventBroker()
   this->LogFileName = nullptr;
   this->ScriptHandler = nullptr;
   this->ScriptHandlerClientData = nullptr;
+  this->EventProfiling = 0;
+  this->MaximumNumberOfTraceEvents = 1000000;
+  this->EventProfileStartTime = -1.0;
+  this->EventCoalescing = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -668,6 +723,191 @@ void vtkEventBroker::LogEvent ( vtkObservation *observation )
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkEventBroker::RecordEventProfile ( vtkObservation *observation, unsigned long eid,
+                                          double startTime, double elapsedTime )
+{
+  std::string subjectClassName = observation->GetSubject()->GetClassName();
+  std::string eventName = GetEventName(eid);
+  std::string observerClassName = "No observer class";
+  if ( observation->GetScript() != nullptr )
+    {
+    observerClassName = observation->GetScript();
+    }
+  else if ( observation->GetObserver() )
+    {
+    observerClassName = observation->GetObserver()->GetClassName();
+    }
+
+  std::string key = subjectClassName + "\n" + eventName + "\n" + observerClassName;
+  int statisticsIndex = 0;
+  std::map< std::string, int >::iterator indexIt = this->EventProfileStatisticsIndexMap.find(key);
+  if ( indexIt == this->EventProfileStatisticsIndexMap.end() )
+    {
+    EventProfileStatistics statistics;
+    statistics.SubjectClassName = subjectClassName;
+    statistics.EventName = eventName;
+    statistics.ObserverClassName = observerClassName;
+    statistics.NumberOfInvocations = 0;
+    statistics.TotalElapsedTime = 0.0;
+    statistics.MaxElapsedTime = 0.0;
+    statistics.MaxNestingLevel = 0;
+    statisticsIndex = static_cast<int>(this->EventProfileStatisticsList.size());
+    this->EventProfileStatisticsList.push_back(statistics);
+    this->EventProfileStatisticsIndexMap[key] = statisticsIndex;
+    }
+  else
+    {
+    statisticsIndex = indexIt->second;
+    }
+
+  EventProfileStatistics& statistics = this->EventProfileStatisticsList[statisticsIndex];
+  statistics.NumberOfInvocations++;
+  statistics.TotalElapsedTime += elapsedTime;
+  statistics.MaxElapsedTime = std::max(statistics.MaxElapsedTime, elapsedTime);
+  statistics.MaxNestingLevel = std::max(statistics.MaxNestingLevel, this->EventNestingLevel);
+
+  if ( this->EventProfileStartTime < 0.0 || startTime < this->EventProfileStartTime )
+    {
+    this->EventProfileStartTime = startTime;
+    }
+  if ( static_cast<int>(this->EventProfileTrace.size()) < this->MaximumNumberOfTraceEvents )
+    {
+    EventProfileTraceEvent traceEvent;
+    traceEvent.StatisticsIndex = statisticsIndex;
+    traceEvent.StartTime = startTime;
+    traceEvent.ElapsedTime = elapsedTime;
+    traceEvent.NestingLevel = this->EventNestingLevel;
+    this->EventProfileTrace.push_back(traceEvent);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::ResetEventProfile ()
+{
+  this->EventProfileStatisticsList.clear();
+  this->EventProfileStatisticsIndexMap.clear();
+  this->EventProfileTrace.clear();
+  this->EventProfileStartTime = -1.0;
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::GetNumberOfTraceEvents ()
+{
+  return static_cast<int>( this->EventProfileTrace.size() );
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PrintEventProfileTrace ( ostream& os )
+{
+  // Complete events ("ph":"X") with timestamps and durations in microseconds.
+  // Nesting is reconstructed by the trace viewer from the time intervals.
+  std::ios::fmtflags previousFlags = os.flags();
+  std::streamsize previousPrecision = os.precision();
+  os << "{\"traceEvents\":[";
+  const char* separator = "\n";
+  std::vector< EventProfileTraceEvent >::const_iterator traceIt;
+  for (traceIt = this->EventProfileTrace.begin(); traceIt != this->EventProfileTrace.end(); ++traceIt)
+    {
+    const EventProfileStatistics& statistics = this->EventProfileStatisticsList[traceIt->StatisticsIndex];
+    std::string subject = EscapeJSONString(statistics.SubjectClassName);
+    std::string event = EscapeJSONString(statistics.EventName);
+    std::string observer = EscapeJSONString(statistics.ObserverClassName);
+    os << separator
+       << "{\"name\":\"" << subject << ":" << event << " -> " << observer << "\""
+       << ",\"cat\":\"" << event << "\""
+       << ",\"ph\":\"X\""
+       << ",\"ts\":" << std::fixed << std::setprecision(3)
+       << (traceIt->StartTime - this->EventProfileStartTime) * 1.0e6
+       << ",\"dur\":" << traceIt->ElapsedTime * 1.0e6
+       << ",\"pid\":1,\"tid\":1"
+       << ",\"args\":{\"subject\":\"" << subject << "\""
+       << ",\"event\":\"" << event << "\""
+       << ",\"observer\":\"" << observer << "\""
+       << ",\"depth\":" << traceIt->NestingLevel << "}}";
+    separator = ",\n";
+    }
+  os << "\n],\n\"displayTimeUnit\":\"ms\"}\n";
+  os.flags(previousFlags);
+  os.precision(previousPrecision);
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::WriteEventProfileTraceFile ( const char *traceFile )
+{
+  std::ofstream file;
+  file.open( traceFile, std::ios::out );
+  if ( file.fail() )
+    {
+    vtkErrorMacro( "could not write to " << (traceFile ? traceFile : "(null)") );
+    return 1;
+    }
+  this->PrintEventProfileTrace(file);
+  file.close();
+  return 0;
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::PrintEventProfileSummary ( ostream& os )
+{
+  std::vector< const EventProfileStatistics* > sortedStatistics;
+  std::vector< EventProfileStatistics >::const_iterator statisticsIt;
+  for (statisticsIt = this->EventProfileStatisticsList.begin();
+    statisticsIt != this->EventProfileStatisticsList.end(); ++statisticsIt)
+    {
+    sortedStatistics.push_back(&(*statisticsIt));
+    }
+  std::sort(sortedStatistics.begin(), sortedStatistics.end(),
+    [](const EventProfileStatistics* a, const EventProfileStatistics* b)
+    {
+    return a->TotalElapsedTime > b->TotalElapsedTime;
+    });
+
+  std::ios::fmtflags previousFlags = os.flags();
+  std::streamsize previousPrecision = os.precision();
+  os << std::setw(12) << "Total [ms]" << std::setw(12) << "Max [ms]" << std::setw(12) << "Mean [ms]"
+     << std::setw(10) << "Count" << std::setw(7) << "Depth"
+     << "  Subject:Event -> Observer\n";
+  os << std::fixed << std::setprecision(3);
+  std::vector< const EventProfileStatistics* >::const_iterator sortedIt;
+  for (sortedIt = sortedStatistics.begin(); sortedIt != sortedStatistics.end(); ++sortedIt)
+    {
+    const EventProfileStatistics* statistics = *sortedIt;
+    os << std::setw(12) << statistics->TotalElapsedTime * 1000.0
+       << std::setw(12) << statistics->MaxElapsedTime * 1000.0
+       << std::setw(12) << statistics->TotalElapsedTime * 1000.0 / statistics->NumberOfInvocations
+       << std::setw(10) << statistics->NumberOfInvocations
+       << std::setw(7) << statistics->MaxNestingLevel
+       << "  " << statistics->SubjectClassName << ":" << statistics->EventName
+       << " -> " << statistics->ObserverClassName << "\n";
+    }
+  os.flags(previousFlags);
+  os.precision(previousPrecision);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkEventBroker::GetEventProfileSummary ()
+{
+  std::stringstream ss;
+  this->PrintEventProfileSummary(ss);
+  return ss.str();
+}
+
+//----------------------------------------------------------------------------
+int vtkEventBroker::WriteEventProfileSummaryFile ( const char *summaryFile )
+{
+  std::ofstream file;
+  file.open( summaryFile, std::ios::out );
+  if ( file.fail() )
+    {
+    vtkErrorMacro( "could not write to " << (summaryFile ? summaryFile : "(null)") );
+    return 1;
+    }
+  this->PrintEventProfileSummary(file);
+  file.close();
+  return 0;
+}
+
 //----------------------------------------------------------------------------
 void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *caller, unsigned long eid, void *callData )
 {
@@ -681,11 +921,12 @@ void vtkEventBroker::ProcessEvent ( vtkObservation *observation, vtkObject *call
   //
   if ( eid == observation->GetEvent() || observation->GetEvent() == vtkCommand::AnyEvent )
     {
-    if ( this->EventMode == vtkEventBroker::Synchronous || eid == vtkCommand::DeleteEvent )
+    if ( eid == vtkCommand::DeleteEvent
+      || ( this->EventMode == vtkEventBroker::Synchronous && !this->IsObservationCoalesced( observation, eid ) ) )
       {
       this->InvokeObservation( observation, eid, callData );
       }
-    else if ( this->EventMode == vtkEventBroker::Asynchronous )
+    else if ( this->EventMode == vtkEventBroker::Synchronous || this->EventMode == vtkEventBroker::Asynchronous )
       {
       this->QueueObservation( observation, eid, callData );
       }
@@ -776,9 +1017,99 @@ void vtkEventBroker::QueueObservation ( vtkObservation *observation,
 
   if ( !observation->GetInEventQueue() )
     {
+    bool wasEmpty = this->EventQueue.empty();
     this->EventQueue.push_back( observation );
     observation->SetInEventQueue(1);
+    if ( wasEmpty )
+      {
+      this->InvokeEvent( vtkEventBroker::EventQueueProcessingRequestEvent );
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::SetEventCoalescing ( int eventCoalescing )
+{
+  if ( eventCoalescing == this->EventCoalescing )
+    {
+    return;
+    }
+  this->EventCoalescing = eventCoalescing;
+  if ( !this->EventCoalescing && this->EventMode == vtkEventBroker::Synchronous )
+    {
+    // deliver the events that have been deferred so far
+    this->ProcessEventQueue();
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::AddCoalescedObserverClass ( const char* className, unsigned long event )
+{
+  if ( className == nullptr )
+    {
+    vtkErrorMacro( "AddCoalescedObserverClass: invalid class name" );
+    return;
+    }
+  if ( event == vtkCommand::DeleteEvent )
+    {
+    vtkErrorMacro( "AddCoalescedObserverClass: DeleteEvent cannot be coalesced" );
+    return;
+    }
+  this->CoalescedObserverClasses[className].insert( event );
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::RemoveCoalescedObserverClass ( const char* className, unsigned long event )
+{
+  if ( className == nullptr )
+    {
+    return;
+    }
+  std::map< std::string, std::set< unsigned long > >::iterator classIt =
+    this->CoalescedObserverClasses.find( className );
+  if ( classIt == this->CoalescedObserverClasses.end() )
+    {
+    return;
+    }
+  classIt->second.erase( event );
+  if ( classIt->second.empty() )
+    {
+    this->CoalescedObserverClasses.erase( classIt );
     }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkEventBroker::RemoveAllCoalescedObserverClasses ()
+{
+  if ( this->CoalescedObserverClasses.empty() )
+    {
+    return;
+    }
+  this->CoalescedObserverClasses.clear();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkEventBroker::IsObservationCoalesced ( vtkObservation *observation, unsigned long eid )
+{
+  if ( !this->EventCoalescing || this->CoalescedObserverClasses.empty()
+    || eid == vtkCommand::DeleteEvent || observation->GetObserver() == nullptr )
+    {
+    return false;
+    }
+  std::map< std::string, std::set< unsigned long > >::iterator classIt;
+  for ( classIt = this->CoalescedObserverClasses.begin(); classIt != this->CoalescedObserverClasses.end(); ++classIt )
+    {
+    if ( classIt->second.find( eid ) != classIt->second.end()
+      && observation->GetObserver()->IsA( classIt->first.c_str() ) )
+      {
+      return true;
+      }
+    }
+  return false;
 }
 
 //----------------------------------------------------------------------------
@@ -841,7 +1172,13 @@ void vtkEventBroker::InvokeObservation ( vtkObservation *observation,
   double elapsedTime = this->TimerLog->GetUniversalTime() - startTime;
   observation->SetTotalElapsedTime (observation->GetTotalElapsedTime() + elapsedTime);
   observation->SetLastElapsedTime (elapsedTime);
+  observation->SetMaxElapsedTime (std::max(observation->GetMaxElapsedTime(), elapsedTime));
+  observation->SetNumberOfInvocations (observation->GetNumberOfInvocations() + 1);
   this->LogEvent (observation);
+  if ( this->EventProfiling )
+    {
+    this->RecordEventProfile (observation, eid, startTime, elapsedTime);
+    }
 
   // clear reference to observation (may cause delete)
   observation->Delete();
@@ -868,8 +1205,9 @@ void vtkEventBroker::ProcessEventQueue ()
       {
       vtkObservation::CallType call = observation->GetCallDataList()->front();
       observation->GetCallDataList()->pop_front();
-      finished = (observation->GetCallDataList()->size() == 0);
       this->InvokeObservation( observation, call.EventID, call.CallData );
+      // the invocation may have queued new call data for the same observation
+      finished = (observation->GetCallDataList()->size() == 0);
       if ( !observation->GetInEventQueue() )
         {
         observation->GetCallDataList()->clear();
@@ -877,7 +1215,12 @@ void vtkEventBroker::ProcessEventQueue ()
         break;
         }
       }
-    this->DequeueObservation();
+    // the observation may have been already removed from the queue
+    // (e.g., when it was removed from the broker during the invocation)
+    if ( observation->GetInEventQueue() )
+      {
+      this->DequeueObservation();
+      }
     observation->Delete();
     }
 }
@@ -894,6 +1237,21 @@ void vtkEventBroker::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "EventNestingLevel: " << this->EventNestingLevel << "\n";
   os << indent << "LogFileName: " <<
     (this->LogFileName ? this->LogFileName : "(none)") << "\n";
+  os << indent << "EventCoalescing: " << this->EventCoalescing << "\n";
+  os << indent << "CoalescedObserverClasses:";
+  std::map< std::string, std::set< unsigned long > >::iterator classIt;
+  for ( classIt = this->CoalescedObserverClasses.begin(); classIt != this->CoalescedObserverClasses.end(); ++classIt )
+    {
+    std::set< unsigned long >::iterator eventIt;
+    for ( eventIt = classIt->second.begin(); eventIt != classIt->second.end(); ++eventIt )
+      {
+      os << " " << classIt->first << "(" << GetEventName(*eventIt) << ")";
+      }
+    }
+  os << "\n";
+  os << indent << "EventProfiling: " << this->EventProfiling << "\n";
+  os << indent << "MaximumNumberOfTraceEvents: " << this->MaximumNumberOfTraceEvents << "\n";
+  os << indent << "NumberOfTraceEvents: " << this->GetNumberOfTraceEvents() << "\n";
 }
 
 //----------------------------------------------------------------------------
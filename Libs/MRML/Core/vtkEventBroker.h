@@ -19,6 +19,7 @@
 #include "vtkMRML.h"
 
 // VTK includes
+#include <vtkCommand.h>
 #include <vtkObject.h>
 class vtkTimerLog;
 
@@ -28,6 +29,7 @@ class vtkTimerLog;
 #include <set>
 #include <map>
 #include <fstream>
+#include <string>
 
 class vtkCollection;
 class vtkCallbackCommand;
@@ -168,6 +170,46 @@ public:
   /// based on the filename and the EventLogging variable)
   void LogEvent (vtkObservation *observation);
 
+  /// Event Profiling
+  ///
+  /// Turn on recording of invocation statistics and of a trace of invocations.
+  /// Statistics (number of invocations, total and maximum elapsed time, maximum
+  /// nesting level) are accumulated for each subject class, event, and observer
+  /// class (or script) combination. Elapsed times include nested invocations.
+  /// Turning profiling on does not clear previously recorded data,
+  /// use ResetEventProfile() for that.
+  vtkBooleanMacro (EventProfiling, int);
+  vtkSetMacro (EventProfiling, int);
+  vtkGetMacro (EventProfiling, int);
+
+  ///
+  /// Maximum number of invocations that are kept in the trace (default: 1000000).
+  /// Statistics are still collected after the trace is full.
+  vtkSetMacro (MaximumNumberOfTraceEvents, int);
+  vtkGetMacro (MaximumNumberOfTraceEvents, int);
+
+  ///
+  /// Clear all recorded statistics and trace events.
+  void ResetEventProfile();
+
+  ///
+  /// Number of invocations stored in the trace
+  int GetNumberOfTraceEvents();
+
+  ///
+  /// Write recorded invocations in Chrome trace event format (JSON),
+  /// which can be displayed by chrome://tracing or https://ui.perfetto.dev.
+  /// Returns 0 on success.
+  int WriteEventProfileTraceFile(const char* traceFile);
+  void PrintEventProfileTrace(ostream& os);
+
+  ///
+  /// Write a table of recorded statistics, sorted by total elapsed time.
+  /// Returns 0 on success.
+  int WriteEventProfileSummaryFile(const char* summaryFile);
+  void PrintEventProfileSummary(ostream& os);
+  std::string GetEventProfileSummary();
+
   /// Graph File
   ///
   /// Write out the current list of observations in graphviz format (.dot)
@@ -203,6 +245,41 @@ public:
   }
 
 
+  /// Event coalescing
+  ///
+  /// In synchronous mode, events of observers that opted in for coalescing
+  /// are not invoked immediately but added to the event queue, the same way
+  /// as in asynchronous mode. Each observation is queued only once, therefore
+  /// many events of the same subject result in a single invocation when the
+  /// queue is processed. DeleteEvent is never coalesced.
+  /// The application is notified by EventQueueProcessingRequestEvent when the
+  /// queue becomes non-empty and it is responsible for calling ProcessEventQueue()
+  /// (typically once per render frame, from the GUI event loop).
+  /// Coalescing is disabled by default, as without an application that processes
+  /// the queue events would never be delivered. Disabling it processes the queue.
+  virtual void SetEventCoalescing(int eventCoalescing);
+  vtkBooleanMacro (EventCoalescing, int);
+  vtkGetMacro (EventCoalescing, int);
+
+  ///
+  /// Enable coalescing of the event for all observers that are instances
+  /// of the class (or its subclasses). The observer is the object that was
+  /// specified in AddObservation (e.g., the owner of a vtkObserverManager).
+  void AddCoalescedObserverClass (const char* className, unsigned long event = vtkCommand::ModifiedEvent);
+  void RemoveCoalescedObserverClass (const char* className, unsigned long event = vtkCommand::ModifiedEvent);
+  void RemoveAllCoalescedObserverClasses ();
+
+  ///
+  /// Returns true if the invocation of the observation is deferred to
+  /// the processing of the event queue when the event is invoked.
+  bool IsObservationCoalesced (vtkObservation *observation, unsigned long eid);
+
+  enum
+    {
+    /// Invoked when the first observation is added to an empty event queue.
+    EventQueueProcessingRequestEvent = vtkCommand::UserEvent + 1
+    };
+
   /// Event queue processing
 
   ///
@@ -286,7 +363,44 @@ protected:
   int EventMode;
   int CompressCallData;
 
+  int EventCoalescing;
+  /// Coalesced events for each observer class name
+  std::map< std::string, std::set< unsigned long > > CoalescedObserverClasses;
+
   std::ofstream LogFile;
+
+  ///
+  /// Add an invocation to the profiling statistics and trace
+  void RecordEventProfile(vtkObservation *observation, unsigned long eid,
+                          double startTime, double elapsedTime);
+
+  /// Invocation statistics of a subject class, event, observer class combination
+  struct EventProfileStatistics
+    {
+    std::string SubjectClassName;
+    std::string EventName;
+    std::string ObserverClassName;
+    int NumberOfInvocations;
+    double TotalElapsedTime;
+    double MaxElapsedTime;
+    int MaxNestingLevel;
+    };
+  /// A single invocation in the trace
+  struct EventProfileTraceEvent
+    {
+    int StatisticsIndex;
+    double StartTime;
+    double ElapsedTime;
+    int NestingLevel;
+    };
+
+  int EventProfiling;
+  int MaximumNumberOfTraceEvents;
+  /// Time of the first recorded invocation, trace times are relative to this
+  double EventProfileStartTime;
+  std::vector< EventProfileStatistics > EventProfileStatisticsList;
+  std::map< std::string, int > EventProfileStatisticsIndexMap;
+  std::vector< EventProfileTraceEvent > EventProfileTrace;
 private:
   /// DetachObservations is a fast (but dangerous) method to delete all the
   /// observations. It leaves the event broker in an inconsistent state:
@@ -23,6 +23,10 @@ Version:   $Revision: 1.3 $
 #include "vtkMRMLTransformNode.h"
 #include "vtkMRMLScene.h"
 
+// vtkAddon includes
+#include <vtkOrientedBSplineTransform.h>
+#include <vtkOrientedGridTransform.h>
+
 // VTK includes
 #include <vtkAlgorithmOutput.h>
 #include <vtkAssignAttribute.h>
@@ -32,11 +36,15 @@ Version:   $Revision: 1.3 $
 #include <vtkEventForwarderCommand.h>
 #include <vtkFloatArray.h>
 #include <vtkGeneralTransform.h>
+#include <vtkLinearTransform.h>
+#include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
 #include <vtkPolyData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkSmartPointer.h>
 #include <vtkTransformFilter.h>
 #include <vtkTrivialProducer.h>
@@ -46,6 +54,7 @@ Version:   $Revision: 1.3 $
 // STD includes
 #include <cassert>
 #include <sstream>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLModelNode);
@@ -690,6 +699,232 @@ bool vtkMRMLModelNode::CanApplyNonLinearTransforms()const
   return true;
 }
 
+//---------------------------------------------------------------------------
+namespace
+{
+//---------------------------------------------------------------------------
+// Elementary transform of a transform concatenation
+struct TransformStep
+{
+  vtkAbstractTransform* Transform{nullptr};
+  // Inverse grid and b-spline transforms are computed iteratively and may not converge.
+  // They are computed with ComputeInverseTransformDerivative, which does not log
+  // warnings or invoke events, and failures are reported once after all points are
+  // transformed.
+  vtkOrientedGridTransform* InverseGridTransform{nullptr};
+  vtkOrientedBSplineTransform* InverseBSplineTransform{nullptr};
+};
+
+//---------------------------------------------------------------------------
+// Split the transform into elementary transforms that can be computed concurrently
+// from multiple threads. Returns false if any of them may log warnings or invoke
+// events for individual points (for example, the inverse of a thin-plate spline).
+bool GetThreadSafeTransformSteps(vtkAbstractTransform* transform, std::vector<TransformStep>& steps)
+{
+  vtkGeneralTransform* generalTransform = vtkGeneralTransform::SafeDownCast(transform);
+  if (generalTransform)
+    {
+    for (int i = 0; i < generalTransform->GetNumberOfConcatenatedTransforms(); ++i)
+      {
+      if (!GetThreadSafeTransformSteps(generalTransform->GetConcatenatedTransform(i), steps))
+        {
+        return false;
+        }
+      }
+    return true;
+    }
+  TransformStep step;
+  step.Transform = transform;
+  vtkOrientedGridTransform* gridTransform = vtkOrientedGridTransform::SafeDownCast(transform);
+  vtkOrientedBSplineTransform* bsplineTransform = vtkOrientedBSplineTransform::SafeDownCast(transform);
+  if (gridTransform)
+    {
+    if (!gridTransform->GetDisplacementGrid() || !gridTransform->GetGridDirectionMatrix())
+      {
+      return false;
+      }
+    if (gridTransform->GetInverseFlag())
+      {
+      step.InverseGridTransform = gridTransform;
+      }
+    }
+  else if (bsplineTransform)
+    {
+    if (!bsplineTransform->GetCoefficientData())
+      {
+      return false;
+      }
+    if (bsplineTransform->GetInverseFlag())
+      {
+      step.InverseBSplineTransform = bsplineTransform;
+      }
+    }
+  else if (!vtkLinearTransform::SafeDownCast(transform))
+    {
+    return false;
+    }
+  steps.push_back(step);
+  return true;
+}
+
+//---------------------------------------------------------------------------
+// Transform points, point normals, and point vectors of a mesh in place.
+// vtkTransformFilter computes non-linear transforms point by point in a single
+// thread, which may take minutes for large meshes (for example, when hardening
+// an inverse grid transform), therefore points are transformed in parallel here.
+// Returns false if the mesh cannot be transformed by this function (the transform
+// is linear, not thread-safe, or cell data must be transformed, too).
+bool TransformMeshNonLinear(vtkPointSet* mesh, vtkAbstractTransform* transform)
+{
+  if (vtkLinearTransform::SafeDownCast(transform))
+    {
+    // vtkTransformFilter is already efficient for linear transforms
+    return false;
+    }
+  vtkPoints* inputPoints = mesh->GetPoints();
+  if (!inputPoints || mesh->GetCellData()->GetNormals() || mesh->GetCellData()->GetVectors())
+    {
+    return false;
+    }
+  vtkDataArray* inputNormals = mesh->GetPointData()->GetNormals();
+  vtkDataArray* inputVectors = mesh->GetPointData()->GetVectors();
+
+  // Update is not thread-safe, therefore all transforms are updated before
+  // transforming points.
+  transform->Update();
+  std::vector<TransformStep> steps;
+  if (!GetThreadSafeTransformSteps(transform, steps))
+    {
+    return false;
+    }
+  for (TransformStep& step : steps)
+    {
+    step.Transform->Update();
+    }
+
+  vtkNew<vtkPoints> outputPoints;
+  outputPoints->SetDataType(inputPoints->GetDataType());
+  if (steps.size() == 1 && !inputNormals && !inputVectors)
+    {
+    // Grid and b-spline transforms transform points in parallel and
+    // report convergence failures once for all points.
+    steps[0].Transform->TransformPoints(inputPoints, outputPoints.GetPointer());
+    mesh->SetPoints(outputPoints.GetPointer());
+    return true;
+    }
+
+  vtkIdType numberOfPoints = inputPoints->GetNumberOfPoints();
+  outputPoints->SetNumberOfPoints(numberOfPoints);
+  vtkSmartPointer<vtkDataArray> outputNormals;
+  if (inputNormals)
+    {
+    outputNormals = vtkSmartPointer<vtkDataArray>::Take(inputNormals->NewInstance());
+    outputNormals->SetName(inputNormals->GetName());
+    outputNormals->SetNumberOfComponents(3);
+    outputNormals->SetNumberOfTuples(numberOfPoints);
+    }
+  vtkSmartPointer<vtkDataArray> outputVectors;
+  if (inputVectors)
+    {
+    outputVectors = vtkSmartPointer<vtkDataArray>::Take(inputVectors->NewInstance());
+    outputVectors->SetName(inputVectors->GetName());
+    outputVectors->SetNumberOfComponents(3);
+    outputVectors->SetNumberOfTuples(numberOfPoints);
+    }
+
+  // Number of points for which the inverse did not converge, for each step
+  vtkSMPThreadLocal< std::vector<vtkIdType> > numberOfConvergenceFailures(std::vector<vtkIdType>(steps.size(), 0));
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType beginPointId, vtkIdType endPointId)
+    {
+    std::vector<vtkIdType>& threadNumberOfConvergenceFailures = numberOfConvergenceFailures.Local();
+    double point[3];
+    double derivative[3][3];
+    double stepDerivative[3][3];
+    double tuple[3];
+    double error = 0.0;
+    int numberOfIterations = 0;
+    for (vtkIdType pointId = beginPointId; pointId < endPointId; ++pointId)
+      {
+      inputPoints->GetPoint(pointId, point);
+      vtkMath::Identity3x3(derivative);
+      for (size_t stepIndex = 0; stepIndex < steps.size(); ++stepIndex)
+        {
+        const TransformStep& step = steps[stepIndex];
+        bool converged = true;
+        if (step.InverseGridTransform)
+          {
+          converged = step.InverseGridTransform->ComputeInverseTransformDerivative(
+            point, point, stepDerivative, error, numberOfIterations);
+          }
+        else if (step.InverseBSplineTransform)
+          {
+          converged = step.InverseBSplineTransform->ComputeInverseTransformDerivative(
+            point, point, stepDerivative, error, numberOfIterations);
+          }
+        else
+          {
+          step.Transform->InternalTransformDerivative(point, point, stepDerivative);
+          }
+        if (!converged)
+          {
+          ++threadNumberOfConvergenceFailures[stepIndex];
+          }
+        // Chain rule: derivative of the concatenation
+        vtkMath::Multiply3x3(stepDerivative, derivative, derivative);
+        }
+      outputPoints->SetPoint(pointId, point);
+      // Same computation as in vtkAbstractTransform::TransformPointsNormalsVectors
+      if (inputVectors)
+        {
+        inputVectors->GetTuple(pointId, tuple);
+        vtkMath::Multiply3x3(derivative, tuple, tuple);
+        outputVectors->SetTuple(pointId, tuple);
+        }
+      if (inputNormals)
+        {
+        inputNormals->GetTuple(pointId, tuple);
+        vtkMath::Transpose3x3(derivative, derivative);
+        vtkMath::LinearSolve3x3(derivative, tuple, tuple);
+        vtkMath::Normalize(tuple);
+        outputNormals->SetTuple(pointId, tuple);
+        }
+      }
+    });
+
+  // Report convergence failures once, from the calling thread
+  for (size_t stepIndex = 0; stepIndex < steps.size(); ++stepIndex)
+    {
+    vtkIdType totalNumberOfConvergenceFailures = 0;
+    for (vtkSMPThreadLocal< std::vector<vtkIdType> >::iterator it = numberOfConvergenceFailures.begin();
+      it != numberOfConvergenceFailures.end(); ++it)
+      {
+      totalNumberOfConvergenceFailures += (*it)[stepIndex];
+      }
+    if (steps[stepIndex].InverseGridTransform)
+      {
+      steps[stepIndex].InverseGridTransform->ReportInverseConvergenceFailures(
+        totalNumberOfConvergenceFailures, numberOfPoints);
+      }
+    else if (steps[stepIndex].InverseBSplineTransform)
+      {
+      steps[stepIndex].InverseBSplineTransform->ReportInverseConvergenceFailures(
+        totalNumberOfConvergenceFailures, numberOfPoints);
+      }
+    }
+
+  mesh->SetPoints(outputPoints.GetPointer());
+  if (outputNormals)
+    {
+    mesh->GetPointData()->SetNormals(outputNormals);
+    }
+  if (outputVectors)
+    {
+    mesh->GetPointData()->SetVectors(outputVectors);
+    }
+  return true;
+}
+} // end of anonymous namespace
+
 //---------------------------------------------------------------------------
 void vtkMRMLModelNode::ApplyTransform(vtkAbstractTransform* transform)
 {
@@ -716,9 +951,12 @@ void vtkMRMLModelNode::ApplyTransform(vtkAbstractTransform* transform)
   // transformation to the data object directly
   else
     {
-    transformFilter->Update();
     vtkPointSet * mesh = this->GetMesh();
-    mesh->DeepCopy(transformFilter->GetOutput());
+    if (!TransformMeshNonLinear(mesh, transform))
+      {
+      transformFilter->Update();
+      mesh->DeepCopy(transformFilter->GetOutput());
+      }
     }
   transformFilter->Delete();
 }
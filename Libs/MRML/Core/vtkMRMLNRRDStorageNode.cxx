@@ -122,6 +122,60 @@ bool vtkMRMLNRRDStorageNode::CanReadInReferenceNode(vtkMRMLNode *refNode)
          refNode->IsA("vtkMRMLDiffusionTensorVolumeNode");
 }
 
+//----------------------------------------------------------------------------
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Check that the kind of data described in the file header corresponds
+// to the node type.
+bool IsFileKindMatchingNode(vtkTeemNRRDReader* reader, vtkMRMLNode* refNode)
+{
+  if ( refNode->IsA("vtkMRMLDiffusionTensorVolumeNode") )
+    {
+    return reader->GetPointDataType() == vtkDataSetAttributes::TENSORS;
+    }
+  else if ( refNode->IsA("vtkMRMLDiffusionWeightedVolumeNode"))
+    {
+    const char *value = reader->GetHeaderValue("modality");
+    return value != nullptr
+      && reader->GetPointDataType() == vtkDataSetAttributes::SCALARS
+      && !strcmp(value,"DWMRI");
+    }
+  else if ( refNode->IsA("vtkMRMLVectorVolumeNode") )
+    {
+    return reader->GetPointDataType() == vtkDataSetAttributes::VECTORS
+      || reader->GetPointDataType() == vtkDataSetAttributes::NORMALS;
+    }
+  else if ( refNode->IsA("vtkMRMLScalarVolumeNode") )
+    {
+    return reader->GetPointDataType() == vtkDataSetAttributes::SCALARS
+      && (reader->GetNumberOfComponents() == 1 || reader->GetNumberOfComponents() == 3);
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLNRRDStorageNode::ProbeDataInternal(vtkMRMLNode *refNode)
+{
+  std::string fullName = this->GetFullNameFromFileName();
+  vtkNew<vtkTeemNRRDReader> reader;
+  if (!reader->CanReadFile(fullName.c_str()))
+    {
+    return 0;
+    }
+  reader->SetFileName(fullName.c_str());
+  // Only the header is read
+  reader->UpdateInformation();
+  if (reader->GetReadStatus())
+    {
+    return 0;
+    }
+  return IsFileKindMatchingNode(reader, refNode) ? 1 : 0;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 {
@@ -194,46 +248,15 @@ int vtkMRMLNRRDStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   reader->UpdateInformation();
 
   // Check type
-  if ( refNode->IsA("vtkMRMLDiffusionTensorVolumeNode") )
-    {
-    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::TENSORS))
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-  else if ( refNode->IsA("vtkMRMLDiffusionWeightedVolumeNode"))
+  if (refNode->IsA("vtkMRMLDiffusionWeightedVolumeNode")
+      && reader->GetHeaderValue("modality") == nullptr)
     {
-    vtkDebugMacro("ReadData: Checking we have right info in file");
-    const char *value = reader->GetHeaderValue("modality");
-    if (value == nullptr)
-      {
-      return 0;
-      }
-    if ( ! (reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
-            !strcmp(value,"DWMRI") ) )
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
-    }
-  else if ( refNode->IsA("vtkMRMLVectorVolumeNode") )
-    {
-    if (! (reader->GetPointDataType() == vtkDataSetAttributes::VECTORS
-           || reader->GetPointDataType() == vtkDataSetAttributes::NORMALS))
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
+    return 0;
     }
-  else if ( refNode->IsA("vtkMRMLScalarVolumeNode") )
+  if (!IsFileKindMatchingNode(reader, refNode))
     {
-    if (!(reader->GetPointDataType() == vtkDataSetAttributes::SCALARS &&
-        (reader->GetNumberOfComponents() == 1 || reader->GetNumberOfComponents()==3) ))
-      {
-      vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
-      return 0;
-      }
+    vtkErrorMacro("ReadData: MRMLVolumeNode does not match file kind");
+    return 0;
     }
 
   reader->Update();
@@ -88,6 +88,9 @@ protected:
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Check the kind of data in the file header without reading the data
+  int ProbeDataInternal(vtkMRMLNode *refNode) override;
+
   /// Write data from a  referenced node
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
@@ -333,6 +333,26 @@ public:
   vtkSetMacro(UndoEnabled, bool);
   vtkBooleanMacro(UndoEnabled, bool);
 
+  /// Time of the last change of the node content.
+  /// It is the largest of the modification time of the node and the time of
+  /// the last custom modified event (see InvokeCustomModifiedEvent()), as some
+  /// changes (for example markups control point or transform matrix changes)
+  /// only invoke a custom modified event and do not update the modification time.
+  /// Used by the scene to find the nodes that must be saved in the undo stack.
+  vtkMTimeType GetContentModifiedTime()
+    {
+    vtkMTimeType mtime = this->GetMTime();
+    return (this->CustomModifiedTime.GetMTime() > mtime ? this->CustomModifiedTime.GetMTime() : mtime);
+    }
+
+  /// Estimated memory (in bytes) of the bulk data that Copy() duplicates
+  /// instead of sharing it with the source node (for example segment
+  /// representations or markups control points).
+  /// Returns 0 by default, for nodes that only store properties or that share
+  /// their bulk data in Copy() (such as model and volume nodes).
+  /// Used by the scene to estimate the memory used by the undo stack.
+  virtual size_t GetCopiedDataMemorySize() { return 0; }
+
   /// Propagate events generated in mrml.
   virtual void ProcessMRMLEvents ( vtkObject *caller, unsigned long event, void *callData );
 
@@ -350,7 +370,8 @@ public:
   vtkGetStringMacro(Description);
 
   /// Name of this node, to be set by the user
-  vtkSetStringMacro(Name);
+  /// Invokes NameChangedEvent (with the old name as call data) if the name is changed.
+  virtual void SetName(const char* name);
   vtkGetStringMacro(Name);
 
   /// ID use by other nodes to reference this node in XML.
@@ -508,6 +529,7 @@ public:
   /// If the event is not invoked immediately then it will be sent with `callData=nullptr`.
   virtual void InvokeCustomModifiedEvent(int eventId, void *callData=nullptr)
     {
+    this->CustomModifiedTime.Modified();
     if (!this->GetDisableModifiedEvent())
       {
       // DisableModify is inactive, we immediately invoke the event
@@ -747,7 +769,8 @@ public:
       ReferenceAddedEvent,
       ReferenceModifiedEvent,
       ReferenceRemovedEvent,
-      ReferencedNodeModifiedEvent
+      ReferencedNodeModifiedEvent,
+      NameChangedEvent
     };
 
 
@@ -952,6 +975,7 @@ private:
   int DisableModifiedEvent;
   int ModifiedEventPending;
   std::map<int, int> CustomModifiedEventPending; // event id, pending value (number of events grouped together)
+  vtkTimeStamp CustomModifiedTime; // time of the last InvokeCustomModifiedEvent() call
 };
 
 /// \brief Safe replacement of MRML node start/end modify.
@@ -89,6 +89,7 @@ Version:   $Revision: 1.18 $
 #include <vtkErrorCode.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkTimeStamp.h>
 
 // VTKSYS includes
 #include <vtksys/RegularExpression.hxx>
@@ -97,6 +98,7 @@ Version:   $Revision: 1.18 $
 // STD includes
 #include <algorithm>
 #include <numeric>
+#include <unordered_set>
 
 //#define MRMLSCENE_VERBOSE
 
@@ -113,6 +115,8 @@ vtkCxxSetObjectMacro(vtkMRMLScene, URIHandlerCollection, vtkCollection)
 vtkMRMLScene::vtkMRMLScene()
 {
   this->NodeIDsMTime = 0;
+  this->NodesByClassMTime = 0;
+  this->NodesByNameMTime = 0;
 
   this->RegisteredNodeClasses.clear();
   this->UniqueIDs.clear();
@@ -120,7 +124,9 @@ vtkMRMLScene::vtkMRMLScene()
 
   this->Nodes =  vtkCollection::New();
   this->MaximumNumberOfSavedUndoStates = 20;
+  this->MaximumUndoStackMemorySize = 0;
   this->UndoFlag = false;
+  this->UndoStackReferenceIDsValid = false;
 
   this->NodeReferences.clear();
   this->ReferencedIDChanges.clear();
@@ -150,6 +156,10 @@ vtkMRMLScene::vtkMRMLScene()
   // is caught by other observers.
   this->AddObserver(vtkCommand::DeleteEvent, this->DeleteEventCallback, 1000.);
 
+  this->NodeEventCallback = vtkCallbackCommand::New();
+  this->NodeEventCallback->SetClientData( reinterpret_cast<void *>(this) );
+  this->NodeEventCallback->SetCallback( vtkMRMLScene::NodeCallback );
+
   //
   // Register all the 'built-in' nodes for the library
   // SmartPointer is used to create an instance of the class, and destroy immediately after registration is complete.
@@ -240,6 +250,13 @@ vtkMRMLScene::~vtkMRMLScene()
     if (this->Nodes->GetNumberOfItems() > 0)
       {
       vtkDebugMacro("CurrentScene should have already been cleared in DeleteEvent callback: ");
+      vtkMRMLNode *node = nullptr;
+      vtkCollectionSimpleIterator it;
+      for (this->Nodes->InitTraversal(it);
+        (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it));)
+        {
+        this->RemoveNodeObservers(node);
+        }
       this->Nodes->RemoveAllItems ( );
       }
     this->Nodes->Delete();
@@ -279,6 +296,14 @@ vtkMRMLScene::~vtkMRMLScene()
     this->DeleteEventCallback->Delete();
     this->DeleteEventCallback = nullptr;
     }
+  if ( this->NodeEventCallback != nullptr )
+    {
+    // nodes that are still observed (e.g., removed from the node collection
+    // directly) must not call back into the deleted scene
+    this->NodeEventCallback->SetClientData( nullptr );
+    this->NodeEventCallback->Delete();
+    this->NodeEventCallback = nullptr;
+    }
 }
 
 //------------------------------------------------------------------------------
@@ -298,6 +323,45 @@ void vtkMRMLScene::SceneCallback( vtkObject *vtkNotUsed(caller),
   self->Clear(1);
 }
 
+//------------------------------------------------------------------------------
+void vtkMRMLScene::NodeCallback( vtkObject *caller, unsigned long eid,
+                                 void *clientData, void *callData )
+{
+  vtkMRMLScene *self = reinterpret_cast<vtkMRMLScene *>(clientData);
+  vtkMRMLNode *node = vtkMRMLNode::SafeDownCast(caller);
+  if (self == nullptr || node == nullptr)
+    {
+    return;
+    }
+  // old ID or name is passed as call data
+  const char* oldValue = reinterpret_cast<const char*>(callData);
+  if (eid == vtkMRMLNode::IDChangedEvent)
+    {
+    if (oldValue)
+      {
+      NodeIDsType::iterator it = self->NodeIDs.find(std::string(oldValue));
+      if (it != self->NodeIDs.end() && it->second.GetPointer() == node)
+        {
+        self->NodeIDs.erase(it);
+        }
+      }
+    if (node->GetID())
+      {
+      self->NodeIDs[std::string(node->GetID())] = node;
+      }
+    }
+  else if (eid == vtkMRMLNode::NameChangedEvent)
+    {
+    if (self->Nodes->GetMTime() > self->NodesByNameMTime)
+      {
+      // the index is out of date anyway, it will be rebuilt on next query
+      return;
+      }
+    self->RemoveNodeFromNameIndex(node, oldValue);
+    self->AddNodeToNameIndex(node, false);
+    }
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::Clear(int removeSingletons)
 {
@@ -1190,10 +1254,15 @@ vtkMRMLNode* vtkMRMLScene::AddNodeNoNotify(vtkMRMLNode *n)
     n->SetName(this->GenerateUniqueName(n).c_str());
     }
   n->SetScene( this );
+  this->UpdateNodeClassIndex();
+  this->UpdateNodeNameIndex();
   this->Nodes->vtkCollection::AddItem((vtkObject *)n);
 
   // cache the node so the whole scene cache stays up-to date
   this->AddNodeID(n);
+  this->AddNodeToClassIndex(n);
+  this->AddNodeToNameIndex(n);
+  this->AddNodeObservers(n);
 
   // Keep the SH up-to-date
   if (vtkMRMLSubjectHierarchyNode::SafeDownCast(n) != nullptr &&
@@ -1407,10 +1476,15 @@ void vtkMRMLScene::RemoveNode(vtkMRMLNode *n)
     {
     n->SetScene(nullptr);
     }
+  this->RemoveNodeObservers(n);
+  this->UpdateNodeClassIndex();
+  this->UpdateNodeNameIndex();
   this->Nodes->vtkCollection::RemoveItem((vtkObject *)n);
 
   std::string nid = (n->GetID() ? n->GetID() : "");
   this->RemoveNodeID(n->GetID());
+  this->RemoveNodeFromClassIndex(n);
+  this->RemoveNodeFromNameIndex(n, n->GetName());
 
   this->InvokeEvent(vtkMRMLScene::NodeRemovedEvent, n);
 
@@ -1588,18 +1662,7 @@ int vtkMRMLScene::GetNumberOfNodesByClass(const char *className)
     vtkErrorMacro("GetNumberOfNodesByClass: class name is null.");
     return 0;
     }
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      num++;
-      }
-    }
-  return num;
+  return static_cast<int>(this->GetIndexedNodesByClass(className).size());
 }
 
 //------------------------------------------------------------------------------
@@ -1611,16 +1674,7 @@ int vtkMRMLScene::GetNodesByClass(const char *className, std::vector<vtkMRMLNode
     vtkErrorMacro("GetNodesByClass: class name is null.");
     return 0;
     }
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
-    {
-    if (node->IsA(className))
-      {
-      nodes.push_back(node);
-      }
-    }
+  nodes = this->GetIndexedNodesByClass(className);
   return static_cast<int>(nodes.size());
 }
 
@@ -1633,15 +1687,10 @@ vtkCollection* vtkMRMLScene::GetNodesByClass(const char *className)
     return nullptr;
     }
   vtkCollection* nodes = vtkCollection::New();
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin(); nodeIt != classNodes.end(); ++nodeIt)
     {
-    if (node->IsA(className))
-      {
-      nodes->AddItem(node);
-      }
+    nodes->AddItem(*nodeIt);
     }
   return nodes;
 }
@@ -1702,13 +1751,11 @@ vtkMRMLNode* vtkMRMLScene::GetSingletonNode(const char* singletonTag, const char
     return nullptr;
     }
 
-  vtkCollectionSimpleIterator it;
-  vtkMRMLNode* node = nullptr;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(className);
+  for (std::vector<vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin(); nodeIt != classNodes.end(); ++nodeIt)
     {
-    if (node->IsA(className) &&
-        node->GetSingletonTag() != nullptr &&
+    vtkMRMLNode* node = *nodeIt;
+    if (node->GetSingletonTag() != nullptr &&
         strcmp(node->GetSingletonTag(), singletonTag) == 0)
       {
       return node;
@@ -1778,22 +1825,12 @@ vtkMRMLNode* vtkMRMLScene::GetNthNodeByClass(int n, const char *className)
     return nullptr;
     }
 
-  int num=0;
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(className);
+  if (n >= static_cast<int>(classNodes.size()))
     {
-    if (node->IsA(className))
-      {
-      if (num == n)
-        {
-        return node;
-        }
-      num++;
-      }
+    return nullptr;
     }
-  return nullptr;
+  return classNodes[n];
 }
 
 //------------------------------------------------------------------------------
@@ -1813,14 +1850,12 @@ vtkCollection* vtkMRMLScene::GetNodesByName(const char* name)
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>* namedNodes = this->GetIndexedNodesByName(name);
+  if (namedNodes)
     {
-    if (node->GetName() != nullptr && !strcmp(node->GetName(), name))
+    for (std::vector<vtkMRMLNode*>::const_iterator nodeIt = namedNodes->begin(); nodeIt != namedNodes->end(); ++nodeIt)
       {
-      nodes->AddItem(node);
+      nodes->AddItem(*nodeIt);
       }
     }
   return nodes;
@@ -1832,23 +1867,42 @@ vtkMRMLNode* vtkMRMLScene::GetFirstNode(const char* byName,
                                         const int* byHideFromEditors,
                                         bool exactNameMatch)
 {
-  vtkCollectionSimpleIterator it;
-  vtkMRMLNode* node;
-  for (this->Nodes->InitTraversal(it);
-       (node= vtkMRMLNode::SafeDownCast(
-          this->Nodes->GetNextItemAsObject(it))) ;)
+  if (byName && exactNameMatch)
     {
-    if (exactNameMatch && byName &&
-        node->GetName() != nullptr && strcmp(node->GetName(), byName) != 0)
+    // Only nodes with the requested name need to be checked
+    const std::vector<vtkMRMLNode*>* namedNodes = this->GetIndexedNodesByName(byName);
+    if (!namedNodes)
       {
-      continue;
+      return nullptr;
       }
-    if (!exactNameMatch && byName &&
-        node->GetName() != nullptr && !vtksys::RegularExpression(byName).find(node->GetName()))
+    for (std::vector<vtkMRMLNode*>::const_iterator nodeIt = namedNodes->begin(); nodeIt != namedNodes->end(); ++nodeIt)
       {
-      continue;
+      vtkMRMLNode* node = *nodeIt;
+      if (byClass && !node->IsA(byClass))
+        {
+        continue;
+        }
+      if (byHideFromEditors && node->GetHideFromEditors() != *byHideFromEditors)
+        {
+        continue;
+        }
+      return node;
       }
-    if (byClass && !node->IsA(byClass))
+    return nullptr;
+    }
+
+  // Compile the regular expression only once
+  vtksys::RegularExpression nameRegExp;
+  if (byName)
+    {
+    nameRegExp.compile(byName);
+    }
+  const std::vector<vtkMRMLNode*>& classNodes = this->GetIndexedNodesByClass(byClass ? byClass : "vtkMRMLNode");
+  for (std::vector<vtkMRMLNode*>::const_iterator nodeIt = classNodes.begin(); nodeIt != classNodes.end(); ++nodeIt)
+    {
+    vtkMRMLNode* node = *nodeIt;
+    if (byName &&
+        node->GetName() != nullptr && !nameRegExp.find(node->GetName()))
       {
       continue;
       }
@@ -1864,23 +1918,18 @@ vtkMRMLNode* vtkMRMLScene::GetFirstNode(const char* byName,
 //------------------------------------------------------------------------------
 vtkMRMLNode* vtkMRMLScene::GetFirstNodeByName(const char* name)
 {
-  vtkMRMLNode *node = nullptr;
   if (name == nullptr)
     {
     vtkErrorMacro("GetNodesByName: name is null");
-    return node;
+    return nullptr;
     }
 
-  vtkCollectionSimpleIterator it;
-  for (this->Nodes->InitTraversal(it);
-       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+  const std::vector<vtkMRMLNode*>* namedNodes = this->GetIndexedNodesByName(name);
+  if (!namedNodes)
     {
-    if (node->GetName() != nullptr && !strcmp(node->GetName(), name))
-      {
-      return node;
-      }
+    return nullptr;
     }
-  return nullptr;
+  return namedNodes->front();
 }
 
 //------------------------------------------------------------------------------
@@ -1900,7 +1949,7 @@ vtkMRMLNode* vtkMRMLScene::GetNodeByID(const char* id)
 
   vtkMRMLNode *node = nullptr;
   this->UpdateNodeIDs();
-  std::map< std::string, vtkSmartPointer<vtkMRMLNode> >::iterator it = this->NodeIDs.find(std::string(id));
+  NodeIDsType::iterator it = this->NodeIDs.find(std::string(id));
   if (it != this->NodeIDs.end())
     {
     node = it->second;
@@ -1940,13 +1989,16 @@ vtkCollection* vtkMRMLScene::GetNodesByClassByName(const char* className, const
     return nodes;
     }
 
-  vtkMRMLNode *node;
-  for (int n=0; n < this->Nodes->GetNumberOfItems(); n++)
+  const std::vector<vtkMRMLNode*>* namedNodes = this->GetIndexedNodesByName(name);
+  if (!namedNodes)
     {
-    node = (vtkMRMLNode*)this->Nodes->GetItemAsObject(n);
-    if (node->GetName() != nullptr && !strcmp(node->GetName(), name) && node->IsA(className))
+    return nodes;
+    }
+  for (std::vector<vtkMRMLNode*>::const_iterator nodeIt = namedNodes->begin(); nodeIt != namedNodes->end(); ++nodeIt)
+    {
+    if ((*nodeIt)->IsA(className))
       {
-      nodes->AddItem(node);
+      nodes->AddItem(*nodeIt);
       }
     }
 
@@ -2025,6 +2077,7 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
   int itemIndex = 0;
   // find the index of the item to insert after
   itemIndex = this->IsNodePresent(item);
+  this->UpdateNodeNameIndex();
   if (itemIndex == 0)
     {
     // it wasn't found, just add
@@ -2039,6 +2092,10 @@ vtkMRMLNode* vtkMRMLScene::InsertAfterNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-to-date
   this->AddNodeID(n);
+  // the node is not necessarily appended, the class index order must be rebuilt
+  this->ClearNodeClassIndex();
+  this->AddNodeToNameIndex(n, false);
+  this->AddNodeObservers(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2122,6 +2179,7 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
   int itemIndex = 0;
   // find the index of the item to insert before
   itemIndex = this->IsNodePresent(item);
+  this->UpdateNodeNameIndex();
   if (itemIndex == 0)
     {
     // it wasn't found, just add
@@ -2137,6 +2195,10 @@ vtkMRMLNode* vtkMRMLScene::InsertBeforeNode(vtkMRMLNode *item, vtkMRMLNode *n)
     }
   // cache the node so the whole scene cache stays up-todate
   this->AddNodeID(n);
+  // the node is not necessarily appended, the class index order must be rebuilt
+  this->ClearNodeClassIndex();
+  this->AddNodeToNameIndex(n, false);
+  this->AddNodeObservers(n);
 
   n->SetDisableModifiedEvent(modifyStatus);
 
@@ -2315,14 +2377,18 @@ bool vtkMRMLScene::IsNodeIDReservedByUndo(const std::string id) const
     return false;
     }
 
-  std::set<std::string> undoReferenceIDs;
-  this->GetNodeReferenceIDsFromUndoStack(undoReferenceIDs);
-  if (undoReferenceIDs.find(id) != undoReferenceIDs.end())
+  if (this->UndoStack.empty())
     {
-    return true;
+    return false;
     }
 
-  return false;
+  if (!this->UndoStackReferenceIDsValid)
+    {
+    this->GetNodeReferenceIDsFromUndoStack(this->UndoStackReferenceIDs);
+    this->UndoStackReferenceIDsValid = true;
+    }
+
+  return this->UndoStackReferenceIDs.find(id) != this->UndoStackReferenceIDs.end();
 }
 
 //------------------------------------------------------------------------------
@@ -2330,13 +2396,15 @@ void vtkMRMLScene::GetNodeReferenceIDsFromUndoStack(std::set<std::string>& refer
 {
   referenceIDs.clear();
 
-  std::list<vtkCollection*>::const_iterator undoStackIt;
+  // Nodes that are not saved in the undo stack are in the scene,
+  // their references are already in NodeReferences.
+  UndoStackType::const_iterator undoStackIt;
   for (undoStackIt = this->UndoStack.begin(); undoStackIt != this->UndoStack.end(); ++undoStackIt)
     {
-    vtkCollection* nodes = *undoStackIt;
-    for (int i = 0; i < nodes->GetNumberOfItems(); ++i)
+    std::unordered_map< std::string, vtkSmartPointer<vtkMRMLNode> >::const_iterator savedNodeIt;
+    for (savedNodeIt = undoStackIt->SavedNodes.begin(); savedNodeIt != undoStackIt->SavedNodes.end(); ++savedNodeIt)
       {
-      vtkMRMLNode* node = vtkMRMLNode::SafeDownCast(nodes->GetItemAsObject(i));
+      vtkMRMLNode* node = savedNodeIt->second;
       if (!node)
         {
         continue;
@@ -2469,74 +2537,37 @@ void vtkMRMLScene::RemoveReservedIDs()
 }
 
 //------------------------------------------------------------------------------
-// Pushes the current scene onto the undo stack, and makes a backup copy of the
-// passed node so that changes to the node are undoable; several signatures to handle
-// individual nodes or a vtkCollection of nodes, or a vector of nodes
+// Pushes the current scene onto the undo stack. The state of all the modified
+// undo-enabled nodes is saved, so the nodes passed to the deprecated
+// overloads do not need special handling.
 //
 void vtkMRMLScene::SaveStateForUndo (vtkMRMLNode *node)
 {
-  if (!this->UndoFlag)
-    {
-    return;
-    }
-
-  if (this->IsUndoing())
-    {
-    return;
-    }
-
-  if (this->IsBatchProcessing())
-    {
-    return;
-    }
-
   if (node && !node->GetUndoEnabled())
     {
     return;
     }
-
-  this->ClearRedoStack();
-  //this->SetUndoOn();
-  this->PushIntoUndoStack();
-  if (node)
-    {
-    this->CopyNodeInUndoStack(node);
-    }
+  this->SaveStateForUndo();
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> nodes)
+void vtkMRMLScene::SaveStateForUndo (std::vector<vtkMRMLNode *> vtkNotUsed(nodes))
 {
-  if (!this->UndoFlag)
-    {
-    return;
-    }
+  this->SaveStateForUndo();
+}
 
-  if (this->IsUndoing())
-    {
-    return;
-    }
-  if (this->IsBatchProcessing())
+//------------------------------------------------------------------------------
+void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
+{
+  if (!nodes)
     {
     return;
     }
-
-  this->ClearRedoStack();
-  //this->SetUndoOn();
-  this->PushIntoUndoStack();
-  unsigned int n;
-  for (n=0; n<nodes.size(); n++)
-    {
-    vtkMRMLNode *node = nodes[n];
-    if (node && node->GetUndoEnabled())
-      {
-      this->CopyNodeInUndoStack(node);
-      }
-    }
+  this->SaveStateForUndo();
 }
 
 //------------------------------------------------------------------------------
-void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
+void vtkMRMLScene::SaveStateForUndo ()
 {
   if (!this->UndoFlag)
     {
@@ -2553,47 +2584,13 @@ void vtkMRMLScene::SaveStateForUndo (vtkCollection* nodes)
     return;
     }
 
-  if (!nodes)
-    {
-    return;
-    }
-
   this->ClearRedoStack();
-  //this->SetUndoOn();
   this->PushIntoUndoStack();
-
-  int nnodes = nodes->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
-    {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(nodes->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
-      {
-      this->CopyNodeInUndoStack(node);
-      }
-    }
-}
-
-//------------------------------------------------------------------------------
-void vtkMRMLScene::SaveStateForUndo ()
-{
-  if (!this->UndoFlag)
-    {
-    return;
-    }
-
-  if (this->IsBatchProcessing())
-    {
-    return;
-    }
-  if (this->Nodes)
-    {
-    this->SaveStateForUndo(this->Nodes);
-    }
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to all the nodes in the current scene
+// Add a new entry to the undo stack and save the undo-enabled nodes that
+// have been modified since their last copy in the stack
 void vtkMRMLScene::PushIntoUndoStack()
 {
   if (this->Nodes == nullptr)
@@ -2601,27 +2598,42 @@ void vtkMRMLScene::PushIntoUndoStack()
     return;
     }
 
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
+  UndoStackEntry newEntry;
+  newEntry.NodeIDs = this->GetUndoEnabledNodeIDs(
+    this->UndoStack.empty() ? nullptr : &this->UndoStack.back());
+  this->UndoStack.push_back(newEntry);
+  this->UndoStackReferenceIDsValid = false;
 
-  int nnodes = currentScene->GetNumberOfItems();
-
-  for (int n=0; n<nnodes; n++)
+  vtkMRMLNode *node = nullptr;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+    (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it));)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
+    if (!node->GetUndoEnabled() || !node->GetID())
       {
-      newScene->AddItem(node);
+      continue;
       }
+    std::unordered_map<std::string, UndoSavedNodeInfo>::iterator savedNodeIt =
+      this->UndoSavedNodes.find(node->GetID());
+    if (savedNodeIt != this->UndoSavedNodes.end()
+      && savedNodeIt->second.Node.GetPointer() == node
+      && !vtkMRMLScene::IsNodeModifiedSince(node, savedNodeIt->second.NodeMTime))
+      {
+      // unchanged, the saved copy in the stack is shared
+      continue;
+      }
+    this->CopyNodeInUndoStack(node);
     }
 
-  this->UndoStack.push_back(newScene);
+  vtkTimeStamp saveTime;
+  saveTime.Modified();
+  this->UndoStack.back().SaveTime = saveTime.GetMTime();
+
   this->TrimUndoStack();
 }
 
 //------------------------------------------------------------------------------
-// Make a new collection that has pointers to the current scene nodes
+// Add a new entry to the redo stack, nodes are saved in it by Undo()
 void vtkMRMLScene::PushIntoRedoStack()
 {
   if (this->Nodes == nullptr)
@@ -2629,27 +2641,39 @@ void vtkMRMLScene::PushIntoRedoStack()
     return;
     }
 
-  vtkCollection* newScene = vtkCollection::New();
-
-  vtkCollection* currentScene = this->Nodes;
-
-  int nnodes = currentScene->GetNumberOfItems();
+  UndoStackEntry newEntry;
+  newEntry.NodeIDs = this->GetUndoEnabledNodeIDs(nullptr);
+  vtkTimeStamp saveTime;
+  saveTime.Modified();
+  newEntry.SaveTime = saveTime.GetMTime();
+  this->RedoStack.push_back(newEntry);
+}
 
-  for (int n=0; n<nnodes; n++)
+//------------------------------------------------------------------------------
+std::shared_ptr< const std::vector<std::string> > vtkMRMLScene::GetUndoEnabledNodeIDs(
+  const UndoStackEntry* referenceEntry)
+{
+  std::shared_ptr< std::vector<std::string> > nodeIDs = std::make_shared< std::vector<std::string> >();
+  vtkMRMLNode *node = nullptr;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+    (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it));)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
+    if (node->GetUndoEnabled() && node->GetID())
       {
-      newScene->AddItem(node);
+      nodeIDs->push_back(node->GetID());
       }
     }
-
-  this->RedoStack.push_back(newScene);
+  if (referenceEntry && referenceEntry->NodeIDs && *referenceEntry->NodeIDs == *nodeIDs)
+    {
+    // nodes have not been added or removed, share the list
+    return referenceEntry->NodeIDs;
+    }
+  return nodeIDs;
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the undoable copy of the scene so that the node
-// can be edited
+// Save a copy of the node in the top entry of the undo stack
 void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
 {
   if (!copyNode)
@@ -2657,29 +2681,38 @@ void vtkMRMLScene::CopyNodeInUndoStack(vtkMRMLNode *copyNode)
     vtkErrorMacro("CopyNodeInUndoStack: node is null");
     return;
     }
+  if (this->UndoStack.empty() || !copyNode->GetID())
+    {
+    return;
+    }
 
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != nullptr)
+  vtkSmartPointer<vtkMRMLNode> snode = vtkSmartPointer<vtkMRMLNode>::Take(copyNode->CreateNodeInstance());
+  if (snode == nullptr)
     {
-    snode->CopyWithScene(copyNode);
+    vtkErrorMacro("CopyNodeInUndoStack: failed to create a copy of node " << copyNode->GetID());
+    return;
     }
+  snode->CopyWithScene(copyNode);
 
-  vtkCollection* undoScene = this->UndoStack.back();
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+  UndoStackEntry& undoEntry = this->UndoStack.back();
+  vtkSmartPointer<vtkMRMLNode>& savedNode = undoEntry.SavedNodes[copyNode->GetID()];
+  if (savedNode)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
-      {
-      undoScene->ReplaceItem (n, snode);
-      break;
-      }
+    undoEntry.MemorySize -= vtkMRMLScene::GetUndoNodeMemorySize(savedNode);
     }
-  snode->Delete();
+  savedNode = snode;
+  undoEntry.MemorySize += vtkMRMLScene::GetUndoNodeMemorySize(snode);
+
+  UndoSavedNodeInfo& savedNodeInfo = this->UndoSavedNodes[copyNode->GetID()];
+  savedNodeInfo.Node = copyNode;
+  savedNodeInfo.SavedNode = snode;
+  savedNodeInfo.NodeMTime = copyNode->GetContentModifiedTime();
+
+  this->UndoStackReferenceIDsValid = false;
 }
 
 //------------------------------------------------------------------------------
-// Put a replacement node into the redoable copy of the scene so that the node
+// Save a copy of the node in the top entry of the redo stack so that the node
 // can be replaced by the Undo version
 void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
 {
@@ -2688,28 +2721,85 @@ void vtkMRMLScene::CopyNodeInRedoStack(vtkMRMLNode *copyNode)
     vtkErrorMacro("CopyNodeInRedoStack: node is null");
     return;
     }
-  vtkMRMLNode *snode = copyNode->CreateNodeInstance();
-  if (snode != nullptr)
+  if (this->RedoStack.empty() || !copyNode->GetID())
     {
-    snode->CopyWithSceneWithSingleModifiedEvent(copyNode);
+    return;
     }
-  vtkCollection* undoScene = this->RedoStack.back();
-  int nnodes = undoScene->GetNumberOfItems();
-  for (int n=0; n<nnodes; n++)
+
+  vtkSmartPointer<vtkMRMLNode> snode = vtkSmartPointer<vtkMRMLNode>::Take(copyNode->CreateNodeInstance());
+  if (snode == nullptr)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-    if (node == copyNode)
+    vtkErrorMacro("CopyNodeInRedoStack: failed to create a copy of node " << copyNode->GetID());
+    return;
+    }
+  snode->CopyWithScene(copyNode);
+
+  UndoStackEntry& redoEntry = this->RedoStack.back();
+  redoEntry.SavedNodes[copyNode->GetID()] = snode;
+  redoEntry.MemorySize += vtkMRMLScene::GetUndoNodeMemorySize(snode);
+}
+
+//------------------------------------------------------------------------------
+vtkMRMLNode* vtkMRMLScene::FindNodeInUndoStack(UndoStackType::reverse_iterator entryIt, const std::string& nodeID)
+{
+  for (; entryIt != this->UndoStack.rend(); ++entryIt)
+    {
+    std::unordered_map< std::string, vtkSmartPointer<vtkMRMLNode> >::iterator savedNodeIt =
+      entryIt->SavedNodes.find(nodeID);
+    if (savedNodeIt != entryIt->SavedNodes.end())
       {
-      undoScene->ReplaceItem (n, snode);
-      break;
+      return savedNodeIt->second;
       }
     }
-  snode->Delete();
+  return nullptr;
+}
+
+//------------------------------------------------------------------------------
+bool vtkMRMLScene::IsNodeModifiedSince(vtkMRMLNode* node, vtkMTimeType time)
+{
+  // Changes made between StartModify() and EndModify() only update the
+  // modification time when EndModify() is called.
+  return node->GetContentModifiedTime() > time || node->GetModifiedEventPending() > 0;
 }
 
 //------------------------------------------------------------------------------
-// Replace the current scene by the top of the undo stack
-// -- move the current scene on the redo stack
+size_t vtkMRMLScene::GetUndoNodeMemorySize(vtkMRMLNode* node)
+{
+  if (!node)
+    {
+    return 0;
+    }
+  // Approximate size of the node object itself, plus the bulk data that the
+  // copy does not share with the node (e.g., segment representations,
+  // markups control points).
+  size_t memorySize = 1024 + node->GetCopiedDataMemorySize();
+  memorySize += node->GetName() ? strlen(node->GetName()) : 0;
+  memorySize += node->GetDescription() ? strlen(node->GetDescription()) : 0;
+
+  std::vector<std::string> attributeNames = node->GetAttributeNames();
+  for (std::vector<std::string>::iterator nameIt = attributeNames.begin(); nameIt != attributeNames.end(); ++nameIt)
+    {
+    const char* attributeValue = node->GetAttribute(nameIt->c_str());
+    memorySize += nameIt->size() + (attributeValue ? strlen(attributeValue) : 0);
+    }
+
+  std::vector<std::string> roles;
+  node->GetNodeReferenceRoles(roles);
+  for (std::vector<std::string>::iterator roleIt = roles.begin(); roleIt != roles.end(); ++roleIt)
+    {
+    std::vector<const char*> referenceIDs;
+    node->GetNodeReferenceIDs(roleIt->c_str(), referenceIDs);
+    for (std::vector<const char*>::iterator referenceIDIt = referenceIDs.begin(); referenceIDIt != referenceIDs.end(); ++referenceIDIt)
+      {
+      memorySize += roleIt->size() + (*referenceIDIt ? strlen(*referenceIDIt) : 0);
+      }
+    }
+  return memorySize;
+}
+
+//------------------------------------------------------------------------------
+// Restore the state of the top of the undo stack
+// -- save the nodes changed by the undo on the redo stack
 void vtkMRMLScene::Undo()
 {
   if (!this->UndoFlag)
@@ -2725,91 +2815,80 @@ void vtkMRMLScene::Undo()
   this->StartState(vtkMRMLScene::UndoState);
   this->RemoveUnusedNodeReferences();
 
-  int nnodes;
-  int n;
-  unsigned int nn;
-
   this->PushIntoRedoStack();
 
-  vtkCollection* currentScene = this->Nodes;
-  // We use 2 vectors instead of a map in order to keep the ordering of the
-  // nodes.
-  std::vector<std::string> currentIDs;
-  std::vector<vtkMRMLNode*> currentNodes;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
+  std::unordered_map<std::string, vtkMRMLNode*> currentNodes;
+  vtkMRMLNode *node = nullptr;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+    (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it));)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
+    if (node->GetUndoEnabled() && node->GetID())
       {
-      currentIDs.push_back(node->GetID());
-      currentNodes.push_back(node);
+      currentNodes[node->GetID()] = node;
       }
     }
 
-  vtkCollection* undoScene = nullptr;
-  std::vector<std::string> undoIDs;
-  std::vector<vtkMRMLNode*> undoNodes;
+  UndoStackType::reverse_iterator undoEntryIt = this->UndoStack.rbegin();
+  const std::vector<std::string>& undoIDs = *undoEntryIt->NodeIDs;
+  std::unordered_set<std::string> undoIDSet(undoIDs.begin(), undoIDs.end());
 
-  if (!this->UndoStack.empty())
+  // copy back changes and add deleted nodes to the current scene
+  std::vector< vtkSmartPointer<vtkMRMLNode> > addNodes;
+  for (std::vector<std::string>::const_iterator iterID = undoIDs.begin(); iterID != undoIDs.end(); ++iterID)
     {
-    undoScene = this->UndoStack.back();
-    nnodes = undoScene->GetNumberOfItems();
-    for (n=0; n<nnodes; n++)
+    std::unordered_map<std::string, vtkMRMLNode*>::iterator curIter = currentNodes.find(*iterID);
+    if (curIter != currentNodes.end()
+      && !vtkMRMLScene::IsNodeModifiedSince(curIter->second, undoEntryIt->SaveTime))
       {
-      vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-      if (node && node->GetUndoEnabled())
-        {
-        undoIDs.push_back(node->GetID());
-        undoNodes.push_back(node);
-        }
+      // the node has not changed since the state was saved
+      continue;
       }
-    }
-
-  std::vector<std::string>::iterator iterID;
-  std::vector<vtkMRMLNode*>::iterator iterNode;
-  std::vector<std::string>::iterator curIterID;
-  std::vector<vtkMRMLNode*>::iterator curIterNode;
-
-  // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkMRMLNode*> addNodes;
-
-  for(iterID=undoIDs.begin(), iterNode = undoNodes.begin(); iterID != undoIDs.end(); iterID++, iterNode++)
-    {
-    curIterID = std::find(currentIDs.begin(), currentIDs.end(), *iterID);
-    curIterNode = currentNodes.begin() + std::distance(currentIDs.begin(), curIterID);
-    if ( curIterID == currentIDs.end() )
+    vtkMRMLNode* savedNode = this->FindNodeInUndoStack(undoEntryIt, *iterID);
+    if (!savedNode)
       {
-      // the node was deleted, add Node back to the current scene
-      addNodes.push_back(*iterNode);
+      vtkWarningMacro("Undo: no saved state is found for node " << *iterID);
+      continue;
       }
-    else if (*iterNode != *curIterNode)
+    if (curIter == currentNodes.end())
+      {
+      // the node was deleted, add a copy of the saved node back to the current scene
+      // (saved nodes may be shared with other undo levels, so they are not added directly)
+      vtkSmartPointer<vtkMRMLNode> addNode = vtkSmartPointer<vtkMRMLNode>::Take(savedNode->CreateNodeInstance());
+      addNode->CopyWithScene(savedNode);
+      addNodes.push_back(addNode);
+      }
+    else
       {
       // nodes differ, copy from undo to current scene
       // but before create a copy in redo stack from current
-      this->CopyNodeInRedoStack(*curIterNode);
-      (*curIterNode)->CopyWithSceneWithSingleModifiedEvent(*iterNode);
+      this->CopyNodeInRedoStack(curIter->second);
+      curIter->second->CopyWithSceneWithSingleModifiedEvent(savedNode);
       }
     }
 
-  // remove new nodes created before Undo
-  std::vector<vtkMRMLNode*> removeNodes;
-  for(curIterID=currentIDs.begin(), curIterNode = currentNodes.begin(); curIterID != currentIDs.end(); curIterID++, curIterNode++)
+  // remove new nodes created before Undo, they are kept in the redo stack
+  std::vector< vtkSmartPointer<vtkMRMLNode> > removeNodes;
+  UndoStackEntry& redoEntry = this->RedoStack.back();
+  const std::vector<std::string>& currentIDs = *redoEntry.NodeIDs;
+  for (std::vector<std::string>::const_iterator curIterID = currentIDs.begin(); curIterID != currentIDs.end(); ++curIterID)
     {
-    iterID = std::find(undoIDs.begin(),undoIDs.end(), *curIterID);
     // Remove only if the node is not present in the previous state.
-    if ( iterID == undoIDs.end() )
+    if (undoIDSet.find(*curIterID) == undoIDSet.end())
       {
-      removeNodes.push_back(*curIterNode);
+      vtkMRMLNode* removeNode = currentNodes[*curIterID];
+      removeNodes.push_back(removeNode);
+      redoEntry.SavedNodes[*curIterID] = removeNode;
+      redoEntry.MemorySize += vtkMRMLScene::GetUndoNodeMemorySize(removeNode);
       }
     }
 
-  for (nn=0; nn<addNodes.size(); nn++)
+  for (size_t nn = 0; nn < addNodes.size(); nn++)
     {
     this->AddNode(addNodes[nn]);
     addNodes[nn]->SetSceneReferences();
     }
-  for (nn=0; nn<removeNodes.size(); nn++)
+  for (size_t nn = 0; nn < removeNodes.size(); nn++)
     {
     vtkMRMLNode* nodeToRemove = removeNodes[nn];
     // Maybe the node has been removed already by a side effect of a previous
@@ -2820,16 +2899,22 @@ void vtkMRMLScene::Undo()
       }
     }
 
-  if (undoScene)
+  // Nodes saved in the removed entry are not available anymore for
+  // comparison in the next PushIntoUndoStack()
+  const UndoStackEntry& undoEntry = this->UndoStack.back();
+  for (std::unordered_map< std::string, vtkSmartPointer<vtkMRMLNode> >::const_iterator savedNodeIt = undoEntry.SavedNodes.begin();
+    savedNodeIt != undoEntry.SavedNodes.end(); ++savedNodeIt)
     {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
+    std::unordered_map<std::string, UndoSavedNodeInfo>::iterator savedNodeInfoIt =
+      this->UndoSavedNodes.find(savedNodeIt->first);
+    if (savedNodeInfoIt != this->UndoSavedNodes.end()
+      && savedNodeInfoIt->second.SavedNode == savedNodeIt->second.GetPointer())
+      {
+      this->UndoSavedNodes.erase(savedNodeInfoIt);
+      }
     }
-
-  if (!this->UndoStack.empty())
-   {
-   this->UndoStack.pop_back();
-   }
+  this->UndoStack.pop_back();
+  this->UndoStackReferenceIDsValid = false;
   this->Modified();
 
   this->EndState(vtkMRMLScene::UndoState);
@@ -2852,109 +2937,77 @@ void vtkMRMLScene::Redo()
     return;
     }
 
-  int nnodes;
-  int n;
-  unsigned int nn;
-
   this->StartState(vtkMRMLScene::RedoState);
 
   this->RemoveUnusedNodeReferences();
 
   this->PushIntoUndoStack();
 
-
-  vtkCollection* currentScene = this->Nodes;
-  //std::hash_map<std::string, vtkMRMLNode*> currentMap;
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> > currentMap;
-  nnodes = currentScene->GetNumberOfItems();
-  for (n=0; n<nnodes; n++)
+  std::unordered_map<std::string, vtkWeakPointer<vtkMRMLNode> > currentMap;
+  std::vector<std::string> currentIDs;
+  vtkMRMLNode *node = nullptr;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+    (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it));)
     {
-    vtkMRMLNode *node  = vtkMRMLNode::SafeDownCast(currentScene->GetItemAsObject(n));
-    if (node && node->GetUndoEnabled())
+    if (node->GetUndoEnabled() && node->GetID())
       {
       currentMap[node->GetID()] = node;
+      currentIDs.push_back(node->GetID());
       }
     }
 
-  //std::hash_map<std::string, vtkMRMLNode*> undoMap;
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> > undoMap;
-
-  vtkCollection* undoScene = nullptr;
-
-  if (!this->RedoStack.empty())
-    {
-    undoScene = this->RedoStack.back();
-    if (undoScene)
-      {
-      nnodes = undoScene->GetNumberOfItems();
-      for (n=0; n<nnodes; n++)
-        {
-        vtkMRMLNode *node = vtkMRMLNode::SafeDownCast(undoScene->GetItemAsObject(n));
-        if (node && node->GetUndoEnabled())
-          {
-          undoMap[node->GetID()] = node;
-          }
-        }
-      }
-    }
-
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> >::iterator iter;
-  std::map<std::string, vtkWeakPointer<vtkMRMLNode> >::iterator curIter;
+  const UndoStackEntry& redoEntry = this->RedoStack.back();
+  const std::vector<std::string>& redoIDs = *redoEntry.NodeIDs;
+  std::unordered_set<std::string> redoIDSet(redoIDs.begin(), redoIDs.end());
 
   // copy back changes and add deleted nodes to the current scene
-  std::vector<vtkWeakPointer<vtkMRMLNode> > addNodes;
-  for(iter=undoMap.begin(); iter != undoMap.end(); iter++)
+  std::vector< vtkSmartPointer<vtkMRMLNode> > addNodes;
+  for (std::vector<std::string>::const_iterator iterID = redoIDs.begin(); iterID != redoIDs.end(); ++iterID)
     {
-    curIter = currentMap.find(iter->first);
-    if ( curIter == currentMap.end() )
+    std::unordered_map< std::string, vtkSmartPointer<vtkMRMLNode> >::const_iterator savedNodeIt =
+      redoEntry.SavedNodes.find(*iterID);
+    if (savedNodeIt == redoEntry.SavedNodes.end())
       {
-      // the node was deleted, add Node back to the current scene
-      addNodes.push_back(iter->second);
+      // the node was not changed by the undo
+      continue;
       }
-    else if (!curIter->second || !iter->second)
+    std::unordered_map<std::string, vtkWeakPointer<vtkMRMLNode> >::iterator curIter = currentMap.find(*iterID);
+    if (curIter == currentMap.end())
       {
-      continue;
+      // the node was deleted, add Node back to the current scene
+      addNodes.push_back(savedNodeIt->second);
       }
-    else if (iter->second != curIter->second)
+    else if (curIter->second
+      && vtkMRMLScene::IsNodeModifiedSince(curIter->second, redoEntry.SaveTime))
       {
       // nodes differ, copy from redo to current scene
-      // but before create a copy in undo stack from current
-      this->CopyNodeInUndoStack(curIter->second);
-      curIter->second->CopyWithSceneWithSingleModifiedEvent(iter->second);
+      curIter->second->CopyWithSceneWithSingleModifiedEvent(savedNodeIt->second);
       }
     }
 
   // remove new nodes created before Undo
-  std::vector<vtkWeakPointer<vtkMRMLNode> > removeNodes;
-  for(curIter=currentMap.begin(); curIter != currentMap.end(); curIter++)
+  std::vector< vtkWeakPointer<vtkMRMLNode> > removeNodes;
+  for (std::vector<std::string>::iterator curIterID = currentIDs.begin(); curIterID != currentIDs.end(); ++curIterID)
     {
-    if (!curIter->second)
-      {
-      continue;
-      }
-
-    iter = undoMap.find(curIter->first);
-    if ( iter == undoMap.end() )
+    if (redoIDSet.find(*curIterID) == redoIDSet.end())
       {
-      this->CopyNodeInUndoStack(curIter->second);
-      removeNodes.push_back(curIter->second);
+      removeNodes.push_back(currentMap[*curIterID]);
       }
     }
 
-  for (nn=0; nn<addNodes.size(); nn++)
+  for (size_t nn = 0; nn < addNodes.size(); nn++)
     {
     this->AddNode(addNodes[nn]);
     }
-  for (nn=0; nn<removeNodes.size(); nn++)
+  for (size_t nn = 0; nn < removeNodes.size(); nn++)
     {
-    this->RemoveNode(removeNodes[nn]);
+    if (removeNodes[nn])
+      {
+      this->RemoveNode(removeNodes[nn]);
+      }
     }
 
-  if (undoScene)
-    {
-    undoScene->RemoveAllItems();
-    undoScene->Delete();
-    }
   this->RedoStack.pop_back();
   this->Modified();
 
@@ -2964,24 +3017,14 @@ void vtkMRMLScene::Redo()
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ClearUndoStack()
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->UndoStack.begin(); iter != this->UndoStack.end(); iter++)
-    {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
-    }
   this->UndoStack.clear();
+  this->UndoSavedNodes.clear();
+  this->UndoStackReferenceIDsValid = false;
 }
 
 //------------------------------------------------------------------------------
 void vtkMRMLScene::ClearRedoStack()
 {
-  std::list< vtkCollection* >::iterator iter;
-  for(iter=this->RedoStack.begin(); iter != this->RedoStack.end(); iter++)
-    {
-    (*iter)->RemoveAllItems();
-    (*iter)->Delete();
-    }
   this->RedoStack.clear();
 }
 
@@ -3238,12 +3281,11 @@ void vtkMRMLScene::UpdateNodeChangedIDs()
       node = this->GetNodeByID(iterChanged->first.c_str());
       if (node)
         {
+        // NodeIDs map is updated in NodeCallback()
         node->SetID(iterChanged->second.c_str());
         }
       }
     }
-  this->NodeIDsMTime = 0;
-  this->UpdateNodeIDs();
 }
 
 //------------------------------------------------------------------------------
@@ -3310,6 +3352,213 @@ void vtkMRMLScene::ClearNodeIDs()
   }
 }
 
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::UpdateNodeClassIndex()
+{
+  if (this->Nodes->GetMTime() > this->NodesByClassMTime)
+    {
+    // The node collection has been modified without updating the index
+    // (e.g., nodes were added directly to the collection), start over.
+    this->ClearNodeClassIndex();
+    }
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<vtkMRMLNode*>& vtkMRMLScene::GetIndexedNodesByClass(const char* className)
+{
+  this->UpdateNodeClassIndex();
+  NodesByClassType::iterator classIt = this->NodesByClass.find(className);
+  if (classIt != this->NodesByClass.end())
+    {
+    return classIt->second;
+    }
+  // First query for this class, populate the index entry
+  std::vector<vtkMRMLNode*>& classNodes = this->NodesByClass[className];
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    if (node->IsA(className))
+      {
+      classNodes.push_back(node);
+      }
+    }
+  return classNodes;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToClassIndex(vtkMRMLNode* node)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  for (NodesByClassType::iterator classIt = this->NodesByClass.begin(); classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (node->IsA(classIt->first.c_str()))
+      {
+      classIt->second.push_back(node);
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromClassIndex(vtkMRMLNode* node)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  for (NodesByClassType::iterator classIt = this->NodesByClass.begin(); classIt != this->NodesByClass.end(); ++classIt)
+    {
+    if (!node->IsA(classIt->first.c_str()))
+      {
+      continue;
+      }
+    std::vector<vtkMRMLNode*>::iterator nodeIt = std::find(classIt->second.begin(), classIt->second.end(), node);
+    if (nodeIt != classIt->second.end())
+      {
+      classIt->second.erase(nodeIt);
+      }
+    }
+  this->NodesByClassMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::ClearNodeClassIndex()
+{
+  if (this->Nodes)
+    {
+    this->NodesByClass.clear();
+    this->NodesByClassMTime = this->Nodes->GetMTime();
+    }
+}
+
+//-----------------------------------------------------------------------------
+const std::vector<vtkMRMLNode*>* vtkMRMLScene::GetIndexedNodesByName(const char* name)
+{
+  this->UpdateNodeNameIndex();
+  NodesByNameType::const_iterator nameIt = this->NodesByName.find(std::string(name));
+  if (nameIt == this->NodesByName.end() || nameIt->second.empty())
+    {
+    return nullptr;
+    }
+  return &(nameIt->second);
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::UpdateNodeNameIndex()
+{
+  if (!this->Nodes || this->Nodes->GetMTime() <= this->NodesByNameMTime)
+    {
+    // up-to-date
+    return;
+    }
+#ifdef MRMLSCENE_VERBOSE
+  std::cerr << "Recompute node name index..." << std::endl;
+#endif
+  this->NodesByName.clear();
+  vtkMRMLNode *node;
+  vtkCollectionSimpleIterator it;
+  for (this->Nodes->InitTraversal(it);
+       (node = (vtkMRMLNode*)this->Nodes->GetNextItemAsObject(it)) ;)
+    {
+    if (node->GetName())
+      {
+      this->NodesByName[std::string(node->GetName())].push_back(node);
+      }
+    }
+  this->NodesByNameMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeToNameIndex(vtkMRMLNode* node, bool appended/*=true*/)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  if (this->NodesByNameMTime == 0)
+    {
+    // index has been invalidated, it will be rebuilt on next query
+    return;
+    }
+  if (node->GetName())
+    {
+    std::vector<vtkMRMLNode*>& namedNodes = this->NodesByName[std::string(node->GetName())];
+    if (!appended && !namedNodes.empty())
+      {
+      // position of the node relative to the other nodes with the same name
+      // is unknown, rebuild the index on next query
+      this->InvalidateNodeNameIndex();
+      return;
+      }
+    namedNodes.push_back(node);
+    }
+  this->NodesByNameMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeFromNameIndex(vtkMRMLNode* node, const char* name)
+{
+  if (!this->Nodes || !node)
+    {
+    return;
+    }
+  if (this->NodesByNameMTime == 0)
+    {
+    // index has been invalidated, it will be rebuilt on next query
+    return;
+    }
+  if (name)
+    {
+    NodesByNameType::iterator nameIt = this->NodesByName.find(std::string(name));
+    if (nameIt != this->NodesByName.end())
+      {
+      std::vector<vtkMRMLNode*>::iterator nodeIt = std::find(nameIt->second.begin(), nameIt->second.end(), node);
+      if (nodeIt != nameIt->second.end())
+        {
+        nameIt->second.erase(nodeIt);
+        }
+      if (nameIt->second.empty())
+        {
+        this->NodesByName.erase(nameIt);
+        }
+      }
+    }
+  this->NodesByNameMTime = this->Nodes->GetMTime();
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::InvalidateNodeNameIndex()
+{
+  this->NodesByName.clear();
+  this->NodesByNameMTime = 0;
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::AddNodeObservers(vtkMRMLNode* node)
+{
+  if (!node)
+    {
+    return;
+    }
+  node->AddObserver(vtkMRMLNode::IDChangedEvent, this->NodeEventCallback);
+  node->AddObserver(vtkMRMLNode::NameChangedEvent, this->NodeEventCallback);
+}
+
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::RemoveNodeObservers(vtkMRMLNode* node)
+{
+  if (!node)
+    {
+    return;
+    }
+  node->RemoveObserver(this->NodeEventCallback);
+}
+
 //------------------------------------------------------------------------------
 void vtkMRMLScene::AddURIHandler(vtkURIHandler *handler)
 {
@@ -3683,13 +3932,75 @@ void vtkMRMLScene::SetMaximumNumberOfSavedUndoStates(int stackSize)
   this->Modified();
 }
 
+//-----------------------------------------------------------------------------
+void vtkMRMLScene::SetMaximumUndoStackMemorySize(size_t bytes)
+{
+  if (bytes == this->MaximumUndoStackMemorySize)
+    {
+    return;
+    }
+
+  this->MaximumUndoStackMemorySize = bytes;
+  this->TrimUndoStack();
+  this->Modified();
+}
+
+//-----------------------------------------------------------------------------
+size_t vtkMRMLScene::GetUndoStackMemorySize()
+{
+  size_t memorySize = 0;
+  for (UndoStackType::iterator entryIt = this->UndoStack.begin(); entryIt != this->UndoStack.end(); ++entryIt)
+    {
+    memorySize += entryIt->MemorySize;
+    }
+  return memorySize;
+}
+
 //-----------------------------------------------------------------------------
 void vtkMRMLScene::TrimUndoStack()
 {
-  std::list<vtkSmartPointer<vtkCollection> > removedStacks;
-  while(static_cast<int>(this->UndoStack.size()) > this->MaximumNumberOfSavedUndoStates)
+  while (!this->UndoStack.empty())
     {
-    removedStacks.push_back(this->UndoStack.front());
+    bool tooManyStates = (static_cast<int>(this->UndoStack.size()) > this->MaximumNumberOfSavedUndoStates);
+    bool tooMuchMemory = (this->MaximumUndoStackMemorySize > 0 && this->UndoStack.size() > 1
+      && this->GetUndoStackMemorySize() > this->MaximumUndoStackMemorySize);
+    if (!tooManyStates && !tooMuchMemory)
+      {
+      break;
+      }
+
+    UndoStackEntry& removedEntry = this->UndoStack.front();
+    UndoStackType::iterator nextEntryIt = this->UndoStack.begin();
+    ++nextEntryIt;
+
+    // The next entry shares the saved nodes of the removed entry for all the
+    // nodes that have not been modified in between: move them to the next entry.
+    std::unordered_set<std::string> nextNodeIDs;
+    if (nextEntryIt != this->UndoStack.end() && nextEntryIt->NodeIDs != removedEntry.NodeIDs)
+      {
+      nextNodeIDs.insert(nextEntryIt->NodeIDs->begin(), nextEntryIt->NodeIDs->end());
+      }
+    std::unordered_map< std::string, vtkSmartPointer<vtkMRMLNode> >::iterator savedNodeIt;
+    for (savedNodeIt = removedEntry.SavedNodes.begin(); savedNodeIt != removedEntry.SavedNodes.end(); ++savedNodeIt)
+      {
+      if (nextEntryIt != this->UndoStack.end()
+        && nextEntryIt->SavedNodes.find(savedNodeIt->first) == nextEntryIt->SavedNodes.end()
+        && (nextEntryIt->NodeIDs == removedEntry.NodeIDs || nextNodeIDs.find(savedNodeIt->first) != nextNodeIDs.end()))
+        {
+        nextEntryIt->SavedNodes[savedNodeIt->first] = savedNodeIt->second;
+        nextEntryIt->MemorySize += vtkMRMLScene::GetUndoNodeMemorySize(savedNodeIt->second);
+        continue;
+        }
+      std::unordered_map<std::string, UndoSavedNodeInfo>::iterator savedNodeInfoIt =
+        this->UndoSavedNodes.find(savedNodeIt->first);
+      if (savedNodeInfoIt != this->UndoSavedNodes.end()
+        && savedNodeInfoIt->second.SavedNode == savedNodeIt->second.GetPointer())
+        {
+        this->UndoSavedNodes.erase(savedNodeInfoIt);
+        }
+      }
+
     this->UndoStack.pop_front();
+    this->UndoStackReferenceIDsValid = false;
     }
 }
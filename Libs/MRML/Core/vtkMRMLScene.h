@@ -30,8 +30,10 @@ Version:   $Revision: 1.18 $
 // STD includes
 #include <list>
 #include <map>
+#include <memory>
 #include <set>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 class vtkCacheManager;
@@ -295,7 +297,10 @@ public:
   /// Get number of nodes of a specified class in the scene
   int GetNumberOfNodesByClass(const char* className);
 
-  /// Get vector of nodes of a specified class in the scene
+  /// Get vector of nodes of a specified class in the scene.
+  /// \a nodes is cleared first (the found nodes are not appended to its
+  /// previous content), therefore the same vector can be reused for multiple queries.
+  /// Returns the number of found nodes.
   int GetNodesByClass(const char *className, std::vector<vtkMRMLNode *> &nodes);
 
   /// \warning You are responsible for deleting the returned collection.
@@ -369,21 +374,26 @@ public:
   /// returns number of redo steps in the history buffer
   int GetNumberOfRedoLevels() {return static_cast<int>(this->RedoStack.size());}
 
-  /// Save current state in the undo buffer
+  /// Save current state in the undo buffer.
+  /// Only the undo-enabled nodes that have been modified since their state
+  /// was last saved are copied, unchanged node states are shared with the
+  /// previous undo levels.
   void SaveStateForUndo();
 
   /// Save current state of the node in the undo buffer
   /// \deprecated Use SaveStateForUndo() instead.
   /// Storing of only selected nodes may result in incomplete saving of
   /// important changes in the scene. Instead, each node's UndoEnabled flag
-  /// will tell if that node's state must be stored or not.
+  /// will tell if that node's state must be stored or not: the state of all
+  /// modified undo-enabled nodes is saved, as in SaveStateForUndo().
   void SaveStateForUndo(vtkMRMLNode *node);
 
   /// Save current state of the nodes in the undo buffer
   /// \deprecated Use SaveStateForUndo() instead.
   /// Storing of only selected nodes may result in incomplete saving of
   /// important changes in the scene. Instead, each node's UndoEnabled flag
-  /// will tell if that node's state must be stored or not.
+  /// will tell if that node's state must be stored or not: the state of all
+  /// modified undo-enabled nodes is saved, as in SaveStateForUndo().
   void SaveStateForUndo(vtkCollection *nodes);
   void SaveStateForUndo(std::vector<vtkMRMLNode *> nodes);
 
@@ -745,19 +755,91 @@ public:
   void SetMaximumNumberOfSavedUndoStates(int stackSize);
   vtkGetMacro(MaximumNumberOfSavedUndoStates, int);
 
+  /// \brief Sets the maximum memory (in bytes) used by the saved undo states and removes
+  /// the oldest saved states until the memory usage is below the limit.
+  /// The most recent saved state is always kept. 0 (default) means no limit.
+  /// Memory usage is an estimate of the size of the node copies: it includes
+  /// the bulk data that is duplicated when a node is copied (segment
+  /// representations, markups control points...) but not the bulk data that
+  /// is shared between the copy and the node (model polydata, volume image data...).
+  /// \sa vtkMRMLNode::GetCopiedDataMemorySize()
+  /// \sa GetUndoStackMemorySize()
+  void SetMaximumUndoStackMemorySize(size_t bytes);
+  vtkGetMacro(MaximumUndoStackMemorySize, size_t);
+
+  /// Returns the estimated memory (in bytes) used by the saved undo states.
+  /// \sa SetMaximumUndoStackMemorySize()
+  size_t GetUndoStackMemorySize();
+
 protected:
 
   typedef std::map< std::string, std::set<std::string> > NodeReferencesType;
+  typedef std::map< std::string, std::vector<vtkMRMLNode*> > NodesByClassType;
+  typedef std::unordered_map< std::string, std::vector<vtkMRMLNode*> > NodesByNameType;
+  typedef std::unordered_map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDsType;
+
+  /// Saved state of the scene in the undo or redo stack.
+  /// An undo entry only stores copies of the nodes that have been modified
+  /// since their state was last saved, the state of the other nodes is found
+  /// in the entries below it in the stack (see FindNodeInUndoStack()).
+  /// A redo entry stores copies of the nodes that were changed by the undo.
+  /// Node copies are never modified once saved.
+  struct UndoStackEntry
+    {
+    UndoStackEntry() : SaveTime(0), MemorySize(0) {}
+    /// Global modification time when the state was saved: nodes with a
+    /// larger content modification time have been changed since.
+    /// \sa vtkMRMLNode::GetContentModifiedTime()
+    vtkMTimeType SaveTime;
+    /// IDs of the undo-enabled nodes of the scene (in scene order).
+    /// The list is shared between consecutive entries if it does not change.
+    std::shared_ptr< const std::vector<std::string> > NodeIDs;
+    /// Copies of the nodes (indexed by node ID) saved in this entry.
+    std::unordered_map< std::string, vtkSmartPointer<vtkMRMLNode> > SavedNodes;
+    /// Estimated memory used by the node copies in this entry (in bytes).
+    size_t MemorySize;
+    };
+  typedef std::list<UndoStackEntry> UndoStackType;
+
+  /// Most recent copy of a node in the undo stack.
+  struct UndoSavedNodeInfo
+    {
+    UndoSavedNodeInfo() : SavedNode(nullptr), NodeMTime(0) {}
+    vtkWeakPointer<vtkMRMLNode> Node;
+    vtkMRMLNode* SavedNode;
+    vtkMTimeType NodeMTime;
+    };
 
   vtkMRMLScene();
   ~vtkMRMLScene() override;
 
+  /// Add a new entry to the undo stack and save in it the undo-enabled nodes
+  /// modified since their state was last saved.
   void PushIntoUndoStack();
+  /// Add a new, empty, entry to the redo stack.
   void PushIntoRedoStack();
 
+  /// Save a copy of the node in the top entry of the undo stack.
   void CopyNodeInUndoStack(vtkMRMLNode *node);
+  /// Save a copy of the node in the top entry of the redo stack.
   void CopyNodeInRedoStack(vtkMRMLNode *node);
 
+  /// Returns the most recent saved copy of a node in the undo stack, starting
+  /// the search at entryIt and going down the stack. Returns nullptr if not found.
+  vtkMRMLNode* FindNodeInUndoStack(UndoStackType::reverse_iterator entryIt, const std::string& nodeID);
+
+  /// Returns the list of IDs of the undo-enabled nodes of the scene, shares
+  /// the list of the reference entry if it is identical.
+  std::shared_ptr< const std::vector<std::string> > GetUndoEnabledNodeIDs(const UndoStackEntry* referenceEntry);
+
+  /// Returns true if the node has been modified after the given time,
+  /// including changes that only invoked a custom modified event.
+  /// \sa vtkMRMLNode::GetContentModifiedTime()
+  static bool IsNodeModifiedSince(vtkMRMLNode* node, vtkMTimeType time);
+
+  /// Returns an estimate of the memory used by a copy of the node (in bytes).
+  static size_t GetUndoNodeMemorySize(vtkMRMLNode* node);
+
   /// Add a node to the scene without invoking a vtkMRMLScene::NodeAddedEvent event.
   ///
   /// \warning Use with extreme caution as it might unsynchronize observer.
@@ -771,6 +853,15 @@ protected:
   /// Handle vtkMRMLScene::DeleteEvent: clear the scene.
   static void SceneCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData);
 
+  /// Handle vtkMRMLNode::IDChangedEvent and vtkMRMLNode::NameChangedEvent of
+  /// the nodes of the scene: keep the \a NodeIDs map and \a NodesByName index up-to-date.
+  static void NodeCallback(vtkObject *caller, unsigned long eid, void *clientData, void *callData);
+
+  /// Observe ID and name changes of a node added to the scene.
+  void AddNodeObservers(vtkMRMLNode* node);
+  /// Remove observers added by AddNodeObservers().
+  void RemoveNodeObservers(vtkMRMLNode* node);
+
   std::string GenerateUniqueID(vtkMRMLNode* node);
   std::string GenerateUniqueID(const std::string& baseID);
   int GetUniqueIDIndex(const std::string& baseID);
@@ -802,10 +893,59 @@ protected:
   /// Clear NodeIDs map used to speedup GetByID() method.
   void ClearNodeIDs();
 
+  /// \brief Get nodes of the class (or subclasses) \a className from the
+  /// \a NodesByClass index used to speedup GetNodesByClass() and related methods.
+  ///
+  /// Index entries are populated on demand (the first time a class is queried)
+  /// and then kept in sync by AddNodeToClassIndex() and RemoveNodeFromClassIndex().
+  /// Nodes are stored in the same order as in the \a Nodes collection.
+  /// \warning The returned vector is invalidated when nodes are added to or
+  /// removed from the scene.
+  const std::vector<vtkMRMLNode*>& GetIndexedNodesByClass(const char* className);
+
+  /// Clear the \a NodesByClass index if it is not in sync with \a Nodes collection.
+  void UpdateNodeClassIndex();
+
+  /// Add node to all the \a NodesByClass index entries it belongs to.
+  void AddNodeToClassIndex(vtkMRMLNode* node);
+
+  /// Remove node from all the \a NodesByClass index entries it belongs to.
+  void RemoveNodeFromClassIndex(vtkMRMLNode* node);
+
+  /// Clear NodesByClass index used to speedup GetNodesByClass() method.
+  void ClearNodeClassIndex();
+
+  /// \brief Get nodes that have the name \a name from the \a NodesByName index
+  /// used to speedup GetFirstNodeByName() and related methods.
+  ///
+  /// Returns nullptr if there is no node with that name.
+  /// Nodes are stored in the same order as in the \a Nodes collection.
+  /// \warning The returned vector is invalidated when nodes are added to or
+  /// removed from the scene or renamed.
+  const std::vector<vtkMRMLNode*>* GetIndexedNodesByName(const char* name);
+
+  /// Rebuild the \a NodesByName index if it is not in sync with \a Nodes collection.
+  void UpdateNodeNameIndex();
+
+  /// \brief Add node to the \a NodesByName index.
+  ///
+  /// If \a appended is false, the node has been inserted in the middle of the
+  /// \a Nodes collection and the index is invalidated if the name is not unique,
+  /// so that nodes are kept in scene order.
+  void AddNodeToNameIndex(vtkMRMLNode* node, bool appended = true);
+
+  /// Remove node from the \a NodesByName index entry of \a name.
+  void RemoveNodeFromNameIndex(vtkMRMLNode* node, const char* name);
+
+  /// Clear the NodesByName index, it is rebuilt on next query.
+  void InvalidateNodeNameIndex();
+
   /// Get a NodeReferences iterator for a node reference.
   NodeReferencesType::iterator FindNodeReference(const char* referencedId, vtkMRMLNode* referencingNode);
 
-  /// Clean up elements of the undo/redo stack beyond the maximum size
+  /// Clean up elements of the undo/redo stack beyond the maximum size or
+  /// memory usage. Node copies of the removed entries that are still needed
+  /// by the next entry are moved to it.
   void TrimUndoStack();
 
   /// Reserve all node reference ids for a node
@@ -835,8 +975,20 @@ protected:
   int  MaximumNumberOfSavedUndoStates;
   bool UndoFlag;
 
-  std::list< vtkCollection* >  UndoStack;
-  std::list< vtkCollection* >  RedoStack;
+  size_t MaximumUndoStackMemorySize;
+
+  UndoStackType  UndoStack;
+  UndoStackType  RedoStack;
+
+  // Most recent copy of each node in the undo stack, indexed by node ID.
+  // Used for deciding if a node needs to be copied when the state is saved.
+  std::unordered_map< std::string, UndoSavedNodeInfo > UndoSavedNodes;
+
+  // Cache of the IDs referenced by the nodes of the undo stack
+  // (saved node copies are never modified, so it is only invalidated
+  // when entries are added or removed).
+  mutable std::set<std::string> UndoStackReferenceIDs;
+  mutable bool UndoStackReferenceIDsValid;
 
   std::string                 URL;
   std::string                 RootDirectory;
@@ -850,7 +1002,16 @@ protected:
 
   NodeReferencesType NodeReferences; // ReferencedIDs (string), ReferencingNodes (node pointer)
   std::map< std::string, std::string > ReferencedIDChanges;
-  std::map< std::string, vtkSmartPointer<vtkMRMLNode> > NodeIDs;
+  NodeIDsType NodeIDs;
+
+  // Nodes of the scene indexed by their names.
+  // Pointers are not reference counted, the Nodes collection owns the nodes.
+  NodesByNameType NodesByName;
+
+  // Nodes of the scene indexed by the class names that have been queried
+  // (a node is listed in the entry of its own class and all its superclasses).
+  // Pointers are not reference counted, the Nodes collection owns the nodes.
+  NodesByClassType NodesByClass;
 
   // Stores default nodes. If a class is created or reset (using CreateNodeByClass or Clear) and
   // a default node is defined for it then the content of the default node will be used to initialize
@@ -868,6 +1029,8 @@ protected:
   int ReadDataOnLoad;
 
   vtkMTimeType  NodeIDsMTime;
+  vtkMTimeType  NodesByClassMTime;
+  vtkMTimeType  NodesByNameMTime;
 
   void RemoveAllNodes(bool removeSingletons);
 
@@ -875,6 +1038,7 @@ protected:
   char * LastLoadedVersion;
 
   vtkCallbackCommand *DeleteEventCallback;
+  vtkCallbackCommand *NodeEventCallback;
 
 private:
 
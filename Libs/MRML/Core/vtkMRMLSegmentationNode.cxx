@@ -58,6 +58,7 @@
 
 // STD includes
 #include <algorithm>
+#include <set>
 
 //----------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLSegmentationNode);
@@ -170,6 +171,33 @@ void vtkMRMLSegmentationNode::DeepCopy(vtkMRMLNode* aNode)
   Copy(aNode);
 }
 
+//----------------------------------------------------------------------------
+size_t vtkMRMLSegmentationNode::GetCopiedDataMemorySize()
+{
+  if (!this->Segmentation)
+    {
+    return 0;
+    }
+  // Segments may share the same data object (e.g., binary labelmap layers), count each only once
+  std::set<vtkDataObject*> dataObjects;
+  size_t memorySizeKiB = 0;
+  for (int segmentIndex = 0; segmentIndex < this->Segmentation->GetNumberOfSegments(); ++segmentIndex)
+    {
+    vtkSegment* segment = this->Segmentation->GetNthSegment(segmentIndex);
+    std::vector<std::string> representationNames;
+    segment->GetContainedRepresentationNames(representationNames);
+    for (std::vector<std::string>::iterator nameIt = representationNames.begin(); nameIt != representationNames.end(); ++nameIt)
+      {
+      vtkDataObject* dataObject = segment->GetRepresentation(*nameIt);
+      if (dataObject && dataObjects.insert(dataObject).second)
+        {
+        memorySizeKiB += dataObject->GetActualMemorySize();
+        }
+      }
+    }
+  return memorySizeKiB * 1024;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLSegmentationNode::PrintSelf(ostream& os, vtkIndent indent)
 {
@@ -74,6 +74,9 @@ public:
   /// Copy the entire contents of the node into this node
   virtual void DeepCopy(vtkMRMLNode* node);
 
+  /// Segment representations are deep-copied by Copy(), returns their memory size.
+  size_t GetCopiedDataMemorySize() override;
+
   /// Get unique node XML tag name (like Volume, Model)
   const char* GetNodeTagName() override {return "Segmentation";};
 
@@ -96,6 +96,11 @@ vtkMRMLNodeNewMacro(vtkMRMLSegmentationStorageNode);
 vtkMRMLSegmentationStorageNode::vtkMRMLSegmentationStorageNode()
   : CropToMinimumExtent(false)
 {
+  this->CompressionPresets.push_back(vtkMRMLStorageNode::CompressionPreset(this->GetCompressionParameterFastest(), "Fastest"));
+  this->CompressionPresets.push_back(vtkMRMLStorageNode::CompressionPreset(this->GetCompressionParameterNormal(), "Normal"));
+  this->CompressionPresets.push_back(vtkMRMLStorageNode::CompressionPreset(this->GetCompressionParameterMinimumSize(), "Minimum size"));
+
+  this->CompressionParameter = this->GetCompressionParameterNormal();
 }
 
 //----------------------------------------------------------------------------
@@ -1146,6 +1151,7 @@ int vtkMRMLSegmentationStorageNode::WriteBinaryLabelmapRepresentation(vtkMRMLSeg
   vtkNew<vtkTeemNRRDWriter> writer;
   writer->SetFileName(fullName.c_str());
   writer->SetUseCompression(this->GetUseCompression());
+  writer->SetCompressionLevel(this->GetGzipCompressionLevelFromCompressionParameter(this->CompressionParameter));
   writer->SetSpace(nrrdSpaceLeftPosteriorSuperior);
   writer->SetMeasurementFrameMatrix(nullptr);
 
@@ -1674,3 +1680,21 @@ void vtkMRMLSegmentationStorageNode::GetSegmentColorFromString(double color[3],
   color[2] = 0.5;
   colorStream >> color[0] >> color[1] >> color[2];
 }
+
+//----------------------------------------------------------------------------
+int vtkMRMLSegmentationStorageNode::GetGzipCompressionLevelFromCompressionParameter(std::string compressionParameter)
+{
+  if (compressionParameter == this->GetCompressionParameterFastest())
+    {
+    return 1;
+    }
+  else if (compressionParameter == this->GetCompressionParameterNormal())
+    {
+    return 6;
+    }
+  else if (compressionParameter == this->GetCompressionParameterMinimumSize())
+    {
+    return 9;
+    }
+  return 6;
+}
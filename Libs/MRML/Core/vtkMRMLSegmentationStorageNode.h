@@ -180,7 +180,17 @@ public:
   vtkGetMacro(CropToMinimumExtent, bool);
   vtkBooleanMacro(CropToMinimumExtent, bool);
 
+  /// Compression parameter corresponding to minimum compression (fast)
+  std::string GetCompressionParameterFastest() { return "gzip_fastest"; };
+  /// Compression parameter corresponding to normal compression
+  std::string GetCompressionParameterNormal() { return "gzip_normal"; };
+  /// Compression parameter corresponding to maximum compression (slow)
+  std::string GetCompressionParameterMinimumSize() { return "gzip_minimum_size"; };
+
 protected:
+  /// Convert compression parameter string to gzip compression level
+  int GetGzipCompressionLevelFromCompressionParameter(std::string parameter);
+
   /// Initialize all the supported read file types
   void InitializeSupportedReadFileTypes() override;
 
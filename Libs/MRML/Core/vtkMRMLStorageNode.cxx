@@ -1222,6 +1222,26 @@ int vtkMRMLStorageNode::ReadData(vtkMRMLNode* refNode, bool temporary)
   return res;
 }
 
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::ProbeData(vtkMRMLNode* refNode)
+{
+  if (refNode == nullptr || !this->CanReadInReferenceNode(refNode))
+    {
+    return 0;
+    }
+  if (this->GetFileName() == nullptr || this->GetURI() != nullptr)
+    {
+    // remote files are only available after ReadData() downloaded them
+    return -1;
+    }
+  std::string fullName = this->GetFullNameFromFileName();
+  if (fullName.empty() || !vtksys::SystemTools::FileExists(fullName))
+    {
+    return -1;
+    }
+  return this->ProbeDataInternal(refNode);
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteData(vtkMRMLNode* refNode)
 {
@@ -1254,6 +1274,12 @@ int vtkMRMLStorageNode::ReadDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
   return 0;
 }
 
+//------------------------------------------------------------------------------
+int vtkMRMLStorageNode::ProbeDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
+{
+  return -1;
+}
+
 //------------------------------------------------------------------------------
 int vtkMRMLStorageNode::WriteDataInternal(vtkMRMLNode* vtkNotUsed(refNode))
 {
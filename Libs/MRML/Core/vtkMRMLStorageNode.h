@@ -57,6 +57,14 @@ public:
   /// \sa SetFileName(), ReadDataInternal(), GetStoredTime()
   virtual int ReadData(vtkMRMLNode *refNode, bool temporaryFile = false);
 
+  /// Check if the file can be read into the referenced node by only reading
+  /// the file header, without reading the data.
+  /// Return 1 if the file content matches the node, 0 if it does not and -1
+  /// if it can't be told without reading the data (e.g. remote file that
+  /// has not been downloaded yet, or probing not supported by the reader).
+  /// \sa ReadData(), ProbeDataInternal()
+  virtual int ProbeData(vtkMRMLNode *refNode);
+
   ///
   /// Write data from a  referenced node
   /// Return 1 on success, 0 on failure.
@@ -381,6 +389,12 @@ protected:
   /// To be reimplemented in subclass.
   virtual int ReadDataInternal(vtkMRMLNode* refNode);
 
+  /// Does the actual probing of the local file header.
+  /// Returns -1 by default (probing not supported).
+  /// To be reimplemented in subclass.
+  /// \sa ProbeData()
+  virtual int ProbeDataInternal(vtkMRMLNode* refNode);
+
   /// Does the actual writing. Returns 1 on success, 0 otherwise.
   /// Returns 0 by default (write not supported).
   /// To be reimplemented in subclass.
@@ -36,7 +36,7 @@ Version:   $Revision: 1.6 $
 #include <vtkCallbackCommand.h>
 #include <vtkDataArray.h>
 #include <vtkErrorCode.h>
-#include <vtkImageChangeInformation.h>
+#include <vtkImageData.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
 #include <vtkSmartPointer.h>
@@ -448,20 +448,18 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
       }
     }
 
-  vtkNew<vtkImageChangeInformation> ici;
-  ici->SetInputConnection(reader->GetOutputPort());
-  ici->SetOutputSpacing( 1, 1, 1 );
-  ici->SetOutputOrigin( 0, 0, 0 );
-  ici->Update();
-
-  if (ici->GetOutput() == nullptr)
+  if (reader->GetOutput() == nullptr)
     {
     vtkErrorMacro("ReadDataInternal: Cannot read file: " << fullName);
     return 0;
     }
 
+  // The voxels are shared with the reader output, they are not copied.
+  // Spacing and origin are stored in the volume node IJK to RAS matrix.
   vtkNew<vtkImageData> iciOutputCopy;
-  iciOutputCopy->ShallowCopy(ici->GetOutput());
+  iciOutputCopy->ShallowCopy(reader->GetOutput());
+  iciOutputCopy->SetSpacing(1, 1, 1);
+  iciOutputCopy->SetOrigin(0, 0, 0);
   volNode->SetAndObserveImageData(iciOutputCopy.GetPointer());
 
   // Log volume size to the application log. It helps to identify potential out-of-memory issues.
@@ -486,6 +484,61 @@ int vtkMRMLVolumeArchetypeStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLVolumeArchetypeStorageNode::ProbeDataInternal(vtkMRMLNode *refNode)
+{
+  std::string fullName = this->GetFullNameFromFileName();
+  if (refNode->IsA("vtkMRMLVectorVolumeNode"))
+    {
+    // the vector reader is only instantiated if the header describes
+    // at least 3 components
+    vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+    reader.TakeReference(this->InstantiateVectorVolumeReader(fullName));
+    if (reader.GetPointer() == nullptr)
+      {
+      return 0;
+      }
+    unsigned int numberOfComponents = reader->GetNumberOfComponents();
+    // 6 or 9 components may as well be a tensor volume, let ReadData decide
+    return (numberOfComponents == 6 || numberOfComponents == 9) ? -1 : 1;
+    }
+
+  vtkSmartPointer<vtkITKArchetypeImageSeriesReader> reader;
+  if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeDiffusionTensorImageReaderFile>::New();
+    }
+  else
+    {
+    reader = vtkSmartPointer<vtkITKArchetypeImageSeriesScalarReader>::New();
+    }
+  reader->SetSingleFile( this->GetSingleFile() );
+  reader->SetUseOrientationFromFile( this->GetUseOrientationFromFile() );
+  reader->ResetFileNames();
+  reader->SetArchetype(fullName.c_str());
+  ApplyImageSeriesReaderWorkaround(this, reader, fullName);
+  try
+    {
+    // Only the header is read
+    reader->UpdateInformation();
+    }
+  catch ( ... )
+    {
+    return 0;
+    }
+  if (reader->GetErrorCode() != vtkErrorCode::NoError)
+    {
+    return 0;
+    }
+
+  unsigned int numberOfComponents = reader->GetNumberOfComponents();
+  if (refNode->IsA("vtkMRMLDiffusionTensorVolumeNode"))
+    {
+    return (numberOfComponents == 6 || numberOfComponents == 9) ? 1 : 0;
+    }
+  return numberOfComponents == 1 ? 1 : 0;
+}
+
 //----------------------------------------------------------------------------
 int vtkMRMLVolumeArchetypeStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
 {
@@ -104,6 +104,10 @@ protected:
   /// Read data and set it in the referenced node
   int ReadDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Check the number of components found in the file header
+  /// without reading the voxels.
+  int ProbeDataInternal(vtkMRMLNode *refNode) override;
+
   /// Write data from a referenced node
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
@@ -90,6 +90,13 @@ class VTK_MRML_EXPORT vtkObservation : public vtkObject
   vtkGetMacro (TotalElapsedTime, double);
   vtkSetMacro (TotalElapsedTime, double);
 
+  /// Description
+  /// Number of invocations and longest elapsed time of a single invocation
+  vtkGetMacro (NumberOfInvocations, int);
+  vtkSetMacro (NumberOfInvocations, int);
+  vtkGetMacro (MaxElapsedTime, double);
+  vtkSetMacro (MaxElapsedTime, double);
+
   struct CallType
   {
     inline CallType(unsigned long eventID, void* callData);
@@ -159,6 +166,8 @@ protected:
 
   double LastElapsedTime;
   double TotalElapsedTime;
+  double MaxElapsedTime;
+  int NumberOfInvocations;
 
 };
 
@@ -0,0 +1,187 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRMLLogic includes
+#include "vtkImageLabelmapsToRGBA.h"
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkLookupTable.h>
+#include <vtkNew.h>
+#include <vtkSmartPointer.h>
+#include <vtkTimerLog.h>
+#include <vtkTrivialProducer.h>
+
+// STD includes
+#include <cstdlib>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Create a labelmap that contains the specified label in the [x0,x1]x[y0,y1] rectangle
+vtkSmartPointer<vtkImageData> CreateLabelmap(int dimensions[2], int labelValue, int x0, int x1, int y0, int y1)
+{
+  vtkSmartPointer<vtkImageData> labelmap = vtkSmartPointer<vtkImageData>::New();
+  labelmap->SetDimensions(dimensions[0], dimensions[1], 1);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  for (int y = 0; y < dimensions[1]; ++y)
+    {
+    for (int x = 0; x < dimensions[0]; ++x)
+      {
+      bool inside = (x >= x0 && x <= x1 && y >= y0 && y <= y1);
+      *static_cast<unsigned char*>(labelmap->GetScalarPointer(x, y, 0)) = (inside ? labelValue : 0);
+      }
+    }
+  return labelmap;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkLookupTable> CreateLookupTable(int labelValue, double r, double g, double b, double a)
+{
+  vtkSmartPointer<vtkLookupTable> lookupTable = vtkSmartPointer<vtkLookupTable>::New();
+  lookupTable->SetNumberOfTableValues(labelValue + 1);
+  lookupTable->SetRange(0, labelValue);
+  lookupTable->Build();
+  for (int i = 0; i < labelValue; ++i)
+    {
+    lookupTable->SetTableValue(i, 0.0, 0.0, 0.0, 0.0);
+    }
+  lookupTable->SetTableValue(labelValue, r, g, b, a);
+  return lookupTable;
+}
+
+//----------------------------------------------------------------------------
+bool CheckPixel(vtkImageData* image, int x, int y, int r, int g, int b, int a)
+{
+  unsigned char* pixel = static_cast<unsigned char*>(image->GetScalarPointer(x, y, 0));
+  int expected[4] = { r, g, b, a };
+  for (int c = 0; c < 4; ++c)
+    {
+    if (abs(pixel[c] - expected[c]) > 1)
+      {
+      std::cerr << "Pixel (" << x << ", " << y << ") mismatch: "
+        << int(pixel[0]) << ", " << int(pixel[1]) << ", " << int(pixel[2]) << ", " << int(pixel[3])
+        << " (expected " << r << ", " << g << ", " << b << ", " << a << ")" << std::endl;
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+int TestCompositing()
+{
+  int dimensions[2] = { 20, 20 };
+
+  // First labelmap: opaque red filled square
+  vtkNew<vtkTrivialProducer> squareProducer;
+  squareProducer->SetOutput(CreateLabelmap(dimensions, 1, 5, 14, 5, 14));
+  vtkSmartPointer<vtkLookupTable> squareFill = CreateLookupTable(1, 1.0, 0.0, 0.0, 1.0);
+
+  // Second labelmap: half-transparent blue fill with green outline,
+  // overlaps with the first labelmap and touches the image boundary.
+  vtkNew<vtkTrivialProducer> barProducer;
+  barProducer->SetOutput(CreateLabelmap(dimensions, 2, 10, 19, 0, 19));
+  vtkSmartPointer<vtkLookupTable> barFill = CreateLookupTable(2, 0.0, 0.0, 1.0, 0.5);
+  vtkSmartPointer<vtkLookupTable> barOutline = CreateLookupTable(2, 0.0, 1.0, 0.0, 1.0);
+
+  vtkNew<vtkImageLabelmapsToRGBA> compositor;
+  EXERCISE_BASIC_OBJECT_METHODS(compositor.GetPointer());
+  compositor->AddLabelmapConnection(squareProducer->GetOutputPort(), squareFill, nullptr);
+  compositor->AddLabelmapConnection(barProducer->GetOutputPort(), barFill, barOutline);
+  CHECK_INT(compositor->GetNumberOfLabelmaps(), 2);
+  compositor->Update();
+
+  vtkImageData* output = compositor->GetOutput();
+  CHECK_INT(output->GetScalarType(), VTK_UNSIGNED_CHAR);
+  CHECK_INT(output->GetNumberOfScalarComponents(), 4);
+
+  int barAlpha = barFill->MapValue(2)[3];
+  double blend = barAlpha / 255.0;
+
+  // Background
+  CHECK_BOOL(CheckPixel(output, 0, 0, 0, 0, 0, 0), true);
+  // Square only
+  CHECK_BOOL(CheckPixel(output, 7, 7, 255, 0, 0, 255), true);
+  // Square and interior of the bar
+  CHECK_BOOL(CheckPixel(output, 12, 7, int(255 * (1.0 - blend) + 0.5), 0, int(255 * blend + 0.5), 255), true);
+  // Bar only
+  CHECK_BOOL(CheckPixel(output, 15, 2, 0, 0, 255, barAlpha), true);
+  // Bar outline (at label boundary and at image boundary), fill is blended over the outline
+  CHECK_BOOL(CheckPixel(output, 10, 7, 0, int(255 * (1.0 - blend) + 0.5), int(255 * blend + 0.5), 255), true);
+  CHECK_BOOL(CheckPixel(output, 19, 7, 0, int(255 * (1.0 - blend) + 0.5), int(255 * blend + 0.5), 255), true);
+  CHECK_BOOL(CheckPixel(output, 11, 7, int(255 * (1.0 - blend) + 0.5), 0, int(255 * blend + 0.5), 255), true);
+
+  // Thicker outline
+  compositor->SetOutline(2);
+  compositor->Update();
+  CHECK_BOOL(CheckPixel(output, 11, 7, 0, int(255 * (1.0 - blend) + 0.5), int(255 * blend + 0.5), 255), true);
+
+  // Lookup table change is detected
+  barOutline->SetTableValue(2, 0.0, 1.0, 0.0, 0.0);
+  compositor->Update();
+  CHECK_BOOL(CheckPixel(output, 10, 7, int(255 * (1.0 - blend) + 0.5), 0, int(255 * blend + 0.5), 255), true);
+
+  compositor->RemoveAllLabelmaps();
+  CHECK_INT(compositor->GetNumberOfLabelmaps(), 0);
+
+  return EXIT_SUCCESS;
+}
+
+//----------------------------------------------------------------------------
+int TestPerformance()
+{
+  // Many overlapping labelmap layers, as in a segmentation with many overlapping segments
+  const int numberOfLabelmaps = 100;
+  int dimensions[2] = { 512, 512 };
+  std::vector< vtkSmartPointer<vtkTrivialProducer> > producers;
+  std::vector< vtkSmartPointer<vtkLookupTable> > lookupTables;
+  vtkNew<vtkImageLabelmapsToRGBA> compositor;
+  for (int i = 0; i < numberOfLabelmaps; ++i)
+    {
+    vtkSmartPointer<vtkTrivialProducer> producer = vtkSmartPointer<vtkTrivialProducer>::New();
+    producer->SetOutput(CreateLabelmap(dimensions, 1, i, 300 + i * 2, 2 * i, 400));
+    vtkSmartPointer<vtkLookupTable> lookupTable = CreateLookupTable(1, 0.01 * i, 0.5, 1.0 - 0.01 * i, 0.5);
+    compositor->AddLabelmapConnection(producer->GetOutputPort(), lookupTable, lookupTable);
+    producers.push_back(producer);
+    lookupTables.push_back(lookupTable);
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  compositor->Update();
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"vtkImageLabelmapsToRGBA-100Labelmaps\" "
+            << "type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  CHECK_INT(compositor->GetOutput()->GetDimensions()[0], dimensions[0]);
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkImageLabelmapsToRGBATest1(int, char* [])
+{
+  CHECK_EXIT_SUCCESS(TestCompositing());
+  CHECK_EXIT_SUCCESS(TestPerformance());
+  return EXIT_SUCCESS;
+}
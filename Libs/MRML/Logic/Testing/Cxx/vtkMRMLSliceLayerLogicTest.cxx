@@ -24,21 +24,34 @@
 // MRML includes
 #include "vtkMRMLCoreTestingMacros.h"
 #include "vtkMRMLScene.h"
+#include "vtkMRMLTransformNode.h"
 
 // VTK includes
 #include <vtkAssignAttribute.h>
 #include <vtkDataSetAttributes.h>
 #include <vtkFloatArray.h>
+#include <vtkGeneralTransform.h>
 #include <vtkImageData.h>
 #include <vtkImageInterpolator.h>
 #include <vtkImageReslice.h>
+#include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkPointData.h>
+#include <vtkPoints.h>
+#include <vtkThinPlateSplineTransform.h>
+#include <vtkTimerLog.h>
+#include <vtkTransform.h>
 #include <vtkTrivialProducer.h>
 
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
 namespace
 {
 bool testDTIPipeline();
+int testNonlinearTransformCache();
 }
 
 //----------------------------------------------------------------------------
@@ -73,6 +86,7 @@ int vtkMRMLSliceLayerLogicTest(int , char * [] )
 
   bool res = true;
   res = res && testDTIPipeline();
+  res = res && (testNonlinearTransformCache() == EXIT_SUCCESS);
   return res ? EXIT_SUCCESS : EXIT_FAILURE;
 }
 
@@ -136,4 +150,153 @@ bool testDTIPipeline()
   return true;
 }
 
+
+//----------------------------------------------------------------------------
+// Transform the pixels of the slice to IJK and return elapsed time
+double transformSlicePixels(vtkMRMLSliceLayerLogic* logic, std::vector<double>& points_IJK)
+{
+  int dimensions[3] = { 0, 0, 0 };
+  logic->GetSliceNode()->GetDimensions(dimensions);
+  vtkAbstractTransform* xyToIJK = logic->GetReslice()->GetResliceTransform();
+  xyToIJK->Update();
+  points_IJK.resize(dimensions[0] * dimensions[1] * 3);
+  double point_XY[3] = { 0.0, 0.0, 0.0 };
+  double* point_IJK = &points_IJK[0];
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  for (int y = 0; y < dimensions[1]; ++y)
+    {
+    point_XY[1] = y;
+    for (int x = 0; x < dimensions[0]; ++x, point_IJK += 3)
+      {
+      point_XY[0] = x;
+      xyToIJK->InternalTransformPoint(point_XY, point_IJK);
+      }
+    }
+  timer->StopTimer();
+  return timer->GetElapsedTime();
+}
+
+//----------------------------------------------------------------------------
+double maximumDistance(const std::vector<double>& points1, const std::vector<double>& points2)
+{
+  double maximumDistance = 0.0;
+  for (size_t i = 0; i < points1.size(); i += 3)
+    {
+    maximumDistance = std::max(maximumDistance, sqrt(vtkMath::Distance2BetweenPoints(&points1[i], &points2[i])));
+    }
+  return maximumDistance;
+}
+
+//----------------------------------------------------------------------------
+int testNonlinearTransformCache()
+{
+  vtkNew<vtkMRMLScene> scene;
+
+  vtkNew<vtkImageData> imageData;
+  imageData->SetDimensions(50, 50, 50);
+  imageData->AllocateScalars(VTK_SHORT, 1);
+  vtkNew<vtkMRMLScalarVolumeNode> volumeNode;
+  volumeNode->SetSpacing(2.0, 2.0, 2.0);
+  volumeNode->SetOrigin(-50.0, -50.0, -50.0);
+  volumeNode->SetAndObserveImageData(imageData.GetPointer());
+  scene->AddNode(volumeNode.GetPointer());
+
+  // Smooth warping transform. It is specified as transform to parent,
+  // therefore it is inverted iteratively for reslicing.
+  vtkNew<vtkPoints> sourceLandmarks;
+  vtkNew<vtkPoints> targetLandmarks;
+  for (int i = 0; i < 8; ++i)
+    {
+    double corner[3] = { (i & 1) ? 80.0 : -80.0, (i & 2) ? 80.0 : -80.0, (i & 4) ? 80.0 : -80.0 };
+    sourceLandmarks->InsertNextPoint(corner);
+    targetLandmarks->InsertNextPoint(corner);
+    }
+  sourceLandmarks->InsertNextPoint(0.0, 0.0, 0.0);
+  targetLandmarks->InsertNextPoint(8.0, -5.0, 3.0);
+  vtkNew<vtkThinPlateSplineTransform> warpTransform;
+  warpTransform->SetBasisToR();
+  warpTransform->SetSourceLandmarks(sourceLandmarks.GetPointer());
+  warpTransform->SetTargetLandmarks(targetLandmarks.GetPointer());
+  vtkNew<vtkMRMLTransformNode> transformNode;
+  scene->AddNode(transformNode.GetPointer());
+  transformNode->SetAndObserveTransformToParent(warpTransform.GetPointer());
+  volumeNode->SetAndObserveTransformNodeID(transformNode->GetID());
+
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetDimensions(256, 256, 1);
+  sliceNode->SetFieldOfView(120.0, 120.0, 1.0);
+  scene->AddNode(sliceNode.GetPointer());
+
+  vtkNew<vtkMRMLSliceLayerLogic> logic;
+  logic->SetMRMLScene(scene.GetPointer());
+  logic->SetSliceNode(sliceNode.GetPointer());
+  logic->SetVolumeNode(volumeNode.GetPointer());
+  CHECK_BOOL(logic->GetNonlinearTransformCaching(), false);
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), false);
+
+  std::vector<double> exactPoints_IJK;
+  double exactTime = transformSlicePixels(logic.GetPointer(), exactPoints_IJK);
+
+  // Error bound is specified in mm, points are compared in IJK (2mm spacing).
+  // The bound is estimated at cell centers, allow some extra tolerance.
+  const double maximumError = 0.1;
+  const double tolerance_IJK = 2.0 * maximumError / 2.0;
+  logic->SetNonlinearTransformCacheMaximumError(maximumError);
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), false);
+  // Enabling caching updates the reslice transforms
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  logic->NonlinearTransformCachingOn();
+  timer->StopTimer();
+  double bakeTime = timer->GetElapsedTime();
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), true);
+  std::vector<double> cachedPoints_IJK;
+  double cachedTime = transformSlicePixels(logic.GetPointer(), cachedPoints_IJK);
+  std::cout << "Maximum difference: " << maximumDistance(exactPoints_IJK, cachedPoints_IJK) << " voxel" << std::endl;
+  CHECK_BOOL(maximumDistance(exactPoints_IJK, cachedPoints_IJK) <= tolerance_IJK, true);
+
+  std::cout << "<DartMeasurement name=\"vtkMRMLSliceLayerLogic-NonlinearSliceExact\" "
+            << "type=\"numeric/double\">" << exactTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkMRMLSliceLayerLogic-NonlinearSliceCached\" "
+            << "type=\"numeric/double\">" << cachedTime << "</DartMeasurement>" << std::endl;
+  std::cout << "<DartMeasurement name=\"vtkMRMLSliceLayerLogic-NonlinearCacheUpdate\" "
+            << "type=\"numeric/double\">" << bakeTime << "</DartMeasurement>" << std::endl;
+
+  // Moving the slice reuses the cache
+  sliceNode->SetSliceOffset(10.0);
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), true);
+  logic->NonlinearTransformCachingOff();
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), false);
+  transformSlicePixels(logic.GetPointer(), exactPoints_IJK);
+  logic->NonlinearTransformCachingOn();
+  transformSlicePixels(logic.GetPointer(), cachedPoints_IJK);
+  CHECK_BOOL(maximumDistance(exactPoints_IJK, cachedPoints_IJK) <= tolerance_IJK, true);
+
+  // Cache is updated when the transform changes
+  targetLandmarks->SetPoint(8, -6.0, 4.0, 7.0);
+  warpTransform->Modified();
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), true);
+  transformSlicePixels(logic.GetPointer(), cachedPoints_IJK);
+  logic->NonlinearTransformCachingOff();
+  transformSlicePixels(logic.GetPointer(), exactPoints_IJK);
+  CHECK_BOOL(maximumDistance(exactPoints_IJK, cachedPoints_IJK) <= tolerance_IJK, true);
+
+  // Exact transform is used if the error bound cannot be achieved
+  logic->NonlinearTransformCachingOn();
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), true);
+  logic->SetNonlinearTransformCacheMaximumNumberOfGridPoints(100);
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), false);
+  logic->SetNonlinearTransformCacheMaximumNumberOfGridPoints(1000000);
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), true);
+
+  // Linear transforms are not cached
+  vtkNew<vtkTransform> linearTransform;
+  linearTransform->Translate(5.0, 0.0, 0.0);
+  transformNode->SetAndObserveTransformToParent(linearTransform.GetPointer());
+  CHECK_BOOL(logic->IsNonlinearTransformCacheUsed(), false);
+
+  return EXIT_SUCCESS;
+}
+
 }
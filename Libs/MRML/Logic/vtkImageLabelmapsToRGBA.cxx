@@ -0,0 +1,399 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#include "vtkImageLabelmapsToRGBA.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkScalarsToColors.h>
+#include <vtkSmartPointer.h>
+#include <vtkStreamingDemandDrivenPipeline.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+//------------------------------------------------------------------------------
+vtkStandardNewMacro(vtkImageLabelmapsToRGBA);
+
+namespace
+{
+// Lookup tables are converted to color arrays before execution.
+// Larger label ranges are not supported, to prevent excessive memory allocation.
+const vtkIdType MAXIMUM_NUMBER_OF_COLORS = 1 << 24;
+
+//----------------------------------------------------------------------------
+/// Map of label values to RGBA colors.
+struct ColorTable
+{
+  vtkIdType MinimumLabel{0};
+  std::vector<unsigned char> Colors;
+  bool Visible{false};
+
+  const unsigned char* GetColor(double label) const
+  {
+    vtkIdType index = static_cast<vtkIdType>(label) - this->MinimumLabel;
+    vtkIdType maximumIndex = static_cast<vtkIdType>(this->Colors.size() / 4) - 1;
+    index = std::max<vtkIdType>(0, std::min(index, maximumIndex));
+    return &(this->Colors[4 * index]);
+  }
+};
+
+//----------------------------------------------------------------------------
+// Retrieve colors of all label values in the range of the lookup table.
+// Returns false if the range is too large.
+bool BuildColorTable(vtkScalarsToColors* lookupTable, ColorTable& colorTable)
+{
+  colorTable.Colors.clear();
+  colorTable.Visible = false;
+  if (!lookupTable)
+    {
+    return true;
+    }
+  double* range = lookupTable->GetRange();
+  vtkIdType minimumLabel = static_cast<vtkIdType>(std::floor(range[0]));
+  vtkIdType maximumLabel = static_cast<vtkIdType>(std::ceil(range[1]));
+  vtkIdType numberOfColors = maximumLabel - minimumLabel + 1;
+  if (numberOfColors < 1 || numberOfColors > MAXIMUM_NUMBER_OF_COLORS)
+    {
+    return false;
+    }
+  colorTable.MinimumLabel = minimumLabel;
+  colorTable.Colors.resize(4 * numberOfColors);
+  for (vtkIdType colorIndex = 0; colorIndex < numberOfColors; ++colorIndex)
+    {
+    const unsigned char* color = lookupTable->MapValue(static_cast<double>(minimumLabel + colorIndex));
+    unsigned char* tableColor = &(colorTable.Colors[4 * colorIndex]);
+    tableColor[0] = color[0];
+    tableColor[1] = color[1];
+    tableColor[2] = color[2];
+    tableColor[3] = color[3];
+    colorTable.Visible |= (color[3] > 0);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+// Blend source color over destination color (non-premultiplied RGBA).
+inline void BlendOver(const unsigned char* src, unsigned char* dst)
+{
+  if (src[3] == 0)
+    {
+    return;
+    }
+  if (src[3] == 255 || dst[3] == 0)
+    {
+    dst[0] = src[0];
+    dst[1] = src[1];
+    dst[2] = src[2];
+    dst[3] = src[3];
+    return;
+    }
+  double srcAlpha = src[3] / 255.0;
+  double dstAlpha = dst[3] / 255.0 * (1.0 - srcAlpha);
+  double outAlpha = srcAlpha + dstAlpha;
+  for (int c = 0; c < 3; ++c)
+    {
+    dst[c] = static_cast<unsigned char>((src[c] * srcAlpha + dst[c] * dstAlpha) / outAlpha + 0.5);
+    }
+  dst[3] = static_cast<unsigned char>(outAlpha * 255.0 + 0.5);
+}
+
+//----------------------------------------------------------------------------
+// A non-background pixel is on the outline if there is a different label value
+// within the (2*thickness+1)^2 in-plane neighborhood or the neighborhood reaches
+// outside of the image (same as vtkImageLabelOutline).
+template <class T>
+bool IsOutlinePixel(const T* inPtr, T label, int x, int y, int thickness,
+  const int inExt[6], vtkIdType inInc0, vtkIdType inInc1)
+{
+  if (x - thickness < inExt[0] || x + thickness > inExt[1]
+    || y - thickness < inExt[2] || y + thickness > inExt[3])
+    {
+    return true;
+    }
+  const T* hoodPtr1 = inPtr - thickness * inInc1 - thickness * inInc0;
+  for (int hoodIdx1 = -thickness; hoodIdx1 <= thickness; ++hoodIdx1)
+    {
+    const T* hoodPtr0 = hoodPtr1;
+    for (int hoodIdx0 = -thickness; hoodIdx0 <= thickness; ++hoodIdx0)
+      {
+      if (*hoodPtr0 != label)
+        {
+        return true;
+        }
+      hoodPtr0 += inInc0;
+      }
+    hoodPtr1 += inInc1;
+    }
+  return false;
+}
+
+//----------------------------------------------------------------------------
+// Blend outline and fill colors of one row of a labelmap over the output row.
+template <class T>
+void CompositeLabelmapRow(vtkImageData* inData, T* inPtr,
+  unsigned char* outPtr, int x0, int x1, int y, T background, int outlineThickness,
+  const ColorTable& fill, const ColorTable& outline)
+{
+  int* inExt = inData->GetExtent();
+  vtkIdType inInc0 = 0;
+  vtkIdType inInc1 = 0;
+  vtkIdType inInc2 = 0;
+  inData->GetIncrements(inInc0, inInc1, inInc2);
+  bool outlineVisible = outline.Visible && outlineThickness > 0;
+  for (int x = x0; x <= x1; ++x, inPtr += inInc0, outPtr += 4)
+    {
+    T label = *inPtr;
+    if (label == background)
+      {
+      continue;
+      }
+    if (outlineVisible)
+      {
+      const unsigned char* outlineColor = outline.GetColor(label);
+      if (outlineColor[3] > 0
+        && IsOutlinePixel(inPtr, label, x, y, outlineThickness, inExt, inInc0, inInc1))
+        {
+        BlendOver(outlineColor, outPtr);
+        }
+      }
+    if (fill.Visible)
+      {
+      BlendOver(fill.GetColor(label), outPtr);
+      }
+    }
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkImageLabelmapsToRGBA::vtkInternal
+{
+public:
+  std::vector< vtkSmartPointer<vtkScalarsToColors> > FillLookupTables;
+  std::vector< vtkSmartPointer<vtkScalarsToColors> > OutlineLookupTables;
+
+  // Color tables of each input, only valid during execution
+  std::vector<ColorTable> FillColorTables;
+  std::vector<ColorTable> OutlineColorTables;
+};
+
+//----------------------------------------------------------------------------
+vtkImageLabelmapsToRGBA::vtkImageLabelmapsToRGBA()
+{
+  this->Internal = new vtkInternal;
+  this->Background = 0.0;
+  this->Outline = 1;
+}
+
+//----------------------------------------------------------------------------
+vtkImageLabelmapsToRGBA::~vtkImageLabelmapsToRGBA()
+{
+  delete this->Internal;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelmapsToRGBA::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  os << indent << "Background: " << this->Background << "\n";
+  os << indent << "Outline: " << this->Outline << "\n";
+  os << indent << "NumberOfLabelmaps: " << this->GetNumberOfLabelmaps() << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelmapsToRGBA::AddLabelmapConnection(vtkAlgorithmOutput* labelmapConnection,
+  vtkScalarsToColors* fillLookupTable, vtkScalarsToColors* outlineLookupTable)
+{
+  if (!labelmapConnection)
+    {
+    vtkErrorMacro("AddLabelmapConnection: invalid labelmap connection");
+    return;
+    }
+  this->Internal->FillLookupTables.push_back(fillLookupTable);
+  this->Internal->OutlineLookupTables.push_back(outlineLookupTable);
+  this->AddInputConnection(0, labelmapConnection);
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelmapsToRGBA::RemoveAllLabelmaps()
+{
+  this->Internal->FillLookupTables.clear();
+  this->Internal->OutlineLookupTables.clear();
+  this->RemoveAllInputConnections(0);
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelmapsToRGBA::GetNumberOfLabelmaps()
+{
+  return this->GetNumberOfInputConnections(0);
+}
+
+//----------------------------------------------------------------------------
+vtkMTimeType vtkImageLabelmapsToRGBA::GetMTime()
+{
+  vtkMTimeType mTime = this->Superclass::GetMTime();
+  for (vtkScalarsToColors* lookupTable : this->Internal->FillLookupTables)
+    {
+    if (lookupTable)
+      {
+      mTime = std::max(mTime, lookupTable->GetMTime());
+      }
+    }
+  for (vtkScalarsToColors* lookupTable : this->Internal->OutlineLookupTables)
+    {
+    if (lookupTable)
+      {
+      mTime = std::max(mTime, lookupTable->GetMTime());
+      }
+    }
+  return mTime;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelmapsToRGBA::FillInputPortInformation(int port, vtkInformation* info)
+{
+  if (!this->Superclass::FillInputPortInformation(port, info))
+    {
+    return 0;
+    }
+  info->Set(vtkAlgorithm::INPUT_IS_REPEATABLE(), 1);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelmapsToRGBA::RequestInformation(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector), vtkInformationVector* outputVector)
+{
+  // Geometry is copied from the first labelmap
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  vtkDataObject::SetPointDataActiveScalarInfo(outInfo, VTK_UNSIGNED_CHAR, 4);
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelmapsToRGBA::RequestUpdateExtent(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  // Outline computation requires neighbor pixels within the slice
+  vtkInformation* outInfo = outputVector->GetInformationObject(0);
+  int outExt[6] = { 0, -1, 0, -1, 0, -1 };
+  outInfo->Get(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), outExt);
+  int numberOfInputs = inputVector[0]->GetNumberOfInformationObjects();
+  for (int inputIndex = 0; inputIndex < numberOfInputs; ++inputIndex)
+    {
+    vtkInformation* inInfo = inputVector[0]->GetInformationObject(inputIndex);
+    int wholeExt[6] = { 0, -1, 0, -1, 0, -1 };
+    inInfo->Get(vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT(), wholeExt);
+    int inExt[6] = { outExt[0], outExt[1], outExt[2], outExt[3], outExt[4], outExt[5] };
+    for (int axis = 0; axis < 2; ++axis)
+      {
+      inExt[axis * 2] = std::max(outExt[axis * 2] - this->Outline, wholeExt[axis * 2]);
+      inExt[axis * 2 + 1] = std::min(outExt[axis * 2 + 1] + this->Outline, wholeExt[axis * 2 + 1]);
+      }
+    inInfo->Set(vtkStreamingDemandDrivenPipeline::UPDATE_EXTENT(), inExt, 6);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkImageLabelmapsToRGBA::RequestData(vtkInformation* request,
+  vtkInformationVector** inputVector, vtkInformationVector* outputVector)
+{
+  // Lookup tables are not thread-safe, therefore colors are retrieved before
+  // the execution is split between threads.
+  int numberOfInputs = inputVector[0]->GetNumberOfInformationObjects();
+  this->Internal->FillColorTables.resize(numberOfInputs);
+  this->Internal->OutlineColorTables.resize(numberOfInputs);
+  for (int inputIndex = 0; inputIndex < numberOfInputs; ++inputIndex)
+    {
+    vtkScalarsToColors* fillLookupTable = nullptr;
+    vtkScalarsToColors* outlineLookupTable = nullptr;
+    if (inputIndex < static_cast<int>(this->Internal->FillLookupTables.size()))
+      {
+      fillLookupTable = this->Internal->FillLookupTables[inputIndex];
+      outlineLookupTable = this->Internal->OutlineLookupTables[inputIndex];
+      }
+    if (!BuildColorTable(fillLookupTable, this->Internal->FillColorTables[inputIndex])
+      || !BuildColorTable(outlineLookupTable, this->Internal->OutlineColorTables[inputIndex]))
+      {
+      vtkErrorMacro("RequestData: lookup table range of labelmap " << inputIndex << " is too large");
+      }
+    }
+
+  int result = this->Superclass::RequestData(request, inputVector, outputVector);
+
+  this->Internal->FillColorTables.clear();
+  this->Internal->OutlineColorTables.clear();
+  return result;
+}
+
+//----------------------------------------------------------------------------
+void vtkImageLabelmapsToRGBA::ThreadedRequestData(vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** vtkNotUsed(inputVector), vtkInformationVector* vtkNotUsed(outputVector),
+  vtkImageData*** inData, vtkImageData** outData, int outExt[6], int vtkNotUsed(threadId))
+{
+  if (outExt[0] > outExt[1] || outExt[2] > outExt[3] || outExt[4] > outExt[5])
+    {
+    return;
+    }
+  vtkImageData* output = outData[0];
+  int numberOfInputs = static_cast<int>(this->Internal->FillColorTables.size());
+  int rowLength = outExt[1] - outExt[0] + 1;
+
+  // Labelmaps are composited row by row so that the output row stays in cache
+  for (int z = outExt[4]; z <= outExt[5]; ++z)
+    {
+    for (int y = outExt[2]; !this->AbortExecute && y <= outExt[3]; ++y)
+      {
+      unsigned char* outPtr = static_cast<unsigned char*>(output->GetScalarPointer(outExt[0], y, z));
+      memset(outPtr, 0, 4 * rowLength * sizeof(unsigned char));
+      for (int inputIndex = 0; inputIndex < numberOfInputs; ++inputIndex)
+        {
+        vtkImageData* labelmap = inData[0][inputIndex];
+        const ColorTable& fill = this->Internal->FillColorTables[inputIndex];
+        const ColorTable& outline = this->Internal->OutlineColorTables[inputIndex];
+        if (!labelmap || !labelmap->GetPointData()->GetScalars() || (!fill.Visible && !outline.Visible))
+          {
+          continue;
+          }
+        // Only composite the part of the row that is within the labelmap
+        int* inExt = labelmap->GetExtent();
+        if (y < inExt[2] || y > inExt[3] || z < inExt[4] || z > inExt[5])
+          {
+          continue;
+          }
+        int x0 = std::max(outExt[0], inExt[0]);
+        int x1 = std::min(outExt[1], inExt[1]);
+        if (x0 > x1)
+          {
+          continue;
+          }
+        void* inPtr = labelmap->GetScalarPointer(x0, y, z);
+        unsigned char* outRowPtr = outPtr + 4 * (x0 - outExt[0]);
+        switch (labelmap->GetScalarType())
+          {
+          vtkTemplateMacro(CompositeLabelmapRow<VTK_TT>(labelmap, static_cast<VTK_TT*>(inPtr),
+            outRowPtr, x0, x1, y, static_cast<VTK_TT>(this->Background), this->Outline, fill, outline));
+          default:
+            vtkErrorMacro("ThreadedRequestData: unknown labelmap scalar type");
+            break;
+          }
+        }
+      }
+    }
+}
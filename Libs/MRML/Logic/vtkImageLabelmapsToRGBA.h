@@ -0,0 +1,90 @@
+/*=auto=========================================================================
+
+  Portions (c) Copyright 2005 Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+=========================================================================auto=*/
+
+#ifndef __vtkImageLabelmapsToRGBA_h
+#define __vtkImageLabelmapsToRGBA_h
+
+#include <vtkThreadedImageAlgorithm.h>
+
+#include "vtkMRMLLogicExport.h"
+
+class vtkAlgorithmOutput;
+class vtkScalarsToColors;
+
+/// \brief Composite fill and outline of multiple labelmaps into a single RGBA image.
+///
+/// Each input connection is a labelmap (typically the resliced output of a segmentation
+/// layer) with a lookup table for the fill and another one for the outline.
+/// Pixels of all labelmaps are visited once, in a single threaded pass: for each labelmap,
+/// in the order they were added, the outline color (as computed by vtkImageLabelOutline)
+/// and then the fill color are blended over the output.
+/// This produces the same image as rendering outline and fill of each labelmap with
+/// separate actors, but requires only one mapper and actor for all labelmaps.
+///
+/// All labelmaps must have the same extent. Label values outside of the range of the
+/// lookup table are mapped to the first or last color of the table.
+class VTK_MRML_LOGIC_EXPORT vtkImageLabelmapsToRGBA : public vtkThreadedImageAlgorithm
+{
+public:
+  static vtkImageLabelmapsToRGBA *New();
+  vtkTypeMacro(vtkImageLabelmapsToRGBA, vtkThreadedImageAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Add a labelmap to be composited over the previously added ones.
+  /// If a lookup table is nullptr then fill or outline of the labelmap is not displayed.
+  void AddLabelmapConnection(vtkAlgorithmOutput* labelmapConnection,
+    vtkScalarsToColors* fillLookupTable, vtkScalarsToColors* outlineLookupTable);
+
+  /// Remove all labelmap input connections.
+  void RemoveAllLabelmaps();
+
+  /// Get number of labelmaps that are composited.
+  int GetNumberOfLabelmaps();
+
+  ///
+  /// Background label value, not displayed in any of the labelmaps (usually 0)
+  vtkSetMacro(Background, double);
+  vtkGetMacro(Background, double);
+
+  ///
+  /// Thickness of the outline in pixels
+  vtkSetClampMacro(Outline, int, 0, 100);
+  vtkGetMacro(Outline, int);
+
+  /// Include modification time of lookup tables.
+  vtkMTimeType GetMTime() override;
+
+protected:
+  vtkImageLabelmapsToRGBA();
+  ~vtkImageLabelmapsToRGBA() override;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestInformation(vtkInformation* request,
+    vtkInformationVector** inputVector, vtkInformationVector* outputVector) override;
+  int RequestUpdateExtent(vtkInformation* request,
+    vtkInformationVector** inputVector, vtkInformationVector* outputVector) override;
+  int RequestData(vtkInformation* request,
+    vtkInformationVector** inputVector, vtkInformationVector* outputVector) override;
+  void ThreadedRequestData(vtkInformation* request,
+    vtkInformationVector** inputVector, vtkInformationVector* outputVector,
+    vtkImageData*** inData, vtkImageData** outData,
+    int outExt[6], int threadId) override;
+
+  double Background;
+  int Outline;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
+
+  vtkImageLabelmapsToRGBA(const vtkImageLabelmapsToRGBA&) = delete;
+  void operator=(const vtkImageLabelmapsToRGBA&) = delete;
+};
+
+#endif
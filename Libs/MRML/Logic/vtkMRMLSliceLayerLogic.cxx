@@ -32,13 +32,17 @@
 #include <vtkDiffusionTensorMathematics.h>
 #include <vtkFloatArray.h>
 #include <vtkGeneralTransform.h>
+#include <vtkGridTransform.h>
 #include <vtkImageData.h>
 #include <vtkImageReslice.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
+#include <vtkMath.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkTrivialProducer.h>
 #include <vtkTransform.h>
 #include <vtkVersion.h>
@@ -49,10 +53,325 @@
 
 // STD includes
 #include <algorithm>
+#include <cmath>
+#include <vector>
 
 //----------------------------------------------------------------------------
 vtkStandardNewMacro(vtkMRMLSliceLayerLogic);
 
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Sample displacements of a transform at the points of a regular grid
+class SampleDisplacementFunctor
+{
+public:
+  vtkAbstractTransform* Transform;
+  float* Displacements;
+  int Dimensions[3];
+  double Origin[3];
+  double Spacing[3];
+
+  void operator()(vtkIdType zBegin, vtkIdType zEnd)
+  {
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double transformedPoint[3] = { 0.0, 0.0, 0.0 };
+    float* displacement = this->Displacements + zBegin * this->Dimensions[0] * this->Dimensions[1] * 3;
+    for (vtkIdType z = zBegin; z < zEnd; ++z)
+      {
+      point[2] = this->Origin[2] + z * this->Spacing[2];
+      for (int y = 0; y < this->Dimensions[1]; ++y)
+        {
+        point[1] = this->Origin[1] + y * this->Spacing[1];
+        for (int x = 0; x < this->Dimensions[0]; ++x)
+          {
+          point[0] = this->Origin[0] + x * this->Spacing[0];
+          this->Transform->InternalTransformPoint(point, transformedPoint);
+          *(displacement++) = static_cast<float>(transformedPoint[0] - point[0]);
+          *(displacement++) = static_cast<float>(transformedPoint[1] - point[1]);
+          *(displacement++) = static_cast<float>(transformedPoint[2] - point[2]);
+          }
+        }
+      }
+  }
+};
+
+//----------------------------------------------------------------------------
+// Compute the maximum distance between two transforms at the cell centers of a regular grid
+class MaximumTransformDifferenceFunctor
+{
+public:
+  vtkAbstractTransform* ExactTransform;
+  vtkAbstractTransform* ApproximateTransform;
+  int Dimensions[3]; // number of grid points
+  double Origin[3];
+  double Spacing[3];
+  vtkSMPThreadLocal<double> ThreadMaximumDifference;
+  double MaximumDifference;
+
+  void Initialize()
+  {
+    this->ThreadMaximumDifference.Local() = 0.0;
+  }
+
+  void operator()(vtkIdType zBegin, vtkIdType zEnd)
+  {
+    double& maximumDifference = this->ThreadMaximumDifference.Local();
+    double point[3] = { 0.0, 0.0, 0.0 };
+    double exactPoint[3] = { 0.0, 0.0, 0.0 };
+    double approximatePoint[3] = { 0.0, 0.0, 0.0 };
+    for (vtkIdType z = zBegin; z < zEnd; ++z)
+      {
+      point[2] = this->Origin[2] + (z + 0.5) * this->Spacing[2];
+      for (int y = 0; y < this->Dimensions[1] - 1; ++y)
+        {
+        point[1] = this->Origin[1] + (y + 0.5) * this->Spacing[1];
+        for (int x = 0; x < this->Dimensions[0] - 1; ++x)
+          {
+          point[0] = this->Origin[0] + (x + 0.5) * this->Spacing[0];
+          this->ExactTransform->InternalTransformPoint(point, exactPoint);
+          this->ApproximateTransform->InternalTransformPoint(point, approximatePoint);
+          maximumDifference = std::max(maximumDifference,
+            sqrt(vtkMath::Distance2BetweenPoints(exactPoint, approximatePoint)));
+          }
+        }
+      }
+  }
+
+  void Reduce()
+  {
+    this->MaximumDifference = 0.0;
+    for (vtkSMPThreadLocal<double>::iterator it = this->ThreadMaximumDifference.begin();
+      it != this->ThreadMaximumDifference.end(); ++it)
+      {
+      this->MaximumDifference = std::max(this->MaximumDifference, *it);
+      }
+  }
+};
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+class vtkMRMLSliceLayerLogic::vtkInternal
+{
+public:
+  vtkInternal();
+
+  /// Get transform from world to the parent of the volume node.
+  /// Returns the cached displacement grid transform if caching is enabled and
+  /// the cache satisfies the error bound, otherwise the exact transform.
+  vtkAbstractTransform* GetTransformFromWorld(vtkMRMLSliceLayerLogic* self,
+    vtkMRMLTransformNode* transformNode, vtkMRMLVolumeNode* volumeNode, vtkGeneralTransform* exactTransformFromWorld);
+
+  /// Returns true if the cache parameters are different from the ones used for computing the cache.
+  bool IsCacheOutdated(vtkMRMLSliceLayerLogic* self, vtkMRMLTransformNode* transformNode, vtkMRMLVolumeNode* volumeNode);
+
+  /// Sample the exact transform into the displacement grid.
+  /// Returns false if the error bound cannot be satisfied.
+  bool UpdateCache(vtkMRMLSliceLayerLogic* self, vtkMRMLTransformNode* transformNode,
+    vtkMRMLVolumeNode* volumeNode, vtkGeneralTransform* exactTransformFromWorld);
+
+  vtkSmartPointer<vtkGridTransform> CachedTransformFromWorld;
+  /// Cache could be computed for the current parameters
+  bool CacheValid;
+  /// Cache is used in the current reslice transform
+  bool CacheUsed;
+
+  /// Parameters the cache was computed for
+  std::vector<vtkMRMLTransformNode*> CachedTransformNodes;
+  vtkMTimeType CachedTransformToWorldMTime;
+  int CachedExtent[6];
+  double CachedIJKToRAS[16];
+  double CachedGridSpacing;
+  double CachedMaximumError;
+  int CachedMaximumNumberOfGridPoints;
+};
+
+//----------------------------------------------------------------------------
+vtkMRMLSliceLayerLogic::vtkInternal::vtkInternal()
+{
+  this->CacheValid = false;
+  this->CacheUsed = false;
+  this->CachedTransformToWorldMTime = 0;
+  std::fill(this->CachedExtent, this->CachedExtent + 6, 0);
+  std::fill(this->CachedIJKToRAS, this->CachedIJKToRAS + 16, 0.0);
+  this->CachedGridSpacing = 0.0;
+  this->CachedMaximumError = 0.0;
+  this->CachedMaximumNumberOfGridPoints = 0;
+}
+
+//----------------------------------------------------------------------------
+vtkAbstractTransform* vtkMRMLSliceLayerLogic::vtkInternal::GetTransformFromWorld(vtkMRMLSliceLayerLogic* self,
+  vtkMRMLTransformNode* transformNode, vtkMRMLVolumeNode* volumeNode, vtkGeneralTransform* exactTransformFromWorld)
+{
+  this->CacheUsed = false;
+  if (!self->NonlinearTransformCaching || transformNode->IsTransformToWorldLinear())
+    {
+    return exactTransformFromWorld;
+    }
+  if (this->IsCacheOutdated(self, transformNode, volumeNode))
+    {
+    this->CacheValid = this->UpdateCache(self, transformNode, volumeNode, exactTransformFromWorld);
+    }
+  if (!this->CacheValid)
+    {
+    return exactTransformFromWorld;
+    }
+  this->CacheUsed = true;
+  return this->CachedTransformFromWorld;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLayerLogic::vtkInternal::IsCacheOutdated(vtkMRMLSliceLayerLogic* self,
+  vtkMRMLTransformNode* transformNode, vtkMRMLVolumeNode* volumeNode)
+{
+  std::vector<vtkMRMLTransformNode*> transformNodes;
+  for (vtkMRMLTransformNode* node = transformNode; node; node = node->GetParentTransformNode())
+    {
+    transformNodes.push_back(node);
+    }
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  volumeNode->GetIJKToRASMatrix(ijkToRAS.GetPointer());
+  int* extent = volumeNode->GetImageData()->GetExtent();
+  return transformNodes != this->CachedTransformNodes
+    || transformNode->GetTransformToWorldMTime() != this->CachedTransformToWorldMTime
+    || !std::equal(extent, extent + 6, this->CachedExtent)
+    || !std::equal(&(ijkToRAS->Element[0][0]), &(ijkToRAS->Element[0][0]) + 16, this->CachedIJKToRAS)
+    || self->NonlinearTransformCacheGridSpacing != this->CachedGridSpacing
+    || self->NonlinearTransformCacheMaximumError != this->CachedMaximumError
+    || self->NonlinearTransformCacheMaximumNumberOfGridPoints != this->CachedMaximumNumberOfGridPoints;
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLayerLogic::vtkInternal::UpdateCache(vtkMRMLSliceLayerLogic* self,
+  vtkMRMLTransformNode* transformNode, vtkMRMLVolumeNode* volumeNode, vtkGeneralTransform* exactTransformFromWorld)
+{
+  // Store parameters first, so that computation is not attempted again
+  // for the same parameters if the error bound cannot be satisfied.
+  this->CachedTransformNodes.clear();
+  for (vtkMRMLTransformNode* node = transformNode; node; node = node->GetParentTransformNode())
+    {
+    this->CachedTransformNodes.push_back(node);
+    }
+  this->CachedTransformToWorldMTime = transformNode->GetTransformToWorldMTime();
+  vtkNew<vtkMatrix4x4> ijkToRAS;
+  volumeNode->GetIJKToRASMatrix(ijkToRAS.GetPointer());
+  std::copy(&(ijkToRAS->Element[0][0]), &(ijkToRAS->Element[0][0]) + 16, this->CachedIJKToRAS);
+  int* extent = volumeNode->GetImageData()->GetExtent();
+  std::copy(extent, extent + 6, this->CachedExtent);
+  this->CachedGridSpacing = self->NonlinearTransformCacheGridSpacing;
+  this->CachedMaximumError = self->NonlinearTransformCacheMaximumError;
+  this->CachedMaximumNumberOfGridPoints = self->NonlinearTransformCacheMaximumNumberOfGridPoints;
+  this->CachedTransformFromWorld = nullptr;
+
+  if (extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5])
+    {
+    return false;
+    }
+
+  // Region to sample: bounding box of the volume in its own coordinate system
+  // and transformed to the world coordinate system. The transformed box is
+  // computed from a lattice, as boundary of the volume may be curved.
+  // Points outside of the grid would be evaluated by extrapolation, but the
+  // volume is not visible there.
+  vtkNew<vtkGeneralTransform> transformToWorld;
+  transformNode->GetTransformToWorld(transformToWorld.GetPointer());
+  transformToWorld->Update();
+  double bounds[6] = { VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN, VTK_DOUBLE_MAX, VTK_DOUBLE_MIN };
+  const int numberOfLatticePoints = 5;
+  double point_IJK[4] = { 0.0, 0.0, 0.0, 1.0 };
+  double point_RAS[4] = { 0.0, 0.0, 0.0, 1.0 };
+  double point_World[3] = { 0.0, 0.0, 0.0 };
+  for (int k = 0; k < numberOfLatticePoints; ++k)
+    {
+    point_IJK[2] = extent[4] - 0.5 + (extent[5] - extent[4] + 1.0) * k / (numberOfLatticePoints - 1);
+    for (int j = 0; j < numberOfLatticePoints; ++j)
+      {
+      point_IJK[1] = extent[2] - 0.5 + (extent[3] - extent[2] + 1.0) * j / (numberOfLatticePoints - 1);
+      for (int i = 0; i < numberOfLatticePoints; ++i)
+        {
+        point_IJK[0] = extent[0] - 0.5 + (extent[1] - extent[0] + 1.0) * i / (numberOfLatticePoints - 1);
+        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
+        transformToWorld->InternalTransformPoint(point_RAS, point_World);
+        for (int axis = 0; axis < 3; ++axis)
+          {
+          bounds[axis * 2] = std::min(bounds[axis * 2], std::min(point_RAS[axis], point_World[axis]));
+          bounds[axis * 2 + 1] = std::max(bounds[axis * 2 + 1], std::max(point_RAS[axis], point_World[axis]));
+          }
+        }
+      }
+    }
+  double maximumSize = std::max(bounds[1] - bounds[0], std::max(bounds[3] - bounds[2], bounds[5] - bounds[4]));
+  if (maximumSize <= 0.0)
+    {
+    return false;
+    }
+  double margin = maximumSize * 0.05;
+  double origin[3] = { bounds[0] - margin, bounds[2] - margin, bounds[4] - margin };
+  double size[3] = { bounds[1] - bounds[0] + 2 * margin, bounds[3] - bounds[2] + 2 * margin, bounds[5] - bounds[4] + 2 * margin };
+
+  double gridSpacing = self->NonlinearTransformCacheGridSpacing;
+  if (gridSpacing <= 0.0)
+    {
+    gridSpacing = (maximumSize + 2 * margin) / 31.0;
+    }
+
+  exactTransformFromWorld->Update();
+  while (true)
+    {
+    int dimensions[3] = { 2, 2, 2 };
+    double numberOfGridPoints = 1.0;
+    for (int axis = 0; axis < 3; ++axis)
+      {
+      dimensions[axis] = std::max(2, static_cast<int>(ceil(size[axis] / gridSpacing)) + 1);
+      numberOfGridPoints *= dimensions[axis];
+      }
+    if (numberOfGridPoints > self->NonlinearTransformCacheMaximumNumberOfGridPoints)
+      {
+      vtkDebugWithObjectMacro(self, "Non-linear transform cache: maximum error of "
+        << self->NonlinearTransformCacheMaximumError << "mm cannot be achieved, the exact transform is used");
+      this->CachedTransformFromWorld = nullptr;
+      return false;
+      }
+
+    vtkNew<vtkImageData> displacementGrid;
+    displacementGrid->SetOrigin(origin);
+    displacementGrid->SetSpacing(gridSpacing, gridSpacing, gridSpacing);
+    displacementGrid->SetDimensions(dimensions);
+    displacementGrid->AllocateScalars(VTK_FLOAT, 3);
+
+    SampleDisplacementFunctor sampler;
+    sampler.Transform = exactTransformFromWorld;
+    sampler.Displacements = static_cast<float*>(displacementGrid->GetScalarPointer());
+    std::copy(dimensions, dimensions + 3, sampler.Dimensions);
+    std::copy(origin, origin + 3, sampler.Origin);
+    std::fill(sampler.Spacing, sampler.Spacing + 3, gridSpacing);
+    vtkSMPTools::For(0, dimensions[2], sampler);
+
+    this->CachedTransformFromWorld = vtkSmartPointer<vtkGridTransform>::New();
+    this->CachedTransformFromWorld->SetInterpolationModeToLinear();
+    this->CachedTransformFromWorld->SetDisplacementGridData(displacementGrid.GetPointer());
+    this->CachedTransformFromWorld->Update();
+
+    // Error is largest far from the grid points
+    MaximumTransformDifferenceFunctor errorEstimator;
+    errorEstimator.ExactTransform = exactTransformFromWorld;
+    errorEstimator.ApproximateTransform = this->CachedTransformFromWorld;
+    std::copy(dimensions, dimensions + 3, errorEstimator.Dimensions);
+    std::copy(origin, origin + 3, errorEstimator.Origin);
+    std::fill(errorEstimator.Spacing, errorEstimator.Spacing + 3, gridSpacing);
+    vtkSMPTools::For(0, dimensions[2] - 1, errorEstimator);
+    if (errorEstimator.MaximumDifference <= self->NonlinearTransformCacheMaximumError)
+      {
+      vtkDebugWithObjectMacro(self, "Non-linear transform cache: " << dimensions[0] << "x" << dimensions[1]
+        << "x" << dimensions[2] << " grid, estimated maximum error " << errorEstimator.MaximumDifference << "mm");
+      return true;
+      }
+    gridSpacing /= 2.0;
+    }
+}
+
 bool AreMatricesEqual(const vtkMatrix4x4* first, const vtkMatrix4x4* second)
 {
   return vtkAddonMathUtilities::MatrixAreEqual(first, second);
@@ -146,6 +465,12 @@ vtkMRMLSliceLayerLogic::vtkMRMLSliceLayerLogic()
   this->ResliceUVW->GenerateStencilOutputOn();
 
   this->UpdatingTransforms = 0;
+
+  this->NonlinearTransformCaching = false;
+  this->NonlinearTransformCacheGridSpacing = 0.0;
+  this->NonlinearTransformCacheMaximumError = 0.5;
+  this->NonlinearTransformCacheMaximumNumberOfGridPoints = 1000000;
+  this->Internal = new vtkInternal;
 }
 
 //----------------------------------------------------------------------------
@@ -168,6 +493,7 @@ vtkMRMLSliceLayerLogic::~vtkMRMLSliceLayerLogic()
   this->SetVolumeNode(nullptr);
   this->XYToIJKTransform->Delete();
   this->UVWToIJKTransform->Delete();
+  delete this->Internal;
 
   this->Reslice->SetInputConnection( nullptr );
   this->ResliceUVW->SetInputConnection( nullptr );
@@ -510,6 +836,7 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
     this->UVWToIJKTransform->Concatenate(uvwToIJK.GetPointer());
     }
 
+  this->Internal->CacheUsed = false;
   if (this->VolumeNode && this->VolumeNode->GetImageData())
     {
     // Apply the transform, if it exists
@@ -521,8 +848,12 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
       transformNode->GetTransformFromWorld(worldTransform.GetPointer());
       //worldTransform->Inverse();
 
-      this->XYToIJKTransform->Concatenate(worldTransform.GetPointer());
-      this->UVWToIJKTransform->Concatenate(worldTransform.GetPointer());
+      // Use the displacement grid approximation of non-linear transforms if enabled
+      vtkAbstractTransform* transformFromWorld = this->Internal->GetTransformFromWorld(
+        this, transformNode, this->VolumeNode, worldTransform.GetPointer());
+
+      this->XYToIJKTransform->Concatenate(transformFromWorld);
+      this->UVWToIJKTransform->Concatenate(transformFromWorld);
       }
 
     vtkNew<vtkMatrix4x4> rasToIJK;
@@ -591,6 +922,60 @@ void vtkMRMLSliceLayerLogic::UpdateTransforms()
     }
 }
 
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::SetNonlinearTransformCaching(bool caching)
+{
+  if (this->NonlinearTransformCaching == caching)
+    {
+    return;
+    }
+  this->NonlinearTransformCaching = caching;
+  this->UpdateTransforms();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::SetNonlinearTransformCacheGridSpacing(double spacing)
+{
+  if (this->NonlinearTransformCacheGridSpacing == spacing)
+    {
+    return;
+    }
+  this->NonlinearTransformCacheGridSpacing = spacing;
+  this->UpdateTransforms();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::SetNonlinearTransformCacheMaximumError(double maximumError)
+{
+  if (this->NonlinearTransformCacheMaximumError == maximumError)
+    {
+    return;
+    }
+  this->NonlinearTransformCacheMaximumError = maximumError;
+  this->UpdateTransforms();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+void vtkMRMLSliceLayerLogic::SetNonlinearTransformCacheMaximumNumberOfGridPoints(int maximumNumberOfGridPoints)
+{
+  if (this->NonlinearTransformCacheMaximumNumberOfGridPoints == maximumNumberOfGridPoints)
+    {
+    return;
+    }
+  this->NonlinearTransformCacheMaximumNumberOfGridPoints = maximumNumberOfGridPoints;
+  this->UpdateTransforms();
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkMRMLSliceLayerLogic::IsNonlinearTransformCacheUsed()
+{
+  return this->Internal->CacheUsed;
+}
+
 //----------------------------------------------------------------------------
 vtkImageData* vtkMRMLSliceLayerLogic::GetImageData()
 {
@@ -984,6 +1369,12 @@ void vtkMRMLSliceLayerLogic::PrintSelf(ostream& os, vtkIndent indent)
     }
 
   os << indent << "IsLabelLayer: " << this->GetIsLabelLayer() << "\n";
+  os << indent << "NonlinearTransformCaching: " << this->NonlinearTransformCaching << "\n";
+  os << indent << "NonlinearTransformCacheGridSpacing: " << this->NonlinearTransformCacheGridSpacing << "\n";
+  os << indent << "NonlinearTransformCacheMaximumError: " << this->NonlinearTransformCacheMaximumError << "\n";
+  os << indent << "NonlinearTransformCacheMaximumNumberOfGridPoints: "
+    << this->NonlinearTransformCacheMaximumNumberOfGridPoints << "\n";
+  os << indent << "NonlinearTransformCacheUsed: " << this->Internal->CacheUsed << "\n";
   os << indent << "LabelOutline:\n";
   if (this->LabelOutline)
     {
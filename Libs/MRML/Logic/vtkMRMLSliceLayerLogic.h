@@ -129,6 +129,45 @@ public:
   /// The current reslice transform XYToIJK
   vtkGetObjectMacro (XYToIJKTransform, vtkGeneralTransform);
 
+  ///
+  /// Use a displacement grid that approximates the non-linear transform of the volume.
+  /// If enabled and the volume is under a non-linear transform then the transform
+  /// from world to the volume's parent is sampled on a regular grid that covers
+  /// the transformed volume. Reslicing then interpolates this grid instead of evaluating
+  /// the whole transform chain (which may include iterative inversion) at each pixel.
+  /// The grid is refined until the interpolation error (estimated at the grid cell
+  /// centers) is below NonlinearTransformCacheMaximumError. If this would require more
+  /// than NonlinearTransformCacheMaximumNumberOfGridPoints grid points then the exact
+  /// transform is used.
+  /// The grid is recomputed when the transform (see vtkMRMLTransformNode::GetTransformToWorldMTime),
+  /// the volume geometry, or the cache parameters change. Changing caching or any of the cache
+  /// parameters updates the reslice transforms.
+  /// Disabled by default.
+  vtkGetMacro (NonlinearTransformCaching, bool);
+  void SetNonlinearTransformCaching(bool caching);
+  vtkBooleanMacro (NonlinearTransformCaching, bool);
+
+  ///
+  /// Spacing of the initial (coarsest) displacement grid in mm.
+  /// If 0 (default) then the spacing is set to have 32 grid points along the longest axis.
+  vtkGetMacro (NonlinearTransformCacheGridSpacing, double);
+  void SetNonlinearTransformCacheGridSpacing(double spacing);
+
+  ///
+  /// Maximum allowed difference (in mm) between the exact and the cached transform.
+  /// Default is 0.5mm.
+  vtkGetMacro (NonlinearTransformCacheMaximumError, double);
+  void SetNonlinearTransformCacheMaximumError(double maximumError);
+
+  ///
+  /// Maximum number of displacement grid points (default: 1000000).
+  vtkGetMacro (NonlinearTransformCacheMaximumNumberOfGridPoints, int);
+  void SetNonlinearTransformCacheMaximumNumberOfGridPoints(int maximumNumberOfGridPoints);
+
+  ///
+  /// Returns true if the current reslice transform uses the cached displacement grid.
+  bool IsNonlinearTransformCacheUsed();
+
 
 protected:
   vtkMRMLSliceLayerLogic();
@@ -182,6 +221,15 @@ protected:
   int IsLabelLayer;
 
   int UpdatingTransforms;
+
+  bool NonlinearTransformCaching;
+  double NonlinearTransformCacheGridSpacing;
+  double NonlinearTransformCacheMaximumError;
+  int NonlinearTransformCacheMaximumNumberOfGridPoints;
+
+private:
+  class vtkInternal;
+  vtkInternal* Internal;
 };
 
 #endif
@@ -13,6 +13,9 @@
 #include "vtkMath.h"
 #include "vtkMatrix4x4.h"
 #include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 
 #include <math.h>
 
@@ -85,6 +88,8 @@ vtkOrientedBSplineTransform::vtkOrientedBSplineTransform()
   this->GridIndexToOutputTransformMatrixCached = vtkMatrix4x4::New();
   this->OutputToGridIndexTransformMatrixCached = vtkMatrix4x4::New();
   this->InverseBulkTransformMatrixCached = vtkMatrix4x4::New();
+
+  this->LastWarningMTime = 0;
 }
 
 //----------------------------------------------------------------------------
@@ -240,6 +245,37 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
                                                      double outPoint[3],
                                                      double derivative[3][3])
 {
+  // inPointTemp and outPoint may be the same vector, so make a copy of the
+  // input for error reporting
+  double inPoint[3] = {inPointTemp[0],inPointTemp[1],inPointTemp[2]};
+
+  double error = 0.0;
+  int numberOfIterations = 0;
+  if (this->ComputeInverseTransformDerivative(inPoint, outPoint, derivative, error, numberOfIterations))
+    {
+    return;
+    }
+
+  // This method may be called concurrently (for example, by vtkImageReslice)
+  std::lock_guard<std::mutex> lock(this->LastWarningMTimeLock);
+  if (this->MTime > this->LastWarningMTime)
+    {
+    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
+                    ") error = " << error << " after " <<
+                    numberOfIterations << " iterations."
+                    "  Further convergence warnings suppressed until transform is modified.");
+    this->LastWarningMTime = this->MTime;
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedBSplineTransform::ComputeInverseTransformDerivative(const double inPointTemp[3],
+  double outPoint[3], double derivative[3][3], double& error, int& numberOfIterations)
+{
+  error = 0.0;
+  numberOfIterations = 0;
+
   // inPointTemp and outPoint may be the same vector, so make a copy of the
   // input before modifying the output
   double inPoint[3] = {inPointTemp[0],inPointTemp[1],inPointTemp[2]};
@@ -260,7 +296,7 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
 
   if (!this->GridPointer || !this->CalculateSpline)
     {
-    return;
+    return true;
     }
 
   void *gridPtr = this->GridPointer;
@@ -418,17 +454,16 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
     inverse[2] = lastInverse[2] - f*deltaI[2];
     }
 
+  error = sqrt(errorSquared);
+  numberOfIterations = iteration;
+  bool converged = true;
   if (iteration >= maxNumberOfIterations)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
-
-    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                    inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                    ") error = " << sqrt(errorSquared) << " after " <<
-                    iteration << " iterations.");
+    converged = false;
     }
 
   // Convert the inPoint to i,j,k indices into the deformation grid
@@ -436,6 +471,70 @@ void vtkOrientedBSplineTransform::InverseTransformDerivative(const double inPoin
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::TransformPoints(vtkPoints *inPts, vtkPoints *outPts)
+{
+  this->Update();
+
+  vtkIdType numberOfPoints = inPts->GetNumberOfPoints();
+  vtkIdType firstOutputPointId = outPts->GetNumberOfPoints();
+  outPts->SetNumberOfPoints(firstOutputPointId + numberOfPoints);
+
+  vtkSMPThreadLocal<vtkIdType> numberOfConvergenceFailures(0);
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType beginPointId, vtkIdType endPointId)
+    {
+    vtkIdType& threadNumberOfConvergenceFailures = numberOfConvergenceFailures.Local();
+    double point[3];
+    double derivative[3][3];
+    double error = 0.0;
+    int numberOfIterations = 0;
+    for (vtkIdType pointId = beginPointId; pointId < endPointId; ++pointId)
+      {
+      inPts->GetPoint(pointId, point);
+      if (this->InverseFlag)
+        {
+        if (!this->ComputeInverseTransformDerivative(point, point, derivative, error, numberOfIterations))
+          {
+          ++threadNumberOfConvergenceFailures;
+          }
+        }
+      else
+        {
+        this->ForwardTransformPoint(point, point);
+        }
+      outPts->SetPoint(firstOutputPointId + pointId, point);
+      }
+    });
+  outPts->Modified();
+
+  vtkIdType totalNumberOfConvergenceFailures = 0;
+  for (vtkSMPThreadLocal<vtkIdType>::iterator it = numberOfConvergenceFailures.begin();
+    it != numberOfConvergenceFailures.end(); ++it)
+    {
+    totalNumberOfConvergenceFailures += *it;
+    }
+  this->ReportInverseConvergenceFailures(totalNumberOfConvergenceFailures, numberOfPoints);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedBSplineTransform::ReportInverseConvergenceFailures(vtkIdType numberOfFailedPoints, vtkIdType numberOfPoints)
+{
+  if (numberOfFailedPoints <= 0)
+    {
+    return;
+    }
+  std::lock_guard<std::mutex> lock(this->LastWarningMTimeLock);
+  if (this->MTime > this->LastWarningMTime)
+    {
+    vtkWarningMacro("TransformPoints: no convergence for " << numberOfFailedPoints
+      << " of " << numberOfPoints << " points."
+      "  Further convergence warnings suppressed until transform is modified.");
+    this->LastWarningMTime = this->MTime;
+    }
 }
 
 //----------------------------------------------------------------------------
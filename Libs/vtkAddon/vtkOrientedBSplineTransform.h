@@ -31,6 +31,8 @@
 
 #include "vtkBSplineTransform.h"
 
+#include <mutex>
+
 class VTK_ADDON_EXPORT vtkOrientedBSplineTransform : public vtkBSplineTransform
 {
 public:
@@ -42,6 +44,27 @@ public:
   // Make another transform of the same type.
   vtkAbstractTransform *MakeTransform() override;
 
+  // Description:
+  // Apply the transformation to a series of points, and append the
+  // results to outPts. Points are transformed in parallel (using vtkSMPTools).
+  // If the inverse transform does not converge for some points then a single
+  // warning is logged for the whole batch.
+  void TransformPoints(vtkPoints *inPts, vtkPoints *outPts) override;
+
+  // Description:
+  // Compute the inverse transform using Newton's method. Returns false if
+  // the computation did not converge. Unlike InverseTransformDerivative,
+  // it does not log warnings, therefore it can be called concurrently
+  // from multiple threads. The transform must be up-to-date.
+  bool ComputeInverseTransformDerivative(const double in[3], double out[3],
+    double derivative[3][3], double& error, int& numberOfIterations);
+
+  // Description:
+  // Log a warning for a batch of points for which
+  // ComputeInverseTransformDerivative did not converge.
+  // Must not be called concurrently from multiple threads.
+  void ReportInverseConvergenceFailures(vtkIdType numberOfFailedPoints, vtkIdType numberOfPoints);
+
   // Description:
   // Set/Get the b-spline grid axis directions.
   // This transform class will never modify the data.
@@ -93,6 +116,12 @@ protected:
   vtkMatrix4x4* OutputToGridIndexTransformMatrixCached;
   vtkMatrix4x4* InverseBulkTransformMatrixCached;
 
+  // Description:
+  // Avoid generating hundreds of warning messages for convergence problems
+  // by keeping track of the MTime when the last warning was issued.
+  vtkMTimeType LastWarningMTime;
+  std::mutex LastWarningMTimeLock;
+
 private:
   vtkOrientedBSplineTransform(const vtkOrientedBSplineTransform&) = delete;
   void operator=(const vtkOrientedBSplineTransform&) = delete;
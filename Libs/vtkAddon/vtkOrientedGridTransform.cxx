@@ -13,6 +13,9 @@
 #include "vtkMatrix4x4.h"
 #include "vtkNew.h"
 #include "vtkObjectFactory.h"
+#include "vtkPoints.h"
+#include "vtkSMPThreadLocal.h"
+#include "vtkSMPTools.h"
 
 vtkStandardNewMacro(vtkOrientedGridTransform);
 
@@ -185,6 +188,38 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
     return;
     }
 
+  // inPoint and outPoint may be the same vector, so make a copy of the
+  // input for error reporting
+  double point[3] = { inPoint[0], inPoint[1], inPoint[2] };
+
+  double error = 0.0;
+  int numberOfIterations = 0;
+  if (this->ComputeInverseTransformDerivative(inPoint, outPoint, derivative, error, numberOfIterations))
+    {
+    vtkDebugMacro("Inverse Iterations: " << numberOfIterations);
+    return;
+    }
+
+  // This method may be called concurrently (for example, by vtkImageReslice)
+  {
+  std::lock_guard<std::mutex> lock(this->LastWarningMTimeLock);
+  if (this->MTime > this->LastWarningMTime)
+    {
+    vtkWarningMacro("InverseTransformPoint: no convergence (" <<
+                    point[0] << ", " << point[1] << ", " << point[2] <<
+                    ") error = " << error << " after " <<
+                    numberOfIterations << " iterations."
+                    "  Further convergence warnings suppressed until transform is modified.");
+    this->LastWarningMTime = this->MTime;
+    }
+  }
+  this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedGridTransform::ComputeInverseTransformDerivative(const double inPoint[3],
+  double outPoint[3], double derivative[3][3], double& error, int& numberOfIterations)
+{
   void *gridPtr = this->GridPointer;
   int gridType = this->GridScalarType;
 
@@ -315,31 +350,98 @@ void vtkOrientedGridTransform::InverseTransformDerivative(const double inPoint[3
     inverse[2] = lastInverse[2] - f*deltaI[2];
     }
 
-  vtkDebugMacro("Inverse Iterations: " << (i+1));
-
+  error = sqrt(errorSquared);
+  bool converged = true;
   if (i >= n)
     {
     // didn't converge: back up to last good result
     inverse[0] = lastInverse[0];
     inverse[1] = lastInverse[1];
     inverse[2] = lastInverse[2];
-
-    if (this->MTime > this->LastWarningMTime)
-      {
-      vtkWarningMacro("InverseTransformPoint: no convergence (" <<
-                      inPoint[0] << ", " << inPoint[1] << ", " << inPoint[2] <<
-                      ") error = " << sqrt(errorSquared) << " after " <<
-                      i << " iterations."
-                      "  Further convergence warnings suppressed until transform is modified.");
-      this->LastWarningMTime = this->MTime;
-      }
-    this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
+    numberOfIterations = i;
+    converged = false;
+    }
+  else
+    {
+    numberOfIterations = i + 1;
     }
 
   // convert point
   outPoint[0] = inverse[0];
   outPoint[1] = inverse[1];
   outPoint[2] = inverse[2];
+
+  return converged;
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::TransformPoints(vtkPoints *inPts, vtkPoints *outPts)
+{
+  this->Update();
+  if (this->GridDirectionMatrix == nullptr || this->GridPointer == nullptr)
+    {
+    this->Superclass::TransformPoints(inPts, outPts);
+    return;
+    }
+
+  vtkIdType numberOfPoints = inPts->GetNumberOfPoints();
+  vtkIdType firstOutputPointId = outPts->GetNumberOfPoints();
+  outPts->SetNumberOfPoints(firstOutputPointId + numberOfPoints);
+
+  vtkSMPThreadLocal<vtkIdType> numberOfConvergenceFailures(0);
+  vtkSMPTools::For(0, numberOfPoints, [&](vtkIdType beginPointId, vtkIdType endPointId)
+    {
+    vtkIdType& threadNumberOfConvergenceFailures = numberOfConvergenceFailures.Local();
+    double point[3];
+    double derivative[3][3];
+    double error = 0.0;
+    int numberOfIterations = 0;
+    for (vtkIdType pointId = beginPointId; pointId < endPointId; ++pointId)
+      {
+      inPts->GetPoint(pointId, point);
+      if (this->InverseFlag)
+        {
+        if (!this->ComputeInverseTransformDerivative(point, point, derivative, error, numberOfIterations))
+          {
+          ++threadNumberOfConvergenceFailures;
+          }
+        }
+      else
+        {
+        this->ForwardTransformPoint(point, point);
+        }
+      outPts->SetPoint(firstOutputPointId + pointId, point);
+      }
+    });
+  outPts->Modified();
+
+  vtkIdType totalNumberOfConvergenceFailures = 0;
+  for (vtkSMPThreadLocal<vtkIdType>::iterator it = numberOfConvergenceFailures.begin();
+    it != numberOfConvergenceFailures.end(); ++it)
+    {
+    totalNumberOfConvergenceFailures += *it;
+    }
+  this->ReportInverseConvergenceFailures(totalNumberOfConvergenceFailures, numberOfPoints);
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedGridTransform::ReportInverseConvergenceFailures(vtkIdType numberOfFailedPoints, vtkIdType numberOfPoints)
+{
+  if (numberOfFailedPoints <= 0)
+    {
+    return;
+    }
+  {
+  std::lock_guard<std::mutex> lock(this->LastWarningMTimeLock);
+  if (this->MTime > this->LastWarningMTime)
+    {
+    vtkWarningMacro("TransformPoints: no convergence for " << numberOfFailedPoints
+      << " of " << numberOfPoints << " points."
+      "  Further convergence warnings suppressed until transform is modified.");
+    this->LastWarningMTime = this->MTime;
+    }
+  }
+  this->InvokeEvent(vtkOrientedGridTransform::ConvergenceFailureEvent);
 }
 
 //----------------------------------------------------------------------------
@@ -21,6 +21,8 @@
 #include "vtkCommand.h"
 #include "vtkGridTransform.h"
 
+#include <mutex>
+
 class VTK_ADDON_EXPORT vtkOrientedGridTransform : public vtkGridTransform
 {
 public:
@@ -40,6 +42,29 @@ public:
   // Make another transform of the same type.
   vtkAbstractTransform *MakeTransform() override;
 
+  // Description:
+  // Apply the transformation to a series of points, and append the
+  // results to outPts. Points are transformed in parallel (using vtkSMPTools).
+  // If the inverse transform does not converge for some points then a single
+  // warning is logged and a single ConvergenceFailureEvent is invoked for
+  // the whole batch.
+  void TransformPoints(vtkPoints *inPts, vtkPoints *outPts) override;
+
+  // Description:
+  // Compute the inverse transform using Newton's method. Returns false if
+  // the computation did not converge. Unlike InverseTransformDerivative,
+  // it does not log warnings or invoke events, therefore it can be called
+  // concurrently from multiple threads. The transform must be up-to-date
+  // and must have a displacement grid and grid direction matrix.
+  bool ComputeInverseTransformDerivative(const double in[3], double out[3],
+    double derivative[3][3], double& error, int& numberOfIterations);
+
+  // Description:
+  // Log a warning and invoke a ConvergenceFailureEvent for a batch of points
+  // for which ComputeInverseTransformDerivative did not converge.
+  // Must not be called concurrently from multiple threads.
+  void ReportInverseConvergenceFailures(vtkIdType numberOfFailedPoints, vtkIdType numberOfPoints);
+
   /// List of custom events fired by the class.
   // ConvergenceFailureEvent is invoked when the gradient cannot be
   // inverted, probably due to a singular transform or numeric instability.
@@ -91,6 +116,7 @@ protected:
   // Avoid generating hundreds of warning messages for convergence problems
   // by keeping track of the MTime when the last warning was issued.
   vtkMTimeType LastWarningMTime;
+  std::mutex LastWarningMTimeLock;
 
 private:
   vtkOrientedGridTransform(const vtkOrientedGridTransform&) = delete;
@@ -0,0 +1,216 @@
+#include <vtkITKArchetypeImageSeriesScalarReader.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+
+// ITK includes
+#include <itkConfigure.h>
+#include <itkFactoryRegistration.h>
+#include <itkGDCMImageIO.h>
+#include <itkImageFileWriter.h>
+#include <itkMetaDataObject.h>
+
+// ITKsys includes
+#include <itksys/SystemTools.hxx>
+
+// STD includes
+#include <cstring>
+#include <sstream>
+
+// Test that the DICOM header cache is reused when a series is loaded again,
+// invalidated when a slice is replaced, and that parsing headers in multiple
+// threads gives the same result as in a single thread.
+
+namespace
+{
+
+const int NumberOfSlices = 10;
+
+//----------------------------------------------------------------------------
+bool WriteSlice(const std::string& fileName, int sliceIndex, const std::string& seriesUID)
+{
+  typedef itk::Image<short, 3> ImageType;
+  ImageType::Pointer image = ImageType::New();
+  ImageType::SizeType size;
+  size[0] = 8;
+  size[1] = 8;
+  size[2] = 1;
+  image->SetRegions(size);
+  double origin[3] = { 0.0, 0.0, static_cast<double>(sliceIndex) };
+  image->SetOrigin(origin);
+  image->Allocate();
+  image->FillBuffer(static_cast<short>(sliceIndex * 10));
+
+  std::ostringstream instanceUID;
+  instanceUID << seriesUID << "." << sliceIndex;
+  std::ostringstream instanceNumber;
+  instanceNumber << sliceIndex + 1;
+  itk::MetaDataDictionary& dictionary = image->GetMetaDataDictionary();
+  itk::EncapsulateMetaData<std::string>(dictionary, "0008|0016", "1.2.840.10008.5.1.4.1.1.2");
+  itk::EncapsulateMetaData<std::string>(dictionary, "0008|0018", instanceUID.str());
+  itk::EncapsulateMetaData<std::string>(dictionary, "0008|0060", "CT");
+  itk::EncapsulateMetaData<std::string>(dictionary, "0020|000d", "1.2.826.0.1.3680043.2.1125.1");
+  itk::EncapsulateMetaData<std::string>(dictionary, "0020|000e", seriesUID);
+  itk::EncapsulateMetaData<std::string>(dictionary, "0020|0013", instanceNumber.str());
+
+  itk::GDCMImageIO::Pointer dicomIO = itk::GDCMImageIO::New();
+  dicomIO->KeepOriginalUIDOn();
+  typedef itk::ImageFileWriter<ImageType> WriterType;
+  WriterType::Pointer writer = WriterType::New();
+  writer->SetImageIO(dicomIO);
+  writer->SetFileName(fileName);
+  writer->SetInput(image);
+  try
+    {
+    writer->Update();
+    }
+  catch (itk::ExceptionObject& err)
+    {
+    std::cout << "Unable to write file '" << fileName << "', err = \n" << err << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+vtkSmartPointer<vtkImageData> ReadSeries(const std::string& archetype, int numberOfThreads)
+{
+  vtkNew<vtkITKArchetypeImageSeriesScalarReader> reader;
+  reader->SetArchetype(archetype.c_str());
+  reader->SetSingleFile(0);
+  reader->SetNumberOfThreads(numberOfThreads);
+  reader->SetOutputScalarTypeToNative();
+  reader->SetDesiredCoordinateOrientationToNative();
+  reader->Update();
+  if (reader->GetErrorCode() != 0 || !reader->GetOutput())
+    {
+    std::cout << "Unable to read series of file '" << archetype << "'" << std::endl;
+    return nullptr;
+    }
+  vtkSmartPointer<vtkImageData> image = vtkSmartPointer<vtkImageData>::New();
+  image->DeepCopy(reader->GetOutput());
+  return image;
+}
+
+//----------------------------------------------------------------------------
+bool CompareImages(vtkImageData* image1, vtkImageData* image2)
+{
+  int* dimensions1 = image1->GetDimensions();
+  int* dimensions2 = image2->GetDimensions();
+  for (int i = 0; i < 3; i++)
+    {
+    if (dimensions1[i] != dimensions2[i])
+      {
+      std::cout << "Image dimensions differ" << std::endl;
+      return false;
+      }
+    }
+  vtkDataArray* scalars1 = image1->GetPointData()->GetScalars();
+  vtkDataArray* scalars2 = image2->GetPointData()->GetScalars();
+  if (!scalars1 || !scalars2
+    || scalars1->GetDataType() != scalars2->GetDataType()
+    || scalars1->GetDataSize() != scalars2->GetDataSize()
+    || memcmp(scalars1->GetVoidPointer(0), scalars2->GetVoidPointer(0),
+      scalars1->GetDataSize() * scalars1->GetDataTypeSize()) != 0)
+    {
+    std::cout << "Image scalars differ" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int main(int argc, char *argv[])
+{
+  itk::itkFactoryRegistration();
+
+  if (argc < 2)
+    {
+    std::cout << "ERROR: need to specify a temporary directory on the command line." << std::endl;
+    return 1;
+    }
+  std::string directory = std::string(argv[1]) + "/vtkITKArchetypeDICOMSeriesReaderTest";
+  itksys::SystemTools::RemoveADirectory(directory);
+  itksys::SystemTools::MakeDirectory(directory);
+
+  const std::string seriesUID = "1.2.826.0.1.3680043.2.1125.1.1";
+  std::vector<std::string> fileNames;
+  for (int i = 0; i < NumberOfSlices; i++)
+    {
+    std::ostringstream fileName;
+    fileName << directory << "/slice" << i << ".dcm";
+    fileNames.push_back(fileName.str());
+    if (!WriteSlice(fileNames.back(), i, seriesUID))
+      {
+      return 1;
+      }
+    }
+
+  vtkITKArchetypeImageSeriesReader::ClearDICOMHeaderCache();
+
+  // Load the series, then again from the cache
+  vtkSmartPointer<vtkImageData> image = ReadSeries(fileNames[0], 1);
+  if (!image || image->GetDimensions()[2] != NumberOfSlices)
+    {
+    std::cout << "ERROR: expected " << NumberOfSlices << " slices" << std::endl;
+    return 1;
+    }
+  int numberOfCachedHeaders = vtkITKArchetypeImageSeriesReader::GetNumberOfCachedDICOMHeaders();
+  if (numberOfCachedHeaders != NumberOfSlices)
+    {
+    std::cout << "ERROR: expected " << NumberOfSlices << " cached headers, got " << numberOfCachedHeaders << std::endl;
+    return 1;
+    }
+  vtkSmartPointer<vtkImageData> cachedImage = ReadSeries(fileNames[0], 1);
+  if (!cachedImage || !CompareImages(image, cachedImage)
+    || vtkITKArchetypeImageSeriesReader::GetNumberOfCachedDICOMHeaders() != numberOfCachedHeaders)
+    {
+    std::cout << "ERROR: loading the series from the cache changed the result" << std::endl;
+    return 1;
+    }
+
+  // Parsing headers in multiple threads gives the same result
+  vtkITKArchetypeImageSeriesReader::ClearDICOMHeaderCache();
+  vtkSmartPointer<vtkImageData> multiThreadedImage = ReadSeries(fileNames[0], 4);
+  if (!multiThreadedImage || !CompareImages(image, multiThreadedImage))
+    {
+    std::cout << "ERROR: multi-threaded header parsing changed the result" << std::endl;
+    return 1;
+    }
+
+  // Replace a slice in place by a slice of another series. This does not
+  // change the modification time of the directory, the cached series and
+  // header must be invalidated by the modification of the file itself.
+  itksys::SystemTools::Delay(1100);
+  if (!WriteSlice(fileNames[NumberOfSlices - 1], NumberOfSlices - 1, seriesUID + ".2"))
+    {
+    return 1;
+    }
+  vtkSmartPointer<vtkImageData> modifiedImage = ReadSeries(fileNames[0], 4);
+  if (!modifiedImage || modifiedImage->GetDimensions()[2] != NumberOfSlices - 1)
+    {
+    std::cout << "ERROR: replaced slice is still part of the cached series" << std::endl;
+    return 1;
+    }
+
+  // Cache size is bounded
+  int maximumNumberOfCachedHeaders = vtkITKArchetypeImageSeriesReader::GetMaximumNumberOfCachedDICOMHeaders();
+  vtkITKArchetypeImageSeriesReader::SetMaximumNumberOfCachedDICOMHeaders(3);
+  vtkITKArchetypeImageSeriesReader::ClearDICOMHeaderCache();
+  vtkSmartPointer<vtkImageData> boundedCacheImage = ReadSeries(fileNames[0], 4);
+  vtkITKArchetypeImageSeriesReader::SetMaximumNumberOfCachedDICOMHeaders(maximumNumberOfCachedHeaders);
+  if (!boundedCacheImage || !CompareImages(modifiedImage, boundedCacheImage)
+    || vtkITKArchetypeImageSeriesReader::GetNumberOfCachedDICOMHeaders() > 3)
+    {
+    std::cout << "ERROR: cache size limit is not respected" << std::endl;
+    return 1;
+    }
+
+  itksys::SystemTools::RemoveADirectory(directory);
+  return 0;
+}
@@ -0,0 +1,112 @@
+import unittest
+import time
+import numpy
+import vtk
+import vtkITK
+from vtk.util import numpy_support as ns
+
+"""
+Compare statistics computed by vtkITKLabelStatistics in a single pass
+with statistics computed by numpy for each label.
+"""
+
+class vtkITKLabelStatisticsTest(unittest.TestCase):
+    def setUp(self):
+        self.dimensions = [64, 48, 32]
+        numpy.random.seed(0)
+        # Labels are stored in two labelmaps, as layers of a segmentation
+        self.labelArrays = [
+          numpy.random.randint(0, 20, self.dimensions[::-1]).astype(numpy.uint8),
+          numpy.random.randint(0, 5, self.dimensions[::-1]).astype(numpy.uint16)]
+        self.scalarArray = numpy.random.randint(-1024, 3000, self.dimensions[::-1]).astype(numpy.int16)
+
+    def createImage(self, array, spacing=(1.0, 1.0, 1.0)):
+        image = vtk.vtkImageData()
+        image.SetDimensions(self.dimensions)
+        image.SetSpacing(spacing)
+        image.GetPointData().SetScalars(ns.numpy_to_vtk(array.ravel(), deep=True))
+        return image
+
+    def test_statistics(self):
+        labelStat = vtkITK.vtkITKLabelStatistics()
+        for labelArray in self.labelArrays:
+            labelStat.AddInputData(0, self.createImage(labelArray, (0.5, 1.0, 3.0)))
+        labelStat.SetScalarInputData(self.createImage(self.scalarArray))
+        labelStat.SetPercentiles([10, 50])
+        labelStat.SetNumberOfThreads(4)
+        labelStat.Update()
+        table = labelStat.GetOutput()
+
+        expectedNumberOfRows = sum(len(numpy.unique(labelArray[labelArray != 0])) for labelArray in self.labelArrays)
+        self.assertEqual(table.GetNumberOfRows(), expectedNumberOfRows)
+        for rowIndex in range(table.GetNumberOfRows()):
+            labelmapIndex = table.GetColumnByName("LabelmapIndex").GetValue(rowIndex)
+            labelValue = table.GetColumnByName("LabelValue").GetValue(rowIndex)
+            values = self.scalarArray[self.labelArrays[labelmapIndex] == labelValue].astype(numpy.float64)
+            self.assertEqual(table.GetColumnByName("VoxelCount").GetValue(rowIndex), len(values))
+            self.assertAlmostEqual(table.GetColumnByName("Volume").GetValue(rowIndex), len(values) * 1.5)
+            self.assertEqual(table.GetColumnByName("Minimum").GetValue(rowIndex), values.min())
+            self.assertEqual(table.GetColumnByName("Maximum").GetValue(rowIndex), values.max())
+            self.assertAlmostEqual(table.GetColumnByName("Mean").GetValue(rowIndex), values.mean(), places=6)
+            self.assertAlmostEqual(table.GetColumnByName("StandardDeviation").GetValue(rowIndex), values.std(ddof=1), places=4)
+            # Values are integers and their range is smaller than the number of bins: percentiles are exact.
+            # Percentile is the smallest value that is greater or equal to the given percent of values.
+            sortedValues = numpy.sort(values)
+            for percentile in [10, 50]:
+                expectedValue = sortedValues[max(0, int(numpy.ceil(percentile / 100.0 * len(values))) - 1)]
+                self.assertEqual(table.GetColumnByName(
+                  vtkITK.vtkITKLabelStatistics.GetPercentileColumnName(percentile)).GetValue(rowIndex), expectedValue)
+
+    def test_shape_statistics(self):
+        labelStat = vtkITK.vtkITKLabelStatistics()
+        labelStat.AddInputData(0, self.createImage(self.labelArrays[0]))
+        labelStat.ComputeShapeStatisticOn("Centroid")
+        labelStat.Update()
+        table = labelStat.GetOutput()
+        self.assertIsNone(table.GetColumnByName("Minimum"))
+        centroidArray = table.GetColumnByName("Centroid")
+        self.assertIsNotNone(centroidArray)
+        for rowIndex in range(table.GetNumberOfRows()):
+            labelValue = table.GetColumnByName("LabelValue").GetValue(rowIndex)
+            k, j, i = numpy.nonzero(self.labelArrays[0] == labelValue)
+            centroid = centroidArray.GetTuple3(rowIndex)
+            self.assertAlmostEqual(centroid[0], i.mean(), places=4)
+            self.assertAlmostEqual(centroid[1], j.mean(), places=4)
+            self.assertAlmostEqual(centroid[2], k.mean(), places=4)
+
+    def test_performance(self):
+        # This test is for performance: compare computing statistics of all labels at once
+        # with computing statistics of each label separately.
+        labelmap = self.createImage(self.labelArrays[0])
+        scalarImage = self.createImage(self.scalarArray)
+        startTime = time.time()
+        labelStat = vtkITK.vtkITKLabelStatistics()
+        labelStat.AddInputData(0, labelmap)
+        labelStat.SetScalarInputData(scalarImage)
+        labelStat.Update()
+        allLabelsTime = time.time() - startTime
+
+        startTime = time.time()
+        for labelValue in range(1, 20):
+            thresh = vtk.vtkImageThreshold()
+            thresh.SetInputData(labelmap)
+            thresh.ThresholdBetween(labelValue, labelValue)
+            thresh.SetInValue(1)
+            thresh.SetOutValue(0)
+            thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
+            stencil = vtk.vtkImageToImageStencil()
+            stencil.SetInputConnection(thresh.GetOutputPort())
+            stencil.ThresholdByUpper(1)
+            stat = vtk.vtkImageAccumulate()
+            stat.SetInputData(scalarImage)
+            stat.SetStencilConnection(stencil.GetOutputPort())
+            stat.Update()
+        perLabelTime = time.time() - startTime
+        print('<DartMeasurement name="vtkITKLabelStatistics-AllLabels" type="numeric/double">%f</DartMeasurement>' % allLabelsTime)
+        print('<DartMeasurement name="vtkITKLabelStatistics-PerLabel" type="numeric/double">%f</DartMeasurement>' % perLabelTime)
+
+    def runTest(self):
+        self.setUp()
+        self.test_statistics()
+        self.test_shape_statistics()
+        self.test_performance()
@@ -23,6 +23,7 @@
 #include <vtkMatrix4x4.h>
 #include <vtkInformation.h>
 #include <vtkInformationVector.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
@@ -37,8 +38,17 @@
 #include <itkMetaImageIO.h>
 #include <itkTimeProbe.h>
 
+// ITKsys includes
+#include <itksys/Directory.hxx>
+#include <itksys/SystemTools.hxx>
+
 // STD includes
 #include <algorithm>
+#include <atomic>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
 #include <vector>
 
 #include "itkArchetypeSeriesFileNames.h"
@@ -52,6 +62,304 @@
 
 vtkStandardNewMacro(vtkITKArchetypeImageSeriesReader);
 
+#ifdef VTKITK_BUILD_DICOM_SUPPORT
+//----------------------------------------------------------------------------
+namespace
+{
+
+/// DICOM tags used to group the files of a directory
+enum
+{
+  SeriesInstanceUIDTag = 0,
+  ContentTimeTag,
+  TriggerTimeTag,
+  EchoNumbersTag,
+  DiffusionGradientOrientationTag,
+  SliceLocationTag,
+  ImageOrientationPatientTag,
+  ImagePositionPatientTag,
+  NumberOfDICOMHeaderTags
+};
+const char* const DICOMHeaderTagKeys[NumberOfDICOMHeaderTags] =
+{
+  "0020|000e", "0008|0033", "0018|1060", "0018|0086",
+  "0010|9089", "0020|1041", "0020|0037", "0020|0032"
+};
+
+/// Size and modification time of a file, to detect that it changed
+struct FileFingerprint
+{
+  unsigned long Size{0};
+  long ModifiedTime{0};
+  bool operator==(const FileFingerprint& other) const
+  {
+    return this->Size == other.Size && this->ModifiedTime == other.ModifiedTime;
+  }
+};
+
+struct DICOMHeader
+{
+  FileFingerprint Fingerprint;
+  /// Value of each tag of DICOMHeaderTagKeys, without spaces
+  std::string TagValues[NumberOfDICOMHeaderTags];
+};
+
+struct DICOMSeriesIndex
+{
+  /// Fingerprint of each file of the directory when it was scanned
+  std::map<std::string, FileFingerprint> DirectoryFingerprint;
+  std::vector<std::string> SeriesUIDs;
+  std::vector< std::vector<std::string> > FileNames;
+};
+
+//----------------------------------------------------------------------------
+/// Cache that discards the least recently used entry when it is full
+template <class ValueType>
+class LeastRecentlyUsedCache
+{
+public:
+  explicit LeastRecentlyUsedCache(size_t maximumSize) : MaximumSize(maximumSize) {}
+
+  /// Return the cached value and mark it as most recently used,
+  /// nullptr if not found.
+  ValueType* Find(const std::string& key)
+  {
+    typename IndexType::iterator it = this->Index.find(key);
+    if (it == this->Index.end())
+      {
+      return nullptr;
+      }
+    this->Entries.splice(this->Entries.begin(), this->Entries, it->second);
+    return &it->second->second;
+  }
+
+  void Insert(const std::string& key, const ValueType& value)
+  {
+    ValueType* cachedValue = this->Find(key);
+    if (cachedValue)
+      {
+      *cachedValue = value;
+      return;
+      }
+    this->Entries.push_front(std::make_pair(key, value));
+    this->Index[key] = this->Entries.begin();
+    this->Shrink();
+  }
+
+  void SetMaximumSize(size_t maximumSize)
+  {
+    this->MaximumSize = maximumSize;
+    this->Shrink();
+  }
+  size_t GetMaximumSize() const { return this->MaximumSize; }
+  size_t GetSize() const { return this->Entries.size(); }
+
+  void Clear()
+  {
+    this->Entries.clear();
+    this->Index.clear();
+  }
+
+protected:
+  void Shrink()
+  {
+    while (this->Entries.size() > this->MaximumSize)
+      {
+      this->Index.erase(this->Entries.back().first);
+      this->Entries.pop_back();
+      }
+  }
+
+  typedef std::list< std::pair<std::string, ValueType> > EntryListType;
+  typedef std::map<std::string, typename EntryListType::iterator> IndexType;
+  size_t MaximumSize;
+  /// Most recently used first
+  EntryListType Entries;
+  IndexType Index;
+};
+
+/// Headers and directory indices shared by all the readers.
+/// Headers of a few large studies fit in the default header cache size.
+std::mutex DICOMHeaderCacheLock;
+LeastRecentlyUsedCache<DICOMHeader> DICOMHeaderCache(20000);
+LeastRecentlyUsedCache< std::shared_ptr<const DICOMSeriesIndex> > DICOMSeriesIndexCache(16);
+
+//----------------------------------------------------------------------------
+FileFingerprint GetFileFingerprint(const std::string& fileName)
+{
+  FileFingerprint fingerprint;
+  fingerprint.Size = itksys::SystemTools::FileLength(fileName);
+  fingerprint.ModifiedTime = itksys::SystemTools::ModifiedTime(fileName);
+  return fingerprint;
+}
+
+//----------------------------------------------------------------------------
+// Fingerprint of all the files of a directory. Files that are added,
+// removed, or replaced in place (which does not modify the directory
+// modification time) change the fingerprint.
+std::map<std::string, FileFingerprint> GetDirectoryFingerprint(const std::string& directory)
+{
+  std::map<std::string, FileFingerprint> directoryFingerprint;
+  itksys::Directory directoryContent;
+  if (!directoryContent.Load(directory))
+    {
+    return directoryFingerprint;
+    }
+  for (unsigned long i = 0; i < directoryContent.GetNumberOfFiles(); ++i)
+    {
+    std::string fileName = directoryContent.GetFile(i);
+    std::string filePath = directory + "/" + fileName;
+    if (fileName == "." || fileName == ".." || itksys::SystemTools::FileIsDirectory(filePath))
+      {
+      continue;
+      }
+    directoryFingerprint[fileName] = GetFileFingerprint(filePath);
+    }
+  return directoryFingerprint;
+}
+
+struct DICOMHeaderParsingInfo
+{
+  const std::vector<std::string>* FileNames;
+  const std::vector<size_t>* FilesToParse;
+  std::vector<DICOMHeader>* Headers;
+  std::atomic<size_t> NextFile{0};
+  std::mutex ErrorLock;
+  std::string ErrorMessage;
+};
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE ParseDICOMHeadersThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  DICOMHeaderParsingInfo* info = static_cast<DICOMHeaderParsingInfo*>(threadInfo->UserData);
+  // Each thread has its own image IO
+  itk::GDCMImageIO::Pointer gdcmIO = itk::GDCMImageIO::New();
+  size_t index = 0;
+  while ((index = info->NextFile++) < info->FilesToParse->size())
+    {
+    size_t f = (*info->FilesToParse)[index];
+    DICOMHeader& header = (*info->Headers)[f];
+    try
+      {
+      gdcmIO->SetFileName( (*info->FileNames)[f] );
+      gdcmIO->ReadImageInformation();
+      }
+    catch (itk::ExceptionObject& e)
+      {
+      std::lock_guard<std::mutex> lock(info->ErrorLock);
+      if (info->ErrorMessage.empty())
+        {
+        info->ErrorMessage = std::string(e.GetLocation()) + ": " + e.GetDescription();
+        }
+      continue;
+      }
+    const itk::MetaDataDictionary& dict = gdcmIO->GetMetaDataDictionary();
+    for (int tag = 0; tag < NumberOfDICOMHeaderTags; ++tag)
+      {
+      std::string& tagValue = header.TagValues[tag];
+      itk::ExposeMetaData<std::string>(dict, DICOMHeaderTagKeys[tag], tagValue);
+      tagValue.erase(std::remove_if(tagValue.begin(), tagValue.end(), isspace), tagValue.end());
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+// Read the headers of the files, only parsing the files that are not
+// in the cache or have been modified since they were cached.
+void ReadDICOMHeaders(const std::vector<std::string>& fileNames,
+                      std::vector<DICOMHeader>& headers, int numberOfThreads)
+{
+  headers.clear();
+  headers.resize(fileNames.size());
+  std::vector<std::string> cacheKeys(fileNames.size());
+  std::vector<size_t> filesToParse;
+  for (size_t f = 0; f < fileNames.size(); ++f)
+    {
+    cacheKeys[f] = itksys::SystemTools::CollapseFullPath(fileNames[f]);
+    headers[f].Fingerprint = GetFileFingerprint(cacheKeys[f]);
+    }
+  {
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  for (size_t f = 0; f < fileNames.size(); ++f)
+    {
+    const DICOMHeader* cachedHeader = DICOMHeaderCache.Find(cacheKeys[f]);
+    if (cachedHeader && cachedHeader->Fingerprint == headers[f].Fingerprint)
+      {
+      headers[f] = *cachedHeader;
+      }
+    else
+      {
+      filesToParse.push_back(f);
+      }
+    }
+  }
+  if (filesToParse.empty())
+    {
+    return;
+    }
+
+  DICOMHeaderParsingInfo info;
+  info.FileNames = &fileNames;
+  info.FilesToParse = &filesToParse;
+  info.Headers = &headers;
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+  numberOfThreads = std::max(1, std::min(numberOfThreads, static_cast<int>(filesToParse.size())));
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ParseDICOMHeadersThreadFunction, &info);
+  threader->SingleMethodExecute();
+  if (!info.ErrorMessage.empty())
+    {
+    itkGenericExceptionMacro(<< "Failed to read DICOM header. " << info.ErrorMessage);
+    }
+
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  for (size_t f : filesToParse)
+    {
+    DICOMHeaderCache.Insert(cacheKeys[f], headers[f]);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Return the DICOM series found in a directory. The directory is only
+// scanned again if any of its files has been added, removed or modified
+// since the last scan.
+std::shared_ptr<const DICOMSeriesIndex> GetDICOMSeriesIndex(const std::string& directory)
+{
+  std::string cacheKey = itksys::SystemTools::CollapseFullPath(directory);
+  std::map<std::string, FileFingerprint> directoryFingerprint = GetDirectoryFingerprint(cacheKey);
+  {
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  std::shared_ptr<const DICOMSeriesIndex>* cachedSeriesIndex = DICOMSeriesIndexCache.Find(cacheKey);
+  if (cachedSeriesIndex && (*cachedSeriesIndex)->DirectoryFingerprint == directoryFingerprint)
+    {
+    return *cachedSeriesIndex;
+    }
+  }
+
+  std::shared_ptr<DICOMSeriesIndex> seriesIndex = std::make_shared<DICOMSeriesIndex>();
+  seriesIndex->DirectoryFingerprint = directoryFingerprint;
+  itk::GDCMSeriesFileNames::Pointer inputImageFileGenerator = itk::GDCMSeriesFileNames::New();
+  inputImageFileGenerator->SetDirectory( directory );
+  seriesIndex->SeriesUIDs = inputImageFileGenerator->GetSeriesUIDs();
+  for (const std::string& seriesUID : seriesIndex->SeriesUIDs)
+    {
+    seriesIndex->FileNames.push_back(inputImageFileGenerator->GetFileNames( seriesUID ));
+    }
+
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  DICOMSeriesIndexCache.Insert(cacheKey, seriesIndex);
+  return seriesIndex;
+}
+
+} // end of anonymous namespace
+#endif
+
 //----------------------------------------------------------------------------
 vtkITKArchetypeImageSeriesReader::vtkITKArchetypeImageSeriesReader()
 {
@@ -72,6 +380,7 @@ vtkITKArchetypeImageSeriesReader::vtkITKArchetypeImageSeriesReader()
 #ifdef VTKITK_BUILD_DICOM_SUPPORT
   this->DICOMImageIOApproach = vtkITKArchetypeImageSeriesReader::GDCM;
 #endif
+  this->NumberOfThreads = 0;
 
   this->OutputScalarType = VTK_FLOAT;
   this->NumberOfComponents = 0;
@@ -180,9 +489,69 @@ void vtkITKArchetypeImageSeriesReader::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "DICOMImageIOApproach: " << this->GetDICOMImageIOApproach();
 #else
   os << indent << "DICOMImageIOApproach: " << "NA";
+#endif
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkITKArchetypeImageSeriesReader::ClearDICOMHeaderCache()
+{
+#ifdef VTKITK_BUILD_DICOM_SUPPORT
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  DICOMHeaderCache.Clear();
+  DICOMSeriesIndexCache.Clear();
+#endif
+}
+
+//----------------------------------------------------------------------------
+void vtkITKArchetypeImageSeriesReader::SetMaximumNumberOfCachedDICOMHeaders(int maximumNumberOfHeaders)
+{
+#ifdef VTKITK_BUILD_DICOM_SUPPORT
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  DICOMHeaderCache.SetMaximumSize(static_cast<size_t>(std::max(0, maximumNumberOfHeaders)));
+#else
+  (void)maximumNumberOfHeaders;
 #endif
 }
 
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::GetMaximumNumberOfCachedDICOMHeaders()
+{
+#ifdef VTKITK_BUILD_DICOM_SUPPORT
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  return static_cast<int>(DICOMHeaderCache.GetMaximumSize());
+#else
+  return 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+int vtkITKArchetypeImageSeriesReader::GetNumberOfCachedDICOMHeaders()
+{
+#ifdef VTKITK_BUILD_DICOM_SUPPORT
+  std::lock_guard<std::mutex> lock(DICOMHeaderCacheLock);
+  return static_cast<int>(DICOMHeaderCache.GetSize());
+#else
+  return 0;
+#endif
+}
+
+//----------------------------------------------------------------------------
+vtkImageData* vtkITKArchetypeImageSeriesReader::AllocateOutputDataForITKBuffer(
+  vtkDataObject* output, vtkInformation* outInfo)
+{
+  vtkImageData *data = vtkImageData::SafeDownCast(output);
+  if (!data)
+    {
+    return nullptr;
+    }
+  data->SetExtent(0,0,0,0,0,0);
+  data->AllocateScalars(outInfo);
+  data->SetExtent(outInfo->Get(
+    vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()));
+  return data;
+}
+
 //----------------------------------------------------------------------------
 int vtkITKArchetypeImageSeriesReader::CanReadFile(const char* filename)
 {
@@ -406,44 +775,25 @@ int vtkITKArchetypeImageSeriesReader::RequestInformation(
 #ifdef VTKITK_BUILD_DICOM_SUPPORT
       if ( this->ArchetypeIsDICOM && !this->GetSingleFile() )
         {
-        typedef itk::GDCMSeriesFileNames DICOMNameGeneratorType;
-        DICOMNameGeneratorType::Pointer inputImageFileGenerator = DICOMNameGeneratorType::New();
         std::string fileNamePath = itksys::SystemTools::GetFilenamePath( this->Archetype );
         if (fileNamePath == "")
           {
           fileNamePath = ".";
           }
-        inputImageFileGenerator->SetDirectory( fileNamePath );
+        // The directory is only scanned if it changed since the last scan
+        std::shared_ptr<const DICOMSeriesIndex> seriesIndex = GetDICOMSeriesIndex( fileNamePath );
 
         // determine if the file is diffusion weighted MR file
 
         // Find the series that contains the archetype
-        candidateSeries = inputImageFileGenerator->GetSeriesUIDs();
-
-        // Find all dicom files in the directory
-        for (unsigned int s = 0; s < candidateSeries.size(); s++)
-          {
-          std::vector<std::string> seriesFileNames;
-          seriesFileNames = inputImageFileGenerator->GetFileNames( candidateSeries[s] );
-          for (unsigned int f = 0; f < seriesFileNames.size(); f++)
-            {
-            this->AllFileNames.push_back( seriesFileNames[f] );
-            }
-          }
-        //int nFiles = this->AllFileNames.size(); UNUSED
-
-        // analysis dicom files and fill the Dicom Tag arrays
-        if ( this->AnalyzeHeader )
-          {
-          this->AnalyzeDicomHeaders();
-          }
+        candidateSeries = seriesIndex->SeriesUIDs;
 
         // the following for loop set up candidate files with same series number
         // that include the given Archetype;
         int found = 0;
         for (unsigned int s = 0; s < candidateSeries.size() && found == 0; s++)
           {
-          candidateFiles = inputImageFileGenerator->GetFileNames(candidateSeries[s]);
+          candidateFiles = seriesIndex->FileNames[s];
           for (unsigned int f = 0; f < candidateFiles.size(); f++)
             {
             if (itksys::SystemTools::CollapseFullPath(candidateFiles[f].c_str()) ==
@@ -455,6 +805,27 @@ int vtkITKArchetypeImageSeriesReader::RequestInformation(
             }
           }
 
+        if ( found && !this->GroupingByTags )
+          {
+          // Only the files of the archetype series are needed to assemble the volume
+          this->AllFileNames = candidateFiles;
+          }
+        else
+          {
+          // Find all dicom files in the directory
+          for (unsigned int s = 0; s < candidateSeries.size(); s++)
+            {
+            const std::vector<std::string>& seriesFileNames = seriesIndex->FileNames[s];
+            this->AllFileNames.insert( this->AllFileNames.end(), seriesFileNames.begin(), seriesFileNames.end() );
+            }
+          }
+
+        // analysis dicom files and fill the Dicom Tag arrays
+        if ( this->AnalyzeHeader )
+          {
+          this->AnalyzeDicomHeaders();
+          }
+
         // do we have just one candidate file
         if ( candidateFiles.size() == 1 )
           {
@@ -1314,21 +1685,21 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
     return;
     }
 
-  // if Archetype is a Dicom File
-  gdcmIO->SetFileName( this->Archetype );
+  // if Archetype is a Dicom File, parse the headers in parallel (headers
+  // that have already been parsed are found in the cache), then index the
+  // tags in the order of the files.
+  std::vector<DICOMHeader> headers;
+  ReadDICOMHeaders(this->AllFileNames, headers, this->NumberOfThreads);
   for (int f = 0; f < nFiles; f++)
     {
-    gdcmIO->SetFileName( this->AllFileNames[f] );
-    gdcmIO->ReadImageInformation();
-    itk::MetaDataDictionary &dict = gdcmIO->GetMetaDataDictionary();
+    // Extra spaces are removed from the DICOM tags, because extra spaces
+    // were found in some DICOM file before/after the multi-value separator
+    // backslashes.
+    const DICOMHeader& header = headers[f];
     std::string tagValue;
 
-    // Use vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces to remove extra spaces
-    // from the DICOM tag, because extra spaces were found in some DICOM file before/after the
-    // multi-value separator backslashes.
-
     // series instance UID
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|000e");
+    tagValue = header.TagValues[SeriesInstanceUIDTag];
     if (!tagValue.empty())
       {
       int idx = InsertSeriesInstanceUIDs( tagValue.c_str() );
@@ -1340,7 +1711,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       }
 
     // content time
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0008|0033");
+    tagValue = header.TagValues[ContentTimeTag];
     if (!tagValue.empty())
       {
       int idx = InsertContentTime( tagValue.c_str() );
@@ -1352,7 +1723,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       }
 
     // trigger time
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0018|1060");
+    tagValue = header.TagValues[TriggerTimeTag];
     if (!tagValue.empty())
       {
       int idx = InsertTriggerTime( tagValue.c_str() );
@@ -1364,7 +1735,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       }
 
     // echo numbers
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0018|0086");
+    tagValue = header.TagValues[EchoNumbersTag];
     if (!tagValue.empty())
       {
       int idx = InsertEchoNumbers( tagValue.c_str() );
@@ -1376,7 +1747,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       }
 
     // diffision gradient orientation
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0010|9089");
+    tagValue = header.TagValues[DiffusionGradientOrientationTag];
     if (!tagValue.empty())
       {
       float a[3] = { -1 };
@@ -1390,7 +1761,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       }
 
     // slice location
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|1041");
+    tagValue = header.TagValues[SliceLocationTag];
     if (!tagValue.empty())
       {
       float a = -1;
@@ -1404,7 +1775,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       }
 
     // image orientation patient
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|0037");
+    tagValue = header.TagValues[ImageOrientationPatientTag];
     if (!tagValue.empty())
       {
       float a[6] = { -1 };
@@ -1417,7 +1788,7 @@ void vtkITKArchetypeImageSeriesReader::AnalyzeDicomHeaders()
       this->IndexImageOrientationPatient[f] = -1;
       }
     // image position patient
-    tagValue = vtkITKArchetypeImageSeriesReader::GetMetaDataWithoutSpaces(dict, "0020|0032");
+    tagValue = header.TagValues[ImagePositionPatientTag];
     if (!tagValue.empty())
       {
       float a[3] = { -1 };
@@ -246,6 +246,28 @@ public:
   vtkSetMacro(AnalyzeHeader, bool);
   vtkGetMacro(AnalyzeHeader, bool);
 
+  ///
+  /// Number of threads used to analyze the DICOM headers of a series.
+  /// 0 (default) uses the global default number of threads.
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfThreads, int);
+
+  ///
+  /// DICOM headers and the series found in directories are cached across
+  /// all readers. A cached header is reused if the size and modification
+  /// time of the file did not change. The series of a directory are reused
+  /// if no file was added, removed, or modified in the directory.
+  /// Clear the cache, e.g. to release memory after loading large studies.
+  static void ClearDICOMHeaderCache();
+
+  ///
+  /// Maximum number of DICOM file headers kept in the cache. The least
+  /// recently used headers are discarded first. Default is 20000.
+  /// The series of the 16 most recently read directories are cached.
+  static void SetMaximumNumberOfCachedDICOMHeaders(int maximumNumberOfHeaders);
+  static int GetMaximumNumberOfCachedDICOMHeaders();
+  static int GetNumberOfCachedDICOMHeaders();
+
   ///
   /// Whether to use orientation from file
   vtkSetMacro(UseOrientationFromFile, int);
@@ -809,6 +831,13 @@ protected:
   /// Get the image IO for the specified filename
   itk::ImageIOBase::Pointer GetImageIO(const char* filename);
 
+  /// Allocate the output image with a single voxel. The scalars are
+  /// then replaced by the buffer of the ITK image, and the output
+  /// extent is set to the whole extent. It avoids allocating the
+  /// image twice while reading.
+  /// \sa AdoptITKPixelContainer()
+  vtkImageData* AllocateOutputDataForITKBuffer(vtkDataObject* output, vtkInformation* outInfo);
+
   char *Archetype;
   int SingleFile;
   int UseOrientationFromFile;
@@ -840,6 +869,7 @@ protected:
   bool UseNativeOrigin;
 
   int DICOMImageIOApproach;
+  int NumberOfThreads;
 
   bool GroupingByTags;
   int SelectedUID;
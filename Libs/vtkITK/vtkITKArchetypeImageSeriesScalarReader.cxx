@@ -13,6 +13,7 @@
 ==========================================================================*/
 
 #include "vtkITKArchetypeImageSeriesScalarReader.h"
+#include "vtkITKUtility.h"
 
 // VTK includes
 #include <vtkAOSDataArrayTemplate.h>
@@ -37,16 +38,6 @@
 
 vtkStandardNewMacro(vtkITKArchetypeImageSeriesScalarReader);
 
-namespace {
-
-template <class T>
-vtkAOSDataArrayTemplate<T>* DownCast(vtkAbstractArray* a)
-{
-  return vtkAOSDataArrayTemplate<T>::FastDownCast(a);
-}
-
-};
-
 //----------------------------------------------------------------------------
 vtkITKArchetypeImageSeriesScalarReader::vtkITKArchetypeImageSeriesScalarReader()
 = default;
@@ -80,14 +71,10 @@ int vtkITKArchetypeImageSeriesScalarReader::RequestData(
   vtkInformation *outInfo = outputVector->GetInformationObject(0);
 
   vtkDataObject * output = outInfo->Get(vtkDataObject::DATA_OBJECT());
-  vtkImageData *data = vtkImageData::SafeDownCast(output);
   // removed UpdateInformation: generates an error message
   //   from VTK and doesn't appear to be needed...
   //data->UpdateInformation();
-  data->SetExtent(0,0,0,0,0,0);
-  data->AllocateScalars(outInfo);
-  data->SetExtent(outInfo->Get(
-    vtkStreamingDemandDrivenPipeline::WHOLE_EXTENT()));
+  vtkImageData *data = this->AllocateOutputDataForITKBuffer(output, outInfo);
   this->SetMetaDataScalarRangeToPointDataInfo(data);
 
 #ifdef VTKITK_BUILD_DICOM_SUPPORT
@@ -149,13 +136,8 @@ int vtkITKArchetypeImageSeriesScalarReader::RequestData(
         filter = orient##typeN; \
         }\
       filter->UpdateLargestPossibleRegion(); \
-      itk::ImportImageContainer<itk::SizeValueType, type>::Pointer PixelContainer##typeN;\
-      PixelContainer##typeN = filter->GetOutput()->GetPixelContainer();\
-      void *ptr = static_cast<void *> (PixelContainer##typeN->GetBufferPointer());\
-      DownCast<type>(data->GetPointData()->GetScalars())                \
-        ->SetVoidArray(ptr, PixelContainer##typeN->Size(), 0,\
-                       vtkAOSDataArrayTemplate<type>::VTK_DATA_ARRAY_DELETE);\
-      PixelContainer##typeN->ContainerManageMemoryOff();\
+      AdoptITKPixelContainer<type>(filter->GetOutput()->GetPixelContainer(), \
+                                   data->GetPointData()->GetScalars()); \
     }\
     break
 
@@ -168,6 +150,7 @@ int vtkITKArchetypeImageSeriesScalarReader::RequestData(
       itk::ImageFileReader<image2##typeN>::Pointer reader2##typeN = \
             itk::ImageFileReader<image2##typeN>::New(); \
       reader2##typeN->SetFileName(this->FileNames[0].c_str()); \
+      reader2##typeN->ReleaseDataFlagOn(); \
       vtkITKExecuteDataDeclareDICOMImageIO \
       if (this->ArchetypeIsDICOM) \
         { \
@@ -188,13 +171,8 @@ int vtkITKArchetypeImageSeriesScalarReader::RequestData(
         filter = orient2##typeN; \
         } \
       filter->UpdateLargestPossibleRegion();\
-      itk::ImportImageContainer<itk::SizeValueType, type>::Pointer PixelContainer2##typeN;\
-      PixelContainer2##typeN = filter->GetOutput()->GetPixelContainer();\
-      void *ptr = static_cast<void *> (PixelContainer2##typeN->GetBufferPointer());\
-      DownCast<type>(data->GetPointData()->GetScalars())                \
-        ->SetVoidArray(ptr, PixelContainer2##typeN->Size(), 0,\
-                       vtkAOSDataArrayTemplate<type>::VTK_DATA_ARRAY_DELETE);\
-      PixelContainer2##typeN->ContainerManageMemoryOff();\
+      AdoptITKPixelContainer<type>(filter->GetOutput()->GetPixelContainer(), \
+                                   data->GetPointData()->GetScalars()); \
     }\
     break
   /// END SCALAR MACRO
@@ -30,16 +30,6 @@
 
 vtkStandardNewMacro(vtkITKArchetypeImageSeriesVectorReaderFile);
 
-namespace {
-
-template <class T>
-vtkAOSDataArrayTemplate<T>* DownCast(vtkAbstractArray* a)
-{
-  return vtkAOSDataArrayTemplate<T>::FastDownCast(a);
-}
-
-};
-
 //----------------------------------------------------------------------------
 vtkITKArchetypeImageSeriesVectorReaderFile::vtkITKArchetypeImageSeriesVectorReaderFile()
 = default;
@@ -83,13 +73,8 @@ void vtkITKExecuteDataFromFileVector(
     filter = orient2;
     }
   filter->UpdateLargestPossibleRegion();
-  typename itk::ImportImageContainer<itk::SizeValueType, T>::Pointer PixelContainer2;
-  PixelContainer2 = filter->GetOutput()->GetPixelContainer();
-  void *ptr = static_cast<void *> (PixelContainer2->GetBufferPointer());
-  DownCast<T>(data->GetPointData()->GetScalars())
-    ->SetVoidArray(ptr, PixelContainer2->Size(), 0,
-                   vtkAOSDataArrayTemplate<T>::VTK_DATA_ARRAY_DELETE);
-  PixelContainer2->ContainerManageMemoryOff();
+  AdoptITKPixelContainer<T>(filter->GetOutput()->GetPixelContainer(),
+                            data->GetPointData()->GetScalars());
 }
 
 //----------------------------------------------------------------------------
@@ -103,7 +88,8 @@ void vtkITKArchetypeImageSeriesVectorReaderFile::ExecuteDataWithInformation(vtkD
         this->SetErrorCode(vtkErrorCode::NoFileNameError);
         return;
       }
-    vtkImageData *data = this->AllocateOutputData(output, outInfo);
+  // The scalars are replaced by the buffer of the ITK image
+  vtkImageData *data = this->AllocateOutputDataForITKBuffer(output, outInfo);
 
     // If there is only one file in the series, just use an image file reader
   if (this->FileNames.size() == 1)
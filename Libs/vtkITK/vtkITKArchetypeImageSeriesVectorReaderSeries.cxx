@@ -40,16 +40,6 @@
 
 vtkStandardNewMacro(vtkITKArchetypeImageSeriesVectorReaderSeries);
 
-namespace {
-
-template <class T>
-vtkAOSDataArrayTemplate<T>* DownCast(vtkAbstractArray* a)
-{
-  return vtkAOSDataArrayTemplate<T>::FastDownCast(a);
-}
-
-};
-
 //----------------------------------------------------------------------------
 vtkITKArchetypeImageSeriesVectorReaderSeries::vtkITKArchetypeImageSeriesVectorReaderSeries()
 = default;
@@ -116,13 +106,8 @@ void vtkITKExecuteDataFromSeriesVector(
     filter = orient;
     }
   filter->UpdateLargestPossibleRegion();
-  typename itk::ImportImageContainer<itk::SizeValueType, VectorPixelType>::Pointer PixelContainer;
-  PixelContainer = filter->GetOutput()->GetPixelContainer();
-  void *ptr = static_cast<void *> (PixelContainer->GetBufferPointer());
-  DownCast<T>(data->GetPointData()->GetScalars())
-    ->SetVoidArray(ptr, PixelContainer->Size(), 0,
-                   vtkAOSDataArrayTemplate<T>::VTK_DATA_ARRAY_DELETE);
-  PixelContainer->ContainerManageMemoryOff();
+  AdoptITKPixelContainer<T>(filter->GetOutput()->GetPixelContainer(),
+                            data->GetPointData()->GetScalars());
 }
 
 //----------------------------------------------------------------------------
@@ -136,7 +121,8 @@ void vtkITKArchetypeImageSeriesVectorReaderSeries::ExecuteDataWithInformation(vt
       this->SetErrorCode(vtkErrorCode::NoFileNameError);
       return;
     }
-  vtkImageData *data = this->AllocateOutputData(output, outInfo);
+  // The scalars are replaced by the buffer of the ITK image
+  vtkImageData *data = this->AllocateOutputDataForITKBuffer(output, outInfo);
 
     // If there is only one file in the series, just use an image file reader
   if (this->FileNames.size() == 1)
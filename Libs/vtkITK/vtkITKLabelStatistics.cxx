@@ -0,0 +1,558 @@
+/*=========================================================================
+
+  Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==========================================================================*/
+
+#include "vtkITKLabelStatistics.h"
+#include "vtkITKLabelShapeStatistics.h"
+
+// VTK includes
+#include <vtkAlgorithmOutput.h>
+#include <vtkDataArray.h>
+#include <vtkDoubleArray.h>
+#include <vtkIdTypeArray.h>
+#include <vtkImageData.h>
+#include <vtkInformation.h>
+#include <vtkInformationVector.h>
+#include <vtkIntArray.h>
+#include <vtkLongArray.h>
+#include <vtkMultiThreader.h>
+#include <vtkNew.h>
+#include <vtkObjectFactory.h>
+#include <vtkPointData.h>
+#include <vtkSmartPointer.h>
+#include <vtkTable.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <sstream>
+
+vtkStandardNewMacro(vtkITKLabelStatistics);
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Statistics of the voxels of one label
+struct LabelAccumulator
+{
+  vtkIdType VoxelCount{0};
+  double Minimum{VTK_DOUBLE_MAX};
+  double Maximum{VTK_DOUBLE_MIN};
+  double Sum{0.0};
+  double SumOfSquares{0.0};
+  std::vector<vtkIdType> Histogram;
+
+  void Add(const LabelAccumulator& other)
+  {
+    this->VoxelCount += other.VoxelCount;
+    this->Minimum = std::min(this->Minimum, other.Minimum);
+    this->Maximum = std::max(this->Maximum, other.Maximum);
+    this->Sum += other.Sum;
+    this->SumOfSquares += other.SumOfSquares;
+    if (this->Histogram.empty())
+      {
+      this->Histogram = other.Histogram;
+      }
+    else if (this->Histogram.size() == other.Histogram.size())
+      {
+      std::transform(this->Histogram.begin(), this->Histogram.end(), other.Histogram.begin(),
+        this->Histogram.begin(), std::plus<vtkIdType>());
+      }
+  }
+};
+
+// Label value to statistics, ordered by label value
+typedef std::map<int, LabelAccumulator> LabelAccumulatorMap;
+
+//----------------------------------------------------------------------------
+struct LabelStatisticsThreadInfo
+{
+  vtkImageData* Labelmap{nullptr};
+  // Optional, no scalar statistics are computed if not set
+  vtkImageData* ScalarImage{nullptr};
+  int Extent[6];
+  int BackgroundValue{0};
+  double BinOrigin{0.0};
+  double BinSpacing{1.0};
+  int NumberOfBins{0};
+  // Accumulators of each thread, they are merged after all threads finished
+  std::vector<LabelAccumulatorMap> ThreadAccumulators;
+};
+
+//----------------------------------------------------------------------------
+template <class T>
+void CopyRowToDoubleTemplate(const T* inPtr, int numberOfComponents, int rowLength, double* outPtr)
+{
+  for (int i = 0; i < rowLength; ++i, inPtr += numberOfComponents)
+    {
+    outPtr[i] = static_cast<double>(*inPtr);
+    }
+}
+
+//----------------------------------------------------------------------------
+// Copy the first component of a row of voxels, converting them to double,
+// so that the voxels can be processed without instantiating templates for
+// each combination of labelmap and scalar image types.
+void CopyRowToDouble(vtkImageData* image, int x0, int y, int z, int rowLength, double* outPtr)
+{
+  void* inPtr = image->GetScalarPointer(x0, y, z);
+  int numberOfComponents = image->GetNumberOfScalarComponents();
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro(CopyRowToDoubleTemplate(static_cast<VTK_TT*>(inPtr), numberOfComponents, rowLength, outPtr));
+    }
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE LabelStatisticsThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  LabelStatisticsThreadInfo* info = static_cast<LabelStatisticsThreadInfo*>(threadInfo->UserData);
+  const int* extent = info->Extent;
+
+  // Each thread processes a contiguous range of slices, so that it only
+  // keeps histograms of the labels that are found in that range.
+  vtkIdType numberOfSlices = extent[5] - extent[4] + 1;
+  int zBegin = extent[4] + static_cast<int>(numberOfSlices * threadInfo->ThreadID / threadInfo->NumberOfThreads);
+  int zEnd = extent[4] + static_cast<int>(numberOfSlices * (threadInfo->ThreadID + 1) / threadInfo->NumberOfThreads);
+
+  LabelAccumulatorMap& accumulators = info->ThreadAccumulators[threadInfo->ThreadID];
+  const int rowLength = extent[1] - extent[0] + 1;
+  std::vector<double> labelRow(rowLength);
+  std::vector<double> scalarRow(info->ScalarImage ? rowLength : 0);
+
+  // Neighbor voxels most often have the same label, keep the last accumulator
+  // to avoid looking up the label at each voxel.
+  LabelAccumulator* accumulator = nullptr;
+  int accumulatorLabel = info->BackgroundValue;
+  for (int z = zBegin; z < zEnd; ++z)
+    {
+    for (int y = extent[2]; y <= extent[3]; ++y)
+      {
+      CopyRowToDouble(info->Labelmap, extent[0], y, z, rowLength, labelRow.data());
+      if (info->ScalarImage)
+        {
+        CopyRowToDouble(info->ScalarImage, extent[0], y, z, rowLength, scalarRow.data());
+        }
+      for (int i = 0; i < rowLength; ++i)
+        {
+        int label = static_cast<int>(labelRow[i]);
+        if (label == info->BackgroundValue)
+          {
+          continue;
+          }
+        if (!accumulator || label != accumulatorLabel)
+          {
+          accumulator = &accumulators[label];
+          accumulatorLabel = label;
+          if (info->ScalarImage && accumulator->Histogram.empty())
+            {
+            accumulator->Histogram.resize(info->NumberOfBins, 0);
+            }
+          }
+        accumulator->VoxelCount++;
+        if (!info->ScalarImage)
+          {
+          continue;
+          }
+        double value = scalarRow[i];
+        accumulator->Minimum = std::min(accumulator->Minimum, value);
+        accumulator->Maximum = std::max(accumulator->Maximum, value);
+        accumulator->Sum += value;
+        accumulator->SumOfSquares += value * value;
+        int bin = static_cast<int>(std::floor((value - info->BinOrigin) / info->BinSpacing + 0.5));
+        bin = std::max(0, std::min(bin, info->NumberOfBins - 1));
+        accumulator->Histogram[bin]++;
+        }
+      }
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+double GetPercentileFromHistogram(const LabelAccumulator& accumulator, double percentile,
+  double binOrigin, double binSpacing)
+{
+  double targetCount = percentile / 100.0 * accumulator.VoxelCount;
+  vtkIdType cumulativeCount = 0;
+  size_t bin = 0;
+  for (; bin + 1 < accumulator.Histogram.size(); ++bin)
+    {
+    cumulativeCount += accumulator.Histogram[bin];
+    if (cumulativeCount > 0 && cumulativeCount >= targetCount)
+      {
+      break;
+      }
+    }
+  // Bin center may be out of the range of the values if bins are larger than one
+  double value = binOrigin + bin * binSpacing;
+  return std::max(accumulator.Minimum, std::min(value, accumulator.Maximum));
+}
+
+//----------------------------------------------------------------------------
+bool GetExtentIntersection(const int extentA[6], const int extentB[6], int intersection[6])
+{
+  for (int i = 0; i < 3; ++i)
+    {
+    intersection[2 * i] = std::max(extentA[2 * i], extentB[2 * i]);
+    intersection[2 * i + 1] = std::min(extentA[2 * i + 1], extentB[2 * i + 1]);
+    if (intersection[2 * i] > intersection[2 * i + 1])
+      {
+      return false;
+      }
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+T* AddColumn(vtkTable* table, const char* name, vtkIdType numberOfRows, int numberOfComponents = 1)
+{
+  vtkNew<T> array;
+  array->SetName(name);
+  array->SetNumberOfComponents(numberOfComponents);
+  array->SetNumberOfTuples(numberOfRows);
+  array->Fill(0);
+  table->AddColumn(array.GetPointer());
+  return array.GetPointer();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+vtkITKLabelStatistics::vtkITKLabelStatistics()
+{
+  this->BackgroundValue = 0;
+  this->Percentiles.push_back(50.0);
+  this->MaximumNumberOfBins = 8192;
+  this->NumberOfThreads = 0;
+  this->Directions = nullptr;
+  this->SetNumberOfInputPorts(2);
+}
+
+//----------------------------------------------------------------------------
+vtkITKLabelStatistics::~vtkITKLabelStatistics()
+{
+  this->SetDirections(nullptr);
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelStatistics::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os,indent);
+  os << indent << "BackgroundValue: " << this->BackgroundValue << "\n";
+  os << indent << "Percentiles:";
+  for (double percentile : this->Percentiles)
+    {
+    os << " " << percentile;
+    }
+  os << "\n";
+  os << indent << "MaximumNumberOfBins: " << this->MaximumNumberOfBins << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+  os << indent << "ComputedShapeStatistics:";
+  for (const std::string& statisticName : this->ComputedShapeStatistics)
+    {
+    os << " " << statisticName;
+    }
+  os << "\n";
+}
+
+//----------------------------------------------------------------------------
+int vtkITKLabelStatistics::FillInputPortInformation(int port, vtkInformation* info)
+{
+  info->Set(vtkAlgorithm::INPUT_REQUIRED_DATA_TYPE(), "vtkImageData");
+  if (port == 0)
+    {
+    info->Set(vtkAlgorithm::INPUT_IS_REPEATABLE(), 1);
+    }
+  else
+    {
+    info->Set(vtkAlgorithm::INPUT_IS_OPTIONAL(), 1);
+    }
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelStatistics::SetScalarInputData(vtkImageData* image)
+{
+  this->SetInputData(1, image);
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelStatistics::SetScalarInputConnection(vtkAlgorithmOutput* output)
+{
+  this->SetInputConnection(1, output);
+}
+
+//----------------------------------------------------------------------------
+std::string vtkITKLabelStatistics::GetPercentileColumnName(double percentile)
+{
+  std::stringstream ss;
+  ss << "Percentile" << percentile;
+  return ss.str();
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelStatistics::ComputeShapeStatisticOn(std::string statisticName)
+{
+  this->SetComputeShapeStatistic(statisticName, true);
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelStatistics::ComputeShapeStatisticOff(std::string statisticName)
+{
+  this->SetComputeShapeStatistic(statisticName, false);
+}
+
+//----------------------------------------------------------------------------
+void vtkITKLabelStatistics::SetComputeShapeStatistic(std::string statisticName, bool state)
+{
+  std::vector<std::string>::iterator statIt = std::find(
+    this->ComputedShapeStatistics.begin(), this->ComputedShapeStatistics.end(), statisticName);
+  if (state == (statIt != this->ComputedShapeStatistics.end()))
+    {
+    return;
+    }
+  if (state)
+    {
+    this->ComputedShapeStatistics.push_back(statisticName);
+    }
+  else
+    {
+    this->ComputedShapeStatistics.erase(statIt);
+    }
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+bool vtkITKLabelStatistics::GetComputeShapeStatistic(std::string statisticName)
+{
+  return std::find(this->ComputedShapeStatistics.begin(), this->ComputedShapeStatistics.end(),
+    statisticName) != this->ComputedShapeStatistics.end();
+}
+
+//----------------------------------------------------------------------------
+int vtkITKLabelStatistics::RequestData(
+  vtkInformation* vtkNotUsed(request),
+  vtkInformationVector** inputVector,
+  vtkInformationVector* outputVector)
+{
+  vtkTable* output = vtkTable::GetData(outputVector);
+  output->Initialize();
+
+  vtkImageData* scalarImage = vtkImageData::GetData(inputVector[1]);
+  vtkDataArray* scalars = (scalarImage ? scalarImage->GetPointData()->GetScalars() : nullptr);
+  if (scalarImage && !scalars)
+    {
+    vtkErrorMacro("RequestData: Scalar input has no scalars");
+    return 0;
+    }
+
+  // Histogram bins are shared by all labels
+  LabelStatisticsThreadInfo info;
+  info.BackgroundValue = this->BackgroundValue;
+  if (scalars)
+    {
+    info.ScalarImage = scalarImage;
+    double range[2] = { 0.0, 0.0 };
+    scalars->GetRange(range, 0);
+    info.BinOrigin = range[0];
+    bool integerType = (scalars->GetDataType() != VTK_FLOAT && scalars->GetDataType() != VTK_DOUBLE);
+    if (integerType && range[1] - range[0] + 1 <= this->MaximumNumberOfBins)
+      {
+      info.NumberOfBins = static_cast<int>(range[1] - range[0]) + 1;
+      info.BinSpacing = 1.0;
+      }
+    else
+      {
+      info.NumberOfBins = this->MaximumNumberOfBins;
+      info.BinSpacing = (range[1] > range[0] ? (range[1] - range[0]) / (this->MaximumNumberOfBins - 1) : 1.0);
+      }
+    }
+
+  int numberOfThreads = this->NumberOfThreads;
+  if (numberOfThreads <= 0)
+    {
+    numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+    }
+
+  std::vector<LabelAccumulatorMap> labelmapAccumulators;
+  std::vector<vtkSmartPointer<vtkTable> > labelmapShapeStatistics;
+  int numberOfLabelmaps = this->GetNumberOfInputConnections(0);
+  for (int labelmapIndex = 0; labelmapIndex < numberOfLabelmaps; ++labelmapIndex)
+    {
+    this->UpdateProgress(static_cast<double>(labelmapIndex) / numberOfLabelmaps);
+    labelmapAccumulators.emplace_back();
+    labelmapShapeStatistics.emplace_back();
+    vtkImageData* labelmap = vtkImageData::GetData(inputVector[0], labelmapIndex);
+    if (!labelmap || !labelmap->GetPointData()->GetScalars())
+      {
+      // Empty labelmap, no labels
+      continue;
+      }
+
+    info.Labelmap = labelmap;
+    if (scalarImage)
+      {
+      if (!GetExtentIntersection(labelmap->GetExtent(), scalarImage->GetExtent(), info.Extent))
+        {
+        continue;
+        }
+      }
+    else
+      {
+      labelmap->GetExtent(info.Extent);
+      if (info.Extent[0] > info.Extent[1] || info.Extent[2] > info.Extent[3] || info.Extent[4] > info.Extent[5])
+        {
+        continue;
+        }
+      }
+
+    int labelmapNumberOfThreads = std::max(1, std::min(numberOfThreads, info.Extent[5] - info.Extent[4] + 1));
+    info.ThreadAccumulators.clear();
+    info.ThreadAccumulators.resize(labelmapNumberOfThreads);
+    vtkNew<vtkMultiThreader> threader;
+    threader->SetNumberOfThreads(labelmapNumberOfThreads);
+    threader->SetSingleMethod(LabelStatisticsThreadFunction, &info);
+    threader->SingleMethodExecute();
+    for (const LabelAccumulatorMap& threadAccumulators : info.ThreadAccumulators)
+      {
+      for (const LabelAccumulatorMap::value_type& labelAccumulator : threadAccumulators)
+        {
+        labelmapAccumulators.back()[labelAccumulator.first].Add(labelAccumulator.second);
+        }
+      }
+
+    if (!this->ComputedShapeStatistics.empty() && !labelmapAccumulators.back().empty())
+      {
+      // All labels of the labelmap are processed at once
+      vtkNew<vtkITKLabelShapeStatistics> shapeStatistics;
+      shapeStatistics->SetInputData(labelmap);
+      shapeStatistics->SetDirections(this->Directions);
+      shapeStatistics->SetComputedStatistics(this->ComputedShapeStatistics);
+      shapeStatistics->Update();
+      labelmapShapeStatistics.back() = shapeStatistics->GetOutput();
+      }
+    }
+
+  // Fill output table
+  vtkIdType numberOfRows = 0;
+  for (const LabelAccumulatorMap& accumulators : labelmapAccumulators)
+    {
+    numberOfRows += static_cast<vtkIdType>(accumulators.size());
+    }
+  vtkIntArray* labelmapIndexArray = AddColumn<vtkIntArray>(output, "LabelmapIndex", numberOfRows);
+  vtkLongArray* labelValueArray = AddColumn<vtkLongArray>(output, "LabelValue", numberOfRows);
+  vtkIdTypeArray* voxelCountArray = AddColumn<vtkIdTypeArray>(output, "VoxelCount", numberOfRows);
+  vtkDoubleArray* volumeArray = AddColumn<vtkDoubleArray>(output, "Volume", numberOfRows);
+  vtkDoubleArray* minimumArray = nullptr;
+  vtkDoubleArray* maximumArray = nullptr;
+  vtkDoubleArray* meanArray = nullptr;
+  vtkDoubleArray* standardDeviationArray = nullptr;
+  std::vector<vtkDoubleArray*> percentileArrays;
+  if (scalars)
+    {
+    minimumArray = AddColumn<vtkDoubleArray>(output, "Minimum", numberOfRows);
+    maximumArray = AddColumn<vtkDoubleArray>(output, "Maximum", numberOfRows);
+    meanArray = AddColumn<vtkDoubleArray>(output, "Mean", numberOfRows);
+    standardDeviationArray = AddColumn<vtkDoubleArray>(output, "StandardDeviation", numberOfRows);
+    for (double percentile : this->Percentiles)
+      {
+      percentileArrays.push_back(AddColumn<vtkDoubleArray>(output,
+        vtkITKLabelStatistics::GetPercentileColumnName(percentile).c_str(), numberOfRows));
+      }
+    }
+
+  vtkIdType rowIndex = 0;
+  for (int labelmapIndex = 0; labelmapIndex < numberOfLabelmaps; ++labelmapIndex)
+    {
+    vtkImageData* labelmap = vtkImageData::GetData(inputVector[0], labelmapIndex);
+    double* spacing = (labelmap ? labelmap->GetSpacing() : nullptr);
+    double voxelVolume = (spacing ? std::abs(spacing[0] * spacing[1] * spacing[2]) : 0.0);
+
+    // Shape statistics rows are looked up by label value
+    vtkTable* shapeTable = labelmapShapeStatistics[labelmapIndex];
+    std::map<int, vtkIdType> shapeTableRows;
+    vtkDataArray* shapeLabelValueArray = (shapeTable ?
+      vtkDataArray::SafeDownCast(shapeTable->GetColumnByName("LabelValue")) : nullptr);
+    if (shapeLabelValueArray)
+      {
+      for (vtkIdType shapeRowIndex = 0; shapeRowIndex < shapeLabelValueArray->GetNumberOfTuples(); ++shapeRowIndex)
+        {
+        shapeTableRows[static_cast<int>(shapeLabelValueArray->GetTuple1(shapeRowIndex))] = shapeRowIndex;
+        }
+      }
+
+    for (const LabelAccumulatorMap::value_type& labelAccumulator : labelmapAccumulators[labelmapIndex])
+      {
+      const LabelAccumulator& accumulator = labelAccumulator.second;
+      labelmapIndexArray->SetValue(rowIndex, labelmapIndex);
+      labelValueArray->SetValue(rowIndex, labelAccumulator.first);
+      voxelCountArray->SetValue(rowIndex, accumulator.VoxelCount);
+      volumeArray->SetValue(rowIndex, accumulator.VoxelCount * voxelVolume);
+      if (scalars && accumulator.VoxelCount > 0)
+        {
+        double mean = accumulator.Sum / accumulator.VoxelCount;
+        double variance = 0.0;
+        if (accumulator.VoxelCount > 1)
+          {
+          variance = (accumulator.SumOfSquares - accumulator.Sum * mean) / (accumulator.VoxelCount - 1);
+          }
+        minimumArray->SetValue(rowIndex, accumulator.Minimum);
+        maximumArray->SetValue(rowIndex, accumulator.Maximum);
+        meanArray->SetValue(rowIndex, mean);
+        standardDeviationArray->SetValue(rowIndex, std::sqrt(std::max(0.0, variance)));
+        for (size_t percentileIndex = 0; percentileIndex < this->Percentiles.size(); ++percentileIndex)
+          {
+          percentileArrays[percentileIndex]->SetValue(rowIndex, GetPercentileFromHistogram(
+            accumulator, this->Percentiles[percentileIndex], info.BinOrigin, info.BinSpacing));
+          }
+        }
+
+      std::map<int, vtkIdType>::iterator shapeRowIt = shapeTableRows.find(labelAccumulator.first);
+      if (shapeRowIt != shapeTableRows.end())
+        {
+        for (vtkIdType columnIndex = 0; columnIndex < shapeTable->GetNumberOfColumns(); ++columnIndex)
+          {
+          vtkDataArray* shapeArray = vtkDataArray::SafeDownCast(shapeTable->GetColumn(columnIndex));
+          if (!shapeArray || shapeArray == shapeLabelValueArray || !shapeArray->GetName())
+            {
+            continue;
+            }
+          vtkDataArray* outputArray = vtkDataArray::SafeDownCast(output->GetColumnByName(shapeArray->GetName()));
+          if (!outputArray)
+            {
+            outputArray = AddColumn<vtkDoubleArray>(output, shapeArray->GetName(),
+              numberOfRows, shapeArray->GetNumberOfComponents());
+            for (int component = 0; component < shapeArray->GetNumberOfComponents(); ++component)
+              {
+              if (shapeArray->GetComponentName(component))
+                {
+                outputArray->SetComponentName(component, shapeArray->GetComponentName(component));
+                }
+              }
+            }
+          outputArray->SetTuple(rowIndex, shapeArray->GetTuple(shapeRowIt->second));
+          }
+        }
+      ++rowIndex;
+      }
+    }
+
+  this->UpdateProgress(1.0);
+  return 1;
+}
@@ -0,0 +1,130 @@
+/*=========================================================================
+
+  Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==========================================================================*/
+
+#ifndef __vtkITKLabelStatistics_h
+#define __vtkITKLabelStatistics_h
+
+#include "vtkITK.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkTableAlgorithm.h>
+
+// vtkAddon includes
+#include <vtkAddonSetGet.h>
+
+// std includes
+#include <string>
+#include <vector>
+
+class vtkAlgorithmOutput;
+class vtkImageData;
+
+/// \brief Compute statistics of all labels of labelmap images in a single pass.
+///
+/// Each input connection of the first port is a labelmap (for example a shared
+/// labelmap layer of a segmentation). Voxel count and volume are computed for each
+/// label value that is found in each labelmap. Voxels of the labelmaps are visited
+/// only once, by multiple threads, regardless of the number of labels.
+///
+/// If a scalar image is set using SetScalarInputData(), then the minimum, maximum, mean,
+/// standard deviation and percentiles of the scalar values within each label are computed
+/// as well. The labelmaps must be sampled on the same grid as the scalar image: voxels
+/// that have the same IJK index are at the same position, only the intersection of the
+/// extents is used. Spacing of the scalar image is ignored, volume is computed from the
+/// spacing of the labelmap.
+/// Percentiles are computed from a histogram. Values are exact for integer scalar types
+/// if the scalar range is smaller than MaximumNumberOfBins, otherwise they are
+/// approximated by the center of the histogram bin.
+///
+/// Shape statistics are computed by vtkITKLabelShapeStatistics for all labels of each
+/// labelmap at once. None of them is computed by default, see SetComputeShapeStatistic().
+///
+/// Output statistics are represented in a vtkTable where each row is a label of a labelmap.
+/// Columns are: LabelmapIndex, LabelValue, VoxelCount, Volume, and if scalar image is set:
+/// Minimum, Maximum, Mean, StandardDeviation and one column for each percentile
+/// (see GetPercentileColumnName()). Shape statistics columns are named as in the output
+/// of vtkITKLabelShapeStatistics.
+class VTK_ITK_EXPORT vtkITKLabelStatistics : public vtkTableAlgorithm
+{
+public:
+  static vtkITKLabelStatistics *New();
+  vtkTypeMacro(vtkITKLabelStatistics, vtkTableAlgorithm);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Set the image that contains the scalar values of which statistics are computed.
+  /// Only the first scalar component is used.
+  void SetScalarInputData(vtkImageData* image);
+  void SetScalarInputConnection(vtkAlgorithmOutput* output);
+
+  /// Label value that is not included in the statistics. Default is 0.
+  vtkSetMacro(BackgroundValue, int);
+  vtkGetMacro(BackgroundValue, int);
+
+  /// Percentiles of the scalar values that are computed for each label (between 0 and 100).
+  /// Default is 50 (median).
+  vtkSetStdVectorMacro(Percentiles, std::vector<double>);
+  vtkGetStdVectorMacro(Percentiles, std::vector<double>);
+
+  /// Get name of the output column that contains the specified percentile.
+  static std::string GetPercentileColumnName(double percentile);
+
+  /// Maximum number of bins of the histogram of each label that is used for computing percentiles.
+  /// Memory usage is proportional to number of bins * number of labels * number of threads.
+  /// Default is 8192.
+  vtkSetClampMacro(MaximumNumberOfBins, int, 2, VTK_INT_MAX);
+  vtkGetMacro(MaximumNumberOfBins, int);
+
+  /// Number of threads used for processing the voxels.
+  /// If 0 (default) then the global default number of threads of vtkMultiThreader is used.
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfThreads, int);
+
+  /// Directions of the labelmap axes, used for computing shape statistics.
+  vtkSetObjectMacro(Directions, vtkMatrix4x4);
+  vtkGetObjectMacro(Directions, vtkMatrix4x4);
+
+  /// Set/Get if the the specified shape statistic should be computed.
+  /// Statistic names are listed in vtkITKLabelShapeStatistics::ShapeStatistic.
+  vtkSetStdVectorMacro(ComputedShapeStatistics, std::vector<std::string>);
+  vtkGetStdVectorMacro(ComputedShapeStatistics, std::vector<std::string>);
+  void SetComputeShapeStatistic(std::string statisticName, bool state);
+  bool GetComputeShapeStatistic(std::string statisticName);
+  void ComputeShapeStatisticOn(std::string statisticName);
+  void ComputeShapeStatisticOff(std::string statisticName);
+
+protected:
+  vtkITKLabelStatistics();
+  ~vtkITKLabelStatistics() override;
+
+  int FillInputPortInformation(int port, vtkInformation* info) override;
+  int RequestData(vtkInformation* request,
+    vtkInformationVector** inputVector,
+    vtkInformationVector* outputVector) override;
+
+protected:
+  int BackgroundValue;
+  std::vector<double> Percentiles;
+  int MaximumNumberOfBins;
+  int NumberOfThreads;
+  vtkMatrix4x4* Directions;
+  std::vector<std::string> ComputedShapeStatistics;
+
+private:
+  vtkITKLabelStatistics(const vtkITKLabelStatistics&) = delete;
+  void operator=(const vtkITKLabelStatistics&) = delete;
+};
+
+#endif
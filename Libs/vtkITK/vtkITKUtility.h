@@ -15,9 +15,36 @@
 #ifndef __vtkITKUtility_h
 #define __vtkITKUtility_h
 
+#include "vtkAOSDataArrayTemplate.h"
 #include "vtkObjectFactory.h"
 #include "vtkSetGet.h"
 
+/**
+ * Release a buffer allocated by itk::ImportImageContainer, which
+ * allocates its elements with new[].
+ */
+template <typename TValue>
+void DeleteITKPixelBuffer(void* buffer)
+{
+  delete [] static_cast<TValue*>(buffer);
+}
+
+/**
+ * This function will make the given VTK array use the buffer of the
+ * given ITK pixel container without copying it. The VTK array takes
+ * ownership of the buffer and releases it with DeleteITKPixelBuffer,
+ * the ITK container stops managing it.
+ */
+template <typename TValue, typename TPixelContainer>
+void AdoptITKPixelContainer(TPixelContainer* pixelContainer, vtkDataArray* array)
+{
+  vtkAOSDataArrayTemplate<TValue>* valueArray = vtkAOSDataArrayTemplate<TValue>::FastDownCast(array);
+  valueArray->SetVoidArray(pixelContainer->GetBufferPointer(), pixelContainer->Size(), 0,
+                           vtkAOSDataArrayTemplate<TValue>::VTK_DATA_ARRAY_USER_DEFINED);
+  valueArray->SetArrayFreeFunction(&DeleteITKPixelBuffer<TValue>);
+  pixelContainer->ContainerManageMemoryOff();
+}
+
 /**
  * This function will connect the given itk::VTKImageExport filter to
  * the given vtkImageImport filter.
@@ -0,0 +1,258 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageStencilData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkPolyDataToImageStencil.h>
+#include <vtkSphereSource.h>
+#include <vtkTransform.h>
+
+// SegmentationCore includes
+#include "vtkLabelmapBrushStamp.h"
+#include "vtkOrientedImageDataResample.h"
+
+// STD includes
+#include <cmath>
+#include <vector>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CreateSphereStencil(double radius, vtkImageStencilData* stencil)
+{
+  vtkNew<vtkSphereSource> sphere;
+  sphere->SetRadius(radius);
+  sphere->SetThetaResolution(32);
+  sphere->SetPhiResolution(32);
+  vtkNew<vtkPolyDataToImageStencil> polyDataToStencil;
+  polyDataToStencil->SetInputConnection(sphere->GetOutputPort());
+  polyDataToStencil->SetOutputSpacing(1.0, 1.0, 1.0);
+  polyDataToStencil->SetOutputOrigin(0.0, 0.0, 0.0);
+  // Padded by 1 voxel on each side, as in the paint effect
+  int halfSize = static_cast<int>(std::ceil(radius)) + 1;
+  polyDataToStencil->SetOutputWholeExtent(-halfSize, halfSize, -halfSize, halfSize, -halfSize, halfSize);
+  polyDataToStencil->Update();
+  stencil->DeepCopy(polyDataToStencil->GetOutput());
+}
+
+//----------------------------------------------------------------------------
+void CreateEmptyLabelmap(vtkImageData* labelmap)
+{
+  labelmap->SetExtent(0, 59, 0, 59, 0, 59);
+  labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(labelmap, 0);
+}
+
+//----------------------------------------------------------------------------
+int GetNumberOfPaintedVoxels(vtkImageData* labelmap)
+{
+  int numberOfPaintedVoxels = 0;
+  unsigned char* voxelPtr = static_cast<unsigned char*>(labelmap->GetScalarPointer());
+  vtkIdType numberOfVoxels = labelmap->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; i++)
+    {
+    if (voxelPtr[i] > 0)
+      {
+      numberOfPaintedVoxels++;
+      }
+    }
+  return numberOfPaintedVoxels;
+}
+
+//----------------------------------------------------------------------------
+bool TestStencilCacheKey()
+{
+  vtkNew<vtkImageStencilData> stencil;
+  CreateSphereStencil(3.0, stencil);
+
+  vtkNew<vtkLabelmapBrushStamp> brushStamp;
+  std::vector<double> shapeParameters = { 0.0, 3.0, 0.0 };
+  vtkNew<vtkMatrix4x4> brushToLabelmapIjk;
+  if (!brushStamp->NeedsUpdate(shapeParameters, brushToLabelmapIjk))
+    {
+    std::cerr << __LINE__ << ": Stencil must be computed initially" << std::endl;
+    return false;
+    }
+  brushStamp->SetStencil(stencil, shapeParameters, brushToLabelmapIjk);
+  if (brushStamp->NeedsUpdate(shapeParameters, brushToLabelmapIjk))
+    {
+    std::cerr << __LINE__ << ": Stencil must not be recomputed for the same parameters" << std::endl;
+    return false;
+    }
+
+  // Brush position does not change the stencil
+  vtkNew<vtkMatrix4x4> translatedBrushToLabelmapIjk;
+  translatedBrushToLabelmapIjk->SetElement(0, 3, 25.0);
+  translatedBrushToLabelmapIjk->SetElement(2, 3, -12.5);
+  if (brushStamp->NeedsUpdate(shapeParameters, translatedBrushToLabelmapIjk))
+    {
+    std::cerr << __LINE__ << ": Stencil must not be recomputed when the brush is moved" << std::endl;
+    return false;
+    }
+
+  // Brush size, labelmap spacing, and brush orientation change the stencil
+  std::vector<double> largerShapeParameters = { 0.0, 4.0, 0.0 };
+  if (!brushStamp->NeedsUpdate(largerShapeParameters, brushToLabelmapIjk))
+    {
+    std::cerr << __LINE__ << ": Stencil must be recomputed when brush size changes" << std::endl;
+    return false;
+    }
+  vtkNew<vtkMatrix4x4> scaledBrushToLabelmapIjk;
+  scaledBrushToLabelmapIjk->SetElement(2, 2, 0.5);
+  if (!brushStamp->NeedsUpdate(shapeParameters, scaledBrushToLabelmapIjk))
+    {
+    std::cerr << __LINE__ << ": Stencil must be recomputed when labelmap spacing changes" << std::endl;
+    return false;
+    }
+  vtkNew<vtkTransform> rotation;
+  rotation->RotateZ(30.0);
+  if (!brushStamp->NeedsUpdate(shapeParameters, rotation->GetMatrix()))
+    {
+    std::cerr << __LINE__ << ": Stencil must be recomputed when brush orientation changes" << std::endl;
+    return false;
+    }
+
+  // Stencil extent excludes the padding
+  const double direction[3] = { 1.0, 0.0, 0.0 };
+  if (brushStamp->GetRadiusAlongDirection(direction) != 3.0)
+    {
+    std::cerr << __LINE__ << ": Unexpected stencil radius: " << brushStamp->GetRadiusAlongDirection(direction) << std::endl;
+    return false;
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestSweptStroke()
+{
+  vtkNew<vtkImageStencilData> stencil;
+  CreateSphereStencil(3.0, stencil);
+  vtkNew<vtkLabelmapBrushStamp> brushStamp;
+  brushStamp->SetStencil(stencil, std::vector<double>(), nullptr);
+
+  const double startPosition_Ijk[3] = { 15.0, 30.0, 30.0 };
+  const double endPosition_Ijk[3] = { 45.0, 34.0, 30.0 };
+  const double fillValue = 1.0;
+
+  // Stroke from the start to the end position
+  vtkNew<vtkImageData> sweptLabelmap;
+  CreateEmptyLabelmap(sweptLabelmap);
+  int sweptExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  brushStamp->Paint(sweptLabelmap, startPosition_Ijk, fillValue, sweptExtent);
+  brushStamp->PaintSegment(sweptLabelmap, startPosition_Ijk, endPosition_Ijk, fillValue, sweptExtent);
+
+  // Reference: brush stamped at each voxel position along the stroke
+  vtkNew<vtkImageData> stampedLabelmap;
+  CreateEmptyLabelmap(stampedLabelmap);
+  int stampedExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  std::vector<std::vector<double> > stampPositions_Ijk;
+  const int numberOfStamps = 64 * 31;
+  for (int stampIndex = 0; stampIndex <= numberOfStamps; stampIndex++)
+    {
+    std::vector<double> position_Ijk(3);
+    for (int i = 0; i < 3; i++)
+      {
+      position_Ijk[i] = startPosition_Ijk[i] + (endPosition_Ijk[i] - startPosition_Ijk[i]) * stampIndex / numberOfStamps;
+      }
+    brushStamp->Paint(stampedLabelmap, position_Ijk.data(), fillValue, stampedExtent);
+    stampPositions_Ijk.push_back(position_Ijk);
+    }
+
+  // Only the start and end positions (what a fast mouse move provides)
+  vtkNew<vtkImageData> endpointsLabelmap;
+  CreateEmptyLabelmap(endpointsLabelmap);
+  int endpointsExtent[6] = { VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN, VTK_INT_MAX, VTK_INT_MIN };
+  brushStamp->Paint(endpointsLabelmap, startPosition_Ijk, fillValue, endpointsExtent);
+  brushStamp->Paint(endpointsLabelmap, endPosition_Ijk, fillValue, endpointsExtent);
+
+  for (int i = 0; i < 6; i++)
+    {
+    if (sweptExtent[i] != stampedExtent[i])
+      {
+      std::cerr << __LINE__ << ": Swept stroke update extent differs from the stamped stroke" << std::endl;
+      return false;
+      }
+    }
+
+  // Swept stroke does not paint outside of the stamped stroke
+  unsigned char* sweptPtr = static_cast<unsigned char*>(sweptLabelmap->GetScalarPointer());
+  unsigned char* stampedPtr = static_cast<unsigned char*>(stampedLabelmap->GetScalarPointer());
+  vtkIdType numberOfVoxels = sweptLabelmap->GetNumberOfPoints();
+  for (vtkIdType voxelIndex = 0; voxelIndex < numberOfVoxels; voxelIndex++)
+    {
+    if (sweptPtr[voxelIndex] > 0 && stampedPtr[voxelIndex] == 0)
+      {
+      std::cerr << __LINE__ << ": Swept stroke painted outside of the stamped stroke" << std::endl;
+      return false;
+      }
+    }
+
+  // Swept stroke has no gaps along the path of the brush
+  for (const std::vector<double>& position_Ijk : stampPositions_Ijk)
+    {
+    int ijk[3] = { 0, 0, 0 };
+    for (int i = 0; i < 3; i++)
+      {
+      ijk[i] = vtkMath::Floor(position_Ijk[i] + 0.5);
+      }
+    if (sweptLabelmap->GetScalarComponentAsDouble(ijk[0], ijk[1], ijk[2], 0) != fillValue)
+      {
+      std::cerr << __LINE__ << ": Swept stroke has a gap at " << ijk[0] << ", " << ijk[1] << ", " << ijk[2] << std::endl;
+      return false;
+      }
+    }
+
+  // Swept stroke covers almost the same region as the stamped stroke
+  int numberOfSweptVoxels = GetNumberOfPaintedVoxels(sweptLabelmap);
+  int numberOfStampedVoxels = GetNumberOfPaintedVoxels(stampedLabelmap);
+  int numberOfEndpointsVoxels = GetNumberOfPaintedVoxels(endpointsLabelmap);
+  std::cout << "Painted voxels: swept = " << numberOfSweptVoxels << ", stamped = " << numberOfStampedVoxels
+    << ", endpoints only = " << numberOfEndpointsVoxels << std::endl;
+  if (numberOfSweptVoxels < 0.8 * numberOfStampedVoxels)
+    {
+    std::cerr << __LINE__ << ": Swept stroke covers only " << numberOfSweptVoxels << " voxels of the "
+      << numberOfStampedVoxels << " voxels of the stamped stroke" << std::endl;
+    return false;
+    }
+  if (numberOfEndpointsVoxels >= 0.5 * numberOfStampedVoxels)
+    {
+    std::cerr << __LINE__ << ": Unexpected number of voxels painted at the endpoints" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkLabelmapBrushStampTest1(int, char*[])
+{
+  if (!TestStencilCacheKey())
+    {
+    return EXIT_FAILURE;
+    }
+  if (!TestSweptStroke())
+    {
+    return EXIT_FAILURE;
+    }
+  std::cout << "Labelmap brush stamp test passed." << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -26,6 +26,7 @@
 #include <vtkSphereSource.h>
 #include <vtkMatrix4x4.h>
 #include <vtkImageAccumulate.h>
+#include <vtkTimerLog.h>
 
 // SegmentationCore includes
 #include "vtkSegmentation.h"
@@ -34,9 +35,13 @@
 #include "vtkOrientedImageData.h"
 #include "vtkOrientedImageDataResample.h"
 #include "vtkSegmentationConverterFactory.h"
+#include "vtkSegmentationModifier.h"
 #include "vtkBinaryLabelmapToClosedSurfaceConversionRule.h"
 #include "vtkClosedSurfaceToBinaryLabelmapConversionRule.h"
 
+// STD includes
+#include <algorithm>
+
 void CreateSpherePolyData(vtkPolyData* polyData, double center[3], double radius);
 int CreateCubeLabelmap(vtkOrientedImageData* imageData, int extent[6]);
 
@@ -266,6 +271,66 @@ bool TestSharedLabelmapCollapse()
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool TestSharedLabelmapCollapseLargeLabelmaps()
+{
+  // Small segments stored in large labelmaps, as after importing a segmentation from separate files.
+  // Each segment overlaps only with the previous one, so they must be collapsed into two layers.
+  const int numberOfSegments = 40;
+  int labelmapExtent[6] = { 0, 127, 0, 127, 0, 63 };
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName());
+  std::vector<int> expectedVoxelCounts;
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    vtkNew<vtkOrientedImageData> labelmap;
+    labelmap->SetExtent(labelmapExtent);
+    labelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+    vtkOrientedImageDataResample::FillImage(labelmap, 0);
+    int cubeExtent[6] = { 3 * i, 3 * i + 3, 10, 20 + i, 5, 10 };
+    vtkOrientedImageDataResample::FillImage(labelmap, 1, cubeExtent);
+    expectedVoxelCounts.push_back(4 * (11 + i) * 6);
+    vtkNew<vtkSegment> segment;
+    segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), labelmap);
+    segmentation->AddSegment(segment);
+    }
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  segmentation->CollapseBinaryLabelmaps(false);
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"CollapseBinaryLabelmaps-" << numberOfSegments << "Segments\" type=\"numeric/double\">"
+    << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  int numberOfLayers = segmentation->GetNumberOfLayers();
+  if (numberOfLayers != 2)
+    {
+    std::cerr << __LINE__ << ": Invalid number of layers " << numberOfLayers << " should be 2" << std::endl;
+    return false;
+    }
+
+  vtkNew<vtkImageAccumulate> imageAccumulate;
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    vtkSegment* segment = segmentation->GetNthSegment(i);
+    vtkOrientedImageData* segmentLabelmap = vtkOrientedImageData::SafeDownCast(segment->GetRepresentation(
+      vtkSegmentationConverter::GetBinaryLabelmapRepresentationName()));
+    int labelValue = segment->GetLabelValue();
+    imageAccumulate->SetInputData(segmentLabelmap);
+    imageAccumulate->SetComponentExtent(0, labelValue, 0, 0, 0, 0);
+    imageAccumulate->Update();
+    double frequency = imageAccumulate->GetOutput()->GetPointData()->GetScalars()->GetTuple1(labelValue);
+    if (frequency != expectedVoxelCounts[i])
+      {
+      std::cerr << __LINE__ << ": Invalid number of voxels in segment " << i << ": " << frequency
+        << " should be " << expectedVoxelCounts[i] << std::endl;
+      return false;
+      }
+    }
+
+  return true;
+}
+
 //----------------------------------------------------------------------------
 bool TestSharedLabelmapCasting()
 {
@@ -314,6 +379,252 @@ bool TestSharedLabelmapCasting()
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool TestLabelmapBlockAllocation()
+{
+  vtkNew<vtkOrientedImageData> cubeImage;
+  int cubeExtent[6] = { 0, 2, 0, 2, 0, 2 };
+  CreateCubeLabelmap(cubeImage, cubeExtent);
+  vtkNew<vtkSegment> segment;
+  segment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), cubeImage);
+  vtkNew<vtkSegmentation> segmentation;
+  segmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName());
+  segmentation->AddSegment(segment);
+  std::string segmentID = segmentation->GetSegmentIdBySegment(segment);
+
+  // Modifier labelmap covers the whole reference geometry, but only a small region is modified
+  vtkNew<vtkOrientedImageData> modifierLabelmap;
+  modifierLabelmap->SetExtent(0, 99, 0, 99, 0, 99);
+  modifierLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(modifierLabelmap, 1);
+
+  vtkOrientedImageData* segmentLabelmap = cubeImage;
+  vtkIdType initialNumberOfVoxels = segmentLabelmap->GetNumberOfPoints();
+  unsigned long initialMemorySize = segmentLabelmap->GetActualMemorySize();
+
+  int modifiedExtent1[6] = { 5, 6, 5, 6, 5, 6 };
+  vtkSegmentationModifier::ModifyBinaryLabelmap(modifierLabelmap, segmentation, segmentID,
+    vtkSegmentationModifier::MODE_MERGE_MAX, modifiedExtent1);
+  int blockSize = segmentation->GetLabelmapBlockSize();
+  int* segmentExtent = segmentLabelmap->GetExtent();
+  for (int i = 0; i < 3; ++i)
+    {
+    if (segmentExtent[2 * i] != 0 || segmentExtent[2 * i + 1] != blockSize - 1)
+      {
+      std::cerr << __LINE__ << ": Segment labelmap extent is not aligned to blocks" << std::endl;
+      return false;
+      }
+    }
+
+  // Modifying the same block must not reallocate the segment labelmap
+  void* scalarPointer = segmentLabelmap->GetScalarPointer();
+  int modifiedExtent2[6] = { 10, 12, 10, 12, 10, 12 };
+  vtkSegmentationModifier::ModifyBinaryLabelmap(modifierLabelmap, segmentation, segmentID,
+    vtkSegmentationModifier::MODE_MERGE_MAX, modifiedExtent2);
+  if (segmentLabelmap->GetScalarPointer() != scalarPointer)
+    {
+    std::cerr << __LINE__ << ": Segment labelmap was reallocated" << std::endl;
+    return false;
+    }
+  if (segmentLabelmap->GetScalarComponentAsDouble(11, 11, 11, 0) != segment->GetLabelValue())
+    {
+    std::cerr << __LINE__ << ": Segment labelmap was not modified" << std::endl;
+    return false;
+    }
+
+  // Erasing the added voxels shrinks the segment labelmap to its effective extent,
+  // therefore memory usage does not grow after an edit/erase cycle
+  vtkNew<vtkOrientedImageData> eraseLabelmap;
+  eraseLabelmap->SetExtent(0, 99, 0, 99, 0, 99);
+  eraseLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(eraseLabelmap, 0);
+  int erasedExtent[6] = { 3, 99, 3, 99, 3, 99 };
+  vtkSegmentationModifier::ModifyBinaryLabelmap(eraseLabelmap, segmentation, segmentID,
+    vtkSegmentationModifier::MODE_MERGE_MIN, erasedExtent);
+  segmentExtent = segmentLabelmap->GetExtent();
+  for (int i = 0; i < 6; ++i)
+    {
+    if (segmentExtent[i] != cubeExtent[i])
+      {
+      std::cerr << __LINE__ << ": Segment labelmap was not shrunk to its effective extent" << std::endl;
+      return false;
+      }
+    }
+  if (segmentLabelmap->GetNumberOfPoints() != initialNumberOfVoxels
+    || segmentLabelmap->GetActualMemorySize() > initialMemorySize)
+    {
+    std::cerr << __LINE__ << ": Segment labelmap memory grew after edit/erase cycle: "
+      << segmentLabelmap->GetActualMemorySize() << " kB (initial: " << initialMemorySize << " kB)" << std::endl;
+    return false;
+    }
+
+  // With block size of 1, added voxels do not leave any padding
+  segmentation->SetLabelmapBlockSize(1);
+  vtkSegmentationModifier::ModifyBinaryLabelmap(modifierLabelmap, segmentation, segmentID,
+    vtkSegmentationModifier::MODE_MERGE_MAX, modifiedExtent1);
+  int expectedExtent[6] = { 0, 6, 0, 6, 0, 6 };
+  segmentExtent = segmentLabelmap->GetExtent();
+  for (int i = 0; i < 6; ++i)
+    {
+    if (segmentExtent[i] != expectedExtent[i])
+      {
+      std::cerr << __LINE__ << ": Segment labelmap extent is not the effective extent" << std::endl;
+      return false;
+      }
+    }
+
+  // Padding that is larger than the blocks containing the segment is removed after adding voxels
+  // (the modified extent is large but almost empty, as the bounding box of a diagonal paint stroke)
+  segmentation->SetLabelmapBlockSize(32);
+  vtkNew<vtkOrientedImageData> sparseModifierLabelmap;
+  sparseModifierLabelmap->SetExtent(0, 99, 0, 99, 0, 99);
+  sparseModifierLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(sparseModifierLabelmap, 0);
+  sparseModifierLabelmap->SetScalarComponentFromDouble(20, 20, 20, 0, 1);
+  int sparseModifiedExtent[6] = { 0, 90, 0, 90, 0, 90 };
+  vtkSegmentationModifier::ModifyBinaryLabelmap(sparseModifierLabelmap, segmentation, segmentID,
+    vtkSegmentationModifier::MODE_MERGE_MAX, sparseModifiedExtent);
+  segmentExtent = segmentLabelmap->GetExtent();
+  for (int i = 0; i < 3; ++i)
+    {
+    if (segmentExtent[2 * i] != 0 || segmentExtent[2 * i + 1] != 31)
+      {
+      std::cerr << __LINE__ << ": Segment labelmap padding was not removed" << std::endl;
+      return false;
+      }
+    }
+  if (segmentLabelmap->GetScalarComponentAsDouble(20, 20, 20, 0) != segment->GetLabelValue())
+    {
+    std::cerr << __LINE__ << ": Segment labelmap was not modified" << std::endl;
+    return false;
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestSharedLabelmapClosedSurface()
+{
+  // Surfaces created from a shared labelmap must be the same as the ones created
+  // from separate labelmaps.
+  vtkNew<vtkSegmentation> separateSegmentation;
+  separateSegmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName());
+  vtkNew<vtkSegmentation> sharedSegmentation;
+  sharedSegmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName());
+  const int numberOfSegments = 4;
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    int extent[6] = { 5 * i, 5 * i + 2, 0, 2 + i, i, 3 };
+    vtkNew<vtkOrientedImageData> separateImage;
+    CreateCubeLabelmap(separateImage, extent);
+    vtkNew<vtkSegment> separateSegment;
+    separateSegment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), separateImage);
+    separateSegmentation->AddSegment(separateSegment);
+
+    vtkNew<vtkOrientedImageData> sharedImage;
+    CreateCubeLabelmap(sharedImage, extent);
+    vtkNew<vtkSegment> sharedSegment;
+    sharedSegment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), sharedImage);
+    sharedSegmentation->AddSegment(sharedSegment);
+    }
+  sharedSegmentation->CollapseBinaryLabelmaps(false);
+  if (sharedSegmentation->GetNumberOfLayers() != 1)
+    {
+    std::cerr << __LINE__ << ": Invalid number of layers " << sharedSegmentation->GetNumberOfLayers() << " should be 1" << std::endl;
+    return false;
+    }
+
+  std::string closedSurfaceName = vtkSegmentationConverter::GetClosedSurfaceRepresentationName();
+  separateSegmentation->CreateRepresentation(closedSurfaceName);
+  sharedSegmentation->CreateRepresentation(closedSurfaceName);
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    vtkPolyData* separatePolyData = vtkPolyData::SafeDownCast(
+      separateSegmentation->GetNthSegment(i)->GetRepresentation(closedSurfaceName));
+    vtkPolyData* sharedPolyData = vtkPolyData::SafeDownCast(
+      sharedSegmentation->GetNthSegment(i)->GetRepresentation(closedSurfaceName));
+    if (!separatePolyData || !sharedPolyData)
+      {
+      std::cerr << __LINE__ << ": Missing closed surface representation in segment " << i << std::endl;
+      return false;
+      }
+    double separateBounds[6] = { 0.0 };
+    separatePolyData->GetBounds(separateBounds);
+    double sharedBounds[6] = { 0.0 };
+    sharedPolyData->GetBounds(sharedBounds);
+    if (separatePolyData->GetNumberOfPoints() == 0
+      || separatePolyData->GetNumberOfPoints() != sharedPolyData->GetNumberOfPoints()
+      || separatePolyData->GetNumberOfPolys() != sharedPolyData->GetNumberOfPolys()
+      || !std::equal(separateBounds, separateBounds + 6, sharedBounds))
+      {
+      std::cerr << __LINE__ << ": Closed surface mismatch in segment " << i << ": "
+        << sharedPolyData->GetNumberOfPoints() << " points should be " << separatePolyData->GetNumberOfPoints() << std::endl;
+      return false;
+      }
+    }
+
+  return true;
+}
+
+//----------------------------------------------------------------------------
+bool TestParallelConversion()
+{
+  // Convert the same segments in the calling thread and in multiple threads,
+  // the results must be identical.
+  vtkNew<vtkSegmentation> serialSegmentation;
+  serialSegmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName());
+  vtkNew<vtkSegmentation> parallelSegmentation;
+  parallelSegmentation->SetMasterRepresentationName(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName());
+  parallelSegmentation->SetNumberOfConversionThreads(4);
+  const int numberOfSegments = 8;
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    int extent[6] = { 4 * i, 4 * i + 2 + i, 0, 2 + i, 0, 2 };
+    vtkNew<vtkOrientedImageData> serialImage;
+    CreateCubeLabelmap(serialImage, extent);
+    vtkNew<vtkSegment> serialSegment;
+    serialSegment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), serialImage);
+    serialSegmentation->AddSegment(serialSegment);
+
+    vtkNew<vtkOrientedImageData> parallelImage;
+    CreateCubeLabelmap(parallelImage, extent);
+    vtkNew<vtkSegment> parallelSegment;
+    parallelSegment->AddRepresentation(vtkSegmentationConverter::GetBinaryLabelmapRepresentationName(), parallelImage);
+    parallelSegmentation->AddSegment(parallelSegment);
+    }
+
+  std::string closedSurfaceName = vtkSegmentationConverter::GetClosedSurfaceRepresentationName();
+  if (!serialSegmentation->CreateRepresentation(closedSurfaceName)
+    || !parallelSegmentation->CreateRepresentation(closedSurfaceName))
+    {
+    std::cerr << __LINE__ << ": Failed to create closed surface representation" << std::endl;
+    return false;
+    }
+
+  for (int i = 0; i < numberOfSegments; ++i)
+    {
+    vtkPolyData* serialPolyData = vtkPolyData::SafeDownCast(
+      serialSegmentation->GetNthSegment(i)->GetRepresentation(closedSurfaceName));
+    vtkPolyData* parallelPolyData = vtkPolyData::SafeDownCast(
+      parallelSegmentation->GetNthSegment(i)->GetRepresentation(closedSurfaceName));
+    if (!serialPolyData || !parallelPolyData)
+      {
+      std::cerr << __LINE__ << ": Missing closed surface representation in segment " << i << std::endl;
+      return false;
+      }
+    if (serialPolyData->GetNumberOfPoints() == 0
+      || serialPolyData->GetNumberOfPoints() != parallelPolyData->GetNumberOfPoints()
+      || serialPolyData->GetNumberOfPolys() != parallelPolyData->GetNumberOfPolys())
+      {
+      std::cerr << __LINE__ << ": Closed surface mismatch in segment " << i << ": "
+        << parallelPolyData->GetNumberOfPoints() << " points should be " << serialPolyData->GetNumberOfPoints() << std::endl;
+      return false;
+      }
+    }
+
+  return true;
+}
+
 //----------------------------------------------------------------------------
 int vtkSegmentationTest2(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
 {
@@ -333,11 +644,31 @@ int vtkSegmentationTest2(int vtkNotUsed(argc), char* vtkNotUsed(argv)[])
     return EXIT_FAILURE;
     }
 
+  if (!TestSharedLabelmapCollapseLargeLabelmaps())
+    {
+    return EXIT_FAILURE;
+    }
+
   if (!TestSharedLabelmapCasting())
     {
     return EXIT_FAILURE;
     }
 
+  if (!TestLabelmapBlockAllocation())
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!TestSharedLabelmapClosedSurface())
+    {
+    return EXIT_FAILURE;
+    }
+
+  if (!TestParallelConversion())
+    {
+    return EXIT_FAILURE;
+    }
+
   std::cout << "Segmentation test 2 passed." << std::endl;
   return EXIT_SUCCESS;
 }
@@ -68,6 +68,9 @@
 #include <vtkExtractSelection.h>
 #include <vtkSelectionSource.h>
 
+// STD includes
+#include <algorithm>
+
 //----------------------------------------------------------------------------
 vtkSegmentationConverterRuleNewMacro(vtkBinaryLabelmapToClosedSurfaceConversionRule);
 
@@ -133,6 +136,15 @@ vtkDataObject* vtkBinaryLabelmapToClosedSurfaceConversionRule::ConstructRepresen
     }
 }
 
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::IsThreadSafe()
+{
+  // Joint smoothing caches the surface of each shared labelmap in the rule
+  double smoothingFactor = vtkVariant(this->GetConversionParameter(GetSmoothingFactorParameterName())).ToDouble();
+  int jointSmoothing = vtkVariant(this->GetConversionParameter(GetJointSmoothingParameterName())).ToInt();
+  return (jointSmoothing == 0 || smoothingFactor <= 0);
+}
+
 //----------------------------------------------------------------------------
 bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment)
 {
@@ -156,8 +168,8 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment
     return false;
     }
 
-  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
-  int jointSmoothing = vtkVariant(this->ConversionParameters[GetJointSmoothingParameterName()].first).ToInt();
+  double smoothingFactor = vtkVariant(this->GetConversionParameter(GetSmoothingFactorParameterName())).ToDouble();
+  int jointSmoothing = vtkVariant(this->GetConversionParameter(GetJointSmoothingParameterName())).ToInt();
 
   if (jointSmoothing > 0 && smoothingFactor > 0)
     {
@@ -217,8 +229,29 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::Convert(vtkSegment* segment
     }
   else
     {
+    vtkSmartPointer<vtkOrientedImageData> segmentLabelmap = orientedBinaryLabelmap;
+    int labelExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    if (this->GetSharedLabelmapLabelExtent(orientedBinaryLabelmap, segment->GetLabelValue(), labelExtent))
+      {
+      if (labelExtent[0] > labelExtent[1] || labelExtent[2] > labelExtent[3] || labelExtent[4] > labelExtent[5])
+        {
+        vtkDebugMacro("Convert: No polygons can be created, label is not present in the shared labelmap");
+        closedSurfacePolyData->Initialize();
+        return true;
+        }
+      // Only process the region of the segment. The region is padded with background voxels
+      // to make sure the surface is closed.
+      vtkNew<vtkImageConstantPad> padder;
+      padder->SetInputData(orientedBinaryLabelmap);
+      padder->SetOutputWholeExtent(labelExtent[0] - 1, labelExtent[1] + 1,
+        labelExtent[2] - 1, labelExtent[3] + 1, labelExtent[4] - 1, labelExtent[5] + 1);
+      padder->Update();
+      segmentLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      segmentLabelmap->ShallowCopy(padder->GetOutput());
+      segmentLabelmap->CopyDirections(orientedBinaryLabelmap);
+      }
     std::vector<int> labelValue = { segment->GetLabelValue() };
-    this->CreateClosedSurface(orientedBinaryLabelmap, closedSurfacePolyData, labelValue);
+    this->CreateClosedSurface(segmentLabelmap, closedSurfacePolyData, labelValue);
     }
 
   return true;
@@ -283,9 +316,9 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
   binaryLabelmapWithIdentityGeometry->SetSpacing(1.0, 1.0, 1.0);
 
   // Get conversion parameters
-  double decimationFactor = vtkVariant(this->ConversionParameters[GetDecimationFactorParameterName()].first).ToDouble();
-  double smoothingFactor = vtkVariant(this->ConversionParameters[GetSmoothingFactorParameterName()].first).ToDouble();
-  int computeSurfaceNormals = vtkVariant(this->ConversionParameters[GetComputeSurfaceNormalsParameterName()].first).ToInt();
+  double decimationFactor = vtkVariant(this->GetConversionParameter(GetDecimationFactorParameterName())).ToDouble();
+  double smoothingFactor = vtkVariant(this->GetConversionParameter(GetSmoothingFactorParameterName())).ToDouble();
+  int computeSurfaceNormals = vtkVariant(this->GetConversionParameter(GetComputeSurfaceNormalsParameterName())).ToInt();
 
 #if VTK_MAJOR_VERSION >= 9 || (VTK_MAJOR_VERSION >= 8 && VTK_MINOR_VERSION >= 2)
   vtkNew<vtkDiscreteFlyingEdges3D> marchingCubes;
@@ -386,10 +419,128 @@ bool vtkBinaryLabelmapToClosedSurfaceConversionRule::CreateClosedSurface(vtkOrie
   return true;
 }
 
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::PreConvert(vtkSegmentation* segmentation)
+{
+  this->SharedLabelmapScalars.clear();
+  this->LabelExtentCache.clear();
+  if (!segmentation)
+    {
+    return true;
+    }
+
+  std::string sourceRepresentationName = this->GetSourceRepresentationName();
+  int numberOfLayers = segmentation->GetNumberOfLayers(sourceRepresentationName);
+  for (int layer = 0; layer < numberOfLayers; ++layer)
+    {
+    if (segmentation->GetSegmentIDsForLayer(layer, sourceRepresentationName).size() < 2)
+      {
+      continue;
+      }
+    vtkImageData* layerLabelmap = vtkImageData::SafeDownCast(segmentation->GetLayerDataObject(layer, sourceRepresentationName));
+    if (layerLabelmap && layerLabelmap->GetPointData()->GetScalars())
+      {
+      this->SharedLabelmapScalars.insert(layerLabelmap->GetPointData()->GetScalars());
+      }
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------------
 bool vtkBinaryLabelmapToClosedSurfaceConversionRule::PostConvert(vtkSegmentation* vtkNotUsed(segmentation))
 {
   this->JointSmoothCache.clear();
+  this->SharedLabelmapScalars.clear();
+  this->LabelExtentCache.clear();
+  return true;
+}
+
+//----------------------------------------------------------------------------
+template<class ImageScalarType>
+void GetLabelExtentsGeneric(vtkImageData* labelmap, std::map<int, std::array<int, 6> >& labelExtents)
+{
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  labelmap->GetExtent(extent);
+  ImageScalarType* imagePtr = (ImageScalarType*)labelmap->GetScalarPointerForExtent(extent);
+  int numberOfComponents = labelmap->GetNumberOfScalarComponents();
+
+  // Voxels of the same label are typically next to each other, so the extent of the last label is kept at hand
+  int currentLabel = 0;
+  std::array<int, 6>* currentLabelExtent = nullptr;
+  for (int k = extent[4]; k <= extent[5]; ++k)
+    {
+    for (int j = extent[2]; j <= extent[3]; ++j)
+      {
+      for (int i = extent[0]; i <= extent[1]; ++i, imagePtr += numberOfComponents)
+        {
+        int label = static_cast<int>(*imagePtr);
+        if (label == 0)
+          {
+          continue;
+          }
+        if (!currentLabelExtent || label != currentLabel)
+          {
+          std::map<int, std::array<int, 6> >::iterator labelExtentIt = labelExtents.find(label);
+          if (labelExtentIt == labelExtents.end())
+            {
+            std::array<int, 6> labelExtent = { { i, i, j, j, k, k } };
+            labelExtentIt = labelExtents.insert(std::make_pair(label, labelExtent)).first;
+            }
+          currentLabel = label;
+          currentLabelExtent = &labelExtentIt->second;
+          }
+        std::array<int, 6>& labelExtent = *currentLabelExtent;
+        labelExtent[0] = std::min(labelExtent[0], i);
+        labelExtent[1] = std::max(labelExtent[1], i);
+        labelExtent[2] = std::min(labelExtent[2], j);
+        labelExtent[3] = std::max(labelExtent[3], j);
+        // Voxels are visited in increasing k order
+        labelExtent[5] = k;
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkBinaryLabelmapToClosedSurfaceConversionRule::GetSharedLabelmapLabelExtent(
+  vtkOrientedImageData* binaryLabelmap, int labelValue, int labelExtent[6])
+{
+  if (!binaryLabelmap || !binaryLabelmap->GetPointData()->GetScalars())
+    {
+    return false;
+    }
+  vtkDataArray* scalars = binaryLabelmap->GetPointData()->GetScalars();
+  if (this->SharedLabelmapScalars.find(scalars) == this->SharedLabelmapScalars.end())
+    {
+    return false;
+    }
+
+  std::lock_guard<std::mutex> lock(this->LabelExtentCacheLock);
+  std::map<vtkDataArray*, std::map<int, std::array<int, 6> > >::iterator labelExtentsIt = this->LabelExtentCache.find(scalars);
+  if (labelExtentsIt == this->LabelExtentCache.end())
+    {
+    // Compute extent of all labels of the shared labelmap in one pass
+    std::map<int, std::array<int, 6> > labelExtents;
+    switch (binaryLabelmap->GetScalarType())
+      {
+      vtkTemplateMacro(GetLabelExtentsGeneric<VTK_TT>(binaryLabelmap, labelExtents));
+      default:
+        vtkErrorMacro("GetSharedLabelmapLabelExtent: Unknown image scalar type!");
+        return false;
+      }
+    labelExtentsIt = this->LabelExtentCache.insert(std::make_pair(scalars, labelExtents)).first;
+    }
+
+  std::map<int, std::array<int, 6> >::iterator labelExtentIt = labelExtentsIt->second.find(labelValue);
+  if (labelExtentIt == labelExtentsIt->second.end())
+    {
+    int emptyExtent[6] = { 0, -1, 0, -1, 0, -1 };
+    std::copy(emptyExtent, emptyExtent + 6, labelExtent);
+    }
+  else
+    {
+    std::copy(labelExtentIt->second.begin(), labelExtentIt->second.end(), labelExtent);
+    }
   return true;
 }
 
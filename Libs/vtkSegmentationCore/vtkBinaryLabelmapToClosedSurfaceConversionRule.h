@@ -30,6 +30,14 @@
 // VTK includes
 #include <vtkPolyData.h>
 
+// STD includes
+#include <array>
+#include <map>
+#include <mutex>
+#include <set>
+
+class vtkDataArray;
+
 /// \ingroup SegmentationCore
 /// \brief Convert binary labelmap representation (vtkOrientedImageData type) to
 ///   closed surface representation (vtkPolyData type). The conversion algorithm
@@ -71,8 +79,15 @@ public:
   /// Update the target representation based on the source representation
   bool Convert(vtkSegment* segment) override;
 
+  /// Conversion can be run in parallel for different segments, unless joint smoothing is enabled
+  bool IsThreadSafe() override;
+
+  /// Perform preprocessing steps before conversion
+  /// Collects the binary labelmaps that are shared by multiple segments
+  bool PreConvert(vtkSegmentation* segmentation) override;
+
   /// Perform postprocesing steps on the output
-  /// Clears the joint smoothing cache
+  /// Clears the joint smoothing and label extent caches
   bool PostConvert(vtkSegmentation* segmentation) override;
 
   /// Get the cost of the conversion.
@@ -92,6 +107,14 @@ protected:
   /// This function checks whether this is the case.
   bool IsLabelmapPaddingNecessary(vtkImageData* binaryLabelMap);
 
+  /// Get the extent of the voxels of a label value in a shared labelmap.
+  /// Extents of all labels in the labelmap are computed in a single pass over the voxels when the first
+  /// segment of the labelmap is converted, so that each segment can be converted using only its own region
+  /// instead of the full extent of the shared labelmap.
+  /// \param labelExtent Output extent. Empty if the label is not present in the labelmap.
+  /// \return False if the labelmap is not shared by multiple segments.
+  bool GetSharedLabelmapLabelExtent(vtkOrientedImageData* binaryLabelmap, int labelValue, int labelExtent[6]);
+
 protected:
   vtkBinaryLabelmapToClosedSurfaceConversionRule();
   ~vtkBinaryLabelmapToClosedSurfaceConversionRule() override;
@@ -102,6 +125,15 @@ protected:
   /// The key used is the binary labelmap representation, which maps to the combined vtkPolyData containing surfaces for all segments in the segmentation
   std::map<vtkOrientedImageData*, vtkSmartPointer<vtkPolyData> > JointSmoothCache;
 
+  /// Scalars of binary labelmaps that are shared by multiple segments.
+  /// Scalar arrays are used for identifying the labelmaps, because segments may be converted
+  /// using shallow copies of the labelmap (see vtkSegmentation::NumberOfConversionThreads).
+  std::set<vtkDataArray*> SharedLabelmapScalars;
+  /// Cache for storing the extent of each label value in shared labelmaps
+  std::map<vtkDataArray*, std::map<int, std::array<int, 6> > > LabelExtentCache;
+  /// Lock for the label extent cache, as segments may be converted in parallel
+  std::mutex LabelExtentCacheLock;
+
 };
 
 #endif // __vtkBinaryLabelmapToClosedSurfaceConversionRule_h
@@ -122,6 +122,20 @@ vtkDataObject* vtkClosedSurfaceToBinaryLabelmapConversionRule::ConstructRepresen
     }
 }
 
+//----------------------------------------------------------------------------
+bool vtkClosedSurfaceToBinaryLabelmapConversionRule::IsThreadSafe()
+{
+  // If there is no valid reference geometry then the default geometry
+  // is computed and stored in the conversion parameters in Convert
+  std::string geometryString = this->GetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName());
+  if (geometryString.empty())
+    {
+    return false;
+    }
+  vtkNew<vtkOrientedImageData> geometryImageData;
+  return vtkSegmentationConverter::DeserializeImageGeometry(geometryString, geometryImageData, false);
+}
+
 //----------------------------------------------------------------------------
 bool vtkClosedSurfaceToBinaryLabelmapConversionRule::Convert(vtkSegment* segment)
 {
@@ -273,7 +287,7 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::CalculateOutputGeometry(vtk
     }
 
   // Get reference image geometry from parameters
-  std::string geometryString = this->ConversionParameters[vtkSegmentationConverter::GetReferenceImageGeometryParameterName()].first;
+  std::string geometryString = this->GetConversionParameter(vtkSegmentationConverter::GetReferenceImageGeometryParameterName());
   if (geometryString.empty() || !vtkSegmentationConverter::DeserializeImageGeometry(geometryString, geometryImageData))
     {
     geometryString = this->GetDefaultImageGeometryStringForPolyData(closedSurfacePolyData);
@@ -294,7 +308,7 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::CalculateOutputGeometry(vtk
     }
 
   // Get oversampling factor
-  std::string oversamplingString = this->ConversionParameters[GetOversamplingFactorParameterName()].first;
+  std::string oversamplingString = this->GetConversionParameter(GetOversamplingFactorParameterName());
   double oversamplingFactor = 1.0;
   if (!oversamplingString.compare("A"))
     {
@@ -329,7 +343,7 @@ bool vtkClosedSurfaceToBinaryLabelmapConversionRule::CalculateOutputGeometry(vtk
 
   int cropToReferenceImageGeometry = 0;
     {
-    std::string cropToReferenceImageGeometryString = this->ConversionParameters[GetCropToReferenceImageGeometryParameterName()].first;
+    std::string cropToReferenceImageGeometryString = this->GetConversionParameter(GetCropToReferenceImageGeometryParameterName());
     std::stringstream ss;
     ss << cropToReferenceImageGeometryString;
     ss >> cropToReferenceImageGeometry;
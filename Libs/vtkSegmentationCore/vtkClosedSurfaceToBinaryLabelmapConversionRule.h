@@ -62,6 +62,9 @@ public:
   /// Note: Need to take ownership of the created object! For example using vtkSmartPointer<vtkDataObject>::Take
   vtkDataObject* ConstructRepresentationObjectByClass(std::string className) override;
 
+  /// Conversion can be run in parallel for different segments if a valid reference geometry is set
+  bool IsThreadSafe() override;
+
   /// Update the target representation based on the source representation
   bool Convert(vtkSegment* segment) override;
 
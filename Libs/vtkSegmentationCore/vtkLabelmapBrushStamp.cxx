@@ -0,0 +1,211 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// SegmentationCore includes
+#include "vtkLabelmapBrushStamp.h"
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkImageStencilData.h>
+#include <vtkMath.h>
+#include <vtkMatrix4x4.h>
+#include <vtkObjectFactory.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+
+//----------------------------------------------------------------------------
+vtkStandardNewMacro(vtkLabelmapBrushStamp);
+
+//----------------------------------------------------------------------------
+vtkLabelmapBrushStamp::vtkLabelmapBrushStamp()
+{
+  this->Stencil = vtkSmartPointer<vtkImageStencilData>::New();
+}
+
+//----------------------------------------------------------------------------
+vtkLabelmapBrushStamp::~vtkLabelmapBrushStamp() = default;
+
+//----------------------------------------------------------------------------
+void vtkLabelmapBrushStamp::PrintSelf(ostream& os, vtkIndent indent)
+{
+  this->Superclass::PrintSelf(os, indent);
+  int extent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->Stencil->GetExtent(extent);
+  os << indent << "Stencil extent: " << extent[0] << " " << extent[1] << " " << extent[2] << " "
+    << extent[3] << " " << extent[4] << " " << extent[5] << "\n";
+  os << indent << "Stencil parameters:";
+  for (double parameter : this->StencilParameters)
+    {
+    os << " " << parameter;
+    }
+  os << "\n";
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapBrushStamp::GetStencilParameters(const std::vector<double>& shapeParameters, vtkMatrix4x4* brushToLabelmapIjk,
+  std::vector<double>& stencilParameters)
+{
+  stencilParameters = shapeParameters;
+  for (int row = 0; row < 3; row++)
+    {
+    for (int column = 0; column < 3; column++)
+      {
+      stencilParameters.push_back(brushToLabelmapIjk ? brushToLabelmapIjk->GetElement(row, column) : (row == column ? 1.0 : 0.0));
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkLabelmapBrushStamp::NeedsUpdate(const std::vector<double>& shapeParameters, vtkMatrix4x4* brushToLabelmapIjk)
+{
+  std::vector<double> stencilParameters;
+  vtkLabelmapBrushStamp::GetStencilParameters(shapeParameters, brushToLabelmapIjk, stencilParameters);
+  return stencilParameters != this->StencilParameters;
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapBrushStamp::SetStencil(vtkImageStencilData* stencil, const std::vector<double>& shapeParameters,
+  vtkMatrix4x4* brushToLabelmapIjk)
+{
+  if (!stencil)
+    {
+    vtkErrorMacro("SetStencil: invalid stencil");
+    return;
+    }
+  this->Stencil->DeepCopy(stencil);
+  vtkLabelmapBrushStamp::GetStencilParameters(shapeParameters, brushToLabelmapIjk, this->StencilParameters);
+  this->Modified();
+}
+
+//----------------------------------------------------------------------------
+vtkImageStencilData* vtkLabelmapBrushStamp::GetStencil()
+{
+  return this->Stencil;
+}
+
+//----------------------------------------------------------------------------
+double vtkLabelmapBrushStamp::GetRadiusAlongDirection(const double direction[3])
+{
+  int stencilExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->Stencil->GetExtent(stencilExtent);
+  double directionLength = vtkMath::Norm(direction);
+  double radius = VTK_DOUBLE_MAX;
+  for (int i = 0; i < 3; i++)
+    {
+    // extent is padded by 1 voxel on each side
+    double stencilRadius = std::max(0.5, (stencilExtent[i * 2 + 1] - stencilExtent[i * 2] - 2) / 2.0);
+    if (std::fabs(direction[i]) > 0)
+      {
+      radius = std::min(radius, stencilRadius * directionLength / std::fabs(direction[i]));
+      }
+    }
+  return (radius < VTK_DOUBLE_MAX ? radius : 0.5);
+}
+
+//----------------------------------------------------------------------------
+template <class T>
+void PaintStencilGeneric(vtkImageData* image, vtkImageStencilData* stencil, const int shift[3], const int paintExtent[6], T value)
+{
+  // paintExtent is in image IJK coordinate system, stencil is shifted by shift
+  for (int z = paintExtent[4]; z <= paintExtent[5]; z++)
+    {
+    for (int y = paintExtent[2]; y <= paintExtent[3]; y++)
+      {
+      int iter = 0;
+      int r1 = 0;
+      int r2 = 0;
+      while (stencil->GetNextExtent(r1, r2, paintExtent[0] - shift[0], paintExtent[1] - shift[0], y - shift[1], z - shift[2], iter))
+        {
+        T* imagePtr = static_cast<T*>(image->GetScalarPointer(r1 + shift[0], y, z));
+        for (int x = r1; x <= r2; x++, imagePtr++)
+          {
+          // Same as vtkOrientedImageDataResample::OPERATION_MAXIMUM
+          if (*imagePtr < value)
+            {
+            *imagePtr = value;
+            }
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapBrushStamp::Paint(vtkImageData* labelmap, const double position_Ijk[3], double fillValue, int updateExtent[6])
+{
+  if (!labelmap || !labelmap->GetScalarPointer())
+    {
+    vtkErrorMacro("Paint: invalid labelmap");
+    return;
+    }
+  int shift[3] = { 0, 0, 0 };
+  int stencilExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  this->Stencil->GetExtent(stencilExtent);
+  int* labelmapExtent = labelmap->GetExtent();
+  int paintExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  for (int i = 0; i < 3; i++)
+    {
+    shift[i] = vtkMath::Floor(position_Ijk[i] + 0.5);
+    paintExtent[i * 2] = std::max(stencilExtent[i * 2] + shift[i], labelmapExtent[i * 2]);
+    paintExtent[i * 2 + 1] = std::min(stencilExtent[i * 2 + 1] + shift[i], labelmapExtent[i * 2 + 1]);
+    if (paintExtent[i * 2] > paintExtent[i * 2 + 1])
+      {
+      // stencil is empty or outside of the labelmap
+      return;
+      }
+    }
+
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(PaintStencilGeneric<VTK_TT>(labelmap, this->Stencil, shift, paintExtent, static_cast<VTK_TT>(fillValue)));
+    default:
+      vtkErrorMacro("Paint: unknown scalar type");
+      return;
+    }
+
+  for (int i = 0; i < 3; i++)
+    {
+    updateExtent[i * 2] = std::min(updateExtent[i * 2], paintExtent[i * 2]);
+    updateExtent[i * 2 + 1] = std::max(updateExtent[i * 2 + 1], paintExtent[i * 2 + 1]);
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkLabelmapBrushStamp::PaintSegment(vtkImageData* labelmap, const double startPosition_Ijk[3], const double endPosition_Ijk[3],
+  double fillValue, int updateExtent[6])
+{
+  double movement[3] = { 0.0, 0.0, 0.0 };
+  vtkMath::Subtract(endPosition_Ijk, startPosition_Ijk, movement);
+  double movementLength = vtkMath::Norm(movement);
+  if (movementLength > 0)
+    {
+    // Step size is half of the stencil radius in the direction of the movement
+    double stepSize = std::max(0.5, this->GetRadiusAlongDirection(movement) * 0.5);
+    int numberOfSteps = static_cast<int>(std::ceil(movementLength / stepSize));
+    for (int step = 1; step < numberOfSteps; step++)
+      {
+      double intermediatePosition_Ijk[3] = { 0.0, 0.0, 0.0 };
+      for (int i = 0; i < 3; i++)
+        {
+        intermediatePosition_Ijk[i] = startPosition_Ijk[i] + movement[i] * step / numberOfSteps;
+        }
+      this->Paint(labelmap, intermediatePosition_Ijk, fillValue, updateExtent);
+      }
+    }
+  this->Paint(labelmap, endPosition_Ijk, fillValue, updateExtent);
+}
@@ -0,0 +1,93 @@
+/*==============================================================================
+
+  Copyright (c) Laboratory for Percutaneous Surgery (PerkLab)
+  Queen's University, Kingston, ON, Canada. All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+#ifndef __vtkLabelmapBrushStamp_h
+#define __vtkLabelmapBrushStamp_h
+
+// VTK includes
+#include <vtkObject.h>
+#include <vtkSmartPointer.h>
+
+// STD includes
+#include <vector>
+
+#include "vtkSegmentationCoreConfigure.h"
+
+class vtkImageData;
+class vtkImageStencilData;
+class vtkMatrix4x4;
+
+/// \ingroup SegmentationCore
+/// \brief Brush shape rasterized in the IJK coordinate system of a labelmap, that can be
+/// painted quickly at many positions.
+///
+/// The stencil is centered at the IJK origin. It is cached together with the parameters that
+/// determine its shape, so that it only needs to be rasterized again if the brush shape, size,
+/// or orientation relative to the labelmap changes (see NeedsUpdate).
+class vtkSegmentationCore_EXPORT vtkLabelmapBrushStamp : public vtkObject
+{
+public:
+  static vtkLabelmapBrushStamp *New();
+  vtkTypeMacro(vtkLabelmapBrushStamp, vtkObject);
+  void PrintSelf(ostream& os, vtkIndent indent) override;
+
+  /// Returns true if the stencil was not computed for these parameters and must be set by SetStencil.
+  /// \param shapeParameters Parameters of the brush shape (such as type and size) in the brush coordinate system
+  /// \param brushToLabelmapIjk Transform from the brush to the labelmap IJK coordinate system.
+  ///   Translation is ignored, as the stencil is positioned when it is painted.
+  bool NeedsUpdate(const std::vector<double>& shapeParameters, vtkMatrix4x4* brushToLabelmapIjk);
+
+  /// Store a deep copy of the stencil computed for the given parameters (see NeedsUpdate).
+  /// The stencil extent is expected to be padded by one voxel on each side.
+  void SetStencil(vtkImageStencilData* stencil, const std::vector<double>& shapeParameters, vtkMatrix4x4* brushToLabelmapIjk);
+
+  /// Cached stencil, centered at the IJK origin
+  vtkImageStencilData* GetStencil();
+
+  /// Half size of the stencil along a direction (in voxels), excluding the padding
+  double GetRadiusAlongDirection(const double direction[3]);
+
+  /// Paint the stencil into the labelmap at the given IJK position (rounded to the nearest voxel).
+  /// Voxels are set to the maximum of the current value and fillValue.
+  /// updateExtent is extended by the modified region.
+  void Paint(vtkImageData* labelmap, const double position_Ijk[3], double fillValue, int updateExtent[6]);
+
+  /// Paint the stencil at intermediate positions along the segment between startPosition_Ijk
+  /// (excluded, it is expected to be already painted) and endPosition_Ijk (included).
+  /// Positions are placed at half of the stencil radius along the segment, so that the painted
+  /// region is continuous.
+  void PaintSegment(vtkImageData* labelmap, const double startPosition_Ijk[3], const double endPosition_Ijk[3],
+    double fillValue, int updateExtent[6]);
+
+protected:
+  vtkLabelmapBrushStamp();
+  ~vtkLabelmapBrushStamp() override;
+
+  /// Get stencil parameters from shape parameters and transform
+  static void GetStencilParameters(const std::vector<double>& shapeParameters, vtkMatrix4x4* brushToLabelmapIjk,
+    std::vector<double>& stencilParameters);
+
+protected:
+  vtkSmartPointer<vtkImageStencilData> Stencil;
+  /// Parameters that the stencil was computed for
+  std::vector<double> StencilParameters;
+
+private:
+  vtkLabelmapBrushStamp(const vtkLabelmapBrushStamp&) = delete;
+  void operator=(const vtkLabelmapBrushStamp&) = delete;
+};
+
+#endif
@@ -44,6 +44,8 @@
 
 // STD includes
 #include <algorithm>
+#include <array>
+#include <map>
 #include <vector>
 
 vtkStandardNewMacro(vtkOrientedImageDataResample);
@@ -1822,6 +1824,172 @@ bool vtkOrientedImageDataResample::IsLabelInMask(
 }
 
 
+//----------------------------------------------------------------------------
+template <class LabelmapScalarType>
+void CalculateEffectiveExtentsForLabelsGeneric(vtkImageData* labelmap, std::map<int, std::array<int, 6> >& labelEffectiveExtents)
+{
+  int* wholeExt = labelmap->GetExtent();
+  if (labelmap->GetScalarPointer() == nullptr
+    || wholeExt[0] > wholeExt[1] || wholeExt[2] > wholeExt[3] || wholeExt[4] > wholeExt[5])
+    {
+    return;
+    }
+
+  // Consecutive voxels usually have the same label, therefore the extent of the last label is cached
+  int currentLabel = 0;
+  int* currentExtent = nullptr;
+  for (int k = wholeExt[4]; k <= wholeExt[5]; k++)
+    {
+    for (int j = wholeExt[2]; j <= wholeExt[3]; j++)
+      {
+      LabelmapScalarType* labelmapPtr = static_cast<LabelmapScalarType*>(labelmap->GetScalarPointer(wholeExt[0], j, k));
+      for (int i = wholeExt[0]; i <= wholeExt[1]; i++)
+        {
+        LabelmapScalarType value = *(labelmapPtr++);
+        if (value == static_cast<LabelmapScalarType>(0))
+          {
+          continue;
+          }
+        int label = static_cast<int>(value);
+        if (currentExtent == nullptr || label != currentLabel)
+          {
+          std::array<int, 6> firstVoxelExtent = { { i, i, j, j, k, k } };
+          currentExtent = labelEffectiveExtents.insert(std::make_pair(label, firstVoxelExtent)).first->second.data();
+          currentLabel = label;
+          }
+        // k is increasing during the iteration, so the minimum k is always the first one
+        if (i < currentExtent[0]) { currentExtent[0] = i; }
+        if (i > currentExtent[1]) { currentExtent[1] = i; }
+        if (j < currentExtent[2]) { currentExtent[2] = j; }
+        if (j > currentExtent[3]) { currentExtent[3] = j; }
+        if (k > currentExtent[5]) { currentExtent[5] = k; }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedImageDataResample::CalculateEffectiveExtentsForLabels(vtkImageData* labelmap,
+  std::map<int, std::array<int, 6> >& labelEffectiveExtents)
+{
+  labelEffectiveExtents.clear();
+  if (!labelmap)
+    {
+    return;
+    }
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacro(CalculateEffectiveExtentsForLabelsGeneric<VTK_TT>(labelmap, labelEffectiveExtents));
+    default:
+      vtkGenericWarningMacro("vtkOrientedImageDataResample::CalculateEffectiveExtentsForLabels: Unknown ScalarType");
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class LabelmapScalarType, class ImageScalarType>
+void IsLabelValueInImageGeneric2(vtkImageData* labelmap, int labelValue, vtkImageData* image, const int extent[6], bool& found)
+{
+  LabelmapScalarType label = static_cast<LabelmapScalarType>(labelValue);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      LabelmapScalarType* labelmapPtr = static_cast<LabelmapScalarType*>(labelmap->GetScalarPointer(extent[0], j, k));
+      ImageScalarType* imagePtr = static_cast<ImageScalarType*>(image->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, labelmapPtr++, imagePtr++)
+        {
+        if (*labelmapPtr == label && *imagePtr != static_cast<ImageScalarType>(0))
+          {
+          found = true;
+          return;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class LabelmapScalarType>
+void IsLabelValueInImageGeneric(vtkImageData* labelmap, int labelValue, vtkImageData* image, const int extent[6], bool& found)
+{
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro((IsLabelValueInImageGeneric2<LabelmapScalarType, VTK_TT>(labelmap, labelValue, image, extent, found)));
+    default:
+      vtkGenericWarningMacro("vtkOrientedImageDataResample::IsLabelValueInImageGeneric: Unknown ScalarType");
+    }
+}
+
+//----------------------------------------------------------------------------
+bool vtkOrientedImageDataResample::IsLabelValueInImage(vtkImageData* labelmap, int labelValue, vtkImageData* image, const int extent[6])
+{
+  if (!labelmap || !image || !extent || extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5]
+    || labelmap->GetScalarPointer() == nullptr || image->GetScalarPointer() == nullptr)
+    {
+    return false;
+    }
+  bool found = false;
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacro((IsLabelValueInImageGeneric<VTK_TT>(labelmap, labelValue, image, extent, found)));
+    default:
+      vtkGenericWarningMacro("vtkOrientedImageDataResample::IsLabelValueInImage: Unknown ScalarType");
+    }
+  return found;
+}
+
+//----------------------------------------------------------------------------
+template <class LabelmapScalarType, class ImageScalarType>
+void CopyLabelValueGeneric2(vtkImageData* labelmap, int labelValue, vtkImageData* image, int outputValue, const int extent[6])
+{
+  LabelmapScalarType label = static_cast<LabelmapScalarType>(labelValue);
+  ImageScalarType output = static_cast<ImageScalarType>(outputValue);
+  for (int k = extent[4]; k <= extent[5]; k++)
+    {
+    for (int j = extent[2]; j <= extent[3]; j++)
+      {
+      LabelmapScalarType* labelmapPtr = static_cast<LabelmapScalarType*>(labelmap->GetScalarPointer(extent[0], j, k));
+      ImageScalarType* imagePtr = static_cast<ImageScalarType*>(image->GetScalarPointer(extent[0], j, k));
+      for (int i = extent[0]; i <= extent[1]; i++, labelmapPtr++, imagePtr++)
+        {
+        if (*labelmapPtr == label)
+          {
+          *imagePtr = output;
+          }
+        }
+      }
+    }
+}
+
+//----------------------------------------------------------------------------
+template <class LabelmapScalarType>
+void CopyLabelValueGeneric(vtkImageData* labelmap, int labelValue, vtkImageData* image, int outputValue, const int extent[6])
+{
+  switch (image->GetScalarType())
+    {
+    vtkTemplateMacro((CopyLabelValueGeneric2<LabelmapScalarType, VTK_TT>(labelmap, labelValue, image, outputValue, extent)));
+    default:
+      vtkGenericWarningMacro("vtkOrientedImageDataResample::CopyLabelValueGeneric: Unknown ScalarType");
+    }
+}
+
+//----------------------------------------------------------------------------
+void vtkOrientedImageDataResample::CopyLabelValue(vtkImageData* labelmap, int labelValue, vtkImageData* image, int outputValue, const int extent[6])
+{
+  if (!labelmap || !image || !extent || extent[0] > extent[1] || extent[2] > extent[3] || extent[4] > extent[5]
+    || labelmap->GetScalarPointer() == nullptr || image->GetScalarPointer() == nullptr)
+    {
+    return;
+    }
+  switch (labelmap->GetScalarType())
+    {
+    vtkTemplateMacro((CopyLabelValueGeneric<VTK_TT>(labelmap, labelValue, image, outputValue, extent)));
+    default:
+      vtkGenericWarningMacro("vtkOrientedImageDataResample::CopyLabelValue: Unknown ScalarType");
+    }
+  image->Modified();
+}
+
 //----------------------------------------------------------------------------
 void vtkOrientedImageDataResample::CastImageForValue(vtkOrientedImageData* image, double value)
 {
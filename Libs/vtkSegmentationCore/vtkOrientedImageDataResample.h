@@ -28,6 +28,8 @@
 #include "vtkObject.h"
 
 // std includes
+#include <array>
+#include <map>
 #include <vector>
 
 class vtkImageData;
@@ -183,6 +185,29 @@ public:
   static bool IsLabelInMask(vtkOrientedImageData* binaryLabelmap, vtkOrientedImageData* mask,
     int extent[6]=nullptr, int maskThreshold=0);
 
+  /// Calculate effective extent of all label values of a labelmap in a single pass
+  /// \param labelmap Input labelmap. Voxels with 0 value are ignored.
+  /// \param labelEffectiveExtents Effective extent of each label value that occurs in the labelmap
+  static void CalculateEffectiveExtentsForLabels(vtkImageData* labelmap, std::map<int, std::array<int, 6> >& labelEffectiveExtents);
+
+  /// Determine if there is a non-zero value in the image where the labelmap contains the specified label value.
+  /// Labelmap and image must have the same geometry and both of them must contain the specified extent.
+  /// This is faster than IsLabelInMask because no intermediate images are created.
+  /// \param labelmap Labelmap that defines the region
+  /// \param labelValue Only voxels of this value are considered in the labelmap
+  /// \param image Image to look for non-zero values in
+  /// \param extent Region to examine
+  static bool IsLabelValueInImage(vtkImageData* labelmap, int labelValue, vtkImageData* image, const int extent[6]);
+
+  /// Set voxels of the image to the output value where the labelmap contains the specified label value.
+  /// Labelmap and image must have the same geometry and both of them must contain the specified extent.
+  /// \param labelmap Labelmap that defines the region
+  /// \param labelValue Only voxels of this value are copied from the labelmap
+  /// \param image Image to modify. Its scalar type must be able to represent outputValue.
+  /// \param outputValue Value to write into the image
+  /// \param extent Region to modify
+  static void CopyLabelValue(vtkImageData* labelmap, int labelValue, vtkImageData* image, int outputValue, const int extent[6]);
+
   /// Cast the data type of the image to be able to contain the specified value
   /// \param image Image to convert
   /// \param value Value that should be representable by the image data type
@@ -33,9 +33,11 @@
 #include <vtkBoundingBox.h>
 #include <vtkCallbackCommand.h>
 #include <vtkCollection.h>
+#include <vtkDataSet.h>
 #include <vtkImageThreshold.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
+#include <vtkMultiThreader.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkPointData.h>
@@ -47,6 +49,8 @@
 
 // STD includes
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <functional>
 #include <sstream>
 
@@ -84,6 +88,9 @@ vtkSegmentation::vtkSegmentation()
 
   this->SegmentIdAutogeneratorIndex = 0;
 
+  this->NumberOfConversionThreads = 1;
+  this->LabelmapBlockSize = 32;
+
   this->SetMasterRepresentationName(vtkSegmentationConverter::GetSegmentationBinaryLabelmapRepresentationName());
 }
 
@@ -147,6 +154,8 @@ void vtkSegmentation::DeepCopy(vtkSegmentation* aSegmentation)
 
   // Copy properties
   this->SetMasterRepresentationName(aSegmentation->GetMasterRepresentationName());
+  this->SetNumberOfConversionThreads(aSegmentation->GetNumberOfConversionThreads());
+  this->SetLabelmapBlockSize(aSegmentation->GetLabelmapBlockSize());
 
   // Copy conversion parameters
   this->Converter->DeepCopy(aSegmentation->Converter);
@@ -177,6 +186,8 @@ void vtkSegmentation::PrintSelf(ostream& os, vtkIndent indent)
   os << indent << "Modified Time: " << this->GetMTime() << "\n";
 
   os << indent << "MasterRepresentationName:  " << this->MasterRepresentationName << "\n";
+  os << indent << "NumberOfConversionThreads:  " << this->NumberOfConversionThreads << "\n";
+  os << indent << "LabelmapBlockSize:  " << this->LabelmapBlockSize << "\n";
   os << indent << "Number of segments:  " << this->Segments.size() << "\n";
 
   for (std::deque< std::string >::iterator segmentIdIt = this->SegmentIds.begin();
@@ -1027,6 +1038,7 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
 
     // Perform conversion step
     currentConversionRule->PreConvert(this);
+    std::vector<vtkSegment*> segmentsToConvert;
     for (auto segmentID : segmentIDs)
       {
       vtkSegment* segment = this->GetSegment(segmentID);
@@ -1049,7 +1061,25 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
         {
         continue;
         }
-      currentConversionRule->Convert(segment);
+      segmentsToConvert.push_back(segment);
+      }
+
+    int numberOfThreads = this->NumberOfConversionThreads;
+    if (numberOfThreads == 0)
+      {
+      numberOfThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+      }
+    numberOfThreads = std::min(numberOfThreads, static_cast<int>(segmentsToConvert.size()));
+    if (numberOfThreads > 1 && currentConversionRule->IsThreadSafe())
+      {
+      this->ConvertSegmentsInParallel(currentConversionRule, segmentsToConvert, numberOfThreads);
+      }
+    else
+      {
+      for (vtkSegment* segment : segmentsToConvert)
+        {
+        currentConversionRule->Convert(segment);
+        }
       }
     currentConversionRule->PostConvert(this);
 
@@ -1058,6 +1088,108 @@ bool vtkSegmentation::ConvertSegmentsUsingPath(std::vector<std::string> segmentI
   return true;
 }
 
+//-----------------------------------------------------------------------------
+namespace
+{
+struct ParallelConversionInfo
+{
+  vtkSegmentationConverterRule* Rule;
+  std::vector<vtkSmartPointer<vtkSegment> >* WorkSegments;
+  std::atomic<size_t> NextSegmentIndex;
+};
+
+VTK_THREAD_RETURN_TYPE ParallelConversionThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ParallelConversionInfo* info = static_cast<ParallelConversionInfo*>(threadInfo->UserData);
+  // Segments are assigned to threads one by one, as conversion time varies a lot between segments
+  size_t segmentIndex = 0;
+  while ((segmentIndex = info->NextSegmentIndex++) < info->WorkSegments->size())
+    {
+    info->Rule->Convert((*info->WorkSegments)[segmentIndex]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+}
+
+//-----------------------------------------------------------------------------
+void vtkSegmentation::ConvertSegmentsInParallel(vtkSegmentationConverterRule* rule,
+  std::vector<vtkSegment*>& segments, int numberOfThreads)
+{
+  std::string targetRepresentationName = rule->GetTargetRepresentationName();
+
+  // Create temporary segments that share the data of the representations.
+  // Segments are not modified by the conversion threads, and each thread gets its own
+  // data objects, so that pipeline information is not shared between threads.
+  std::vector<vtkSmartPointer<vtkSegment> > workSegments;
+  std::vector<vtkDataObject*> workTargetRepresentations;
+  for (vtkSegment* segment : segments)
+    {
+    vtkSmartPointer<vtkSegment> workSegment = vtkSmartPointer<vtkSegment>::New();
+    workSegment->DeepCopyMetadata(segment);
+    vtkDataObject* workTargetRepresentation = nullptr;
+    std::vector<std::string> representationNames;
+    segment->GetContainedRepresentationNames(representationNames);
+    for (const std::string& representationName : representationNames)
+      {
+      vtkDataObject* representation = segment->GetRepresentation(representationName);
+      vtkSmartPointer<vtkDataObject> workRepresentation = vtkSmartPointer<vtkDataObject>::Take(representation->NewInstance());
+      workRepresentation->ShallowCopy(representation);
+      // Compute cached bounds and scalar range now, as they would be computed concurrently
+      // in the threads otherwise
+      vtkDataSet* workDataSet = vtkDataSet::SafeDownCast(workRepresentation);
+      if (workDataSet)
+        {
+        workDataSet->GetBounds();
+        workDataSet->GetScalarRange();
+        }
+      workSegment->AddRepresentation(representationName, workRepresentation);
+      if (representationName == targetRepresentationName)
+        {
+        workTargetRepresentation = workRepresentation;
+        }
+      }
+    workSegments.push_back(workSegment);
+    workTargetRepresentations.push_back(workTargetRepresentation);
+    }
+
+  ParallelConversionInfo info;
+  info.Rule = rule;
+  info.WorkSegments = &workSegments;
+  info.NextSegmentIndex = 0;
+
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  threader->SetSingleMethod(ParallelConversionThreadFunction, &info);
+  threader->SingleMethodExecute();
+
+  // Store conversion results in the segments in the original order
+  for (size_t segmentIndex = 0; segmentIndex < segments.size(); ++segmentIndex)
+    {
+    vtkSegment* segment = segments[segmentIndex];
+    vtkSegment* workSegment = workSegments[segmentIndex];
+    vtkDataObject* workTargetRepresentation = workSegment->GetRepresentation(targetRepresentationName);
+    if (!workTargetRepresentation)
+      {
+      continue;
+      }
+    vtkDataObject* targetRepresentation = segment->GetRepresentation(targetRepresentationName);
+    if (targetRepresentation && workTargetRepresentation == workTargetRepresentations[segmentIndex])
+      {
+      // The rule updated the existing target representation
+      targetRepresentation->ShallowCopy(workTargetRepresentation);
+      }
+    else
+      {
+      segment->AddRepresentation(targetRepresentationName, workTargetRepresentation);
+      }
+    if (segment->GetLabelValue() != workSegment->GetLabelValue())
+      {
+      segment->SetLabelValue(workSegment->GetLabelValue());
+      }
+    }
+}
+
 //-----------------------------------------------------------------------------
 bool vtkSegmentation::ConvertSegmentUsingPath(vtkSegment* segment, vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting/*=false*/)
 {
@@ -2269,6 +2401,40 @@ std::vector<std::string> vtkSegmentation::GetSegmentIDsForDataObject(vtkDataObje
 }
 
 //----------------------------------------------------------------------------
+namespace
+{
+/// Create a binary labelmap (unsigned char, value 1) that contains the voxels of the specified
+/// label value in the labelmap. The output extent is the specified extent.
+vtkSmartPointer<vtkOrientedImageData> ExtractLabelAsBinaryLabelmap(vtkOrientedImageData* labelmap, int labelValue, const int extent[6])
+{
+  vtkSmartPointer<vtkOrientedImageData> binaryLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+  if (!labelmap)
+    {
+    return binaryLabelmap;
+    }
+  vtkNew<vtkMatrix4x4> imageToWorldMatrix;
+  labelmap->GetImageToWorldMatrix(imageToWorldMatrix);
+  binaryLabelmap->SetGeometryFromImageToWorldMatrix(imageToWorldMatrix);
+  binaryLabelmap->SetExtent(const_cast<int*>(extent));
+  binaryLabelmap->AllocateScalars(VTK_UNSIGNED_CHAR, 1);
+  vtkOrientedImageDataResample::FillImage(binaryLabelmap, 0);
+  vtkOrientedImageDataResample::CopyLabelValue(labelmap, labelValue, binaryLabelmap, 1, extent);
+  return binaryLabelmap;
+}
+
+/// Layer that is built during CollapseBinaryLabelmaps
+struct CollapsedLayer
+{
+  vtkSmartPointer<vtkOrientedImageData> Labelmap;
+  std::vector<std::string> SegmentIds;
+  /// Effective extent of each label in the layer, used for quickly ruling out overlap
+  std::vector<std::array<int, 6> > OccupiedExtents;
+  /// Largest label value used in the layer
+  int MaximumLabelValue{ 0 };
+};
+}
+
+//---------------------------------------------------------------------------
 void vtkSegmentation::CollapseBinaryLabelmaps(bool forceToSingleLayer/*=false*/)
 {
   std::string labelmapRepresentationName = vtkSegmentationConverter::GetBinaryLabelmapRepresentationName();
@@ -2288,104 +2454,119 @@ void vtkSegmentation::CollapseBinaryLabelmaps(bool forceToSingleLayer/*=false*/)
     return;
     }
 
-  typedef std::pair<vtkSmartPointer<vtkOrientedImageData>, std::vector<std::string> > LayerType;
-  typedef std::vector<LayerType> LayerListType;
+  // Each segment is added to the first layer that it does not overlap with.
+  // Effective extents of all labels of a layer are computed in a single pass. Voxels are only compared
+  // where the extent of the segment intersects the extent of a label that is already in the new layer,
+  // and the segment is copied into the new layer directly, without creating full-size intermediate images.
   std::map<std::string, int> newLabelmapValues;
-  LayerListType newLayers;
+  std::vector<CollapsedLayer> newLayers;
+  std::map<int, std::array<int, 6> > labelEffectiveExtents;
   for (int i = 0; i < numberOfLayers; ++i)
     {
     vtkOrientedImageData* layerLabelmap = vtkOrientedImageData::SafeDownCast(this->GetLayerDataObject(i, labelmapRepresentationName));
     std::vector<std::string> currentLayerSegmentIds = this->GetSegmentIDsForLayer(i, labelmapRepresentationName);
+    vtkOrientedImageDataResample::CalculateEffectiveExtentsForLabels(layerLabelmap, labelEffectiveExtents);
     if (i == 0)
       {
-      vtkSmartPointer<vtkOrientedImageData> newLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
-      newLabelmap->DeepCopy(layerLabelmap);
-      newLayers.push_back( std::make_pair(newLabelmap, currentLayerSegmentIds));
+      CollapsedLayer newLayer;
+      newLayer.Labelmap = vtkSmartPointer<vtkOrientedImageData>::New();
+      newLayer.Labelmap->DeepCopy(layerLabelmap);
+      newLayer.SegmentIds = currentLayerSegmentIds;
+      for (const std::pair<const int, std::array<int, 6> >& labelEffectiveExtent : labelEffectiveExtents)
+        {
+        newLayer.OccupiedExtents.push_back(labelEffectiveExtent.second);
+        newLayer.MaximumLabelValue = std::max(newLayer.MaximumLabelValue, labelEffectiveExtent.first);
+        }
       for (std::string currentSegmentId : currentLayerSegmentIds)
         {
         vtkSegment* segment = this->GetSegment(currentSegmentId);
         newLabelmapValues[currentSegmentId] = segment->GetLabelValue();
+        // Segments that have no filled voxels in the labelmap still reserve their label value
+        newLayer.MaximumLabelValue = std::max(newLayer.MaximumLabelValue, segment->GetLabelValue());
         }
+      newLayers.push_back(newLayer);
       continue;
       }
 
     for (std::string currentSegmentId : currentLayerSegmentIds)
       {
       vtkSegment* currentSegment = this->GetSegment(currentSegmentId);
-      vtkOrientedImageData* currentLabelmap = vtkOrientedImageData::SafeDownCast(currentSegment->GetRepresentation(labelmapRepresentationName));
-
-      vtkSmartPointer<vtkOrientedImageData> thresholdedLabelmap = vtkSmartPointer<vtkOrientedImageData>::New();
-      if (currentLabelmap)
+      int currentLabelValue = currentSegment->GetLabelValue();
+      int currentExtent[6] = { 0, -1, 0, -1, 0, -1 };
+      std::map<int, std::array<int, 6> >::iterator labelEffectiveExtentIt = labelEffectiveExtents.find(currentLabelValue);
+      if (labelEffectiveExtentIt != labelEffectiveExtents.end())
         {
-        vtkNew<vtkImageThreshold> imageThreshold;
-        imageThreshold->SetInputData(currentLabelmap);
-        imageThreshold->ThresholdBetween(currentSegment->GetLabelValue(), currentSegment->GetLabelValue());
-        imageThreshold->SetInValue(1);
-        imageThreshold->SetOutValue(0);
-        imageThreshold->SetOutputScalarTypeToUnsignedChar();
-        imageThreshold->Update();
-
-        thresholdedLabelmap->ShallowCopy(imageThreshold->GetOutput());
-        thresholdedLabelmap->CopyDirections(currentLabelmap);
-
-        int effectiveExtent[6] = { 0 };
-        vtkOrientedImageDataResample::CalculateEffectiveExtent(thresholdedLabelmap, effectiveExtent);
-
-        vtkNew<vtkOrientedImageData> referenceImage;
-        referenceImage->ShallowCopy(thresholdedLabelmap);
-        referenceImage->SetExtent(effectiveExtent);
-
-        vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(thresholdedLabelmap, referenceImage, thresholdedLabelmap);
+        std::copy(labelEffectiveExtentIt->second.begin(), labelEffectiveExtentIt->second.end(), currentExtent);
         }
+      bool currentSegmentEmpty = (currentExtent[0] > currentExtent[1] || currentExtent[2] > currentExtent[3] || currentExtent[4] > currentExtent[5]);
 
       bool shared = false;
-      int layerCount = 0;
-      for (LayerType newLayer : newLayers)
+      for (CollapsedLayer& newLayer : newLayers)
         {
-        vtkOrientedImageData* newLayerLabelmap = newLayer.first;
-        bool safeToMerge = true;
-        if (currentLabelmap)
+        // Segment voxels, in the geometry of the new layer
+        vtkOrientedImageData* segmentLabelmap = layerLabelmap;
+        int segmentLabelValue = currentLabelValue;
+        int segmentExtent[6] = { 0, -1, 0, -1, 0, -1 };
+        std::copy(currentExtent, currentExtent + 6, segmentExtent);
+        vtkSmartPointer<vtkOrientedImageData> resampledSegmentLabelmap;
+        if (!currentSegmentEmpty && !vtkOrientedImageDataResample::DoGeometriesMatch(layerLabelmap, newLayer.Labelmap))
           {
-          safeToMerge = !vtkOrientedImageDataResample::IsLabelInMask(newLayerLabelmap, thresholdedLabelmap);
+          // Only the effective extent of the segment is resampled
+          resampledSegmentLabelmap = ExtractLabelAsBinaryLabelmap(layerLabelmap, currentLabelValue, currentExtent);
+          vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(resampledSegmentLabelmap,
+            newLayer.Labelmap, resampledSegmentLabelmap, false, true);
+          vtkOrientedImageDataResample::CalculateEffectiveExtent(resampledSegmentLabelmap, segmentExtent);
+          segmentLabelmap = resampledSegmentLabelmap;
+          segmentLabelValue = 1;
           }
 
-        if (safeToMerge)
+        bool safeToMerge = true;
+        for (const std::array<int, 6>& occupiedExtent : newLayer.OccupiedExtents)
           {
-          shared = true;
-          int labelValue = this->GetUniqueLabelValueForSharedLabelmap(newLayerLabelmap);
-          for (std::string layerSegmentID : newLayer.second)
+          int overlapExtent[6] = { 0, -1, 0, -1, 0, -1 };
+          for (int axis = 0; axis < 3; ++axis)
             {
-            // GetUniqueLabelValueForSharedLabelmap(vtkOrientedImageData) only checks the existing scalars in the labelmap.
-            // If there are shared labelmaps in the new layer that do not have filled voxels in the labelmap, then the result of
-            // GetUniqueLabelValueForSharedLabelmap may not be unique. Instead, we compare the label value of all of the segments in the
-            // new layer to make sure the value is unique.
-            int existingValue = newLabelmapValues[layerSegmentID];
-            labelValue = std::max(labelValue, existingValue + 1);
+            overlapExtent[2 * axis] = std::max(segmentExtent[2 * axis], occupiedExtent[2 * axis]);
+            overlapExtent[2 * axis + 1] = std::min(segmentExtent[2 * axis + 1], occupiedExtent[2 * axis + 1]);
             }
-
-          if (currentLabelmap)
+          if (vtkOrientedImageDataResample::IsLabelValueInImage(segmentLabelmap, segmentLabelValue, newLayer.Labelmap, overlapExtent))
             {
-            int extent[6] = { 0 };
-            currentLabelmap->GetExtent(extent);
-            // If the current labelmap is empty, we don't need to merge the image.
-            if (extent[0] <= extent[1] || extent[2] <= extent[3] || extent[4] <= extent[5])
-              {
-              vtkOrientedImageDataResample::CastImageForValue(newLayerLabelmap, labelValue);
-              vtkOrientedImageDataResample::ResampleOrientedImageToReferenceOrientedImage(thresholdedLabelmap,
-                newLayerLabelmap, thresholdedLabelmap, false, true);
-              vtkOrientedImageDataResample::MergeImage(newLayerLabelmap, thresholdedLabelmap, newLayerLabelmap,
-                vtkOrientedImageDataResample::OPERATION_MASKING, thresholdedLabelmap->GetExtent(), 0.0, labelValue); // Add segment to new layer
-              }
+            safeToMerge = false;
+            break;
             }
-          newLayers[layerCount].second.push_back(currentSegmentId);
-          newLabelmapValues[currentSegmentId] = labelValue;
-          break;
           }
-        ++layerCount;
+        if (!safeToMerge)
+          {
+          continue;
+          }
+
+        // Label value is unique among the label values stored in the layer and the segments added to the layer.
+        shared = true;
+        int labelValue = newLayer.MaximumLabelValue + 1;
+        if (segmentExtent[0] <= segmentExtent[1] && segmentExtent[2] <= segmentExtent[3] && segmentExtent[4] <= segmentExtent[5])
+          {
+          vtkOrientedImageDataResample::PadImageToContainImage(newLayer.Labelmap, segmentLabelmap, newLayer.Labelmap, segmentExtent);
+          vtkOrientedImageDataResample::CastImageForValue(newLayer.Labelmap, labelValue);
+          vtkOrientedImageDataResample::CopyLabelValue(segmentLabelmap, segmentLabelValue, newLayer.Labelmap, labelValue, segmentExtent);
+          std::array<int, 6> occupiedExtent = { { segmentExtent[0], segmentExtent[1], segmentExtent[2],
+            segmentExtent[3], segmentExtent[4], segmentExtent[5] } };
+          newLayer.OccupiedExtents.push_back(occupiedExtent);
+          }
+        newLayer.MaximumLabelValue = labelValue;
+        newLayer.SegmentIds.push_back(currentSegmentId);
+        newLabelmapValues[currentSegmentId] = labelValue;
+        break;
         }
       if (!shared)
         {
-        newLayers.push_back(std::make_pair(thresholdedLabelmap, std::vector<std::string>({ currentSegmentId })));
+        CollapsedLayer newLayer;
+        newLayer.Labelmap = ExtractLabelAsBinaryLabelmap(layerLabelmap, currentLabelValue, currentExtent);
+        newLayer.SegmentIds.push_back(currentSegmentId);
+        std::array<int, 6> occupiedExtent = { { currentExtent[0], currentExtent[1], currentExtent[2],
+          currentExtent[3], currentExtent[4], currentExtent[5] } };
+        newLayer.OccupiedExtents.push_back(occupiedExtent);
+        newLayer.MaximumLabelValue = 1;
+        newLayers.push_back(newLayer);
         newLabelmapValues[currentSegmentId] = 1;
         }
       }
@@ -2394,15 +2575,15 @@ void vtkSegmentation::CollapseBinaryLabelmaps(bool forceToSingleLayer/*=false*/)
   // Although the labelmaps have been collapsed, the individual segment contents should not have been modified.
   // Don't invoke a MasterRepresentation modified event, since that would invalidate the derived representations.
   bool wasMasterRepresentationModifiedEnabled = this->SetMasterRepresentationModifiedEnabled(false);
-  for (LayerType newLayer : newLayers)
+  for (CollapsedLayer& newLayer : newLayers)
     {
-    for (std::string segmentId : newLayer.second)
+    for (std::string segmentId : newLayer.SegmentIds)
       {
       vtkSegment* segment = this->GetSegment(segmentId);
-      segment->AddRepresentation(labelmapRepresentationName, newLayer.first);
+      segment->AddRepresentation(labelmapRepresentationName, newLayer.Labelmap);
       segment->SetLabelValue(newLabelmapValues[segmentId]);
       }
-    newLayer.first->Modified();
+    newLayer.Labelmap->Modified();
     }
   this->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
 }
@@ -461,6 +461,25 @@ public:
   /// the segmentation! Use \sa CreateRepresentation for that.
   virtual void SetMasterRepresentationName(const std::string& representationName);
 
+  /// Number of threads used for converting segments.
+  /// Segments are converted in parallel only if the conversion rule is thread-safe
+  /// (\sa vtkSegmentationConverterRule::IsThreadSafe). Pre- and post-conversion steps always
+  /// run in the calling thread and the result does not depend on the number of threads.
+  /// 1 (default): segments are converted one by one in the calling thread.
+  /// 0: number of threads is set to the number of processors.
+  vtkGetMacro(NumberOfConversionThreads, int);
+  vtkSetClampMacro(NumberOfConversionThreads, int, 0, VTK_INT_MAX);
+
+  /// Size of the blocks (in voxels along each axis) that binary labelmaps are grown by when voxels are added
+  /// to a segment (\sa vtkSegmentationModifier::ModifyBinaryLabelmap). Consecutive small additions in the same
+  /// region (such as paint strokes) then do not require reallocating and copying the segment labelmap.
+  /// This reduces the cost of edits, the labelmap is still stored as one image: padding is removed after
+  /// adding voxels if it gets larger than the blocks containing the segment, and any other modification
+  /// shrinks the labelmap to its effective extent.
+  /// 1: labelmaps are always shrunk to their effective extent. Default is 32.
+  vtkGetMacro(LabelmapBlockSize, int);
+  vtkSetClampMacro(LabelmapBlockSize, int, 1, VTK_INT_MAX);
+
   /// Deep copies source segment to destination segment. If the same representation is found in baseline
   /// with up-to-date timestamp then the representation is reused from baseline.
   static void CopySegment(vtkSegment* destination, vtkSegment* source, vtkSegment* baseline,
@@ -469,6 +488,11 @@ public:
 protected:
   bool ConvertSegmentsUsingPath(std::vector<std::string> segmentIDs, vtkSegmentationConverter::ConversionPathType path, bool overwriteExisting = false);
 
+  /// Convert segments using a thread-safe conversion rule in multiple threads.
+  /// Each segment is converted in a temporary copy that shares the representations, then
+  /// the converted representations are added to the segments in the calling thread.
+  void ConvertSegmentsInParallel(vtkSegmentationConverterRule* rule, std::vector<vtkSegment*>& segments, int numberOfThreads);
+
   /// Convert given segment along a specified path
   /// \param segment Segment to convert
   /// \param path Path to do the conversion along
@@ -550,6 +574,12 @@ protected:
 
   std::set<vtkSmartPointer<vtkDataObject> > MasterRepresentationCache;
 
+  /// Number of threads used for converting segments
+  int NumberOfConversionThreads;
+
+  /// Size of the blocks that binary labelmaps are grown by when voxels are added
+  int LabelmapBlockSize;
+
   friend class vtkMRMLSegmentationNode;
   friend class vtkSlicerSegmentationsModuleLogic;
   friend class vtkSegmentationModifier;
@@ -90,13 +90,25 @@ void vtkSegmentationConverterRule::SetConversionParameter(const std::string& nam
 //----------------------------------------------------------------------------
 std::string vtkSegmentationConverterRule::GetConversionParameter(const std::string& name)
 {
-  return this->ConversionParameters[name].first;
+  // Parameters are only looked up (not inserted) so that this method can be
+  // used by thread-safe rules in Convert
+  ConversionParameterListType::const_iterator paramIt = this->ConversionParameters.find(name);
+  if (paramIt == this->ConversionParameters.end())
+    {
+    return "";
+    }
+  return paramIt->second.first;
 }
 
 //----------------------------------------------------------------------------
 std::string vtkSegmentationConverterRule::GetConversionParameterDescription(const std::string& name)
 {
-  return this->ConversionParameters[name].second;
+  ConversionParameterListType::const_iterator paramIt = this->ConversionParameters.find(name);
+  if (paramIt == this->ConversionParameters.end())
+    {
+    return "";
+    }
+  return paramIt->second.second;
 }
 
 //----------------------------------------------------------------------------
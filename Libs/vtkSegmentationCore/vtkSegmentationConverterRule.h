@@ -92,6 +92,13 @@ public:
   /// \sa ConvertInternal
   virtual bool Convert(vtkSegment* segment) = 0;
 
+  /// Determine if Convert can be called concurrently from multiple threads for different segments.
+  /// In that case Convert is called on temporary segments that share (shallow copy) the representations
+  /// of the segments in the segmentation, and it must not modify the rule itself.
+  /// PreConvert and PostConvert are always called from the calling thread.
+  /// False by default.
+  virtual bool IsThreadSafe() { return false; };
+
   /// Perform post-conversion steps across the specified segments in the segmentation
   /// This step should be unneccessary if only converting a single segment
   virtual bool PostConvert(vtkSegmentation* vtkNotUsed(segmentation)) { return true; };
@@ -33,6 +33,7 @@
 
 // STD includes
 #include <algorithm>
+#include <cmath>
 
 vtkStandardNewMacro(vtkSegmentationModifier);
 
@@ -97,8 +98,18 @@ bool vtkSegmentationModifier::ModifyBinaryLabelmap(
     return false;
     }
 
-  // Shrink the image data extent to only contain the effective data (extent of non-zero voxels)
-  vtkSegmentationModifier::ShrinkSegmentToEffectiveExtent(segmentLabelmap);
+  // Shrink the image data extent to only contain the effective data (extent of non-zero voxels).
+  // If voxels were only added then the labelmap was grown by whole blocks and it is kept that way,
+  // so that subsequent additions in the same blocks (such as paint strokes) do not reallocate it.
+  // The padding is still removed once it becomes larger than the segment itself.
+  if (mergeMode != MODE_MERGE_MAX || segmentation->GetLabelmapBlockSize() <= 1)
+    {
+    vtkSegmentationModifier::ShrinkSegmentToEffectiveExtent(segmentLabelmap);
+    }
+  else
+    {
+    vtkSegmentationModifier::ShrinkSegmentPadding(segmentLabelmap, segmentation->GetLabelmapBlockSize());
+    }
 
   // Re-enable master representation modified event
   segmentation->SetMasterRepresentationModifiedEnabled(wasMasterRepresentationModifiedEnabled);
@@ -350,6 +361,12 @@ bool vtkSegmentationModifier::AppendLabelmapToSegment(vtkOrientedImageData* labe
       vtkOrientedImageDataResample::ApplyImageMask(modifierLabelmap, segmentMask, modifierLabelmap->GetScalarTypeMax());
       }
 
+    if (operation == vtkOrientedImageDataResample::OPERATION_MAXIMUM && resampledSegmentLabelmap == segmentLabelmap)
+      {
+      vtkSegmentationModifier::PadSegmentToContainModifierExtent(segmentLabelmap, modifierLabelmap, extent,
+        segmentation->GetLabelmapBlockSize());
+      }
+
     if (!vtkOrientedImageDataResample::MergeImage(
       resampledSegmentLabelmap, modifierLabelmap, segmentLabelmap, operation, extent, 0, labelValue, &segmentLabelmapModified))
       {
@@ -393,3 +410,104 @@ void vtkSegmentationModifier::ShrinkSegmentToEffectiveExtent(vtkOrientedImageDat
       }
     }
 }
+
+//-----------------------------------------------------------------------------
+void vtkSegmentationModifier::ShrinkSegmentPadding(vtkOrientedImageData* segmentLabelmap, int blockSize)
+{
+  int segmentExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  segmentLabelmap->GetExtent(segmentExtent);
+  if (segmentExtent[0] > segmentExtent[1] || segmentExtent[2] > segmentExtent[3] || segmentExtent[4] > segmentExtent[5])
+    {
+    return;
+    }
+
+  int effectiveExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkOrientedImageDataResample::CalculateEffectiveExtent(segmentLabelmap, effectiveExtent);
+  if (effectiveExtent[0] > effectiveExtent[1] || effectiveExtent[2] > effectiveExtent[3] || effectiveExtent[4] > effectiveExtent[5])
+    {
+    // Nothing to keep
+    vtkSegmentationModifier::ShrinkSegmentToEffectiveExtent(segmentLabelmap);
+    return;
+    }
+
+  // Padding that is within the blocks of the effective extent is expected, only padding
+  // beyond that is counted (for example the empty region of a diagonal paint stroke's bounding box).
+  int alignedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkSegmentationModifier::AlignExtentToBlocks(effectiveExtent, segmentExtent, blockSize, alignedExtent);
+  vtkIdType numberOfAllocatedVoxels = 1;
+  vtkIdType numberOfAlignedVoxels = 1;
+  for (int i = 0; i < 3; ++i)
+    {
+    numberOfAllocatedVoxels *= static_cast<vtkIdType>(segmentExtent[2 * i + 1] - segmentExtent[2 * i] + 1);
+    numberOfAlignedVoxels *= static_cast<vtkIdType>(alignedExtent[2 * i + 1] - alignedExtent[2 * i] + 1);
+    }
+  if (numberOfAllocatedVoxels - numberOfAlignedVoxels <= numberOfAlignedVoxels)
+    {
+    return;
+    }
+
+  vtkSmartPointer<vtkImageConstantPad> padder = vtkSmartPointer<vtkImageConstantPad>::New();
+  padder->SetInputData(segmentLabelmap);
+  padder->SetOutputWholeExtent(alignedExtent);
+  padder->Update();
+  segmentLabelmap->ShallowCopy(padder->GetOutput());
+}
+
+//-----------------------------------------------------------------------------
+void vtkSegmentationModifier::AlignExtentToBlocks(const int extent[6], const int boundingExtent[6], int blockSize, int alignedExtent[6])
+{
+  blockSize = std::max(1, blockSize);
+  for (int i = 0; i < 3; ++i)
+    {
+    int firstBlock = static_cast<int>(std::floor(static_cast<double>(extent[2 * i]) / blockSize));
+    int lastBlock = static_cast<int>(std::floor(static_cast<double>(extent[2 * i + 1]) / blockSize));
+    alignedExtent[2 * i] = std::max(firstBlock * blockSize, boundingExtent[2 * i]);
+    alignedExtent[2 * i + 1] = std::min((lastBlock + 1) * blockSize - 1, boundingExtent[2 * i + 1]);
+    }
+}
+
+//-----------------------------------------------------------------------------
+void vtkSegmentationModifier::PadSegmentToContainModifierExtent(vtkOrientedImageData* segmentLabelmap,
+  vtkOrientedImageData* modifierLabelmap, const int extent[6], int blockSize)
+{
+  int modifierExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  modifierLabelmap->GetExtent(modifierExtent);
+  const int* modifiedExtent = extent ? extent : modifierExtent;
+  if (modifiedExtent[0] > modifiedExtent[1] || modifiedExtent[2] > modifiedExtent[3] || modifiedExtent[4] > modifiedExtent[5])
+    {
+    return;
+    }
+
+  int segmentExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  segmentLabelmap->GetExtent(segmentExtent);
+  if (segmentExtent[0] > segmentExtent[1] || segmentExtent[2] > segmentExtent[3] || segmentExtent[4] > segmentExtent[5])
+    {
+    // Empty segment labelmap is allocated when merging
+    return;
+    }
+
+  // The segment labelmap may only grow within the modifier labelmap (typically the reference geometry)
+  int requiredExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  int boundingExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  bool paddingRequired = false;
+  for (int i = 0; i < 3; ++i)
+    {
+    requiredExtent[2 * i] = std::min(modifiedExtent[2 * i], segmentExtent[2 * i]);
+    requiredExtent[2 * i + 1] = std::max(modifiedExtent[2 * i + 1], segmentExtent[2 * i + 1]);
+    boundingExtent[2 * i] = std::min(modifierExtent[2 * i], requiredExtent[2 * i]);
+    boundingExtent[2 * i + 1] = std::max(modifierExtent[2 * i + 1], requiredExtent[2 * i + 1]);
+    if (requiredExtent[2 * i] < segmentExtent[2 * i] || requiredExtent[2 * i + 1] > segmentExtent[2 * i + 1])
+      {
+      paddingRequired = true;
+      }
+    }
+  if (!paddingRequired)
+    {
+    // Modified region is already allocated
+    return;
+    }
+
+  int alignedExtent[6] = { 0, -1, 0, -1, 0, -1 };
+  vtkSegmentationModifier::AlignExtentToBlocks(requiredExtent, boundingExtent, blockSize, alignedExtent);
+  vtkOrientedImageDataResample::PadImageToContainImage(segmentLabelmap, modifierLabelmap, segmentLabelmap, alignedExtent);
+}
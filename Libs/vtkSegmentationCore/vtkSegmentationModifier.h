@@ -45,7 +45,11 @@ public:
   /// Set a labelmap image as binary labelmap representation into the segment defined by the segmentation node and segment ID.
   /// Master representation must be binary labelmap! Master representation changed event is disabled to prevent deletion of all
   /// other representation in all segments. The other representations in the given segment are re-converted. The extent of the
-  /// segment binary labelmap is shrunk to the effective extent. Display update is triggered.
+  /// segment binary labelmap is shrunk to the effective extent, except when voxels are only added (MODE_MERGE_MAX): then the
+  /// extent is grown by whole blocks (see vtkSegmentation::SetLabelmapBlockSize) so that consecutive edits in the same region
+  /// do not reallocate and copy the labelmap. This reduces the cost of edits, not the memory usage: the labelmap remains a
+  /// single contiguous image. The padding is removed (down to whole blocks around the non-zero voxels) when it exceeds the
+  /// size of the block-aligned non-zero region. Display update is triggered.
   /// \param mergeMode Determines if the labelmap should replace the segment, combined with a maximum or minimum operation, or set under the mask.
   /// \param extent If extent is specified then only that extent of the labelmap is used.
   enum
@@ -69,11 +73,24 @@ public:
     std::vector<std::string>& segmentIDs, int maskThreshold = 0.0, bool includeInputSharedSegmentID = false);
 
 protected:
+  /// Round extent outwards to a grid of blockSize voxels, while keeping it within boundingExtent.
+  /// boundingExtent must contain extent.
+  static void AlignExtentToBlocks(const int extent[6], const int boundingExtent[6], int blockSize, int alignedExtent[6]);
+
+  /// Pad the segment labelmap by whole blocks so that it contains the modified region.
+  /// Modifier labelmap must have the same geometry as the segment labelmap.
+  static void PadSegmentToContainModifierExtent(vtkOrientedImageData* segmentLabelmap, vtkOrientedImageData* modifierLabelmap,
+    const int extent[6], int blockSize);
+
   static bool AppendLabelmapToSegment(vtkOrientedImageData* labelmap, vtkSegmentation* segmentation, std::string segmentID, int mergeMode, const int extent[6],
     bool minimumOfAllSegments, std::vector<std::string>* modifiedSegmentIDs, bool& segmentLabelmapModified);
 
   static void ShrinkSegmentToEffectiveExtent(vtkOrientedImageData* segmentLabelmap);
 
+  /// Crop the segment labelmap to whole blocks around its non-zero voxels if the padding outside
+  /// these blocks is larger than the blocks themselves.
+  static void ShrinkSegmentPadding(vtkOrientedImageData* segmentLabelmap, int blockSize);
+
   static bool SharedLabelmapShouldOverlap(vtkSegmentation* segmentation, std::string segmentID, std::vector<std::string>& segmentIDsToOverwrite);
 
   static void SeparateModifiedSegmentFromSharedLabelmap(vtkOrientedImageData* labelmap, vtkSegmentation* segmentation, std::string segmentID,
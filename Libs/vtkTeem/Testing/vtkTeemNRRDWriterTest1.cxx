@@ -0,0 +1,115 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// vtkTeem includes
+#include <vtkTeemNRRDReader.h>
+#include <vtkTeemNRRDWriter.h>
+
+// VTK includes
+#include <vtkImageData.h>
+#include <vtkNew.h>
+#include <vtkPointData.h>
+#include <vtkTimerLog.h>
+
+// STD includes
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+bool WriteAndReadImage(vtkImageData* image, const std::string& fileName, int numberOfThreads)
+{
+  vtkNew<vtkTeemNRRDWriter> writer;
+  writer->SetFileName(fileName.c_str());
+  writer->SetInputData(image);
+  writer->SetUseCompression(1);
+  writer->SetCompressionLevel(1);
+  writer->SetNumberOfThreads(numberOfThreads);
+
+  vtkNew<vtkTimerLog> timer;
+  timer->StartTimer();
+  writer->Write();
+  timer->StopTimer();
+  if (writer->GetWriteError())
+    {
+    std::cerr << "Failed to write " << fileName << " using " << numberOfThreads << " threads" << std::endl;
+    return false;
+    }
+  std::cout << "<DartMeasurement name=\"vtkTeemNRRDWriter-CompressedWritePerformance-"
+            << numberOfThreads << "\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  vtkNew<vtkTeemNRRDReader> reader;
+  reader->SetFileName(fileName.c_str());
+  reader->Update();
+  if (reader->GetReadStatus())
+    {
+    std::cerr << "Failed to read " << fileName << std::endl;
+    return false;
+    }
+  vtkImageData* readImage = reader->GetOutput();
+  int* dimensions = image->GetDimensions();
+  int* readDimensions = readImage->GetDimensions();
+  if (dimensions[0] != readDimensions[0] || dimensions[1] != readDimensions[1] || dimensions[2] != readDimensions[2]
+    || readImage->GetScalarType() != image->GetScalarType())
+    {
+    std::cerr << "Image read from " << fileName << " does not match the written image" << std::endl;
+    return false;
+    }
+  size_t dataSize = static_cast<size_t>(image->GetPointData()->GetScalars()->GetDataSize()) * image->GetScalarSize();
+  if (memcmp(image->GetScalarPointer(), readImage->GetScalarPointer(), dataSize) != 0)
+    {
+    std::cerr << "Voxels read from " << fileName << " do not match the written voxels" << std::endl;
+    return false;
+    }
+  return true;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkTeemNRRDWriterTest1(int argc, char* argv[])
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: " << argv[0] << " /path/to/temp" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string tempDir = argv[1];
+
+  // Image is larger than a compression block, so that it is compressed in multiple blocks
+  vtkNew<vtkImageData> image;
+  image->SetDimensions(256, 256, 40);
+  image->AllocateScalars(VTK_SHORT, 1);
+  short* voxels = static_cast<short*>(image->GetScalarPointer());
+  vtkIdType numberOfVoxels = image->GetNumberOfPoints();
+  for (vtkIdType i = 0; i < numberOfVoxels; ++i)
+    {
+    voxels[i] = static_cast<short>((i * 7) % 1000 + (i / 5000));
+    }
+
+  if (!WriteAndReadImage(image, tempDir + "/vtkTeemNRRDWriterTest1_1.nrrd", 1)
+    || !WriteAndReadImage(image, tempDir + "/vtkTeemNRRDWriterTest1_4.nrrd", 4)
+    || !WriteAndReadImage(image, tempDir + "/vtkTeemNRRDWriterTest1_auto.nrrd", 0)
+    || !WriteAndReadImage(image, tempDir + "/vtkTeemNRRDWriterTest1_4.nhdr", 4))
+    {
+    return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
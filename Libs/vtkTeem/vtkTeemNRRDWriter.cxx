@@ -7,19 +7,122 @@
 #include "vtkPointData.h"
 #include "vtkObjectFactory.h"
 #include "vtkInformation.h"
+#include <vtkMultiThreader.h>
 #include <vtkVersion.h>
+#include <vtk_zlib.h>
+#include <vtksys/SystemTools.hxx>
 
 #include <vnl/vnl_math.h>
 #include <vnl/vnl_double_3.h>
 
 #include "itkNumberToString.h"
 
+#include <algorithm>
+#include <atomic>
+#include <vector>
 
 class AttributeMapType: public std::map<std::string, std::string> {};
 class AxisInfoMapType : public std::map<unsigned int, std::string> {};
 
 vtkStandardNewMacro(vtkTeemNRRDWriter);
 
+namespace
+{
+/// Size of the data blocks that are compressed independently
+const size_t CompressionBlockSize = 1 << 20;
+/// Maximum size of the deflate history, used for priming the compression of a block with the preceding data
+const size_t DeflateDictionarySize = 1 << 15;
+
+struct CompressedBlock
+{
+  std::vector<unsigned char> Data;
+  uLong Crc{0};
+  size_t UncompressedSize{0};
+  bool Success{false};
+};
+
+struct ParallelCompressionInfo
+{
+  const unsigned char* Data;
+  size_t DataSize;
+  size_t NumberOfBlocks;
+  int CompressionLevel;
+  size_t FirstBlock;
+  std::vector<CompressedBlock>* Blocks;
+  std::atomic<size_t> NextBlock;
+};
+
+//----------------------------------------------------------------------------
+// Compress a block as raw deflate data. All blocks except the last one are ended with a sync flush
+// so that the compressed blocks can be concatenated into a single deflate stream.
+void CompressBlock(ParallelCompressionInfo* info, size_t blockIndex, CompressedBlock& block)
+{
+  size_t blockStart = blockIndex * CompressionBlockSize;
+  size_t blockSize = std::min(CompressionBlockSize, info->DataSize - blockStart);
+  bool lastBlock = (blockIndex == info->NumberOfBlocks - 1);
+  const unsigned char* blockData = info->Data + blockStart;
+
+  block.UncompressedSize = blockSize;
+  block.Crc = crc32(crc32(0L, Z_NULL, 0), blockData, static_cast<uInt>(blockSize));
+  block.Success = false;
+
+  z_stream stream;
+  stream.zalloc = Z_NULL;
+  stream.zfree = Z_NULL;
+  stream.opaque = Z_NULL;
+  if (deflateInit2(&stream, info->CompressionLevel, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+    return;
+    }
+  if (blockStart > 0)
+    {
+    size_t dictionarySize = std::min(DeflateDictionarySize, blockStart);
+    deflateSetDictionary(&stream, blockData - dictionarySize, static_cast<uInt>(dictionarySize));
+    }
+  // deflateBound does not include the empty block written by the sync flush
+  block.Data.resize(deflateBound(&stream, static_cast<uLong>(blockSize)) + 16);
+  stream.next_in = const_cast<Bytef*>(blockData);
+  stream.avail_in = static_cast<uInt>(blockSize);
+  stream.next_out = block.Data.data();
+  stream.avail_out = static_cast<uInt>(block.Data.size());
+  int result = deflate(&stream, lastBlock ? Z_FINISH : Z_SYNC_FLUSH);
+  if (lastBlock)
+    {
+    block.Success = (result == Z_STREAM_END);
+    }
+  else
+    {
+    block.Success = (result == Z_OK && stream.avail_in == 0 && stream.avail_out > 0);
+    }
+  block.Data.resize(stream.total_out);
+  deflateEnd(&stream);
+}
+
+//----------------------------------------------------------------------------
+VTK_THREAD_RETURN_TYPE CompressBlocksThreadFunction(void* arg)
+{
+  vtkMultiThreader::ThreadInfo* threadInfo = static_cast<vtkMultiThreader::ThreadInfo*>(arg);
+  ParallelCompressionInfo* info = static_cast<ParallelCompressionInfo*>(threadInfo->UserData);
+  size_t blockIndex = 0;
+  while ((blockIndex = info->NextBlock++) < info->Blocks->size())
+    {
+    CompressBlock(info, info->FirstBlock + blockIndex, (*info->Blocks)[blockIndex]);
+    }
+  return VTK_THREAD_RETURN_VALUE;
+}
+
+//----------------------------------------------------------------------------
+void WriteLittleEndianUInt32(FILE* file, uLong value)
+{
+  unsigned char bytes[4] = {
+    static_cast<unsigned char>(value & 0xff),
+    static_cast<unsigned char>((value >> 8) & 0xff),
+    static_cast<unsigned char>((value >> 16) & 0xff),
+    static_cast<unsigned char>((value >> 24) & 0xff) };
+  fwrite(bytes, 1, 4, file);
+}
+}
+
 //----------------------------------------------------------------------------
 vtkTeemNRRDWriter::vtkTeemNRRDWriter()
 {
@@ -31,6 +134,7 @@ vtkTeemNRRDWriter::vtkTeemNRRDWriter()
   this->UseCompression = 1;
   // use default CompressionLevel
   this->CompressionLevel = -1;
+  this->NumberOfThreads = 0;
   this->DiffusionWeightedData = 0;
   this->FileType = VTK_BINARY;
   this->WriteErrorOff();
@@ -413,11 +517,31 @@ void vtkTeemNRRDWriter::WriteData()
   NrrdIoState *nio = nrrdIoStateNew();
 
   // set encoding for data: compressed (raw), (uncompressed) raw, or ascii
+  int numberOfCompressionThreads = 1;
   if ( this->GetUseCompression() && nrrdEncodingGzip->available() )
     {
     // this is necessarily gzip-compressed *raw* data
     nio->encoding = nrrdEncodingGzip;
     nio->zlibLevel = this->CompressionLevel;
+
+    numberOfCompressionThreads = this->NumberOfThreads;
+    if (numberOfCompressionThreads == 0)
+      {
+      numberOfCompressionThreads = vtkMultiThreader::GetGlobalDefaultNumberOfThreads();
+      }
+    // Data file name of detached headers is determined by teem, so only attached data is compressed in parallel
+    size_t dataSize = nrrdElementNumber(nrrd) * nrrdElementSize(nrrd);
+    std::string extension = vtksys::SystemTools::LowerCase(
+      vtksys::SystemTools::GetFilenameLastExtension(this->GetFileName()));
+    if (dataSize <= CompressionBlockSize || extension == ".nhdr")
+      {
+      numberOfCompressionThreads = 1;
+      }
+    if (numberOfCompressionThreads > 1)
+      {
+      // teem only writes the header, compressed data is appended after that
+      nio->skipData = AIR_TRUE;
+      }
     }
   else
     {
@@ -445,16 +569,100 @@ void vtkTeemNRRDWriter::WriteData()
                       << this->GetFileName() << ":\n" << err);
     this->WriteErrorOn();
     }
+  else if (numberOfCompressionThreads > 1 && !this->WriteCompressedDataInParallel(nrrd, numberOfCompressionThreads))
+    {
+    vtkErrorMacro("Write: Error writing compressed data to " << this->GetFileName());
+    this->WriteErrorOn();
+    }
   // Free the nrrd struct but don't touch nrrd->data
   nrrd = nrrdNix(nrrd);
   nio = nrrdIoStateNix(nio);
   return;
 }
 
+//----------------------------------------------------------------------------
+bool vtkTeemNRRDWriter::WriteCompressedDataInParallel(Nrrd* nrrd, int numberOfThreads)
+{
+  ParallelCompressionInfo info;
+  info.Data = static_cast<const unsigned char*>(nrrd->data);
+  info.DataSize = nrrdElementNumber(nrrd) * nrrdElementSize(nrrd);
+  info.NumberOfBlocks = (info.DataSize + CompressionBlockSize - 1) / CompressionBlockSize;
+  info.CompressionLevel = (this->CompressionLevel < 0 ? Z_DEFAULT_COMPRESSION : this->CompressionLevel);
+
+  // Data is separated from the header by an empty line
+  bool emptyLineWritten = false;
+  FILE* file = vtksys::SystemTools::Fopen(this->GetFileName(), "rb");
+  if (file)
+    {
+    char lastCharacters[2] = { 0, 0 };
+    if (fseek(file, -2, SEEK_END) == 0 && fread(lastCharacters, 1, 2, file) == 2)
+      {
+      emptyLineWritten = (lastCharacters[0] == '\n' && lastCharacters[1] == '\n');
+      }
+    fclose(file);
+    }
+  file = vtksys::SystemTools::Fopen(this->GetFileName(), "ab");
+  if (!file)
+    {
+    return false;
+    }
+  if (!emptyLineWritten)
+    {
+    fputc('\n', file);
+    }
+
+  // gzip header: magic number, deflate method, no flags, no modification time, unknown OS
+  const unsigned char gzipHeader[10] = { 0x1f, 0x8b, 8, 0, 0, 0, 0, 0, 0, 0xff };
+  fwrite(gzipHeader, 1, sizeof(gzipHeader), file);
+
+  // Compress a limited number of blocks at a time to limit memory usage
+  size_t numberOfBlocksInBatch = static_cast<size_t>(numberOfThreads) * 4;
+  std::vector<CompressedBlock> blocks;
+  uLong crc = crc32(0L, Z_NULL, 0);
+  bool success = true;
+  vtkNew<vtkMultiThreader> threader;
+  threader->SetNumberOfThreads(numberOfThreads);
+  for (size_t firstBlock = 0; success && firstBlock < info.NumberOfBlocks; firstBlock += numberOfBlocksInBatch)
+    {
+    blocks.resize(std::min(numberOfBlocksInBatch, info.NumberOfBlocks - firstBlock));
+    info.FirstBlock = firstBlock;
+    info.Blocks = &blocks;
+    info.NextBlock = 0;
+    threader->SetSingleMethod(CompressBlocksThreadFunction, &info);
+    threader->SingleMethodExecute();
+
+    // Write blocks in order
+    for (const CompressedBlock& block : blocks)
+      {
+      if (!block.Success || fwrite(block.Data.data(), 1, block.Data.size(), file) != block.Data.size())
+        {
+        success = false;
+        break;
+        }
+      crc = crc32_combine(crc, block.Crc, static_cast<z_off_t>(block.UncompressedSize));
+      }
+    }
+
+  // gzip trailer: CRC-32 and size of the uncompressed data modulo 2^32
+  WriteLittleEndianUInt32(file, crc);
+  WriteLittleEndianUInt32(file, static_cast<uLong>(info.DataSize & 0xffffffff));
+  if (ferror(file))
+    {
+    success = false;
+    }
+  fclose(file);
+  return success;
+}
+
+//----------------------------------------------------------------------------
 void vtkTeemNRRDWriter::PrintSelf(ostream& os, vtkIndent indent)
 {
   this->Superclass::PrintSelf(os,indent);
 
+  os << indent << "UseCompression: " << this->UseCompression << "\n";
+  os << indent << "CompressionLevel: " << this->CompressionLevel << "\n";
+  os << indent << "NumberOfThreads: " << this->NumberOfThreads << "\n";
+
   os << indent << "RAS to IJK Matrix: ";
      this->IJKToRASMatrix->PrintSelf(os,indent);
   os << indent << "Measurement frame: ";
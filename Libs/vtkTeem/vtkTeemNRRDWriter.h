@@ -58,6 +58,16 @@ public:
   vtkSetClampMacro(CompressionLevel, int, 0, 9);
   vtkGetMacro(CompressionLevel, int);
 
+  /// Number of threads used for compressing the data.
+  /// If more than one thread is used then the data is split into blocks that are compressed
+  /// independently and stored as a single standard gzip stream (similarly to pigz),
+  /// therefore the file can be read by any NRRD reader.
+  /// 0 (default): the number of threads is set to the number of processors.
+  /// 1: data is compressed by teem in the calling thread.
+  /// Parallel compression is not used for detached headers (.nhdr).
+  vtkSetClampMacro(NumberOfThreads, int, 0, VTK_INT_MAX);
+  vtkGetMacro(NumberOfThreads, int);
+
   vtkSetClampMacro(FileType,int,VTK_ASCII,VTK_BINARY);
   vtkGetMacro(FileType,int);
   void SetFileTypeToASCII() {this->SetFileType(VTK_ASCII);};
@@ -108,6 +118,11 @@ protected:
   /// Write method. It is called by vtkWriter::Write();
   void WriteData() override;
 
+  ///
+  /// Write gzip compressed data of the nrrd using multiple threads.
+  /// The header must be already written into the file.
+  bool WriteCompressedDataInParallel(Nrrd* nrrd, int numberOfThreads);
+
   ///
   /// Flag to set to on when a write error occurred
   int WriteError;
@@ -122,6 +137,7 @@ protected:
 
   int UseCompression;
   int CompressionLevel;
+  int NumberOfThreads;
   int FileType;
 
   AttributeMapType *Attributes;
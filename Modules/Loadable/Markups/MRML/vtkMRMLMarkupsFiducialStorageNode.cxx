@@ -21,12 +21,15 @@
 #include "vtkMRMLScene.h"
 #include "vtkSlicerVersionConfigure.h"
 
+#include "vtkByteSwap.h"
 #include "vtkObjectFactory.h"
 #include "vtkStringArray.h"
 #include <vtksys/SystemTools.hxx>
 
 #include "itkNumberToString.h"
 
+#include <cstring>
+#include <fstream>
 #include <sstream>
 
 // CSV table field indexes
@@ -213,6 +216,168 @@ protected:
   std::vector<std::string> Fields;
 };
 
+// Binary file format (.mrkb)
+//
+// All values are stored in little-endian byte order. Each block is padded to a multiple of 8 bytes.
+// Header:
+//   char[8] magic, uint32 version, int32 coordinate system, uint64 number of control points (N)
+// Columns:
+//   float64[N*3] position (in the coordinate system specified in the header)
+//   float64[N*9] orientation matrix
+//   int32[N] position status
+//   uint8[N] flags (selected, locked, visibility)
+//   string columns: id, label, description, associated node ID
+// String column:
+//   uint64[N+1] offsets, char[offsets[N]] characters (not zero-terminated)
+static const char MARKUPS_BINARY_MAGIC[8] = { 'S', 'l', 'M', 'r', 'k', 'B', 'i', 'n' };
+static const vtkTypeUInt32 MARKUPS_BINARY_VERSION = 1;
+static const unsigned char MARKUPS_BINARY_FLAG_SELECTED = 1;
+static const unsigned char MARKUPS_BINARY_FLAG_LOCKED = 2;
+static const unsigned char MARKUPS_BINARY_FLAG_VISIBILITY = 4;
+
+//------------------------------------------------------------------------------
+/// Write blocks of a markups binary file.
+class MarkupsBinaryWriter
+{
+public:
+  MarkupsBinaryWriter(std::ostream& stream) : Stream(stream), NumberOfBytesWritten(0) {}
+
+  /// Write values in little-endian byte order (values are byte swapped in place)
+  template<class T> void WriteArray(std::vector<T>& values)
+    {
+    if (!values.empty())
+      {
+      vtkByteSwap::SwapLERange(&values[0], values.size());
+      this->WriteBytes(reinterpret_cast<const char*>(&values[0]), values.size() * sizeof(T));
+      }
+    this->WritePadding();
+    }
+
+  template<class T> void WriteValue(T value)
+    {
+    vtkByteSwap::SwapLERange(&value, 1);
+    this->WriteBytes(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+  void WriteStringColumn(const std::vector<const std::string*>& strings)
+    {
+    std::vector<vtkTypeUInt64> offsets(strings.size() + 1);
+    offsets[0] = 0;
+    for (size_t i = 0; i < strings.size(); i++)
+      {
+      offsets[i + 1] = offsets[i] + strings[i]->size();
+      }
+    this->WriteArray(offsets);
+    for (const std::string* str : strings)
+      {
+      this->WriteBytes(str->c_str(), str->size());
+      }
+    this->WritePadding();
+    }
+
+  void WriteBytes(const char* data, size_t numberOfBytes)
+    {
+    this->Stream.write(data, numberOfBytes);
+    this->NumberOfBytesWritten += numberOfBytes;
+    }
+
+  void WritePadding()
+    {
+    static const char padding[8] = { 0 };
+    size_t paddingSize = (8 - this->NumberOfBytesWritten % 8) % 8;
+    this->WriteBytes(padding, paddingSize);
+    }
+
+protected:
+  std::ostream& Stream;
+  size_t NumberOfBytesWritten;
+};
+
+//------------------------------------------------------------------------------
+/// Read blocks of a markups binary file from a memory buffer.
+/// All methods return false if the buffer is too short.
+class MarkupsBinaryReader
+{
+public:
+  MarkupsBinaryReader(const char* buffer, size_t bufferSize) : Buffer(buffer), BufferSize(bufferSize), Position(0) {}
+
+  template<class T> bool ReadArray(std::vector<T>& values, size_t numberOfValues)
+    {
+    values.resize(numberOfValues);
+    if (numberOfValues > 0)
+      {
+      if (!this->ReadBytes(reinterpret_cast<char*>(&values[0]), numberOfValues * sizeof(T)))
+        {
+        return false;
+        }
+      vtkByteSwap::SwapLERange(&values[0], numberOfValues);
+      }
+    return this->SkipPadding();
+    }
+
+  template<class T> bool ReadValue(T& value)
+    {
+    if (!this->ReadBytes(reinterpret_cast<char*>(&value), sizeof(T)))
+      {
+      return false;
+      }
+    vtkByteSwap::SwapLERange(&value, 1);
+    return true;
+    }
+
+  /// Get offsets and a pointer to the characters of a string column.
+  /// The i-th string is characters[offsets[i]] ... characters[offsets[i+1]-1].
+  bool ReadStringColumn(size_t numberOfStrings, std::vector<vtkTypeUInt64>& offsets, const char*& characters)
+    {
+    if (!this->ReadArray(offsets, numberOfStrings + 1) || offsets[0] != 0)
+      {
+      return false;
+      }
+    for (size_t i = 0; i < numberOfStrings; i++)
+      {
+      if (offsets[i + 1] < offsets[i])
+        {
+        return false;
+        }
+      }
+    vtkTypeUInt64 numberOfCharacters = offsets[numberOfStrings];
+    if (numberOfCharacters > this->BufferSize - this->Position)
+      {
+      return false;
+      }
+    characters = this->Buffer + this->Position;
+    this->Position += numberOfCharacters;
+    return this->SkipPadding();
+    }
+
+  bool ReadBytes(char* data, size_t numberOfBytes)
+    {
+    if (numberOfBytes > this->BufferSize - this->Position)
+      {
+      return false;
+      }
+    memcpy(data, this->Buffer + this->Position, numberOfBytes);
+    this->Position += numberOfBytes;
+    return true;
+    }
+
+  bool SkipPadding()
+    {
+    size_t paddingSize = (8 - this->Position % 8) % 8;
+    if (paddingSize > this->BufferSize - this->Position)
+      {
+      return false;
+      }
+    this->Position += paddingSize;
+    return true;
+    }
+
+protected:
+  const char* Buffer;
+  size_t BufferSize;
+  size_t Position;
+};
+
 //------------------------------------------------------------------------------
 vtkMRMLNodeNewMacro(vtkMRMLMarkupsFiducialStorageNode);
 
@@ -473,9 +638,14 @@ int vtkMRMLMarkupsFiducialStorageNode::ReadDataInternal(vtkMRMLNode *refNode)
 
   MRMLNodeModifyBlocker blocker(markupsNode);
 
+  std::string ext = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
+  if (ext.compare(".mrkb") == 0)
+    {
+    return this->ReadBinaryDataInternal(markupsNode, fullName);
+    }
+
   // check if it's an annotation csv file
   bool parseAsAnnotationFiducial = false;
-  std::string ext = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName);
   if (ext.compare(".acsv") == 0)
     {
     parseAsAnnotationFiducial = true;
@@ -682,6 +852,11 @@ int vtkMRMLMarkupsFiducialStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
     return 0;
     }
 
+  if (vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(fullName).compare(".mrkb") == 0)
+    {
+    return this->WriteBinaryDataInternal(markupsNode, fullName);
+    }
+
   // open the file for writing
   fstream of;
 
@@ -723,15 +898,236 @@ int vtkMRMLMarkupsFiducialStorageNode::WriteDataInternal(vtkMRMLNode *refNode)
   return 1;
 }
 
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNode::ReadBinaryDataInternal(vtkMRMLMarkupsNode* markupsNode, const std::string& fullName)
+{
+  // Read the whole file with a single call and then get all values directly from the buffer
+  std::ifstream fstr(fullName.c_str(), std::ios::in | std::ios::binary | std::ios::ate);
+  if (!fstr.is_open())
+    {
+    vtkErrorMacro("ERROR opening markups file " << fullName);
+    return 0;
+    }
+  std::streamoff fileSize = fstr.tellg();
+  if (fileSize < 0)
+    {
+    vtkErrorMacro("ReadData: failed to get size of markups file " << fullName);
+    return 0;
+    }
+  std::vector<char> buffer(static_cast<size_t>(fileSize));
+  fstr.seekg(0, std::ios::beg);
+  if (!buffer.empty() && !fstr.read(&buffer[0], fileSize))
+    {
+    vtkErrorMacro("ReadData: failed to read markups file " << fullName);
+    return 0;
+    }
+  fstr.close();
+  MarkupsBinaryReader reader(buffer.empty() ? nullptr : &buffer[0], buffer.size());
+
+  // Header
+  char magic[8] = { 0 };
+  vtkTypeUInt32 version = 0;
+  vtkTypeInt32 coordinateSystem = 0;
+  vtkTypeUInt64 numberOfControlPoints = 0;
+  if (!reader.ReadBytes(magic, sizeof(magic))
+    || memcmp(magic, MARKUPS_BINARY_MAGIC, sizeof(magic)) != 0
+    || !reader.ReadValue(version)
+    || !reader.ReadValue(coordinateSystem)
+    || !reader.ReadValue(numberOfControlPoints))
+    {
+    vtkErrorMacro("ReadData: " << fullName << " is not a markups binary file");
+    return 0;
+    }
+  if (version > MARKUPS_BINARY_VERSION)
+    {
+    vtkErrorMacro("ReadData: markups binary file version " << version << " is not supported (maximum supported version is "
+      << MARKUPS_BINARY_VERSION << ")");
+    return 0;
+    }
+  if (coordinateSystem != vtkMRMLStorageNode::CoordinateSystemRAS
+    && coordinateSystem != vtkMRMLStorageNode::CoordinateSystemLPS)
+    {
+    vtkErrorMacro("ReadData: invalid coordinate system in markups file " << fullName);
+    return 0;
+    }
+  // Each control point takes more than 100 bytes, this check prevents huge allocations for corrupted files
+  if (numberOfControlPoints > buffer.size() / 100)
+    {
+    vtkErrorMacro("ReadData: invalid number of control points in markups file " << fullName);
+    return 0;
+    }
+  size_t n = static_cast<size_t>(numberOfControlPoints);
+
+  // Columns
+  std::vector<double> positions;
+  std::vector<double> orientationMatrices;
+  std::vector<vtkTypeInt32> positionStatus;
+  std::vector<unsigned char> flags;
+  const int numberOfStringColumns = 4;
+  std::vector<vtkTypeUInt64> stringOffsets[numberOfStringColumns];
+  const char* stringCharacters[numberOfStringColumns] = { nullptr };
+  bool valid = reader.ReadArray(positions, n * 3)
+    && reader.ReadArray(orientationMatrices, n * 9)
+    && reader.ReadArray(positionStatus, n)
+    && reader.ReadArray(flags, n);
+  for (int columnIndex = 0; valid && columnIndex < numberOfStringColumns; columnIndex++)
+    {
+    valid = reader.ReadStringColumn(n, stringOffsets[columnIndex], stringCharacters[columnIndex]);
+    }
+  if (!valid)
+    {
+    vtkErrorMacro("ReadData: markups file " << fullName << " is truncated or corrupted");
+    return 0;
+    }
+
+  this->SetCoordinateSystem(coordinateSystem);
+  double positionScale[3] = { 1.0, 1.0, 1.0 };
+  if (coordinateSystem == vtkMRMLStorageNode::CoordinateSystemLPS)
+    {
+    positionScale[0] = -1.0;
+    positionScale[1] = -1.0;
+    }
+
+  if (markupsNode->GetNumberOfControlPoints() > 0)
+    {
+    // clear out the list
+    markupsNode->RemoveAllControlPoints();
+    }
+  if (n == 0)
+    {
+    return 1;
+    }
+
+  std::vector<vtkMRMLMarkupsNode::ControlPoint*> controlPoints(n);
+  for (size_t i = 0; i < n; i++)
+    {
+    vtkMRMLMarkupsNode::ControlPoint* controlPoint = new vtkMRMLMarkupsNode::ControlPoint;
+    for (int j = 0; j < 3; j++)
+      {
+      controlPoint->Position[j] = positionScale[j] * positions[i * 3 + j];
+      }
+    for (int j = 0; j < 9; j++)
+      {
+      controlPoint->OrientationMatrix[j] = orientationMatrices[i * 9 + j];
+      }
+    controlPoint->PositionStatus = positionStatus[i];
+    controlPoint->Selected = (flags[i] & MARKUPS_BINARY_FLAG_SELECTED) != 0;
+    controlPoint->Locked = (flags[i] & MARKUPS_BINARY_FLAG_LOCKED) != 0;
+    controlPoint->Visibility = (flags[i] & MARKUPS_BINARY_FLAG_VISIBILITY) != 0;
+    std::string* stringFields[numberOfStringColumns] =
+      { &controlPoint->ID, &controlPoint->Label, &controlPoint->Description, &controlPoint->AssociatedNodeID };
+    for (int columnIndex = 0; columnIndex < numberOfStringColumns; columnIndex++)
+      {
+      const std::vector<vtkTypeUInt64>& offsets = stringOffsets[columnIndex];
+      stringFields[columnIndex]->assign(stringCharacters[columnIndex] + offsets[i], static_cast<size_t>(offsets[i + 1] - offsets[i]));
+      }
+    controlPoints[i] = controlPoint;
+    }
+
+  // Empty labels are preserved (same as when reading fcsv files)
+  if (markupsNode->AddControlPointsInternal(controlPoints, false) < 0)
+    {
+    vtkErrorMacro("ReadData: failed to add control points read from " << fullName);
+    for (vtkMRMLMarkupsNode::ControlPoint* controlPoint : controlPoints)
+      {
+      delete controlPoint;
+      }
+    return 0;
+    }
+
+  return 1;
+}
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNode::WriteBinaryDataInternal(vtkMRMLMarkupsNode* markupsNode, const std::string& fullName)
+{
+  double positionScale[3] = { 1.0, 1.0, 1.0 };
+  if (this->GetCoordinateSystem() == vtkMRMLStorageNode::CoordinateSystemLPS)
+    {
+    positionScale[0] = -1.0;
+    positionScale[1] = -1.0;
+    }
+  else if (this->GetCoordinateSystem() != vtkMRMLStorageNode::CoordinateSystemRAS)
+    {
+    vtkErrorMacro("WriteData: invalid coordinate system index " << this->GetCoordinateSystem());
+    return 0;
+    }
+
+  // Collect values into columns
+  vtkMRMLMarkupsNode::ControlPointsListType* controlPoints = markupsNode->GetControlPoints();
+  size_t n = controlPoints->size();
+  std::vector<double> positions(n * 3);
+  std::vector<double> orientationMatrices(n * 9);
+  std::vector<vtkTypeInt32> positionStatus(n);
+  std::vector<unsigned char> flags(n);
+  const int numberOfStringColumns = 4;
+  std::vector<const std::string*> strings[numberOfStringColumns];
+  for (int columnIndex = 0; columnIndex < numberOfStringColumns; columnIndex++)
+    {
+    strings[columnIndex].resize(n);
+    }
+  for (size_t i = 0; i < n; i++)
+    {
+    vtkMRMLMarkupsNode::ControlPoint* controlPoint = (*controlPoints)[i];
+    for (int j = 0; j < 3; j++)
+      {
+      positions[i * 3 + j] = positionScale[j] * controlPoint->Position[j];
+      }
+    for (int j = 0; j < 9; j++)
+      {
+      orientationMatrices[i * 9 + j] = controlPoint->OrientationMatrix[j];
+      }
+    positionStatus[i] = controlPoint->PositionStatus;
+    flags[i] = (controlPoint->Selected ? MARKUPS_BINARY_FLAG_SELECTED : 0)
+      | (controlPoint->Locked ? MARKUPS_BINARY_FLAG_LOCKED : 0)
+      | (controlPoint->Visibility ? MARKUPS_BINARY_FLAG_VISIBILITY : 0);
+    strings[0][i] = &controlPoint->ID;
+    strings[1][i] = &controlPoint->Label;
+    strings[2][i] = &controlPoint->Description;
+    strings[3][i] = &controlPoint->AssociatedNodeID;
+    }
+
+  std::ofstream of(fullName.c_str(), std::ios::out | std::ios::binary);
+  if (!of.is_open())
+    {
+    vtkErrorMacro("WriteData: unable to open file " << fullName.c_str() << " for writing");
+    return 0;
+    }
+
+  MarkupsBinaryWriter writer(of);
+  writer.WriteBytes(MARKUPS_BINARY_MAGIC, sizeof(MARKUPS_BINARY_MAGIC));
+  writer.WriteValue(MARKUPS_BINARY_VERSION);
+  writer.WriteValue(static_cast<vtkTypeInt32>(this->GetCoordinateSystem()));
+  writer.WriteValue(static_cast<vtkTypeUInt64>(n));
+  writer.WriteArray(positions);
+  writer.WriteArray(orientationMatrices);
+  writer.WriteArray(positionStatus);
+  writer.WriteArray(flags);
+  for (int columnIndex = 0; columnIndex < numberOfStringColumns; columnIndex++)
+    {
+    writer.WriteStringColumn(strings[columnIndex]);
+    }
+
+  of.close();
+  if (of.fail())
+    {
+    vtkErrorMacro("WriteData: failed to write file " << fullName.c_str());
+    return 0;
+    }
+  return 1;
+}
+
 //----------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialStorageNode::InitializeSupportedReadFileTypes()
 {
   this->SupportedReadFileTypes->InsertNextValue("Markups Fiducial CSV (.fcsv)");
   this->SupportedReadFileTypes->InsertNextValue("Annotation Fiducial CSV (.acsv)");
+  this->SupportedReadFileTypes->InsertNextValue("Markups Fiducial Binary (.mrkb)");
 }
 
 //----------------------------------------------------------------------------
 void vtkMRMLMarkupsFiducialStorageNode::InitializeSupportedWriteFileTypes()
 {
   this->SupportedWriteFileTypes->InsertNextValue("Markups Fiducial CSV (.fcsv)");
+  this->SupportedWriteFileTypes->InsertNextValue("Markups Fiducial Binary (.mrkb)");
 }
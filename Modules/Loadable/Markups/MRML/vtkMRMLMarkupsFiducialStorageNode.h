@@ -91,6 +91,12 @@ protected:
   /// necessary, same with the description
   int WriteDataInternal(vtkMRMLNode *refNode) override;
 
+  /// Read/write markups binary file (.mrkb).
+  /// All control point properties are stored in columns of raw values, which can be
+  /// read and written much faster than text files.
+  int ReadBinaryDataInternal(vtkMRMLMarkupsNode* markupsNode, const std::string& fullName);
+  int WriteBinaryDataInternal(vtkMRMLMarkupsNode* markupsNode, const std::string& fullName);
+
   std::string FieldDelimiterCharacters;
 };
 
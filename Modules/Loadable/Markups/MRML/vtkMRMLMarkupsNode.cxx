@@ -37,6 +37,7 @@
 #include <vtkCellLocator.h>
 #include <vtkFrenetSerretFrame.h>
 #include <vtkGeneralTransform.h>
+#include <vtkIdList.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
@@ -200,17 +201,43 @@ void vtkMRMLMarkupsNode::Copy(vtkMRMLNode *anode)
 
   this->RemoveAllControlPoints();
   int numMarkups = node->GetNumberOfControlPoints();
+  std::vector<ControlPoint*> controlPointCopies;
+  controlPointCopies.reserve(numMarkups);
   for (int n = 0; n < numMarkups; n++)
     {
     ControlPoint* controlPoint = node->GetNthControlPoint(n);
     ControlPoint* controlPointCopy = new ControlPoint;
     (*controlPointCopy) = (*controlPoint);
-    this->AddControlPoint(controlPointCopy);
+    controlPointCopies.push_back(controlPointCopy);
+    }
+  if (!controlPointCopies.empty() && this->AddControlPointsInternal(controlPointCopies) < 0)
+    {
+    for (ControlPoint* controlPointCopy : controlPointCopies)
+      {
+      delete controlPointCopy;
+      }
     }
 
   this->EndModify(disabledModify);
 }
 
+//---------------------------------------------------------------------------
+size_t vtkMRMLMarkupsNode::GetCopiedDataMemorySize()
+{
+  size_t memorySize = this->ControlPoints.size() * (sizeof(ControlPoint) + sizeof(ControlPoint*));
+  for (ControlPoint* controlPoint : this->ControlPoints)
+    {
+    memorySize += controlPoint->ID.capacity() + controlPoint->Label.capacity()
+      + controlPoint->Description.capacity() + controlPoint->AssociatedNodeID.capacity();
+    }
+  memorySize += static_cast<size_t>(this->TextList->GetActualMemorySize()) * 1024;
+  if (this->CurveInputPoly->GetPoints())
+    {
+    memorySize += static_cast<size_t>(this->CurveInputPoly->GetPoints()->GetActualMemorySize()) * 1024;
+    }
+  return memorySize;
+}
+
 //---------------------------------------------------------------------------
 void vtkMRMLMarkupsNode::ProcessMRMLEvents(vtkObject *caller,
                                            unsigned long event,
@@ -499,6 +526,123 @@ int vtkMRMLMarkupsNode::AddControlPoint(ControlPoint *controlPoint)
   return controlPointIndex;
 }
 
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPointsInternal(std::vector<ControlPoint*>& controlPoints, bool generateLabels /*=true*/)
+{
+  if (controlPoints.empty())
+    {
+    return -1;
+    }
+  int numberOfNewControlPoints = static_cast<int>(controlPoints.size());
+  int firstControlPointIndex = this->GetNumberOfControlPoints();
+  if (this->MaximumNumberOfControlPoints != 0 &&
+      firstControlPointIndex + numberOfNewControlPoints > this->MaximumNumberOfControlPoints)
+    {
+    vtkErrorMacro("AddControlPoints: number of points major than maximum number of control points allowed.");
+    return -1;
+    }
+
+  // Label format is the same for all points, get it only once
+  std::string labelFormatString = this->ReplaceListNameInMarkupLabelFormat();
+  char labelBuffer[128];
+  labelBuffer[sizeof(labelBuffer) - 1] = 0; // make sure the string is zero-terminated
+
+  this->ControlPoints.reserve(firstControlPointIndex + numberOfNewControlPoints);
+  vtkPoints* curveInputPoints = this->CurveInputPoly->GetPoints();
+  curveInputPoints->SetNumberOfPoints(firstControlPointIndex + numberOfNewControlPoints);
+  bool definedPointAdded = false;
+  for (int i = 0; i < numberOfNewControlPoints; i++)
+    {
+    ControlPoint* controlPoint = controlPoints[i];
+    // generate a unique id based on list policy
+    if (controlPoint->ID.empty())
+      {
+      controlPoint->ID = this->GenerateUniqueControlPointID();
+      }
+    if (generateLabels && controlPoint->Label.empty())
+      {
+      snprintf(labelBuffer, sizeof(labelBuffer) - 1, labelFormatString.c_str(), this->LastUsedControlPointNumber);
+      controlPoint->Label = labelBuffer;
+      }
+    if (controlPoint->PositionStatus == vtkMRMLMarkupsNode::PositionDefined)
+      {
+      definedPointAdded = true;
+      }
+    this->ControlPoints.push_back(controlPoint);
+    curveInputPoints->SetPoint(firstControlPointIndex + i, controlPoint->Position);
+    }
+  curveInputPoints->Modified();
+
+  // nullptr callData indicates that more than one point may have been added
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointAddedEvent);
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent);
+  if (definedPointAdded)
+    {
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionDefinedEvent);
+    }
+  this->UpdateMeasurements();
+  return firstControlPointIndex;
+}
+
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPoints(vtkPoints* points, vtkStringArray* labels /*=nullptr*/)
+{
+  if (!points)
+    {
+    vtkErrorMacro("AddControlPoints failed: invalid points");
+    return -1;
+    }
+  vtkIdType numberOfPoints = points->GetNumberOfPoints();
+  if (labels && labels->GetNumberOfValues() != numberOfPoints)
+    {
+    vtkErrorMacro("AddControlPoints failed: number of labels (" << labels->GetNumberOfValues()
+      << ") does not match the number of points (" << numberOfPoints << ")");
+    return -1;
+    }
+  std::vector<ControlPoint*> controlPoints;
+  controlPoints.reserve(numberOfPoints);
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    ControlPoint* controlPoint = new ControlPoint;
+    points->GetPoint(pointIndex, controlPoint->Position);
+    controlPoint->PositionStatus = PositionDefined;
+    if (labels)
+      {
+      controlPoint->Label = labels->GetValue(pointIndex);
+      }
+    controlPoints.push_back(controlPoint);
+    }
+  int firstControlPointIndex = this->AddControlPointsInternal(controlPoints);
+  if (firstControlPointIndex < 0)
+    {
+    for (ControlPoint* controlPoint : controlPoints)
+      {
+      delete controlPoint;
+      }
+    }
+  return firstControlPointIndex;
+}
+
+//-----------------------------------------------------------
+int vtkMRMLMarkupsNode::AddControlPointsWorld(vtkPoints* pointsWorld, vtkStringArray* labels /*=nullptr*/)
+{
+  if (!pointsWorld)
+    {
+    vtkErrorMacro("AddControlPointsWorld failed: invalid points");
+    return -1;
+    }
+  vtkIdType numberOfPoints = pointsWorld->GetNumberOfPoints();
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPoints);
+  double pointLocal[3] = { 0.0, 0.0, 0.0 };
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+    {
+    this->TransformPointFromWorld(pointsWorld->GetPoint(pointIndex), pointLocal);
+    points->SetPoint(pointIndex, pointLocal);
+    }
+  return this->AddControlPoints(points, labels);
+}
+
 //-----------------------------------------------------------
 int vtkMRMLMarkupsNode::AddNControlPoints(int n, std::string label /*=std::string()*/, vtkVector3d* point /*=nullptr*/)
 {
@@ -642,6 +786,74 @@ void vtkMRMLMarkupsNode::RemoveNthControlPoint(int pointIndex)
   this->UpdateMeasurements();
 }
 
+//-----------------------------------------------------------
+void vtkMRMLMarkupsNode::RemoveControlPoints(vtkIdList* pointIndices)
+{
+  if (!pointIndices)
+    {
+    vtkErrorMacro("RemoveControlPoints failed: invalid point indices");
+    return;
+    }
+  int numberOfControlPoints = this->GetNumberOfControlPoints();
+  std::vector<bool> removePoint(numberOfControlPoints, false);
+  bool anyPointRemoved = false;
+  for (vtkIdType i = 0; i < pointIndices->GetNumberOfIds(); i++)
+    {
+    vtkIdType pointIndex = pointIndices->GetId(i);
+    if (pointIndex >= 0 && pointIndex < numberOfControlPoints)
+      {
+      removePoint[pointIndex] = true;
+      anyPointRemoved = true;
+      }
+    }
+  if (!anyPointRemoved)
+    {
+    return;
+    }
+
+  // Allow reusing last control point number (same as in RemoveNthControlPoint,
+  // as if points were removed one by one, starting from the last one).
+  std::string lastAutoGeneratedLabel = this->GenerateControlPointLabel(this->LastUsedControlPointNumber);
+  for (int pointIndex = numberOfControlPoints - 1; pointIndex >= 0; pointIndex--)
+    {
+    if (removePoint[pointIndex] && this->ControlPoints[pointIndex]->Label == lastAutoGeneratedLabel)
+      {
+      this->LastUsedControlPointNumber--;
+      lastAutoGeneratedLabel = this->GenerateControlPointLabel(this->LastUsedControlPointNumber);
+      }
+    }
+
+  // Remove points in one pass, keeping the order of the remaining points
+  bool positionWasDefined = false;
+  int numberOfRemainingControlPoints = 0;
+  for (int pointIndex = 0; pointIndex < numberOfControlPoints; pointIndex++)
+    {
+    ControlPoint* controlPoint = this->ControlPoints[pointIndex];
+    if (!removePoint[pointIndex])
+      {
+      this->ControlPoints[numberOfRemainingControlPoints++] = controlPoint;
+      continue;
+      }
+    if (controlPoint->PositionStatus == vtkMRMLMarkupsNode::PositionDefined)
+      {
+      positionWasDefined = true;
+      }
+    delete controlPoint;
+    }
+  this->ControlPoints.resize(numberOfRemainingControlPoints);
+
+  this->UpdateCurvePolyFromControlPoints();
+
+  // nullptr callData indicates that more than one point may have been removed
+  if (positionWasDefined)
+    {
+    this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointPositionUndefinedEvent);
+    }
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointModifiedEvent);
+  this->InvokeCustomModifiedEvent(vtkMRMLMarkupsNode::PointRemovedEvent);
+  this->UpdateMeasurements();
+}
+
 //-----------------------------------------------------------
 bool vtkMRMLMarkupsNode::InsertControlPoint(ControlPoint *controlPoint, int targetIndex)
 {
@@ -1788,23 +2000,32 @@ void vtkMRMLMarkupsNode::SetControlPointPositionsWorld(vtkPoints* points)
     }
   int wasModified = this->StartModify();
   vtkIdType numberOfPoints = points->GetNumberOfPoints();
-  for (vtkIdType pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
+  vtkIdType numberOfExistingPoints = std::min(numberOfPoints, static_cast<vtkIdType>(this->GetNumberOfControlPoints()));
+  for (vtkIdType pointIndex = 0; pointIndex < numberOfExistingPoints; pointIndex++)
     {
-    double* posWorld = points->GetPoint(pointIndex);
-    if (pointIndex < this->GetNumberOfControlPoints())
-      {
-      // point already exists, just update it
-      this->SetNthControlPointPositionWorldFromArray(pointIndex, posWorld);
-      }
-    else
+    // point already exists, just update it
+    this->SetNthControlPointPositionWorldFromArray(pointIndex, points->GetPoint(pointIndex));
+    }
+  if (numberOfPoints > numberOfExistingPoints)
+    {
+    // need to add new points
+    vtkNew<vtkPoints> newPointsWorld;
+    newPointsWorld->SetNumberOfPoints(numberOfPoints - numberOfExistingPoints);
+    for (vtkIdType pointIndex = numberOfExistingPoints; pointIndex < numberOfPoints; pointIndex++)
       {
-      // need to add a new point
-      vtkMRMLMarkupsNode::AddControlPointWorld(vtkVector3d(posWorld));
+      newPointsWorld->SetPoint(pointIndex - numberOfExistingPoints, points->GetPoint(pointIndex));
       }
+    this->AddControlPointsWorld(newPointsWorld);
     }
-  while (this->GetNumberOfControlPoints() > numberOfPoints)
+  else if (this->GetNumberOfControlPoints() > numberOfPoints)
     {
-    this->RemoveNthControlPoint(this->GetNumberOfControlPoints() - 1);
+    // remove extra points
+    vtkNew<vtkIdList> extraPointIndices;
+    for (vtkIdType pointIndex = numberOfPoints; pointIndex < this->GetNumberOfControlPoints(); pointIndex++)
+      {
+      extraPointIndices->InsertNextId(pointIndex);
+      }
+    this->RemoveControlPoints(extraPointIndices);
     }
   this->EndModify(wasModified);
 }
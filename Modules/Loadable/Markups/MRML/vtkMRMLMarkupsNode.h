@@ -58,6 +58,7 @@ class vtkMRMLUnitNode;
 
 class vtkAlgorithmOutput;
 class vtkGeneralTransform;
+class vtkIdList;
 class vtkMatrix4x4;
 class vtkMRMLMarkupsDisplayNode;
 class vtkPolyData;
@@ -152,6 +153,9 @@ public:
   /// Copy the node's attributes to this object
   void Copy(vtkMRMLNode *node) override;
 
+  /// Control points are copied by Copy(), returns their memory size.
+  size_t GetCopiedDataMemorySize() override;
+
   /// Alternative method to propagate events generated in Display nodes
   void ProcessMRMLEvents ( vtkObject * /*caller*/,
                                    unsigned long /*event*/,
@@ -274,6 +278,17 @@ public:
   /// of new controlPoint, -1 on failure.
   /// Markups node takes over ownership of the pointer (markups node will delete it).
   int AddControlPoint(ControlPoint *controlPoint);
+  /// Add control points to the end of the list, at the specified positions.
+  /// If labels are specified then the array must contain one label for each point,
+  /// empty labels are replaced by automatically generated labels.
+  /// Point added, modified, and position defined events are invoked only once (with nullptr callData),
+  /// therefore adding many control points is much faster than with AddControlPoint.
+  /// Return index of the first added control point, -1 on failure.
+  int AddControlPoints(vtkPoints* points, vtkStringArray* labels = nullptr);
+  /// Add control points to the end of the list, at the specified positions
+  /// defined in the world coordinate system.
+  /// \sa AddControlPoints
+  int AddControlPointsWorld(vtkPoints* pointsWorld, vtkStringArray* labels = nullptr);
 
   /// Get the position of the Nth control point
   /// returning it as a vtkVector3d, return (0,0,0) if not found
@@ -305,6 +320,12 @@ public:
   /// \deprecated Use RemoveNthControlPoint instead.
   void RemoveMarkup(int pointIndex) { this->RemoveNthControlPoint(pointIndex); };
 
+  /// Remove control points of the specified indices.
+  /// Invalid indices are ignored.
+  /// Point removed, modified, and position undefined events are invoked only once (with nullptr callData),
+  /// therefore removing many control points is much faster than with RemoveNthControlPoint.
+  void RemoveControlPoints(vtkIdList* pointIndices);
+
   /// Insert a control point in this list at targetIndex.
   /// If targetIndex is < 0, insert at the start of the list.
   /// If targetIndex is > list size - 1, append to end of list.
@@ -596,6 +617,12 @@ protected:
 
   std::string GenerateControlPointLabel(int controlPointIndex);
 
+  /// Append control points to the end of the list and invoke events only once.
+  /// Markups node takes over ownership of the control points.
+  /// Return index of the first added control point, -1 on failure (then control points are not taken over).
+  /// If generateLabels is false then empty labels are kept (e.g., when reading from file).
+  int AddControlPointsInternal(std::vector<ControlPoint*>& controlPoints, bool generateLabels = true);
+
   virtual void UpdateCurvePolyFromControlPoints();
 
   void OnTransformNodeReferenceChanged(vtkMRMLTransformNode* transformNode) override;
@@ -299,6 +299,7 @@ void vtkMRMLMarkupsDisplayableManager
         continue;
         }
       widget->UpdateFromMRML(markupsNode, event, callData);
+      this->Helper->InvalidateInteractionBounds(widget);
       if (widget->GetNeedToRender())
         {
         renderRequested = true;
@@ -607,14 +608,11 @@ vtkSlicerMarkupsWidget* vtkMRMLMarkupsDisplayableManager::FindClosestWidget(vtkM
   vtkSlicerMarkupsWidget* closestWidget = nullptr;
   closestDistance2 = VTK_DOUBLE_MAX;
 
-  for (vtkMRMLMarkupsDisplayableManagerHelper::DisplayNodeToWidgetIt widgetIterator = this->Helper->MarkupsDisplayNodesToWidgets.begin();
-    widgetIterator != this->Helper->MarkupsDisplayNodesToWidgets.end(); ++widgetIterator)
+  // Only check widgets that may interact at the event position
+  std::vector<vtkSlicerMarkupsWidget*> candidateWidgets;
+  this->Helper->GetInteractionCandidateWidgets(callData, candidateWidgets);
+  for (vtkSlicerMarkupsWidget* widget : candidateWidgets)
     {
-    vtkSlicerMarkupsWidget* widget = widgetIterator->second;
-    if (!widget)
-      {
-      continue;
-      }
     double distance2FromWidget = VTK_DOUBLE_MAX;
     if (widget->CanProcessInteractionEvent(callData, distance2FromWidget))
       {
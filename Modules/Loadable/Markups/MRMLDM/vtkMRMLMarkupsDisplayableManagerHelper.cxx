@@ -25,11 +25,14 @@
 
 // VTK includes
 #include <vtkCollection.h>
+#include <vtkMRMLInteractionEventData.h>
 #include <vtkMRMLInteractionNode.h>
+#include <vtkMatrix4x4.h>
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkProperty.h>
 #include <vtkPickingManager.h>
+#include <vtkRenderer.h>
 #include <vtkRenderWindowInteractor.h>
 #include <vtkSlicerMarkupsWidgetRepresentation.h>
 #include <vtkSlicerMarkupsWidget.h>
@@ -48,9 +51,16 @@
 
 // STD includes
 #include <algorithm>
+#include <cmath>
 #include <map>
 #include <vector>
 
+namespace
+{
+/// Size of a cell of the interaction grid, in display coordinates (pixels)
+const double INTERACTION_GRID_CELL_SIZE = 64.0;
+}
+
 //---------------------------------------------------------------------------
 vtkStandardNewMacro (vtkMRMLMarkupsDisplayableManagerHelper);
 
@@ -59,6 +69,7 @@ vtkMRMLMarkupsDisplayableManagerHelper::vtkMRMLMarkupsDisplayableManagerHelper()
 {
   this->DisplayableManager = nullptr;
   this->AddingMarkupsNode = false;
+  this->InteractionGridModified = true;
   this->ObservedMarkupNodeEvents.push_back(vtkCommand::ModifiedEvent);
   this->ObservedMarkupNodeEvents.push_back(vtkMRMLTransformableNode::TransformModifiedEvent);
   this->ObservedMarkupNodeEvents.push_back(vtkMRMLDisplayableNode::DisplayModifiedEvent);
@@ -169,6 +180,8 @@ void vtkMRMLMarkupsDisplayableManagerHelper::RemoveAllWidgetsAndNodes()
     widgetIterator->second->Delete();
     }
   this->MarkupsDisplayNodesToWidgets.clear();
+  this->WidgetInteractionBounds.clear();
+  this->InteractionGridModified = true;
 
   MarkupsNodesIt markupsIterator = this->MarkupsNodes.begin();
   for (markupsIterator = this->MarkupsNodes.begin();
@@ -302,6 +315,7 @@ void vtkMRMLMarkupsDisplayableManagerHelper::AddDisplayNode(vtkMRMLMarkupsDispla
 
   // Build representation
   newWidget->UpdateFromMRML(markupsDisplayNode, 0); // no specific event triggers full rebuild
+  this->InvalidateInteractionBounds(newWidget);
 
   this->DisplayableManager->RequestRender();
 
@@ -338,6 +352,8 @@ void vtkMRMLMarkupsDisplayableManagerHelper::DeleteWidget(vtkSlicerMarkupsWidget
     {
     return;
     }
+  this->WidgetInteractionBounds.erase(widget);
+  this->InteractionGridModified = true;
   widget->SetRenderer(nullptr);
   widget->SetRepresentation(nullptr);
   widget->Delete();
@@ -375,3 +391,236 @@ void vtkMRMLMarkupsDisplayableManagerHelper::SetDisplayableManager(vtkMRMLMarkup
 {
   this->DisplayableManager = displayableManager;
 }
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::InvalidateInteractionBounds(vtkSlicerMarkupsWidget* widget)
+{
+  if (widget)
+    {
+    this->WidgetInteractionBounds[widget].Modified = true;
+    return;
+    }
+  for (DisplayNodeToWidgetIt widgetIterator = this->MarkupsDisplayNodesToWidgets.begin();
+    widgetIterator != this->MarkupsDisplayNodesToWidgets.end(); ++widgetIterator)
+    {
+    if (widgetIterator->second)
+      {
+      this->WidgetInteractionBounds[widgetIterator->second].Modified = true;
+      }
+    }
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::UpdateInteractionIndex()
+{
+  // Display positions of all widgets change when the slice view is panned, zoomed, or resized
+  std::vector<double> viewGeometry;
+  int viewportSize[2] = { 0, 0 };
+  vtkRenderer* renderer = this->DisplayableManager ? this->DisplayableManager->GetRenderer() : nullptr;
+  if (renderer)
+    {
+    const int* rendererSize = renderer->GetSize();
+    viewportSize[0] = rendererSize[0];
+    viewportSize[1] = rendererSize[1];
+    }
+  viewGeometry.push_back(viewportSize[0]);
+  viewGeometry.push_back(viewportSize[1]);
+  vtkMRMLSliceNode* sliceNode = this->DisplayableManager ? this->DisplayableManager->GetMRMLSliceNode() : nullptr;
+  if (sliceNode)
+    {
+    vtkMatrix4x4* xyToRAS = sliceNode->GetXYToRAS();
+    for (int row = 0; row < 4; row++)
+      {
+      for (int column = 0; column < 4; column++)
+        {
+        viewGeometry.push_back(xyToRAS->GetElement(row, column));
+        }
+      }
+    }
+  if (viewGeometry != this->InteractionViewGeometry)
+    {
+    this->InteractionViewGeometry = viewGeometry;
+    this->InvalidateInteractionBounds();
+    }
+
+  // Widgets that have not been invalidated yet (for example, created without
+  // InvalidateInteractionBounds call) get their regions computed now
+  for (DisplayNodeToWidgetIt widgetIterator = this->MarkupsDisplayNodesToWidgets.begin();
+    widgetIterator != this->MarkupsDisplayNodesToWidgets.end(); ++widgetIterator)
+    {
+    if (widgetIterator->second
+      && this->WidgetInteractionBounds.find(widgetIterator->second) == this->WidgetInteractionBounds.end())
+      {
+      this->WidgetInteractionBounds[widgetIterator->second].Modified = true;
+      }
+    }
+
+  // Recompute interaction regions of widgets that have been updated since the last query
+  for (std::map<vtkSlicerMarkupsWidget*, InteractionBoundsType>::iterator boundsIt = this->WidgetInteractionBounds.begin();
+    boundsIt != this->WidgetInteractionBounds.end(); ++boundsIt)
+    {
+    InteractionBoundsType& interactionBounds = boundsIt->second;
+    if (!interactionBounds.Modified)
+      {
+      continue;
+      }
+    vtkSlicerMarkupsWidgetRepresentation* rep = boundsIt->first->GetMarkupsRepresentation();
+    interactionBounds.Known = (rep && rep->GetInteractionRegionsDisplay(interactionBounds.Regions));
+    interactionBounds.Bounds[0] = interactionBounds.Bounds[2] = VTK_DOUBLE_MAX;
+    interactionBounds.Bounds[1] = interactionBounds.Bounds[3] = VTK_DOUBLE_MIN;
+    const std::vector<double>& regions = interactionBounds.Regions;
+    for (size_t regionIndex = 0; regionIndex + 3 < regions.size(); regionIndex += 4)
+      {
+      for (int i = 0; i < 4; i += 2)
+        {
+        interactionBounds.Bounds[i] = std::min(interactionBounds.Bounds[i], regions[regionIndex + i]);
+        interactionBounds.Bounds[i + 1] = std::max(interactionBounds.Bounds[i + 1], regions[regionIndex + i + 1]);
+        }
+      }
+    interactionBounds.Modified = false;
+    this->InteractionGridModified = true;
+    }
+
+  if (!this->InteractionGridModified)
+    {
+    return;
+    }
+
+  // Rebuilding the grid is fast, as it does not require access to widgets.
+  // Events only occur within the viewport, therefore only cells of the viewport are filled.
+  const int lastCell[2] = {
+    static_cast<int>(floor(viewportSize[0] / INTERACTION_GRID_CELL_SIZE)),
+    static_cast<int>(floor(viewportSize[1] / INTERACTION_GRID_CELL_SIZE)) };
+  this->InteractionGridCells.clear();
+  this->InteractionGridOtherWidgets.clear();
+  for (std::map<vtkSlicerMarkupsWidget*, InteractionBoundsType>::iterator boundsIt = this->WidgetInteractionBounds.begin();
+    boundsIt != this->WidgetInteractionBounds.end(); ++boundsIt)
+    {
+    const InteractionBoundsType& interactionBounds = boundsIt->second;
+    if (!interactionBounds.Known || viewportSize[0] <= 0 || viewportSize[1] <= 0)
+      {
+      this->InteractionGridOtherWidgets.push_back(boundsIt->first);
+      continue;
+      }
+    const std::vector<double>& regions = interactionBounds.Regions;
+    for (size_t regionIndex = 0; regionIndex + 3 < regions.size(); regionIndex += 4)
+      {
+      const double* region = &regions[regionIndex];
+      if (region[0] > region[1] || region[2] > region[3])
+        {
+        // no interaction is possible
+        continue;
+        }
+      // Regions are clamped to the viewport before conversion to int, as they may be very far outside of it
+      const int cellRange[4] = {
+        static_cast<int>(floor(std::max(region[0], 0.0) / INTERACTION_GRID_CELL_SIZE)),
+        static_cast<int>(floor(std::min(region[1], static_cast<double>(viewportSize[0])) / INTERACTION_GRID_CELL_SIZE)),
+        static_cast<int>(floor(std::max(region[2], 0.0) / INTERACTION_GRID_CELL_SIZE)),
+        static_cast<int>(floor(std::min(region[3], static_cast<double>(viewportSize[1])) / INTERACTION_GRID_CELL_SIZE)) };
+      for (int cellY = cellRange[2]; cellY <= std::min(cellRange[3], lastCell[1]); ++cellY)
+        {
+        for (int cellX = cellRange[0]; cellX <= std::min(cellRange[1], lastCell[0]); ++cellX)
+          {
+          std::vector<vtkSlicerMarkupsWidget*>& cellWidgets = this->InteractionGridCells[std::make_pair(cellX, cellY)];
+          // regions of the same widget are stored consecutively, therefore checking the last item prevents duplicates
+          if (cellWidgets.empty() || cellWidgets.back() != boundsIt->first)
+            {
+            cellWidgets.push_back(boundsIt->first);
+            }
+          }
+        }
+      }
+    }
+  this->InteractionGridModified = false;
+}
+
+//---------------------------------------------------------------------------
+void vtkMRMLMarkupsDisplayableManagerHelper::GetInteractionCandidateWidgets(
+  vtkMRMLInteractionEventData* eventData, std::vector<vtkSlicerMarkupsWidget*>& candidateWidgets)
+{
+  candidateWidgets.clear();
+  if (!eventData || !eventData->IsDisplayPositionValid())
+    {
+    // Interaction regions are stored in display coordinates, without a display position all widgets are candidates
+    for (DisplayNodeToWidgetIt widgetIterator = this->MarkupsDisplayNodesToWidgets.begin();
+      widgetIterator != this->MarkupsDisplayNodesToWidgets.end(); ++widgetIterator)
+      {
+      if (widgetIterator->second)
+        {
+        candidateWidgets.push_back(widgetIterator->second);
+        }
+      }
+    return;
+    }
+
+  this->UpdateInteractionIndex();
+
+  const int* displayPosition = eventData->GetDisplayPosition();
+  auto isCandidate = [&](vtkSlicerMarkupsWidget* widget)
+    {
+    std::map<vtkSlicerMarkupsWidget*, InteractionBoundsType>::const_iterator boundsIt =
+      this->WidgetInteractionBounds.find(widget);
+    if (boundsIt == this->WidgetInteractionBounds.end())
+      {
+      // interaction region is not known
+      return true;
+      }
+    const InteractionBoundsType& interactionBounds = boundsIt->second;
+    if (!interactionBounds.Known)
+      {
+      return true;
+      }
+    if (displayPosition[0] < interactionBounds.Bounds[0] || displayPosition[0] > interactionBounds.Bounds[1]
+      || displayPosition[1] < interactionBounds.Bounds[2] || displayPosition[1] > interactionBounds.Bounds[3])
+      {
+      return false;
+      }
+    const std::vector<double>& regions = interactionBounds.Regions;
+    for (size_t regionIndex = 0; regionIndex + 3 < regions.size(); regionIndex += 4)
+      {
+      if (displayPosition[0] >= regions[regionIndex] && displayPosition[0] <= regions[regionIndex + 1]
+        && displayPosition[1] >= regions[regionIndex + 2] && displayPosition[1] <= regions[regionIndex + 3])
+        {
+        return true;
+        }
+      }
+    return false;
+    };
+
+  std::map<std::pair<int, int>, std::vector<vtkSlicerMarkupsWidget*> >::iterator cellIt = this->InteractionGridCells.find(
+    std::make_pair(static_cast<int>(floor(displayPosition[0] / INTERACTION_GRID_CELL_SIZE)),
+      static_cast<int>(floor(displayPosition[1] / INTERACTION_GRID_CELL_SIZE))));
+  if (cellIt != this->InteractionGridCells.end())
+    {
+    for (vtkSlicerMarkupsWidget* widget : cellIt->second)
+      {
+      if (isCandidate(widget))
+        {
+        candidateWidgets.push_back(widget);
+        }
+      }
+    }
+  for (vtkSlicerMarkupsWidget* widget : this->InteractionGridOtherWidgets)
+    {
+    if (isCandidate(widget))
+      {
+      candidateWidgets.push_back(widget);
+      }
+    }
+
+  // Widgets that are not idle (being placed, manipulated, or just hovered) process events anywhere,
+  // for example a hovered widget has to be notified when the mouse pointer leaves it
+  for (DisplayNodeToWidgetIt widgetIterator = this->MarkupsDisplayNodesToWidgets.begin();
+    widgetIterator != this->MarkupsDisplayNodesToWidgets.end(); ++widgetIterator)
+    {
+    vtkSlicerMarkupsWidget* widget = widgetIterator->second;
+    if (!widget || widget->GetWidgetState() == vtkSlicerMarkupsWidget::WidgetStateIdle)
+      {
+      continue;
+      }
+    if (std::find(candidateWidgets.begin(), candidateWidgets.end(), widget) == candidateWidgets.end())
+      {
+      candidateWidgets.push_back(widget);
+      }
+    }
+}
@@ -41,8 +41,11 @@
 #include <vtkMRMLSliceNode.h>
 
 // STL includes
+#include <map>
 #include <set>
+#include <vector>
 
+class vtkMRMLInteractionEventData;
 class vtkMRMLMarkupsDisplayableManager;
 class vtkMRMLMarkupsDisplayNode;
 class vtkMRMLInteractionNode;
@@ -90,6 +93,19 @@ public:
   void AddObservations(vtkMRMLMarkupsNode* node);
   void RemoveObservations(vtkMRMLMarkupsNode* node);
 
+  /// Indicate that the widget has been updated from MRML and so its interaction region
+  /// has to be recomputed. If widget is nullptr then all widgets are invalidated.
+  /// Changes of the slice view geometry (pan, zoom, resize) are detected automatically.
+  void InvalidateInteractionBounds(vtkSlicerMarkupsWidget* widget = nullptr);
+
+  /// Get widgets that may be able to process the interaction event.
+  /// Interaction regions of widgets are stored in a grid in display coordinates, therefore
+  /// only widgets near the event position are returned, without querying each widget.
+  /// Widgets that are not idle (e.g., hovered or dragged) and widgets with unknown
+  /// interaction region are always returned.
+  void GetInteractionCandidateWidgets(vtkMRMLInteractionEventData* eventData,
+    std::vector<vtkSlicerMarkupsWidget*>& candidateWidgets);
+
 protected:
 
   vtkMRMLMarkupsDisplayableManagerHelper();
@@ -100,6 +116,36 @@ private:
   vtkMRMLMarkupsDisplayableManagerHelper(const vtkMRMLMarkupsDisplayableManagerHelper&) = delete;
   void operator=(const vtkMRMLMarkupsDisplayableManagerHelper&) = delete;
 
+  /// Recompute invalidated interaction regions and update the interaction grid.
+  /// All regions are recomputed if the slice view geometry has changed.
+  void UpdateInteractionIndex();
+
+  struct InteractionBoundsType
+    {
+    InteractionBoundsType() : Modified(true), Known(false)
+      {
+      this->Bounds[0] = this->Bounds[2] = 0.0;
+      this->Bounds[1] = this->Bounds[3] = -1.0;
+      }
+    bool Modified;
+    /// If false then the widget may interact anywhere
+    bool Known;
+    /// xmin, xmax, ymin, ymax in display coordinates
+    double Bounds[4];
+    /// Regions (xmin, xmax, ymin, ymax quadruples) within Bounds where interaction is possible
+    std::vector<double> Regions;
+    };
+  std::map<vtkSlicerMarkupsWidget*, InteractionBoundsType> WidgetInteractionBounds;
+
+  /// Widgets stored in each cell of a uniform grid (in display coordinates).
+  /// Each interaction region of a widget is stored in the cells that it overlaps within the view.
+  std::map<std::pair<int, int>, std::vector<vtkSlicerMarkupsWidget*> > InteractionGridCells;
+  /// Widgets with unknown interaction region
+  std::vector<vtkSlicerMarkupsWidget*> InteractionGridOtherWidgets;
+  bool InteractionGridModified;
+  /// Slice XYToRAS matrix and viewport size that the interaction regions were computed for
+  std::vector<double> InteractionViewGeometry;
+
   /// Keep a record of the current glyph type for the handles in the widget
   /// associated with this node, prevents changing them unnecessarily
   std::map<vtkMRMLNode*, std::vector<int> > NodeGlyphTypes;
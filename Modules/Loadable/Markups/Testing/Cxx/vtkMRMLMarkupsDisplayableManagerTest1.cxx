@@ -0,0 +1,221 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// Markups includes
+#include "vtkMRMLMarkupsDisplayableManager.h"
+#include "vtkMRMLMarkupsDisplayableManagerHelper.h"
+#include "vtkMRMLMarkupsDisplayNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLMarkupsLineNode.h"
+#include "vtkSlicerMarkupsWidget.h"
+
+// MRMLDisplayableManager includes
+#include <vtkMRMLDisplayableManagerGroup.h>
+#include <vtkMRMLInteractionEventData.h>
+
+// MRMLLogic includes
+#include <vtkMRMLApplicationLogic.h>
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLScene.h"
+#include "vtkMRMLSliceNode.h"
+
+// VTK includes
+#include <vtkMatrix4x4.h>
+#include <vtkNew.h>
+#include <vtkRenderer.h>
+#include <vtkRenderWindow.h>
+#include <vtkRenderWindowInteractor.h>
+
+// STD includes
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+
+// Test that only markups widgets near the event position are queried for interaction in slice views
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void GetDisplayPosition(vtkMRMLSliceNode* sliceNode, const double positionRAS[3], int displayPosition[2])
+{
+  vtkNew<vtkMatrix4x4> rasToXY;
+  vtkMatrix4x4::Invert(sliceNode->GetXYToRAS(), rasToXY.GetPointer());
+  double ras[4] = { positionRAS[0], positionRAS[1], positionRAS[2], 1.0 };
+  double xy[4] = { 0.0, 0.0, 0.0, 1.0 };
+  rasToXY->MultiplyPoint(ras, xy);
+  displayPosition[0] = static_cast<int>(floor(xy[0] + 0.5));
+  displayPosition[1] = static_cast<int>(floor(xy[1] + 0.5));
+}
+
+//----------------------------------------------------------------------------
+std::vector<vtkSlicerMarkupsWidget*> GetCandidateWidgets(vtkMRMLMarkupsDisplayableManager* displayableManager,
+  vtkMRMLSliceNode* sliceNode, vtkRenderer* renderer, const int displayPosition[2])
+{
+  vtkNew<vtkMRMLInteractionEventData> eventData;
+  eventData->SetType(vtkCommand::MouseMoveEvent);
+  eventData->SetViewNode(sliceNode);
+  eventData->SetRenderer(renderer);
+  eventData->SetDisplayPosition(displayPosition);
+  std::vector<vtkSlicerMarkupsWidget*> candidateWidgets;
+  displayableManager->GetHelper()->GetInteractionCandidateWidgets(eventData.GetPointer(), candidateWidgets);
+  return candidateWidgets;
+}
+
+//----------------------------------------------------------------------------
+bool Contains(const std::vector<vtkSlicerMarkupsWidget*>& widgets, vtkSlicerMarkupsWidget* widget)
+{
+  return std::find(widgets.begin(), widgets.end(), widget) != widgets.end();
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsDisplayableManagerTest1(int , char * [] )
+{
+  vtkNew<vtkRenderer> renderer;
+  vtkNew<vtkRenderWindow> renderWindow;
+  vtkNew<vtkRenderWindowInteractor> renderWindowInteractor;
+  renderWindow->SetSize(600, 600);
+  renderWindow->SetMultiSamples(0);
+  renderWindow->AddRenderer(renderer.GetPointer());
+  renderWindow->SetInteractor(renderWindowInteractor.GetPointer());
+
+  vtkNew<vtkMRMLScene> scene;
+  // Application logic - Handle creation of vtkMRMLSelectionNode and vtkMRMLInteractionNode
+  vtkNew<vtkMRMLApplicationLogic> applicationLogic;
+  applicationLogic->SetMRMLScene(scene.GetPointer());
+
+  vtkNew<vtkMRMLSliceNode> sliceNode;
+  sliceNode->SetLayoutName("Red");
+  sliceNode->SetOrientationToAxial();
+  sliceNode->SetDimensions(600, 600, 1);
+  sliceNode->SetFieldOfView(300.0, 300.0, 1.0);
+  scene->AddNode(sliceNode.GetPointer());
+
+  vtkNew<vtkMRMLDisplayableManagerGroup> displayableManagerGroup;
+  displayableManagerGroup->SetRenderer(renderer.GetPointer());
+  displayableManagerGroup->SetMRMLDisplayableNode(sliceNode.GetPointer());
+  vtkNew<vtkMRMLMarkupsDisplayableManager> displayableManager;
+  displayableManager->SetMRMLApplicationLogic(applicationLogic.GetPointer());
+  displayableManagerGroup->AddDisplayableManager(displayableManager.GetPointer());
+  displayableManagerGroup->GetInteractor()->Initialize();
+
+  // Two fiducial lists, far from each other in the slice view
+  const double positionA[3] = { 0.0, 0.0, 0.0 };
+  const double positionB[3] = { 100.0, 100.0, 0.0 };
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNodeA;
+  scene->AddNode(markupsNodeA.GetPointer());
+  markupsNodeA->CreateDefaultDisplayNodes();
+  markupsNodeA->AddControlPoint(vtkVector3d(positionA[0], positionA[1], positionA[2]));
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNodeB;
+  scene->AddNode(markupsNodeB.GetPointer());
+  markupsNodeB->CreateDefaultDisplayNodes();
+  markupsNodeB->AddControlPoint(vtkVector3d(positionB[0], positionB[1], positionB[2]));
+
+  vtkMRMLMarkupsDisplayNode* displayNodeA = markupsNodeA->GetMarkupsDisplayNode();
+  vtkSlicerMarkupsWidget* widgetA = displayableManager->GetWidget(displayNodeA);
+  vtkSlicerMarkupsWidget* widgetB = displayableManager->GetWidget(markupsNodeB->GetMarkupsDisplayNode());
+  CHECK_NOT_NULL(widgetA);
+  CHECK_NOT_NULL(widgetB);
+
+  // Only the nearby widget is returned
+  int displayPositionA[2] = { 0, 0 };
+  int displayPositionB[2] = { 0, 0 };
+  GetDisplayPosition(sliceNode.GetPointer(), positionA, displayPositionA);
+  GetDisplayPosition(sliceNode.GetPointer(), positionB, displayPositionB);
+  std::vector<vtkSlicerMarkupsWidget*> candidateWidgets =
+    GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionA);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), true);
+  CHECK_BOOL(Contains(candidateWidgets, widgetB), false);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionB);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), false);
+  CHECK_BOOL(Contains(candidateWidgets, widgetB), true);
+  const int emptyDisplayPosition[2] = { 550, 50 };
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), emptyDisplayPosition);
+  CHECK_INT(static_cast<int>(candidateWidgets.size()), 0);
+
+  // Candidates follow the markups after slice pan and zoom
+  double sliceOrigin[3] = { 20.0, 0.0, 0.0 };
+  sliceNode->SetXYZOrigin(sliceOrigin);
+  sliceNode->SetFieldOfView(150.0, 150.0, 1.0);
+  int oldDisplayPositionA[2] = { displayPositionA[0], displayPositionA[1] };
+  GetDisplayPosition(sliceNode.GetPointer(), positionA, displayPositionA);
+  CHECK_BOOL(abs(displayPositionA[0] - oldDisplayPositionA[0]) + abs(displayPositionA[1] - oldDisplayPositionA[1]) > 50, true);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionA);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), true);
+  CHECK_BOOL(Contains(candidateWidgets, widgetB), false);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), oldDisplayPositionA);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), false);
+
+  // Locked markups cannot be interacted with
+  markupsNodeA->SetLocked(true);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionA);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), false);
+  markupsNodeA->SetLocked(false);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionA);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), true);
+
+  // Hidden markups cannot be interacted with
+  displayNodeA->SetVisibility(false);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionA);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), false);
+  displayNodeA->SetVisibility(true);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionA);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), true);
+
+  // Widgets that are hovered or dragged are always returned
+  widgetB->SetWidgetState(vtkSlicerMarkupsWidget::WidgetStateTranslateControlPoint);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), emptyDisplayPosition);
+  CHECK_BOOL(Contains(candidateWidgets, widgetB), true);
+  CHECK_BOOL(Contains(candidateWidgets, widgetA), false);
+  widgetB->SetWidgetState(vtkSlicerMarkupsWidget::WidgetStateOnWidget);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), emptyDisplayPosition);
+  CHECK_BOOL(Contains(candidateWidgets, widgetB), true);
+  widgetB->SetWidgetState(vtkSlicerMarkupsWidget::WidgetStateIdle);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), emptyDisplayPosition);
+  CHECK_BOOL(Contains(candidateWidgets, widgetB), false);
+
+  // A long diagonal line is only returned near the line, not everywhere within its bounds
+  vtkNew<vtkMRMLMarkupsLineNode> lineNode;
+  scene->AddNode(lineNode.GetPointer());
+  lineNode->CreateDefaultDisplayNodes();
+  lineNode->AddControlPoint(vtkVector3d(-200.0, -150.0, 0.0));
+  lineNode->AddControlPoint(vtkVector3d(200.0, 250.0, 0.0));
+  vtkSlicerMarkupsWidget* lineWidget = displayableManager->GetWidget(lineNode->GetMarkupsDisplayNode());
+  CHECK_NOT_NULL(lineWidget);
+  const double positionOnLine[3] = { 0.0, 50.0, 0.0 };
+  const double positionFarFromLine[3] = { 40.0, -40.0, 0.0 };
+  int displayPositionOnLine[2] = { 0, 0 };
+  int displayPositionFarFromLine[2] = { 0, 0 };
+  GetDisplayPosition(sliceNode.GetPointer(), positionOnLine, displayPositionOnLine);
+  GetDisplayPosition(sliceNode.GetPointer(), positionFarFromLine, displayPositionFarFromLine);
+  for (int i = 0; i < 2; i++)
+    {
+    CHECK_BOOL(displayPositionOnLine[i] >= 0 && displayPositionOnLine[i] < 600, true);
+    CHECK_BOOL(displayPositionFarFromLine[i] >= 0 && displayPositionFarFromLine[i] < 600, true);
+    }
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionOnLine);
+  CHECK_BOOL(Contains(candidateWidgets, lineWidget), true);
+  candidateWidgets = GetCandidateWidgets(displayableManager.GetPointer(), sliceNode.GetPointer(), renderer.GetPointer(), displayPositionFarFromLine);
+  CHECK_BOOL(Contains(candidateWidgets, lineWidget), false);
+
+  return EXIT_SUCCESS;
+}
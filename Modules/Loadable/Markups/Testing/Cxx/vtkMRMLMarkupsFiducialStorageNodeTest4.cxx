@@ -0,0 +1,181 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLMarkupsFiducialStorageNode.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkTestingOutputWindow.h>
+#include <vtkTimerLog.h>
+#include <vtksys/SystemTools.hxx>
+
+// STD includes
+#include <fstream>
+
+// Test reading and writing markups binary file (.mrkb)
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+int CheckControlPointsEqual(vtkMRMLMarkupsNode* expectedNode, vtkMRMLMarkupsNode* actualNode)
+{
+  CHECK_INT(actualNode->GetNumberOfControlPoints(), expectedNode->GetNumberOfControlPoints());
+  for (int pointIndex = 0; pointIndex < expectedNode->GetNumberOfControlPoints(); pointIndex++)
+    {
+    vtkMRMLMarkupsNode::ControlPoint* expected = expectedNode->GetNthControlPoint(pointIndex);
+    vtkMRMLMarkupsNode::ControlPoint* actual = actualNode->GetNthControlPoint(pointIndex);
+    for (int i = 0; i < 3; i++)
+      {
+      CHECK_DOUBLE(actual->Position[i], expected->Position[i]);
+      }
+    for (int i = 0; i < 9; i++)
+      {
+      CHECK_DOUBLE(actual->OrientationMatrix[i], expected->OrientationMatrix[i]);
+      }
+    CHECK_STD_STRING(actual->ID, expected->ID);
+    CHECK_STD_STRING(actual->Label, expected->Label);
+    CHECK_STD_STRING(actual->Description, expected->Description);
+    CHECK_STD_STRING(actual->AssociatedNodeID, expected->AssociatedNodeID);
+    CHECK_BOOL(actual->Selected, expected->Selected);
+    CHECK_BOOL(actual->Locked, expected->Locked);
+    CHECK_BOOL(actual->Visibility, expected->Visibility);
+    CHECK_INT(actual->PositionStatus, expected->PositionStatus);
+    }
+  return EXIT_SUCCESS;
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsFiducialStorageNodeTest4(int argc, char * argv[] )
+{
+  if (argc < 2)
+    {
+    std::cerr << "Usage: vtkMRMLMarkupsFiducialStorageNodeTest4 /path/to/file.mrkb" << std::endl;
+    return EXIT_FAILURE;
+    }
+  std::string fileName = argv[1];
+
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLMarkupsFiducialNode> markupsNode;
+  scene->AddNode(markupsNode);
+
+  // Control points with non-default values in all fields
+  int index = markupsNode->AddControlPoint(vtkVector3d(-9.9, 1.1, 0.87));
+  double orientation[4] = { 0.2, 1.0, 0.0, 0.0 };
+  markupsNode->SetNthControlPointOrientationFromArray(index, orientation);
+  markupsNode->SetNthControlPointAssociatedNodeID(index, "testingAssociatedID");
+  markupsNode->SetNthControlPointSelected(index, false);
+  markupsNode->SetNthControlPointVisibility(index, false);
+  markupsNode->SetNthControlPointLocked(index, true);
+  markupsNode->SetNthControlPointLabel(index, "Label, commas, \"quotes\"\nand new line");
+  markupsNode->SetNthControlPointDescription(index, "description with spaces");
+  // empty label
+  index = markupsNode->AddControlPoint(vtkVector3d(1.0 / 3.0, 1e-20, -1e20));
+  markupsNode->SetNthControlPointLabel(index, "");
+  // position is not defined
+  markupsNode->AddNControlPoints(1);
+  // preview point
+  index = markupsNode->AddControlPoint(vtkVector3d(1, 2, 3));
+  markupsNode->GetNthControlPoint(index)->PositionStatus = vtkMRMLMarkupsNode::PositionPreview;
+
+  vtkNew<vtkMRMLMarkupsFiducialStorageNode> storageNode;
+  scene->AddNode(storageNode);
+  CHECK_STD_STRING(storageNode->GetSupportedFileExtension(fileName.c_str()), ".mrkb");
+
+  for (int coordinateSystem = vtkMRMLStorageNode::CoordinateSystemRAS;
+    coordinateSystem <= vtkMRMLStorageNode::CoordinateSystemLPS; coordinateSystem++)
+    {
+    storageNode->SetCoordinateSystem(coordinateSystem);
+    storageNode->SetFileName(fileName.c_str());
+    CHECK_BOOL(storageNode->WriteData(markupsNode), true);
+
+    vtkNew<vtkMRMLScene> scene2;
+    vtkNew<vtkMRMLMarkupsFiducialNode> markupsNode2;
+    scene2->AddNode(markupsNode2);
+    // existing points are replaced
+    markupsNode2->AddNControlPoints(5);
+    vtkNew<vtkMRMLMarkupsFiducialStorageNode> storageNode2;
+    scene2->AddNode(storageNode2);
+    storageNode2->SetFileName(fileName.c_str());
+    CHECK_BOOL(storageNode2->ReadData(markupsNode2), true);
+    CHECK_INT(storageNode2->GetCoordinateSystem(), coordinateSystem);
+    CHECK_EXIT_SUCCESS(CheckControlPointsEqual(markupsNode, markupsNode2));
+    }
+
+  // Empty markups
+  vtkNew<vtkMRMLMarkupsFiducialNode> emptyMarkupsNode;
+  scene->AddNode(emptyMarkupsNode);
+  CHECK_BOOL(storageNode->WriteData(emptyMarkupsNode), true);
+  CHECK_BOOL(storageNode->ReadData(markupsNode), true);
+  CHECK_INT(markupsNode->GetNumberOfControlPoints(), 0);
+
+  // Truncated file
+  std::string truncatedFileName = vtksys::SystemTools::GetFilenamePath(fileName) + "/truncated.mrkb";
+  {
+  std::ofstream truncatedFile(truncatedFileName.c_str(), std::ios::out | std::ios::binary);
+  truncatedFile.write("SlMrkBin", 8);
+  }
+  storageNode->SetFileName(truncatedFileName.c_str());
+  TESTING_OUTPUT_ASSERT_ERRORS_BEGIN();
+  CHECK_BOOL(storageNode->ReadData(markupsNode), false);
+  TESTING_OUTPUT_ASSERT_ERRORS_END();
+
+  // Performance comparison with fcsv
+  const int numberOfPerformanceTestPoints = 100000;
+  vtkNew<vtkPoints> points;
+  points->SetNumberOfPoints(numberOfPerformanceTestPoints);
+  for (int i = 0; i < numberOfPerformanceTestPoints; i++)
+    {
+    points->SetPoint(i, i * 0.1, (i % 100) * 0.3, (i % 10) * 0.7);
+    }
+  vtkNew<vtkMRMLMarkupsFiducialNode> largeMarkupsNode;
+  scene->AddNode(largeMarkupsNode);
+  largeMarkupsNode->AddControlPoints(points);
+
+  std::string fcsvFileName = vtksys::SystemTools::GetFilenamePath(fileName) + "/largeMarkups.fcsv";
+  std::string binaryFileName = vtksys::SystemTools::GetFilenamePath(fileName) + "/largeMarkups.mrkb";
+  const char* fileNames[2] = { fcsvFileName.c_str(), binaryFileName.c_str() };
+  const char* formatNames[2] = { "fcsv", "mrkb" };
+  vtkNew<vtkTimerLog> timer;
+  for (int formatIndex = 0; formatIndex < 2; formatIndex++)
+    {
+    storageNode->SetFileName(fileNames[formatIndex]);
+    timer->StartTimer();
+    CHECK_BOOL(storageNode->WriteData(largeMarkupsNode), true);
+    timer->StopTimer();
+    std::cout << "<DartMeasurement name=\"Write-" << formatNames[formatIndex] << "-100000\" type=\"numeric/double\">"
+              << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+    vtkNew<vtkMRMLMarkupsFiducialNode> readMarkupsNode;
+    scene->AddNode(readMarkupsNode);
+    timer->StartTimer();
+    CHECK_BOOL(storageNode->ReadData(readMarkupsNode), true);
+    timer->StopTimer();
+    std::cout << "<DartMeasurement name=\"Read-" << formatNames[formatIndex] << "-100000\" type=\"numeric/double\">"
+              << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+    CHECK_INT(readMarkupsNode->GetNumberOfControlPoints(), numberOfPerformanceTestPoints);
+    }
+
+  return EXIT_SUCCESS;
+}
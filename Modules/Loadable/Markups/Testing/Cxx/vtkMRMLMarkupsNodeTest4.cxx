@@ -0,0 +1,165 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkCallbackCommand.h>
+#include <vtkIdList.h>
+#include <vtkNew.h>
+#include <vtkPoints.h>
+#include <vtkStringArray.h>
+#include <vtkTimerLog.h>
+
+// STL includes
+#include <map>
+
+// Test bulk addition and removal of control points
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+void CountEventsCallback(vtkObject* vtkNotUsed(caller), unsigned long eid, void* clientData, void* vtkNotUsed(callData))
+{
+  std::map<unsigned long, int>* eventCounts = reinterpret_cast<std::map<unsigned long, int>*>(clientData);
+  ++(*eventCounts)[eid];
+}
+
+} // end of anonymous namespace
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsNodeTest4(int , char * [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+  vtkNew<vtkMRMLMarkupsFiducialNode> node;
+  scene->AddNode(node);
+  node->SetName("F");
+
+  std::map<unsigned long, int> eventCounts;
+  vtkNew<vtkCallbackCommand> callback;
+  callback->SetCallback(CountEventsCallback);
+  callback->SetClientData(&eventCounts);
+  node->AddObserver(vtkMRMLMarkupsNode::PointAddedEvent, callback);
+  node->AddObserver(vtkMRMLMarkupsNode::PointRemovedEvent, callback);
+  node->AddObserver(vtkMRMLMarkupsNode::PointModifiedEvent, callback);
+  node->AddObserver(vtkMRMLMarkupsNode::PointPositionDefinedEvent, callback);
+
+  // Bulk add with generated and specified labels
+  vtkNew<vtkPoints> points;
+  vtkNew<vtkStringArray> labels;
+  const int numberOfPoints = 10;
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    points->InsertNextPoint(i, 2 * i, 3 * i);
+    labels->InsertNextValue(i % 2 ? "" : "even");
+    }
+  CHECK_INT(node->AddControlPoint(vtkVector3d(-1, -1, -1)), 0);
+  eventCounts.clear();
+  CHECK_INT(node->AddControlPoints(points, labels), 1);
+  CHECK_INT(node->GetNumberOfControlPoints(), numberOfPoints + 1);
+  CHECK_INT(eventCounts[vtkMRMLMarkupsNode::PointAddedEvent], 1);
+  CHECK_INT(eventCounts[vtkMRMLMarkupsNode::PointModifiedEvent], 1);
+  CHECK_INT(eventCounts[vtkMRMLMarkupsNode::PointPositionDefinedEvent], 1);
+  CHECK_STD_STRING(node->GetNthControlPointLabel(1), "even");
+  CHECK_STD_STRING(node->GetNthControlPointLabel(2), "F-3");
+  CHECK_STD_STRING(node->GetNthControlPointID(2), "3");
+  CHECK_INT(node->GetNthControlPointPositionStatus(5), vtkMRMLMarkupsNode::PositionDefined);
+  CHECK_DOUBLE(node->GetNthControlPointPosition(5)[2], 12.0);
+
+  // Bulk remove, invalid indices are ignored
+  vtkNew<vtkIdList> pointIndices;
+  pointIndices->InsertNextId(0);
+  pointIndices->InsertNextId(5);
+  pointIndices->InsertNextId(5);
+  pointIndices->InsertNextId(numberOfPoints);
+  pointIndices->InsertNextId(numberOfPoints + 100);
+  eventCounts.clear();
+  node->RemoveControlPoints(pointIndices);
+  CHECK_INT(node->GetNumberOfControlPoints(), numberOfPoints - 2);
+  CHECK_INT(eventCounts[vtkMRMLMarkupsNode::PointRemovedEvent], 1);
+  CHECK_INT(eventCounts[vtkMRMLMarkupsNode::PointModifiedEvent], 1);
+  CHECK_DOUBLE(node->GetNthControlPointPosition(0)[0], 0.0);
+  CHECK_DOUBLE(node->GetNthControlPointPosition(4)[0], 5.0);
+  // last point was removed, its number is reused
+  CHECK_INT(node->AddControlPoint(vtkVector3d(0, 0, 0)), numberOfPoints - 2);
+  CHECK_STD_STRING(node->GetNthControlPointLabel(numberOfPoints - 2), "F-11");
+
+  // Copy
+  vtkNew<vtkMRMLMarkupsFiducialNode> nodeCopy;
+  nodeCopy->Copy(node);
+  CHECK_INT(nodeCopy->GetNumberOfControlPoints(), node->GetNumberOfControlPoints());
+  CHECK_STD_STRING(nodeCopy->GetNthControlPointLabel(0), node->GetNthControlPointLabel(0));
+  CHECK_STD_STRING(nodeCopy->GetNthControlPointID(3), node->GetNthControlPointID(3));
+
+  // Set positions from point list
+  vtkNew<vtkPoints> copiedPoints;
+  nodeCopy->GetControlPointPositionsWorld(copiedPoints);
+  points->SetNumberOfPoints(3);
+  eventCounts.clear();
+  node->SetControlPointPositionsWorld(points);
+  CHECK_INT(node->GetNumberOfControlPoints(), 3);
+  CHECK_INT(eventCounts[vtkMRMLMarkupsNode::PointRemovedEvent], 1);
+  node->SetControlPointPositionsWorld(copiedPoints);
+  CHECK_INT(node->GetNumberOfControlPoints(), nodeCopy->GetNumberOfControlPoints());
+  CHECK_DOUBLE(node->GetNthControlPointPosition(4)[0], 5.0);
+
+  // Performance comparison of adding control points one by one and in bulk
+  const int numberOfPerformanceTestPoints = 10000;
+  vtkNew<vtkPoints> performanceTestPoints;
+  performanceTestPoints->SetNumberOfPoints(numberOfPerformanceTestPoints);
+  for (int i = 0; i < numberOfPerformanceTestPoints; i++)
+    {
+    performanceTestPoints->SetPoint(i, i, i % 100, i % 10);
+    }
+  vtkNew<vtkTimerLog> timer;
+  vtkNew<vtkMRMLMarkupsFiducialNode> singleAddNode;
+  scene->AddNode(singleAddNode);
+  singleAddNode->SetName("P");
+  timer->StartTimer();
+  for (int i = 0; i < numberOfPerformanceTestPoints; i++)
+    {
+    singleAddNode->AddControlPoint(vtkVector3d(performanceTestPoints->GetPoint(i)));
+    }
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"AddControlPoint-10000\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+
+  vtkNew<vtkMRMLMarkupsFiducialNode> bulkAddNode;
+  scene->AddNode(bulkAddNode);
+  bulkAddNode->SetName("P");
+  timer->StartTimer();
+  bulkAddNode->AddControlPoints(performanceTestPoints);
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"AddControlPoints-10000\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  CHECK_INT(bulkAddNode->GetNumberOfControlPoints(), numberOfPerformanceTestPoints);
+  CHECK_STD_STRING(bulkAddNode->GetNthControlPointLabel(numberOfPerformanceTestPoints - 1),
+    singleAddNode->GetNthControlPointLabel(numberOfPerformanceTestPoints - 1));
+
+  timer->StartTimer();
+  nodeCopy->Copy(bulkAddNode);
+  timer->StopTimer();
+  std::cout << "<DartMeasurement name=\"Copy-10000\" type=\"numeric/double\">"
+            << timer->GetElapsedTime() << "</DartMeasurement>" << std::endl;
+  CHECK_INT(nodeCopy->GetNumberOfControlPoints(), numberOfPerformanceTestPoints);
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,71 @@
+/*==============================================================================
+
+  Program: 3D Slicer
+
+  Portions (c) Copyright Brigham and Women's Hospital (BWH) All Rights Reserved.
+
+  See COPYRIGHT.txt
+  or http://www.slicer.org/copyright/copyright.txt for details.
+
+  Unless required by applicable law or agreed to in writing, software
+  distributed under the License is distributed on an "AS IS" BASIS,
+  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  See the License for the specific language governing permissions and
+  limitations under the License.
+
+==============================================================================*/
+
+// MRML includes
+#include "vtkMRMLCoreTestingMacros.h"
+#include "vtkMRMLMarkupsFiducialNode.h"
+#include "vtkMRMLScene.h"
+
+// VTK includes
+#include <vtkNew.h>
+
+// Test undo of control point changes
+
+//----------------------------------------------------------------------------
+int vtkMRMLMarkupsNodeTest5(int , char * [] )
+{
+  vtkNew<vtkMRMLScene> scene;
+  scene->SetUndoOn();
+  vtkNew<vtkMRMLMarkupsFiducialNode> node;
+  node->SetUndoEnabled(true);
+  scene->AddNode(node);
+  node->AddControlPoint(vtkVector3d(1.0, 2.0, 3.0));
+  scene->SaveStateForUndo();
+  size_t firstLevelMemorySize = scene->GetUndoStackMemorySize();
+
+  // Moving a point only invokes PointModifiedEvent,
+  // the change must still be detected and saved.
+  node->SetNthControlPointPosition(0, 10.0, 20.0, 30.0);
+  scene->SaveStateForUndo();
+  node->SetNthControlPointPosition(0, 100.0, 200.0, 300.0);
+
+  double position[3] = { 0.0, 0.0, 0.0 };
+  scene->Undo();
+  node->GetNthControlPointPosition(0, position);
+  CHECK_DOUBLE(position[0], 10.0);
+  CHECK_DOUBLE(position[2], 30.0);
+  scene->Undo();
+  node->GetNthControlPointPosition(0, position);
+  CHECK_DOUBLE(position[0], 1.0);
+  CHECK_DOUBLE(position[2], 3.0);
+  scene->Redo();
+  node->GetNthControlPointPosition(0, position);
+  CHECK_DOUBLE(position[0], 10.0);
+
+  // Control points are copied in the undo stack, they must be counted
+  scene->ClearUndoStack();
+  scene->ClearRedoStack();
+  for (int i = 0; i < 1000; i++)
+    {
+    node->AddControlPoint(vtkVector3d(i, i, i));
+    }
+  CHECK_BOOL(node->GetCopiedDataMemorySize() > 1000 * sizeof(double) * 12, true);
+  scene->SaveStateForUndo();
+  CHECK_BOOL(scene->GetUndoStackMemorySize() > firstLevelMemorySize + 1000 * sizeof(double) * 12, true);
+
+  return EXIT_SUCCESS;
+}
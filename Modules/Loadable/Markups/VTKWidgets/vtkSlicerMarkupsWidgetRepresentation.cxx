@@ -400,6 +400,28 @@ void vtkSlicerMarkupsWidgetRepresentation::CanInteract(
   foundComponentType = vtkMRMLMarkupsDisplayNode::ComponentNone;
 }
 
+//-----------------------------------------------------------------------------
+bool vtkSlicerMarkupsWidgetRepresentation::GetInteractionBoundsDisplay(double vtkNotUsed(bounds)[4])
+{
+  return false;
+}
+
+//-----------------------------------------------------------------------------
+bool vtkSlicerMarkupsWidgetRepresentation::GetInteractionRegionsDisplay(std::vector<double>& regions)
+{
+  regions.clear();
+  double bounds[4] = { 0.0, -1.0, 0.0, -1.0 };
+  if (!this->GetInteractionBoundsDisplay(bounds))
+    {
+    return false;
+    }
+  if (bounds[0] <= bounds[1] && bounds[2] <= bounds[3])
+    {
+    regions.insert(regions.end(), bounds, bounds + 4);
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------
 bool vtkSlicerMarkupsWidgetRepresentation::GetTransformationReferencePoint(double referencePointWorld[3])
 {
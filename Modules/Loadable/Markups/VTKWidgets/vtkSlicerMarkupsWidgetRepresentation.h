@@ -47,6 +47,9 @@
 #include "vtkMRMLMarkupsDisplayNode.h"
 #include "vtkMRMLMarkupsNode.h"
 
+// STD includes
+#include <vector>
+
 class vtkMarkupsGlyphSource2D;
 class vtkPointPlacer;
 class vtkPointSetToLabelHierarchy;
@@ -106,6 +109,20 @@ public:
   virtual void CanInteract(vtkMRMLInteractionEventData* interactionEventData,
     int &foundComponentType, int &foundComponentIndex, double &closestDistance2);
 
+  /// Get the region (xmin, xmax, ymin, ymax) in display coordinates where CanInteract may find a component.
+  /// Returns false if the region is not known, which means that interaction may be possible anywhere.
+  /// If interaction is not possible at all then xmin > xmax is returned.
+  /// Displayable managers use this to avoid calling CanInteract for widgets that are far from the event position.
+  virtual bool GetInteractionBoundsDisplay(double bounds[4]);
+
+  /// Get small regions in display coordinates where CanInteract may find a component.
+  /// Regions are stored as consecutive (xmin, xmax, ymin, ymax) values. Each region covers only a few
+  /// components (e.g., a control point or a short section of the curve), therefore a long curve
+  /// can be located more precisely than by GetInteractionBoundsDisplay.
+  /// Returns false if the regions are not known, which means that interaction may be possible anywhere.
+  /// By default a single region is returned, containing the interaction bounds.
+  virtual bool GetInteractionRegionsDisplay(std::vector<double>& regions);
+
   virtual int FindClosestPointOnWidget(const int displayPos[2], double worldPos[3], int *idx);
 
   virtual vtkPointPlacer* GetPointPlacer();
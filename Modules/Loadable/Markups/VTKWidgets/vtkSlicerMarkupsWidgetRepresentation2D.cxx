@@ -46,6 +46,16 @@
 #include <vtkMRMLFolderDisplayNode.h>
 #include <vtkMRMLInteractionEventData.h>
 
+// STD includes
+#include <algorithm>
+
+namespace
+{
+/// Maximum size of an interaction region (in display coordinates, without the picking distance)
+const double INTERACTION_REGION_MAXIMUM_SIZE = 64.0;
+}
+
+//----------------------------------------------------------------------
 vtkSlicerMarkupsWidgetRepresentation2D::ControlPointsPipeline2D::ControlPointsPipeline2D()
 {
   this->Glypher = vtkSmartPointer<vtkGlyph2D>::New();
@@ -568,6 +578,144 @@ void vtkSlicerMarkupsWidgetRepresentation2D::CanInteract(
     }
 }
 
+//----------------------------------------------------------------------
+bool vtkSlicerMarkupsWidgetRepresentation2D::GetInteractionBoundsDisplay(double bounds[4])
+{
+  bounds[0] = VTK_DOUBLE_MAX;
+  bounds[1] = VTK_DOUBLE_MIN;
+  bounds[2] = VTK_DOUBLE_MAX;
+  bounds[3] = VTK_DOUBLE_MIN;
+  std::vector<double> regions;
+  this->GetInteractionRegionsDisplay(regions);
+  for (size_t regionIndex = 0; regionIndex + 3 < regions.size(); regionIndex += 4)
+    {
+    bounds[0] = std::min(bounds[0], regions[regionIndex]);
+    bounds[1] = std::max(bounds[1], regions[regionIndex + 1]);
+    bounds[2] = std::min(bounds[2], regions[regionIndex + 2]);
+    bounds[3] = std::max(bounds[3], regions[regionIndex + 3]);
+    }
+  return true;
+}
+
+//----------------------------------------------------------------------
+bool vtkSlicerMarkupsWidgetRepresentation2D::GetInteractionRegionsDisplay(std::vector<double>& regions)
+{
+  regions.clear();
+
+  vtkMRMLSliceNode *sliceNode = this->GetSliceNode();
+  vtkMRMLMarkupsNode* markupsNode = this->GetMarkupsNode();
+  if (!sliceNode || !markupsNode || markupsNode->GetLocked() || markupsNode->GetNumberOfControlPoints() < 1
+    || !this->GetVisibility())
+    {
+    // no interaction is possible
+    return true;
+    }
+
+  // Components can be picked within picking distance
+  this->UpdateControlPointSize();
+  double maxPickingDistance = sqrt(this->GetMaximumControlPointPickingDistance2());
+
+  vtkNew<vtkMatrix4x4> rasToxyMatrix;
+  sliceNode->GetXYToRAS()->Invert(sliceNode->GetXYToRAS(), rasToxyMatrix.GetPointer());
+  double pointWorldPos[4] = { 0.0, 0.0, 0.0, 1.0 };
+
+  // Consecutive points of a polyline are collected into a region until the region grows larger than
+  // INTERACTION_REGION_MAXIMUM_SIZE, then the next region starts from the last point.
+  double regionBounds[4] = { 0.0, -1.0, 0.0, -1.0 };
+  bool regionStarted = false;
+  double previousDisplayPos[2] = { 0.0, 0.0 };
+  auto endRegion = [&]()
+    {
+    if (!regionStarted)
+      {
+      return;
+      }
+    regions.push_back(regionBounds[0] - maxPickingDistance);
+    regions.push_back(regionBounds[1] + maxPickingDistance);
+    regions.push_back(regionBounds[2] - maxPickingDistance);
+    regions.push_back(regionBounds[3] + maxPickingDistance);
+    regionStarted = false;
+    };
+  auto addDisplayPosToRegion = [&](double x, double y)
+    {
+    if (regionStarted
+      && (std::max(regionBounds[1], x) - std::min(regionBounds[0], x) > INTERACTION_REGION_MAXIMUM_SIZE
+      || std::max(regionBounds[3], y) - std::min(regionBounds[2], y) > INTERACTION_REGION_MAXIMUM_SIZE))
+      {
+      endRegion();
+      regionBounds[0] = regionBounds[1] = previousDisplayPos[0];
+      regionBounds[2] = regionBounds[3] = previousDisplayPos[1];
+      regionStarted = true;
+      }
+    if (!regionStarted)
+      {
+      regionBounds[0] = regionBounds[1] = x;
+      regionBounds[2] = regionBounds[3] = y;
+      regionStarted = true;
+      }
+    regionBounds[0] = std::min(regionBounds[0], x);
+    regionBounds[1] = std::max(regionBounds[1], x);
+    regionBounds[2] = std::min(regionBounds[2], y);
+    regionBounds[3] = std::max(regionBounds[3], y);
+    previousDisplayPos[0] = x;
+    previousDisplayPos[1] = y;
+    };
+  auto addPointWorldPosToRegion = [&]()
+    {
+    double pointDisplayPos[4] = { 0.0, 0.0, 0.0, 1.0 };
+    rasToxyMatrix->MultiplyPoint(pointWorldPos, pointDisplayPos);
+    if (regionStarted)
+      {
+      // Long line segments are split, so that each region remains small
+      double segmentStart[2] = { previousDisplayPos[0], previousDisplayPos[1] };
+      double segmentLength = sqrt((pointDisplayPos[0] - segmentStart[0]) * (pointDisplayPos[0] - segmentStart[0])
+        + (pointDisplayPos[1] - segmentStart[1]) * (pointDisplayPos[1] - segmentStart[1]));
+      int numberOfSubdivisions = static_cast<int>(ceil(segmentLength / (0.5 * INTERACTION_REGION_MAXIMUM_SIZE)));
+      for (int subdivision = 1; subdivision < numberOfSubdivisions; subdivision++)
+        {
+        double t = static_cast<double>(subdivision) / numberOfSubdivisions;
+        addDisplayPosToRegion(segmentStart[0] + t * (pointDisplayPos[0] - segmentStart[0]),
+          segmentStart[1] + t * (pointDisplayPos[1] - segmentStart[1]));
+        }
+      }
+    addDisplayPosToRegion(pointDisplayPos[0], pointDisplayPos[1]);
+    };
+
+  // Control points (and straight lines between them)
+  vtkIdType numberOfPoints = markupsNode->GetNumberOfControlPoints();
+  for (int i = 0; i < numberOfPoints; i++)
+    {
+    markupsNode->GetNthControlPointPositionWorld(i, pointWorldPos);
+    addPointWorldPosToRegion();
+    }
+  if (numberOfPoints > 2 && this->ClosedLoop)
+    {
+    markupsNode->GetNthControlPointPositionWorld(0, pointWorldPos);
+    addPointWorldPosToRegion();
+    }
+  endRegion();
+  // Center point
+  if (numberOfPoints > 2 && this->ClosedLoop)
+    {
+    markupsNode->GetCenterPositionWorld(pointWorldPos);
+    addPointWorldPosToRegion();
+    endRegion();
+    }
+  // Interpolated curve points
+  vtkPolyData* curveWorld = markupsNode->GetCurveWorld();
+  if (curveWorld && curveWorld->GetPoints())
+    {
+    vtkIdType numberOfCurvePoints = curveWorld->GetNumberOfPoints();
+    for (vtkIdType i = 0; i < numberOfCurvePoints; i++)
+      {
+      curveWorld->GetPoint(i, pointWorldPos);
+      addPointWorldPosToRegion();
+      }
+    endRegion();
+    }
+  return true;
+}
+
 //----------------------------------------------------------------------
 void vtkSlicerMarkupsWidgetRepresentation2D::CanInteractWithLine(
   vtkMRMLInteractionEventData* interactionEventData,
@@ -57,6 +57,14 @@ public:
   void CanInteract(vtkMRMLInteractionEventData* interactionEventData,
     int &foundComponentType, int &foundComponentIndex, double &closestDistance2) override;
 
+  /// Interaction is possible near the control points, center point, and curve points
+  /// projected to the slice view.
+  bool GetInteractionBoundsDisplay(double bounds[4]) override;
+
+  /// Regions cover each control point and short sections of the lines between control points
+  /// and of the curve, therefore long and diagonal curves are located precisely.
+  bool GetInteractionRegionsDisplay(std::vector<double>& regions) override;
+
   /// Checks if interaction with straight line between visible points is possible.
   /// Can be used on the output of CanInteract, as if no better component is found then the input is returned.
   void CanInteractWithLine(vtkMRMLInteractionEventData* interactionEventData,
@@ -89,6 +89,7 @@ QStringList qSlicerMarkupsReader::extensions()const
 {
   return QStringList()
     << "Markups Fiducials (*.fcsv)"
+    << "Markups Fiducials Binary (*.mrkb)"
     << " Annotation Fiducial (*.acsv)";
 }
 
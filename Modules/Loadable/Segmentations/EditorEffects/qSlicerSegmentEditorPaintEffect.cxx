@@ -25,6 +25,7 @@
 #include "vtkMRMLSegmentationDisplayNode.h"
 #include "vtkMRMLSegmentationsDisplayableManager2D.h"
 #include "vtkMRMLSegmentEditorNode.h"
+#include "vtkLabelmapBrushStamp.h"
 #include "vtkOrientedImageData.h"
 
 // Qt includes
@@ -38,6 +39,7 @@
 // VTK includes
 #include <vtkActor.h>
 #include <vtkActor2D.h>
+#include <vtkAlgorithmOutput.h>
 #include <vtkBoundingBox.h>
 #include <vtkCamera.h>
 #include <vtkCellArray.h>
@@ -47,10 +49,7 @@
 #include <vtkGlyph2D.h>
 #include <vtkGlyph3D.h>
 #include <vtkIdList.h>
-#include <vtkImageChangeInformation.h>
-#include <vtkImageStencil.h>
 #include <vtkImageStencilData.h>
-#include <vtkImageStencilToImage.h>
 #include <vtkMath.h>
 #include <vtkMatrix4x4.h>
 #include <vtkNew.h>
@@ -232,6 +231,7 @@ qSlicerSegmentEditorPaintEffectPrivate::qSlicerSegmentEditorPaintEffectPrivate(q
   , ColorSmudgeCheckbox(nullptr)
   , EraseAllSegmentsCheckbox(nullptr)
   , BrushPixelModeCheckbox(nullptr)
+  , LastPaintPositionValid(false)
 {
   this->PaintCoordinates_World = vtkSmartPointer<vtkPoints>::New();
   this->FeedbackPointsPolyData = vtkSmartPointer<vtkPolyData>::New();
@@ -260,6 +260,7 @@ qSlicerSegmentEditorPaintEffectPrivate::qSlicerSegmentEditorPaintEffectPrivate(q
   this->BrushPolyDataToStencil = vtkSmartPointer<vtkPolyDataToImageStencil>::New();
   this->BrushPolyDataToStencil->SetOutputSpacing(1.0,1.0,1.0);
   this->BrushPolyDataToStencil->SetInputConnection(this->WorldOriginToModifierLabelmapIjkTransformer->GetOutputPort());
+  this->BrushStamp = vtkSmartPointer<vtkLabelmapBrushStamp>::New();
 
   this->FeedbackGlyphFilter = vtkSmartPointer<vtkGlyph3D>::New();
   this->FeedbackGlyphFilter->SetInputData(this->FeedbackPointsPolyData);
@@ -269,6 +270,9 @@ qSlicerSegmentEditorPaintEffectPrivate::qSlicerSegmentEditorPaintEffectPrivate(q
   this->ActiveViewLastInteractionPosition[1] = 0;
   this->ActiveViewLastPaintPosition[0] = 0;
   this->ActiveViewLastPaintPosition[1] = 0;
+  this->LastPaintPosition_Ijk[0] = 0.0;
+  this->LastPaintPosition_Ijk[1] = 0.0;
+  this->LastPaintPosition_Ijk[2] = 0.0;
 }
 
 //-----------------------------------------------------------------------------
@@ -432,15 +436,12 @@ void qSlicerSegmentEditorPaintEffectPrivate::updateBrushStencil(qMRMLWidget* vie
 
   // Brush stencil transform
 
-  this->WorldOriginToModifierLabelmapIjkTransform->Identity();
-
   vtkNew<vtkMatrix4x4> segmentationToSegmentationIjkTransformMatrix;
   modifierLabelmap->GetImageToWorldMatrix(segmentationToSegmentationIjkTransformMatrix.GetPointer());
   segmentationToSegmentationIjkTransformMatrix->Invert();
   segmentationToSegmentationIjkTransformMatrix->SetElement(0,3, 0);
   segmentationToSegmentationIjkTransformMatrix->SetElement(1,3, 0);
   segmentationToSegmentationIjkTransformMatrix->SetElement(2,3, 0);
-  this->WorldOriginToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
 
   vtkNew<vtkMatrix4x4> worldToSegmentationTransformMatrix;
   // We don't support painting in non-linearly transformed node (it could be implemented, but would probably slow down things too much)
@@ -449,6 +450,38 @@ void qSlicerSegmentEditorPaintEffectPrivate::updateBrushStencil(qMRMLWidget* vie
   worldToSegmentationTransformMatrix->SetElement(0,3, 0);
   worldToSegmentationTransformMatrix->SetElement(1,3, 0);
   worldToSegmentationTransformMatrix->SetElement(2,3, 0);
+
+  // The brush model pipeline is re-executed at each mouse move (brush position is updated),
+  // therefore the stencil cannot be cached based on modification time. Instead, the stencil is
+  // recomputed only if any of the parameters that determine the brush shape in IJK coordinate system changes.
+  vtkNew<vtkMatrix4x4> brushToModifierLabelmapIjkTransformMatrix;
+  vtkMatrix4x4::Multiply4x4(worldToSegmentationTransformMatrix.GetPointer(), this->BrushToWorldOriginTransform->GetMatrix(),
+    brushToModifierLabelmapIjkTransformMatrix.GetPointer());
+  vtkMatrix4x4::Multiply4x4(segmentationToSegmentationIjkTransformMatrix.GetPointer(), brushToModifierLabelmapIjkTransformMatrix.GetPointer(),
+    brushToModifierLabelmapIjkTransformMatrix.GetPointer());
+  std::vector<double> brushShapeParameters;
+  vtkAlgorithm* brushSource = this->BrushToWorldOriginTransformer->GetNumberOfInputConnections(0) > 0 ?
+    this->BrushToWorldOriginTransformer->GetInputConnection(0, 0)->GetProducer() : nullptr;
+  if (brushSource == this->BrushSphereSource.GetPointer())
+    {
+    brushShapeParameters.push_back(0.0);
+    brushShapeParameters.push_back(this->BrushSphereSource->GetRadius());
+    brushShapeParameters.push_back(0.0);
+    }
+  else
+    {
+    brushShapeParameters.push_back(1.0);
+    brushShapeParameters.push_back(this->BrushCylinderSource->GetRadius());
+    brushShapeParameters.push_back(this->BrushCylinderSource->GetHeight());
+    }
+  if (!this->BrushStamp->NeedsUpdate(brushShapeParameters, brushToModifierLabelmapIjkTransformMatrix.GetPointer()))
+    {
+    // Brush stencil is up-to-date
+    return;
+    }
+
+  this->WorldOriginToModifierLabelmapIjkTransform->Identity();
+  this->WorldOriginToModifierLabelmapIjkTransform->Concatenate(segmentationToSegmentationIjkTransformMatrix.GetPointer());
   this->WorldOriginToModifierLabelmapIjkTransform->Concatenate(worldToSegmentationTransformMatrix.GetPointer());
 
   this->WorldOriginToModifierLabelmapIjkTransformer->Update();
@@ -456,6 +489,9 @@ void qSlicerSegmentEditorPaintEffectPrivate::updateBrushStencil(qMRMLWidget* vie
   double* boundsIjk = brushModel_ModifierLabelmapIjk->GetBounds();
   this->BrushPolyDataToStencil->SetOutputWholeExtent(floor(boundsIjk[0])-1, ceil(boundsIjk[1])+1,
     floor(boundsIjk[2])-1, ceil(boundsIjk[3])+1, floor(boundsIjk[4])-1, ceil(boundsIjk[5])+1);
+  this->BrushPolyDataToStencil->Update();
+  this->BrushStamp->SetStencil(this->BrushPolyDataToStencil->GetOutput(), brushShapeParameters,
+    brushToModifierLabelmapIjkTransformMatrix.GetPointer());
 }
 
 //-----------------------------------------------------------------------------
@@ -578,55 +614,47 @@ void qSlicerSegmentEditorPaintEffectPrivate::paintBrushes(
     return;
     }
 
-  this->BrushPolyDataToStencil->Update();
-  vtkImageStencilData* stencilData = this->BrushPolyDataToStencil->GetOutput();
-  int stencilExtent[6]={0,-1,0,-1,0,-1};
-  stencilData->GetExtent(stencilExtent);
-
   vtkNew<vtkPoints> paintCoordinates_Ijk;
   this->transformPointsFromWorldToIJK(modifierLabelmap, segmentationNode, this->PaintCoordinates_World, paintCoordinates_Ijk);
 
-  vtkNew<vtkImageStencilToImage> stencilToImage;
-  stencilToImage->SetInputConnection(this->BrushPolyDataToStencil->GetOutputPort());
-  stencilToImage->SetInsideValue(q->m_FillValue);
-  stencilToImage->SetOutsideValue(q->m_EraseValue);
-  stencilToImage->SetOutputScalarType(modifierLabelmap->GetScalarType());
-
-  vtkNew<vtkImageChangeInformation> brushPositioner;
-  brushPositioner->SetInputConnection(stencilToImage->GetOutputPort());
-  brushPositioner->SetOutputSpacing(modifierLabelmap->GetSpacing());
-  brushPositioner->SetOutputOrigin(modifierLabelmap->GetOrigin());
+  // In slice views the brush moves continuously in the slice plane. In 3D views consecutive positions
+  // are picked on the rendered surfaces and may be on different surfaces, therefore they are only
+  // connected if they are near each other.
+  bool connectOnlyNearPositions = (qobject_cast<qMRMLSliceWidget*>(viewWidget) == nullptr);
 
+  updateExtent[0] = updateExtent[2] = updateExtent[4] = VTK_INT_MAX;
+  updateExtent[1] = updateExtent[3] = updateExtent[5] = VTK_INT_MIN;
   vtkIdType numberOfPoints = this->PaintCoordinates_World->GetNumberOfPoints();
   for (int pointIndex = 0; pointIndex < numberOfPoints; pointIndex++)
     {
-    double* shiftDouble = paintCoordinates_Ijk->GetPoint(pointIndex);
-    int shift[3] = {int(shiftDouble[0]+0.5), int(shiftDouble[1]+0.5), int(shiftDouble[2]+0.5)};
-    brushPositioner->SetExtentTranslation(shift);
-    brushPositioner->Update();
-    vtkNew<vtkOrientedImageData> orientedBrushPositionerOutput;
-    orientedBrushPositionerOutput->ShallowCopy(brushPositioner->GetOutput());
-    orientedBrushPositionerOutput->CopyDirections(modifierLabelmap);
-    if (pointIndex == 0)
+    double brushPosition_Ijk[3] = { 0.0, 0.0, 0.0 };
+    paintCoordinates_Ijk->GetPoint(pointIndex, brushPosition_Ijk);
+    bool connectToLastPosition = this->LastPaintPositionValid;
+    if (connectToLastPosition && connectOnlyNearPositions)
       {
-      orientedBrushPositionerOutput->GetExtent(updateExtent);
+      double movement[3] = { 0.0, 0.0, 0.0 };
+      vtkMath::Subtract(brushPosition_Ijk, this->LastPaintPosition_Ijk, movement);
+      connectToLastPosition = (vtkMath::Norm(movement) <= this->BrushStamp->GetRadiusAlongDirection(movement));
+      }
+    if (connectToLastPosition)
+      {
+      // Paint at intermediate positions along the swept segment from the previous brush position
+      this->BrushStamp->PaintSegment(modifierLabelmap, this->LastPaintPosition_Ijk, brushPosition_Ijk, q->m_FillValue, updateExtent);
       }
     else
       {
-      int* brushExtent = orientedBrushPositionerOutput->GetExtent();
-      for (int i = 0; i < 3; i++)
-        {
-        if (brushExtent[i * 2] < updateExtent[i * 2])
-          {
-          updateExtent[i * 2] = brushExtent[i * 2];
-          }
-        if (brushExtent[i * 2 + 1] > updateExtent[i * 2 + 1])
-          {
-          updateExtent[i * 2 + 1] = brushExtent[i * 2 + 1];
-          }
-        }
+      this->BrushStamp->Paint(modifierLabelmap, brushPosition_Ijk, q->m_FillValue, updateExtent);
       }
-    vtkOrientedImageDataResample::ModifyImage(modifierLabelmap, orientedBrushPositionerOutput.GetPointer(), vtkOrientedImageDataResample::OPERATION_MAXIMUM);
+    this->LastPaintPosition_Ijk[0] = brushPosition_Ijk[0];
+    this->LastPaintPosition_Ijk[1] = brushPosition_Ijk[1];
+    this->LastPaintPosition_Ijk[2] = brushPosition_Ijk[2];
+    this->LastPaintPositionValid = true;
+    }
+  if (updateExtent[0] > updateExtent[1])
+    {
+    // nothing has been painted
+    updateExtent[0] = updateExtent[2] = updateExtent[4] = 0;
+    updateExtent[1] = updateExtent[3] = updateExtent[5] = -1;
     }
   modifierLabelmap->Modified();
 }
@@ -1233,6 +1261,8 @@ bool qSlicerSegmentEditorPaintEffect::processInteractionEvents(
   if (eid == vtkCommand::LeftButtonPressEvent && !shiftKeyPressed)
     {
     d->IsPainting = true;
+    // New stroke, do not connect to the previous one
+    d->LastPaintPositionValid = false;
     if (!this->integerParameter("BrushPixelMode"))
       {
       //this->cursorOff(sliceWidget);
@@ -62,6 +62,7 @@ class qMRMLSliceWidget;
 class qMRMLSpinBox;
 class vtkActor2D;
 class vtkGlyph3D;
+class vtkLabelmapBrushStamp;
 class vtkPoints;
 class vtkPolyDataNormals;
 class vtkPolyDataToImageStencil;
@@ -94,6 +95,7 @@ public:
 
   /// Updates the brush stencil that can be used to quickly paint the brush shape into
   /// modifierLabelmap at many different positions.
+  /// The stencil is only recomputed if brush shape, size, orientation, or modifierLabelmap geometry has changed.
   void updateBrushStencil(qMRMLWidget* viewWidget);
 
 protected:
@@ -148,6 +150,14 @@ public:
   vtkSmartPointer<vtkTransform> WorldOriginToModifierLabelmapIjkTransform; // transforms from polydata source to modifierLabelmap's IJK coordinate system (brush origin in IJK origin)
   vtkSmartPointer<vtkPolyDataToImageStencil> BrushPolyDataToStencil;
 
+  /// Brush shape rasterized in modifierLabelmap IJK coordinate system, centered at the origin
+  vtkSmartPointer<vtkLabelmapBrushStamp> BrushStamp;
+
+  /// Last position (in modifierLabelmap IJK coordinate system) where the brush was painted in the current stroke.
+  /// Brush is painted at intermediate positions as well, so that fast mouse moves do not leave gaps.
+  bool LastPaintPositionValid;
+  double LastPaintPosition_Ijk[3];
+
   vtkSmartPointer<vtkGlyph3D> FeedbackGlyphFilter;
 
   vtkSmartPointer<vtkPoints> PaintCoordinates_World;
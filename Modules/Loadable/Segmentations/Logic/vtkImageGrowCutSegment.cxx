@@ -1,5 +1,6 @@
 #include "vtkImageGrowCutSegment.h"
 
+#include <algorithm>
 #include <iostream>
 #include <vector>
 
@@ -9,6 +10,8 @@
 #include <vtkNew.h>
 #include <vtkObjectFactory.h>
 #include <vtkSmartPointer.h>
+#include <vtkSMPThreadLocal.h>
+#include <vtkSMPTools.h>
 #include <vtkStreamingDemandDrivenPipeline.h>
 #include <vtkTimerLog.h>
 
@@ -26,6 +29,203 @@ const int MaskPixelTypeID = VTK_UNSIGNED_CHAR;
 const NodeKeyValueType DIST_INF = std::numeric_limits<NodeKeyValueType>::max();
 const NodeKeyValueType DIST_EPSILON = 1e-3;
 
+// Delta-stepping: the range of possible edge weights is split into this many buckets.
+// Larger number means less re-visiting of voxels but more bucket switches.
+const int DELTA_STEPPING_NUMBER_OF_BUCKETS = 1024;
+// Buckets that contain fewer voxels than this are processed in the main thread.
+const size_t DELTA_STEPPING_PARALLEL_FRONTIER_SIZE = 4096;
+// Voxels are distributed between this many owners (by slice index) for updating distances in parallel.
+const int DELTA_STEPPING_NUMBER_OF_OWNERS = 64;
+
+namespace
+{
+
+//----------------------------------------------------------------------------
+// Returns true if the new path is shorter than the current one.
+// Ties are broken by label value to make the result independent from the processing order.
+// Seeds and masked voxels (DIST_EPSILON distance) are never overwritten.
+template<typename LabelPixelType>
+inline bool IsShorterPath(NodeKeyValueType newDistance, LabelPixelType newLabel,
+  NodeKeyValueType currentDistance, LabelPixelType currentLabel)
+{
+  return newDistance < currentDistance
+    || (newDistance == currentDistance && newLabel < currentLabel && currentDistance > DIST_EPSILON);
+}
+
+//----------------------------------------------------------------------------
+// Cyclic array of buckets that store voxel indices sorted by distance.
+// Each owner has its own set of buckets so that they can be filled concurrently.
+class DeltaSteppingBuckets
+{
+public:
+  DeltaSteppingBuckets(double bucketWidth, int numberOfBuckets)
+    : BucketWidth(bucketWidth)
+    , NumberOfBuckets(numberOfBuckets)
+  {
+    this->Buckets.resize(DELTA_STEPPING_NUMBER_OF_OWNERS);
+    for (int owner = 0; owner < DELTA_STEPPING_NUMBER_OF_OWNERS; ++owner)
+      {
+      this->Buckets[owner].resize(numberOfBuckets);
+      }
+  }
+
+  inline vtkTypeInt64 GetBucketIndex(NodeKeyValueType distance) const
+  {
+    return static_cast<vtkTypeInt64>(distance / this->BucketWidth);
+  }
+
+  inline void Insert(int owner, NodeIndexType index, NodeKeyValueType distance)
+  {
+    this->Buckets[owner][this->GetBucketIndex(distance) % this->NumberOfBuckets].push_back(index);
+  }
+
+  /// Find the first non-empty bucket, starting from bucketIndex.
+  /// Returns false if all the buckets are empty.
+  bool FindNextBucket(vtkTypeInt64& bucketIndex) const
+  {
+    for (vtkTypeInt64 nextBucketIndex = bucketIndex; nextBucketIndex < bucketIndex + this->NumberOfBuckets; ++nextBucketIndex)
+      {
+      int slot = static_cast<int>(nextBucketIndex % this->NumberOfBuckets);
+      for (int owner = 0; owner < DELTA_STEPPING_NUMBER_OF_OWNERS; ++owner)
+        {
+        if (!this->Buckets[owner][slot].empty())
+          {
+          bucketIndex = nextBucketIndex;
+          return true;
+          }
+        }
+      }
+    return false;
+  }
+
+  /// Move content of the bucket to the frontier.
+  /// Returns false if the bucket is empty.
+  bool ExtractBucket(vtkTypeInt64 bucketIndex, std::vector<NodeIndexType>& frontier)
+  {
+    frontier.clear();
+    int slot = static_cast<int>(bucketIndex % this->NumberOfBuckets);
+    for (int owner = 0; owner < DELTA_STEPPING_NUMBER_OF_OWNERS; ++owner)
+      {
+      std::vector<NodeIndexType>& bucket = this->Buckets[owner][slot];
+      frontier.insert(frontier.end(), bucket.begin(), bucket.end());
+      // release memory, as buckets are only revisited after the distance increased by the maximum edge weight
+      std::vector<NodeIndexType>().swap(bucket);
+      }
+    return !frontier.empty();
+  }
+
+private:
+  double BucketWidth;
+  int NumberOfBuckets;
+  std::vector< std::vector< std::vector<NodeIndexType> > > Buckets; // [owner][bucket slot]
+};
+
+//----------------------------------------------------------------------------
+template<typename LabelPixelType>
+struct DeltaSteppingRequest
+{
+  NodeIndexType Index;
+  NodeKeyValueType Distance;
+  LabelPixelType Label;
+};
+
+//----------------------------------------------------------------------------
+// Find shorter paths to neighbors of frontier voxels. Distance and label volumes are
+// only read, found paths are stored as requests, sorted by the owner of the neighbor voxel.
+template<typename IntensityPixelType, typename LabelPixelType>
+class DeltaSteppingRelaxFunctor
+{
+public:
+  typedef std::vector< std::vector< DeltaSteppingRequest<LabelPixelType> > > RequestsType; // [owner][request]
+
+  const IntensityPixelType* Intensity{nullptr};
+  const LabelPixelType* Labels{nullptr};
+  const NodeKeyValueType* Distances{nullptr};
+  const unsigned char* NumberOfNeighbors{nullptr};
+  const NodeIndexType* NeighborIndexOffsets{nullptr};
+  const double* NeighborDistancePenalties{nullptr};
+  NodeIndexType SliceSize{1};
+  const DeltaSteppingBuckets* Buckets{nullptr};
+  const std::vector<NodeIndexType>* Frontier{nullptr};
+  vtkTypeInt64 CurrentBucketIndex{0};
+  vtkSMPThreadLocal<RequestsType> Requests;
+
+  void Initialize()
+  {
+    this->Requests.Local().resize(DELTA_STEPPING_NUMBER_OF_OWNERS);
+  }
+
+  void operator()(vtkIdType begin, vtkIdType end)
+  {
+    RequestsType& requests = this->Requests.Local();
+    for (vtkIdType frontierIndex = begin; frontierIndex < end; ++frontierIndex)
+      {
+      NodeIndexType index = (*this->Frontier)[frontierIndex];
+      NodeKeyValueType currentDistance = this->Distances[index];
+      if (this->Buckets->GetBucketIndex(currentDistance) != this->CurrentBucketIndex)
+        {
+        // voxel has been moved to another bucket since it was added to this bucket
+        continue;
+        }
+      LabelPixelType currentLabel = this->Labels[index];
+      NodeKeyValueType pixCenter = this->Intensity[index];
+      unsigned char nbSize = this->NumberOfNeighbors[index];
+      for (unsigned char i = 0; i < nbSize; i++)
+        {
+        NodeIndexType indexNgbh = index + this->NeighborIndexOffsets[i];
+        NodeKeyValueType neighborNewDistance = fabs(pixCenter - this->Intensity[indexNgbh]) + currentDistance + this->NeighborDistancePenalties[i];
+        if (IsShorterPath(neighborNewDistance, currentLabel, this->Distances[indexNgbh], this->Labels[indexNgbh]))
+          {
+          DeltaSteppingRequest<LabelPixelType> request = { indexNgbh, neighborNewDistance, currentLabel };
+          requests[(indexNgbh / this->SliceSize) % DELTA_STEPPING_NUMBER_OF_OWNERS].push_back(request);
+          }
+        }
+      }
+  }
+
+  void Reduce()
+  {
+  }
+};
+
+//----------------------------------------------------------------------------
+// Apply shorter paths found by DeltaSteppingRelaxFunctor. Each owner updates only its own voxels,
+// therefore no synchronization is needed.
+template<typename IntensityPixelType, typename LabelPixelType>
+class DeltaSteppingApplyFunctor
+{
+public:
+  LabelPixelType* Labels{nullptr};
+  NodeKeyValueType* Distances{nullptr};
+  DeltaSteppingBuckets* Buckets{nullptr};
+  DeltaSteppingRelaxFunctor<IntensityPixelType, LabelPixelType>* RelaxFunctor{nullptr};
+
+  void operator()(vtkIdType beginOwner, vtkIdType endOwner)
+  {
+    typedef typename DeltaSteppingRelaxFunctor<IntensityPixelType, LabelPixelType>::RequestsType RequestsType;
+    for (int owner = beginOwner; owner < endOwner; ++owner)
+      {
+      for (typename vtkSMPThreadLocal<RequestsType>::iterator requestsIt = this->RelaxFunctor->Requests.begin();
+        requestsIt != this->RelaxFunctor->Requests.end(); ++requestsIt)
+        {
+        std::vector< DeltaSteppingRequest<LabelPixelType> >& requests = (*requestsIt)[owner];
+        for (const DeltaSteppingRequest<LabelPixelType>& request : requests)
+          {
+          if (IsShorterPath(request.Distance, request.Label, this->Distances[request.Index], this->Labels[request.Index]))
+            {
+            this->Distances[request.Index] = request.Distance;
+            this->Labels[request.Index] = request.Label;
+            this->Buckets->Insert(owner, request.Index, request.Distance);
+            }
+          }
+        requests.clear();
+        }
+      }
+  }
+};
+
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 class vtkImageGrowCutSegment::vtkInternal
 {
@@ -41,12 +241,22 @@ public:
   template<typename IntensityPixelType, typename LabelPixelType>
   void DijkstraBasedClassificationAHP(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume);
 
+  template<typename LabelPixelType>
+  bool InitializationDeltaStepping(vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
+
+  template<typename IntensityPixelType, typename LabelPixelType>
+  void DeltaSteppingClassification(vtkImageData *intensityVolume);
+
+  /// Allocate distance and result volumes and compute neighborhood offsets
+  void InitializeVolumes(vtkImageData *seedLabelVolume, double distancePenalty);
+
   template <class SourceVolType>
   bool ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume,
-    vtkImageData *resultLabelVolume, double distancePenalty);
+    vtkImageData *resultLabelVolume, double distancePenalty, int shortestPathMethod);
 
   template< class SourceVolType, class SeedVolType>
-  bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume, double distancePenalty);
+  bool ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume, vtkImageData *maskLabelVolume,
+    double distancePenalty, int shortestPathMethod);
 
   // Stores the shortest distance from known labels to each point
   // If a point is set to DIST_INF then that point will modified, as a shorter distance path will be found.
@@ -69,6 +279,9 @@ public:
   FibHeap *m_Heap;
   FibHeapNode *m_HeapNodes; // a node is stored for each voxel
   bool m_bSegInitialized;
+
+  // Voxels to start growing from in the delta-stepping method
+  std::vector<NodeIndexType> m_SeedIndices;
 };
 
 //-----------------------------------------------------------------------------
@@ -102,10 +315,76 @@ void vtkImageGrowCutSegment::vtkInternal::Reset()
     m_HeapNodes = nullptr;
     }
   m_bSegInitialized = false;
+  std::vector<NodeIndexType>().swap(m_SeedIndices);
   m_DistanceVolume->Initialize();
   m_ResultLabelVolume->Initialize();
 }
 
+//-----------------------------------------------------------------------------
+void vtkImageGrowCutSegment::vtkInternal::InitializeVolumes(vtkImageData *seedLabelVolume, double distancePenalty)
+{
+  NodeIndexType dimXYZ = m_DimX * m_DimY * m_DimZ;
+
+  m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
+  m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
+  m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
+  m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
+  m_DistanceVolume->AllocateScalars(NodeKeyValueTypeID, 1);
+
+  // Compute index offset
+  m_DistancePenalty = distancePenalty;
+  m_NeighborIndexOffsets.clear();
+  m_NeighborDistancePenalties.clear();
+  // Neighbors are traversed in the order of m_NeighborIndexOffsets,
+  // therefore one would expect that the offsets should
+  // be as continuous as possible (e.g., x coordinate
+  // should change most quickly), but that resulted in
+  // about 5-6% longer computation time. Therefore,
+  // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
+  double* spacing = seedLabelVolume->GetSpacing();
+  for (long ix = -1; ix <= 1; ix++)
+  {
+    for (long iy = -1; iy <= 1; iy++)
+    {
+      for (long iz = -1; iz <= 1; iz++)
+      {
+        if (ix == 0 && iy == 0 && iz == 0)
+          {
+          continue;
+          }
+        m_NeighborIndexOffsets.push_back(ix + long(m_DimX)*(iy + long(m_DimY)*iz));
+        m_NeighborDistancePenalties.push_back(this->m_DistancePenalty * sqrt((spacing[0] * ix) * (spacing[0] * ix)
+          + (spacing[1] * iy) * (spacing[1] * iy) + (spacing[2] * iz) * (spacing[2] * iz)));
+        }
+      }
+    }
+
+  // Determine neighborhood size for computation at each voxel.
+  // The neighborhood size is everywhere the same (size of m_NeighborIndexOffsets)
+  // except at the edges of the volume, where the neighborhood size is 0.
+  m_NumberOfNeighbors.resize(dimXYZ);
+  const unsigned char numberOfNeighbors = static_cast<unsigned char>(m_NeighborIndexOffsets.size());
+  unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
+  for (NodeIndexType z = 0; z < m_DimZ; z++)
+    {
+    bool zEdge = (z == 0 || z == m_DimZ - 1);
+    for (NodeIndexType y = 0; y < m_DimY; y++)
+      {
+      bool yEdge = (y == 0 || y == m_DimY - 1);
+      *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don't need to check if m_DimX>0)
+      unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
+      for (NodeIndexType x = m_DimX-2; x > 0; x--)
+        {
+        *(nbSizePtr++) = nbSize;
+        }
+      *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
+      }
+    }
+}
+
 //-----------------------------------------------------------------------------
 template<typename IntensityPixelType, typename LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
@@ -148,67 +427,10 @@ bool vtkImageGrowCutSegment::vtkInternal::InitializationAHP(
 
   if (!m_bSegInitialized)
     {
-    m_ResultLabelVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_ResultLabelVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_ResultLabelVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_ResultLabelVolume->AllocateScalars(seedLabelVolume->GetScalarType(), 1);
-    m_DistanceVolume->SetOrigin(seedLabelVolume->GetOrigin());
-    m_DistanceVolume->SetSpacing(seedLabelVolume->GetSpacing());
-    m_DistanceVolume->SetExtent(seedLabelVolume->GetExtent());
-    m_DistanceVolume->AllocateScalars(NodeKeyValueTypeID, 1);
+    this->InitializeVolumes(seedLabelVolume, distancePenalty);
     LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
     NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
 
-    // Compute index offset
-    m_DistancePenalty = distancePenalty;
-    m_NeighborIndexOffsets.clear();
-    m_NeighborDistancePenalties.clear();
-    // Neighbors are traversed in the order of m_NeighborIndexOffsets,
-    // therefore one would expect that the offsets should
-    // be as continuous as possible (e.g., x coordinate
-    // should change most quickly), but that resulted in
-    // about 5-6% longer computation time. Therefore,
-    // we put indices in order x1y1z1, x1y1z2, x1y1z3, etc.
-    double* spacing = seedLabelVolume->GetSpacing();
-    for (long ix = -1; ix <= 1; ix++)
-    {
-      for (long iy = -1; iy <= 1; iy++)
-      {
-        for (long iz = -1; iz <= 1; iz++)
-        {
-          if (ix == 0 && iy == 0 && iz == 0)
-            {
-            continue;
-            }
-          m_NeighborIndexOffsets.push_back(ix + long(m_DimX)*(iy + long(m_DimY)*iz));
-          m_NeighborDistancePenalties.push_back(this->m_DistancePenalty * sqrt((spacing[0] * ix) * (spacing[0] * ix)
-            + (spacing[1] * iy) * (spacing[1] * iy) + (spacing[2] * iz) * (spacing[2] * iz)));
-          }
-        }
-      }
-
-    // Determine neighborhood size for computation at each voxel.
-    // The neighborhood size is everywhere the same (size of m_NeighborIndexOffsets)
-    // except at the edges of the volume, where the neighborhood size is 0.
-    m_NumberOfNeighbors.resize(dimXYZ);
-    const unsigned char numberOfNeighbors = static_cast<unsigned char>(m_NeighborIndexOffsets.size());
-    unsigned char* nbSizePtr = &(m_NumberOfNeighbors[0]);
-    for (NodeIndexType z = 0; z < m_DimZ; z++)
-      {
-      bool zEdge = (z == 0 || z == m_DimZ - 1);
-      for (NodeIndexType y = 0; y < m_DimY; y++)
-        {
-        bool yEdge = (y == 0 || y == m_DimY - 1);
-        *(nbSizePtr++) = 0; // x == 0 (there is always padding, so we don't need to check if m_DimX>0)
-        unsigned char nbSize = (zEdge || yEdge) ? 0 : numberOfNeighbors;
-        for (NodeIndexType x = m_DimX-2; x > 0; x--)
-          {
-          *(nbSizePtr++) = nbSize;
-          }
-        *(nbSizePtr++) = 0; // x == m_DimX-1 (there is always padding, so we don'neighborNewDistance need to check if m_DimX>1)
-        }
-      }
-
     if (!maskLabelVolumePtr)
       {
       // no mask
@@ -402,10 +624,169 @@ void vtkImageGrowCutSegment::vtkInternal::DijkstraBasedClassificationAHP(
   m_HeapNodes = nullptr;
 }
 
+//-----------------------------------------------------------------------------
+template<typename LabelPixelType>
+bool vtkImageGrowCutSegment::vtkInternal::InitializationDeltaStepping(
+    vtkImageData *seedLabelVolume,
+    vtkImageData *maskLabelVolume,
+    double distancePenalty)
+{
+  // Instead of storing a heap node for each voxel, only the seeds are stored.
+  // Voxels are added to the buckets when their distance is updated.
+  std::vector<NodeIndexType>().swap(m_SeedIndices);
+
+  NodeIndexType dimXYZ = m_DimX * m_DimY * m_DimZ;
+  LabelPixelType* seedLabelVolumePtr = static_cast<LabelPixelType*>(seedLabelVolume->GetScalarPointer());
+  MaskPixelType* maskLabelVolumePtr = nullptr;
+  if (maskLabelVolume != nullptr)
+    {
+    maskLabelVolumePtr = static_cast<MaskPixelType*>(maskLabelVolume->GetScalarPointer());
+    }
+
+  if (!m_bSegInitialized)
+    {
+    this->InitializeVolumes(seedLabelVolume, distancePenalty);
+    LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+    NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
+    for (NodeIndexType index = 0; index < dimXYZ; index++)
+      {
+      if (maskLabelVolumePtr && maskLabelVolumePtr[index] != 0)
+        {
+        // masked region, small distance will prevent overwriting of masked voxels
+        resultLabelVolumePtr[index] = 0;
+        distanceVolumePtr[index] = DIST_EPSILON;
+        continue;
+        }
+      LabelPixelType seedValue = seedLabelVolumePtr[index];
+      resultLabelVolumePtr[index] = seedValue;
+      if (seedValue == 0)
+        {
+        distanceVolumePtr[index] = DIST_INF;
+        }
+      else
+        {
+        distanceVolumePtr[index] = DIST_EPSILON;
+        m_SeedIndices.push_back(index);
+        }
+      }
+    }
+  else
+    {
+    // Already initialized, only grow from new/changed seeds
+    LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+    NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
+    for (NodeIndexType index = 0; index < dimXYZ; index++)
+      {
+      if (seedLabelVolumePtr[index] != 0
+        && (resultLabelVolumePtr[index] != seedLabelVolumePtr[index] // changed seed
+          || distanceVolumePtr[index] > DIST_EPSILON)) // new seed
+        {
+        distanceVolumePtr[index] = DIST_EPSILON;
+        resultLabelVolumePtr[index] = seedLabelVolumePtr[index];
+        m_SeedIndices.push_back(index);
+        }
+      }
+    }
+
+  return true;
+}
+
+//-----------------------------------------------------------------------------
+template<typename IntensityPixelType, typename LabelPixelType>
+void vtkImageGrowCutSegment::vtkInternal::DeltaSteppingClassification(vtkImageData *intensityVolume)
+{
+  LabelPixelType* resultLabelVolumePtr = static_cast<LabelPixelType*>(m_ResultLabelVolume->GetScalarPointer());
+  NodeKeyValueType* distanceVolumePtr = static_cast<NodeKeyValueType*>(m_DistanceVolume->GetScalarPointer());
+  IntensityPixelType* imSrc = static_cast<IntensityPixelType*>(intensityVolume->GetScalarPointer());
+
+  // Bucket width is chosen so that a single edge can span at most DELTA_STEPPING_NUMBER_OF_BUCKETS buckets,
+  // therefore that many buckets (plus margin for rounding errors) are enough in the cyclic bucket array.
+  double* intensityRange = intensityVolume->GetScalarRange();
+  double maximumEdgeWeight = intensityRange[1] - intensityRange[0];
+  if (!m_NeighborDistancePenalties.empty())
+    {
+    maximumEdgeWeight += *std::max_element(m_NeighborDistancePenalties.begin(), m_NeighborDistancePenalties.end());
+    }
+  double bucketWidth = 1.0;
+  int numberOfBuckets = 2;
+  if (maximumEdgeWeight > 0)
+    {
+    bucketWidth = maximumEdgeWeight / DELTA_STEPPING_NUMBER_OF_BUCKETS;
+    numberOfBuckets = DELTA_STEPPING_NUMBER_OF_BUCKETS + 2;
+    }
+  DeltaSteppingBuckets buckets(bucketWidth, numberOfBuckets);
+  for (NodeIndexType index : m_SeedIndices)
+    {
+    buckets.Insert(0, index, distanceVolumePtr[index]);
+    }
+  std::vector<NodeIndexType>().swap(m_SeedIndices);
+
+  DeltaSteppingRelaxFunctor<IntensityPixelType, LabelPixelType> relaxFunctor;
+  relaxFunctor.Intensity = imSrc;
+  relaxFunctor.Labels = resultLabelVolumePtr;
+  relaxFunctor.Distances = distanceVolumePtr;
+  relaxFunctor.NumberOfNeighbors = &(m_NumberOfNeighbors[0]);
+  relaxFunctor.NeighborIndexOffsets = &(m_NeighborIndexOffsets[0]);
+  relaxFunctor.NeighborDistancePenalties = &(m_NeighborDistancePenalties[0]);
+  relaxFunctor.SliceSize = m_DimX * m_DimY;
+  relaxFunctor.Buckets = &buckets;
+
+  DeltaSteppingApplyFunctor<IntensityPixelType, LabelPixelType> applyFunctor;
+  applyFunctor.Labels = resultLabelVolumePtr;
+  applyFunctor.Distances = distanceVolumePtr;
+  applyFunctor.Buckets = &buckets;
+  applyFunctor.RelaxFunctor = &relaxFunctor;
+
+  std::vector<NodeIndexType> frontier;
+  vtkTypeInt64 currentBucketIndex = 0;
+  while (buckets.FindNextBucket(currentBucketIndex))
+    {
+    // Voxels may be added to the current bucket while it is processed
+    while (buckets.ExtractBucket(currentBucketIndex, frontier))
+      {
+      if (frontier.size() >= DELTA_STEPPING_PARALLEL_FRONTIER_SIZE)
+        {
+        relaxFunctor.Frontier = &frontier;
+        relaxFunctor.CurrentBucketIndex = currentBucketIndex;
+        vtkSMPTools::For(0, static_cast<vtkIdType>(frontier.size()), relaxFunctor);
+        vtkSMPTools::For(0, DELTA_STEPPING_NUMBER_OF_OWNERS, applyFunctor);
+        continue;
+        }
+
+      // Small frontier, update neighbors directly
+      for (NodeIndexType index : frontier)
+        {
+        NodeKeyValueType currentDistance = distanceVolumePtr[index];
+        if (buckets.GetBucketIndex(currentDistance) != currentBucketIndex)
+          {
+          // voxel has been moved to another bucket since it was added to this bucket
+          continue;
+          }
+        LabelPixelType currentLabel = resultLabelVolumePtr[index];
+        NodeKeyValueType pixCenter = imSrc[index];
+        unsigned char nbSize = m_NumberOfNeighbors[index];
+        for (unsigned char i = 0; i < nbSize; i++)
+          {
+          NodeIndexType indexNgbh = index + m_NeighborIndexOffsets[i];
+          NodeKeyValueType neighborNewDistance = fabs(pixCenter - imSrc[indexNgbh]) + currentDistance + m_NeighborDistancePenalties[i];
+          if (IsShorterPath(neighborNewDistance, currentLabel, distanceVolumePtr[indexNgbh], resultLabelVolumePtr[indexNgbh]))
+            {
+            distanceVolumePtr[indexNgbh] = neighborNewDistance;
+            resultLabelVolumePtr[indexNgbh] = currentLabel;
+            buckets.Insert(0, indexNgbh, neighborNewDistance);
+            }
+          }
+        }
+      }
+    }
+
+  m_bSegInitialized = true;
+}
+
 //-----------------------------------------------------------------------------
 template< class IntensityPixelType, class LabelPixelType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
-  vtkImageData *maskLabelVolume, double distancePenalty)
+  vtkImageData *maskLabelVolume, double distancePenalty, int shortestPathMethod)
 {
   int* imSize = intensityVolume->GetDimensions();
 
@@ -432,6 +813,16 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensit
     return false;
     }
 
+  if (shortestPathMethod == vtkImageGrowCutSegment::DeltaStepping)
+    {
+    if (!InitializationDeltaStepping<LabelPixelType>(seedLabelVolume, maskLabelVolume, distancePenalty))
+      {
+      return false;
+      }
+    DeltaSteppingClassification<IntensityPixelType, LabelPixelType>(intensityVolume);
+    return true;
+    }
+
   if (!InitializationAHP<IntensityPixelType, LabelPixelType>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty))
     {
     return false;
@@ -444,7 +835,7 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut2(vtkImageData *intensit
 //----------------------------------------------------------------------------
 template <class SourceVolType>
 bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensityVolume, vtkImageData *seedLabelVolume,
-  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty)
+  vtkImageData *maskLabelVolume, vtkImageData *resultLabelVolume, double distancePenalty, int shortestPathMethod)
 {
   int* extent = intensityVolume->GetExtent();
   double* spacing = intensityVolume->GetSpacing();
@@ -520,7 +911,7 @@ bool vtkImageGrowCutSegment::vtkInternal::ExecuteGrowCut(vtkImageData *intensity
   bool success = false;
   switch (seedLabelVolume->GetScalarType())
   {
-    vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty)));
+    vtkTemplateMacro((success = ExecuteGrowCut2<SourceVolType, VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, distancePenalty, shortestPathMethod)));
   default:
     vtkGenericWarningMacro("vtkOrientedImageDataResample::MergeImage: Unknown ScalarType");
   }
@@ -543,6 +934,7 @@ vtkImageGrowCutSegment::vtkImageGrowCutSegment()
   this->SetNumberOfInputPorts(3);
   this->SetNumberOfOutputPorts(1);
   this->DistancePenalty = 0.0;
+  this->ShortestPathMethod = DeltaStepping;
 }
 
 //-----------------------------------------------------------------------------
@@ -576,7 +968,8 @@ void vtkImageGrowCutSegment::ExecuteDataWithInformation(
 
   switch (intensityVolume->GetScalarType())
     {
-    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume, this->DistancePenalty));
+    vtkTemplateMacro(this->Internal->ExecuteGrowCut<VTK_TT>(intensityVolume, seedLabelVolume, maskLabelVolume, resultLabelVolume,
+      this->DistancePenalty, this->ShortestPathMethod));
     break;
     }
   logger->StopTimer();
@@ -604,9 +997,24 @@ void vtkImageGrowCutSegment::Reset()
   this->Internal->Reset();
 }
 
+//-----------------------------------------------------------------------------
+void vtkImageGrowCutSegment::SetShortestPathMethod(int method)
+{
+  method = std::max(static_cast<int>(FibonacciHeap), std::min(method, static_cast<int>(DeltaStepping)));
+  if (this->ShortestPathMethod == method)
+    {
+    return;
+    }
+  this->ShortestPathMethod = method;
+  // Intermediate results of the two methods are not compatible
+  this->Internal->Reset();
+  this->Modified();
+}
+
 //-----------------------------------------------------------------------------
 void vtkImageGrowCutSegment::PrintSelf(ostream &os, vtkIndent indent)
 {
-  // XXX Implement this function
   this->Superclass::PrintSelf(os, indent);
+  os << indent << "DistancePenalty: " << this->DistancePenalty << "\n";
+  os << indent << "ShortestPathMethod: " << this->ShortestPathMethod << "\n";
 }
@@ -36,6 +36,23 @@ public:
   vtkGetMacro(DistancePenalty, double);
   vtkSetMacro(DistancePenalty, double);
 
+  enum
+    {
+    FibonacciHeap,
+    DeltaStepping
+    };
+
+  /// Algorithm used for computing shortest paths from the seeds.
+  /// DeltaStepping (default) processes voxels in buckets of similar distance, using multiple threads
+  /// and less memory than FibonacciHeap. If there are multiple paths with the same length then
+  /// the voxel gets the smallest label value.
+  /// FibonacciHeap is the classic single-threaded Dijkstra method.
+  /// Changing the method resets the segmentation.
+  void SetShortestPathMethod(int method);
+  vtkGetMacro(ShortestPathMethod, int);
+  void SetShortestPathMethodToFibonacciHeap() { this->SetShortestPathMethod(FibonacciHeap); }
+  void SetShortestPathMethodToDeltaStepping() { this->SetShortestPathMethod(DeltaStepping); }
+
 protected:
   vtkImageGrowCutSegment();
   ~vtkImageGrowCutSegment() override;
@@ -49,6 +66,7 @@ private:
   class vtkInternal;
   vtkInternal * Internal;
   double DistancePenalty;
+  int ShortestPathMethod;
 };
 
 #endif
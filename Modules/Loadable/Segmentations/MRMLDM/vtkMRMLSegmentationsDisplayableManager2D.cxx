@@ -31,6 +31,7 @@
 
 // MRML logic includes
 #include "vtkImageLabelOutline.h"
+#include "vtkImageLabelmapsToRGBA.h"
 
 // SegmentationCore includes
 #include "vtkSegmentation.h"
@@ -284,6 +285,29 @@ public:
   typedef std::map < vtkMRMLSegmentationDisplayNode*, PipelineMapType > PipelinesCacheType;
   PipelinesCacheType DisplayPipelines;
 
+  /// Fill and outline of all binary labelmap layers of a display node are composited
+  /// into a single image and displayed by a single actor. Each layer is still resliced
+  /// by its own pipeline, but color mapping and outline extraction are done in one pass.
+  struct LabelmapCompositePipeline
+    {
+    LabelmapCompositePipeline()
+      {
+      this->Compositor = vtkSmartPointer<vtkImageLabelmapsToRGBA>::New();
+      this->Actor = vtkSmartPointer<vtkActor2D>::New();
+      vtkSmartPointer<vtkImageMapper> imageMapper = vtkSmartPointer<vtkImageMapper>::New();
+      imageMapper->SetInputConnection(this->Compositor->GetOutputPort());
+      imageMapper->SetColorWindow(255);
+      imageMapper->SetColorLevel(127.5);
+      this->Actor->SetMapper(imageMapper);
+      this->Actor->SetVisibility(0);
+      }
+
+    vtkSmartPointer<vtkImageLabelmapsToRGBA> Compositor;
+    vtkSmartPointer<vtkActor2D> Actor;
+    };
+  typedef std::map < vtkMRMLSegmentationDisplayNode*, LabelmapCompositePipeline > LabelmapCompositePipelinesType;
+  LabelmapCompositePipelinesType LabelmapCompositePipelines;
+
   typedef std::map < vtkMRMLSegmentationNode*, std::set< vtkMRMLSegmentationDisplayNode* > > SegmentationToDisplayCacheType;
   SegmentationToDisplayCacheType SegmentationToDisplayNodes;
 
@@ -535,6 +559,13 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::RemoveDisplayNode(vt
     delete pipeline;
     }
   this->DisplayPipelines.erase(pipelinesIter);
+
+  LabelmapCompositePipelinesType::iterator compositePipelineIt = this->LabelmapCompositePipelines.find(displayNode);
+  if (compositePipelineIt != this->LabelmapCompositePipelines.end())
+    {
+    this->External->GetRenderer()->RemoveActor(compositePipelineIt->second.Actor);
+    this->LabelmapCompositePipelines.erase(compositePipelineIt);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -582,6 +613,7 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::AddDisplayNode(vtkMR
     }
 
   this->DisplayPipelines.insert( std::make_pair(displayNode, pipelineVector) );
+  this->External->GetRenderer()->AddActor( this->LabelmapCompositePipelines[displayNode].Actor );
 
   // Update cached matrices. Calls UpdateDisplayNodePipeline
   this->UpdateDisplayableTransforms(mNode);
@@ -717,6 +749,16 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
     }
   bool displayNodeVisible = this->IsVisible(displayNode);
 
+  // Labelmap layers that are shown in the slice are added to the composite pipeline below
+  LabelmapCompositePipeline* compositePipeline = nullptr;
+  LabelmapCompositePipelinesType::iterator compositePipelineIt = this->LabelmapCompositePipelines.find(displayNode);
+  if (compositePipelineIt != this->LabelmapCompositePipelines.end())
+    {
+    compositePipeline = &compositePipelineIt->second;
+    compositePipeline->Compositor->RemoveAllLabelmaps();
+    compositePipeline->Actor->SetVisibility(false);
+    }
+
   // Get display node from hierarchy that applies display properties on branch
   vtkMRMLDisplayableNode* displayableNode = displayNode->GetDisplayableNode();
   vtkMRMLDisplayNode* overrideHierarchyDisplayNode =
@@ -775,6 +817,20 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
     return;
     }
 
+  // Fractional labelmaps require linear color ramps and thresholding, therefore they are
+  // displayed by the actors of each pipeline.
+  bool compositeLabelmaps = compositePipeline
+    && shownRepresenatationName != vtkSegmentationConverter::GetFractionalLabelmapRepresentationName();
+  // Labelmaps to composite, they are added to the compositor in layer order after all
+  // pipelines are updated (pipelines are not stored in layer order).
+  struct CompositedLabelmap
+    {
+    vtkAlgorithmOutput* ResliceOutputPort;
+    vtkLookupTable* LookupTableFill;
+    vtkLookupTable* LookupTableOutline;
+    };
+  std::map<vtkDataObject*, CompositedLabelmap> compositedLabelmaps;
+
   // For all pipelines (pipeline per segment)
   for (PipelineMapType::iterator pipelineIt=pipelines.begin(); pipelineIt!=pipelines.end(); ++pipelineIt)
     {
@@ -945,9 +1001,9 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
         }
 
       // Update pipeline actors
-      pipeline->ImageOutlineActor->SetVisibility(outlineVisible);
+      pipeline->ImageOutlineActor->SetVisibility(outlineVisible && !compositeLabelmaps);
       pipeline->ImageOutlineActor->SetPosition(0, 0);
-      pipeline->ImageFillActor->SetVisibility(fillVisible);
+      pipeline->ImageFillActor->SetVisibility(fillVisible && !compositeLabelmaps);
       pipeline->ImageFillActor->SetPosition(0, 0);
 
       if (!outlineVisible && !fillVisible)
@@ -1137,6 +1193,16 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
       int sliceOutputExtent[6] = { 0, dimensions[0] - 1, 0, dimensions[1] - 1, 0, dimensions[2] - 1 };
       pipeline->Reslice->SetOutputExtent(sliceOutputExtent);
 
+      if (compositeLabelmaps)
+        {
+        pipeline->LabelOutline->SetInputConnection(nullptr);
+        CompositedLabelmap& compositedLabelmap = compositedLabelmaps[dataObject];
+        compositedLabelmap.ResliceOutputPort = pipeline->Reslice->GetOutputPort();
+        compositedLabelmap.LookupTableFill = fillVisible ? pipeline->LookupTableFill.GetPointer() : nullptr;
+        compositedLabelmap.LookupTableOutline = outlineVisible ? pipeline->LookupTableOutline.GetPointer() : nullptr;
+        continue;
+        }
+
       // Smooth the border of fractional labelmaps
       pipeline->LabelOutline->SetInputConnection(pipeline->Reslice->GetOutputPort());
       pipeline->ImageFillActor->GetMapper()->GetInputAlgorithm()->SetInputConnection(pipeline->Reslice->GetOutputPort());
@@ -1166,6 +1232,27 @@ void vtkMRMLSegmentationsDisplayableManager2D::vtkInternal::UpdateDisplayNodePip
       continue;
       }
     }
+
+  // Later layers are drawn on top of earlier layers
+  int numberOfLayers = compositedLabelmaps.empty() ? 0 : segmentation->GetNumberOfLayers(shownRepresenatationName);
+  for (int layer = 0; layer < numberOfLayers; ++layer)
+    {
+    std::map<vtkDataObject*, CompositedLabelmap>::iterator compositedLabelmapIt =
+      compositedLabelmaps.find(segmentation->GetLayerDataObject(layer, shownRepresenatationName));
+    if (compositedLabelmapIt == compositedLabelmaps.end())
+      {
+      continue;
+      }
+    compositePipeline->Compositor->AddLabelmapConnection(compositedLabelmapIt->second.ResliceOutputPort,
+      compositedLabelmapIt->second.LookupTableFill, compositedLabelmapIt->second.LookupTableOutline);
+    }
+
+  if (compositePipeline && compositePipeline->Compositor->GetNumberOfLabelmaps() > 0)
+    {
+    compositePipeline->Compositor->SetOutline(genericDisplayNode->GetSliceIntersectionThickness());
+    compositePipeline->Actor->SetVisibility(true);
+    compositePipeline->Actor->SetPosition(0, 0);
+    }
 }
 
 //---------------------------------------------------------------------------
@@ -0,0 +1,75 @@
+import time
+import unittest
+import numpy
+import vtk, slicer
+from vtk.util import numpy_support as ns
+
+import vtkSlicerSegmentationsModuleLogicPython as vtkSlicerSegmentationsModuleLogic
+
+'''
+This class tests that the delta-stepping and the Fibonacci heap shortest path methods of
+vtkImageGrowCutSegment produce the same segmentation, both for full and incremental computation.
+'''
+
+class vtkImageGrowCutSegmentTest1(unittest.TestCase):
+
+  #------------------------------------------------------------------------------
+  def setUp(self):
+    self.dimensions = [80, 70, 60]
+    numpy.random.seed(0)
+    # Random floating-point intensities, so that there are no paths with equal length
+    # (the two methods may choose different labels for those)
+    intensityArray = numpy.random.random_sample(self.dimensions[::-1]).astype(numpy.float32) * 100.0
+    intensityArray[:, :, self.dimensions[0]//2:] += 200.0
+    self.intensityVolume = self.createImage(intensityArray)
+
+    self.seedArray = numpy.zeros(self.dimensions[::-1], numpy.int16)
+    self.seedArray[20:40, 20:30, 5:10] = 1
+    self.seedArray[20:40, 20:30, -10:-5] = 2
+    self.seedArray[5:8, 5:8, 5:8] = 3
+
+  #------------------------------------------------------------------------------
+  def createImage(self, array):
+    image = vtk.vtkImageData()
+    image.SetDimensions(self.dimensions)
+    image.GetPointData().SetScalars(ns.numpy_to_vtk(array.ravel(), deep=True, array_type=ns.get_vtk_array_type(array.dtype)))
+    return image
+
+  #------------------------------------------------------------------------------
+  def runTest(self):
+    self.setUp()
+    self.test_vtkImageGrowCutSegmentTest1()
+
+  #------------------------------------------------------------------------------
+  def segment(self, shortestPathMethod, seedArrays, distancePenalty=0.0):
+    growCutFilter = vtkSlicerSegmentationsModuleLogic.vtkImageGrowCutSegment()
+    growCutFilter.SetShortestPathMethod(shortestPathMethod)
+    self.assertEqual(growCutFilter.GetShortestPathMethod(), shortestPathMethod)
+    growCutFilter.SetDistancePenalty(distancePenalty)
+    growCutFilter.SetIntensityVolume(self.intensityVolume)
+    results = []
+    for seedArray in seedArrays:
+      growCutFilter.SetSeedLabelVolume(self.createImage(seedArray))
+      startTime = time.time()
+      growCutFilter.Update()
+      results.append((ns.vtk_to_numpy(growCutFilter.GetOutput().GetPointData().GetScalars()).copy(), time.time() - startTime))
+    return results
+
+  #------------------------------------------------------------------------------
+  def test_vtkImageGrowCutSegmentTest1(self):
+    # Second update adds seeds to the existing ones, which is computed incrementally
+    updatedSeedArray = self.seedArray.copy()
+    updatedSeedArray[50:55, 60:65, 35:40] = 3
+    seedArrays = [self.seedArray, updatedSeedArray]
+
+    for distancePenalty in [0.0, 0.5]:
+      fibonacciHeapResults = self.segment(vtkSlicerSegmentationsModuleLogic.vtkImageGrowCutSegment.FibonacciHeap, seedArrays, distancePenalty)
+      deltaSteppingResults = self.segment(vtkSlicerSegmentationsModuleLogic.vtkImageGrowCutSegment.DeltaStepping, seedArrays, distancePenalty)
+      for (fibonacciHeapResult, fibonacciHeapTime), (deltaSteppingResult, deltaSteppingTime) in zip(fibonacciHeapResults, deltaSteppingResults):
+        self.assertEqual(numpy.count_nonzero(deltaSteppingResult == 0), 0)
+        self.assertTrue(numpy.array_equal(fibonacciHeapResult, deltaSteppingResult))
+
+    print('<DartMeasurement name="vtkImageGrowCutSegment-FibonacciHeap" type="numeric/double">%f</DartMeasurement>' % fibonacciHeapResults[0][1])
+    print('<DartMeasurement name="vtkImageGrowCutSegment-DeltaStepping" type="numeric/double">%f</DartMeasurement>' % deltaSteppingResults[0][1])
+    print('<DartMeasurement name="vtkImageGrowCutSegment-FibonacciHeap-Incremental" type="numeric/double">%f</DartMeasurement>' % fibonacciHeapResults[1][1])
+    print('<DartMeasurement name="vtkImageGrowCutSegment-DeltaStepping-Incremental" type="numeric/double">%f</DartMeasurement>' % deltaSteppingResults[1][1])
@@ -52,6 +52,7 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 #include <vtkPoints.h>
 #include <vtkPointSet.h>
 #include <vtkPointData.h>
+#include <vtkSmartPointer.h>
 #include <vtkSphereSource.h>
 #include <vtkThinPlateSplineTransform.h>
 #include <vtkTransform.h>
@@ -79,6 +80,65 @@ or http://www.slicer.org/copyright/copyright.txt for details.
 
 vtkStandardNewMacro(vtkSlicerTransformLogic);
 
+//----------------------------------------------------------------------------
+namespace
+{
+//----------------------------------------------------------------------------
+// Transform a batch of points. vtkGeneralTransform transforms points one by one
+// through all its concatenated transforms, therefore each concatenated transform
+// is applied to the whole batch instead. This way grid and b-spline transforms
+// can transform the points in parallel (see vtkOrientedGridTransform::TransformPoints).
+void TransformPointBatch(vtkAbstractTransform* transform, vtkPoints* inputPoints, vtkPoints* outputPoints)
+{
+  outputPoints->Reset();
+  vtkGeneralTransform* generalTransform = vtkGeneralTransform::SafeDownCast(transform);
+  if (!generalTransform)
+    {
+    transform->TransformPoints(inputPoints, outputPoints);
+    return;
+    }
+  generalTransform->Update();
+  int numberOfTransforms = generalTransform->GetNumberOfConcatenatedTransforms();
+  if (numberOfTransforms == 0)
+    {
+    // identity
+    outputPoints->DeepCopy(inputPoints);
+    return;
+    }
+  vtkSmartPointer<vtkPoints> currentPoints = inputPoints;
+  for (int i = 0; i < numberOfTransforms; ++i)
+    {
+    vtkSmartPointer<vtkPoints> transformedPoints = outputPoints;
+    if (i < numberOfTransforms - 1)
+      {
+      transformedPoints = vtkSmartPointer<vtkPoints>::New();
+      transformedPoints->SetDataTypeToDouble();
+      }
+    TransformPointBatch(generalTransform->GetConcatenatedTransform(i), currentPoints, transformedPoints);
+    currentPoints = transformedPoints;
+    }
+}
+
+//----------------------------------------------------------------------------
+// Get RAS position of the voxels of a slice (k index) of the image, in the order of the voxels
+void GetSlicePoints(vtkImageData* image, vtkMatrix4x4* ijkToRAS, int k, vtkPoints* slicePoints_RAS)
+{
+  int* extent = image->GetExtent();
+  slicePoints_RAS->SetNumberOfPoints((extent[1] - extent[0] + 1) * (extent[3] - extent[2] + 1));
+  double point_RAS[4] = { 0, 0, 0, 1 };
+  double point_IJK[4] = { 0, 0, static_cast<double>(k), 1 };
+  vtkIdType pointIndex = 0;
+  for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
+    {
+    for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
+      {
+      ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
+      slicePoints_RAS->SetPoint(pointIndex++, point_RAS);
+      }
+    }
+}
+} // end of anonymous namespace
+
 //----------------------------------------------------------------------------
 vtkSlicerTransformLogic::vtkSlicerTransformLogic()
 = default;
@@ -207,21 +267,11 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
   vtkMRMLTransformNode* inputTransformNode, vtkMatrix4x4* gridToRAS, int* gridSize,
   bool transformToWorld /* = true */)
 {
-  vtkNew<vtkGeneralTransform> inputTransform;
-  if (transformToWorld)
-  {
-    inputTransformNode->GetTransformToWorld(inputTransform.GetPointer());
-  }
-  else
-  {
-    inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
-  }
   // Generate sample point set on a grid
   vtkNew<vtkPoints> samplePositions_RAS;
   int numOfSamples = gridSize[0] * gridSize[1] * gridSize[2];
   samplePositions_RAS->SetNumberOfPoints(numOfSamples);
   double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
   double point_Grid[4] = { 0, 0, 0, 1 };
   int sampleIndex = 0;
   for (point_Grid[2] = 0; point_Grid[2]<gridSize[2]; point_Grid[2]++)
@@ -231,7 +281,6 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
       for (point_Grid[0] = 0; point_Grid[0]<gridSize[0]; point_Grid[0]++)
         {
         gridToRAS->MultiplyPoint(point_Grid, point_RAS);
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
         samplePositions_RAS->SetPoint(sampleIndex, point_RAS[0], point_RAS[1], point_RAS[2]);
         sampleIndex++;
         }
@@ -269,13 +318,17 @@ void vtkSlicerTransformLogic::GetTransformedPointSamples(vtkPointSet* outputPoin
     inputTransformNode->GetTransformFromWorld(inputTransform.GetPointer());
     }
 
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
+  vtkNew<vtkPoints> transformedPoints_RAS;
+  transformedPoints_RAS->SetDataTypeToDouble();
+  TransformPointBatch(inputTransform.GetPointer(), samplePositions_RAS, transformedPoints_RAS.GetPointer());
+
+  double point_RAS[3] = { 0, 0, 0 };
+  double transformedPoint_RAS[3] = { 0, 0, 0 };
+  double pointDislocationVector_RAS[3] = { 0, 0, 0 };
   for (int sampleIndex = 0; sampleIndex < numOfSamples; sampleIndex++)
     {
-    double* point_RAS = samplePositions_RAS->GetPoint(sampleIndex);
-
-    inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
+    samplePositions_RAS->GetPoint(sampleIndex, point_RAS);
+    transformedPoints_RAS->GetPoint(sampleIndex, transformedPoint_RAS);
 
     pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
     pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
@@ -406,33 +459,37 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsMagnitudeImage(vtkImag
   // if the direction matrix is not identity.
   magnitudeImage->AllocateScalars(VTK_FLOAT, 1);
 
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double pointDislocationVector_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
+  // Points are transformed slice by slice, to transform many points at once
+  // without storing the positions of all the voxels.
+  vtkNew<vtkPoints> slicePoints_RAS;
+  slicePoints_RAS->SetDataTypeToDouble();
+  vtkNew<vtkPoints> transformedSlicePoints_RAS;
+  transformedSlicePoints_RAS->SetDataTypeToDouble();
+  double point_RAS[3] = { 0, 0, 0 };
+  double transformedPoint_RAS[3] = { 0, 0, 0 };
+  double pointDislocationVector_RAS[3] = { 0, 0, 0 };
   float* voxelPtr = static_cast<float*>(magnitudeImage->GetScalarPointer());
   int* extent = magnitudeImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
+  for (int k = extent[4]; k <= extent[5]; k++)
   {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
+    GetSlicePoints(magnitudeImage, ijkToRAS, k, slicePoints_RAS.GetPointer());
+    TransformPointBatch(inputTransform.GetPointer(), slicePoints_RAS.GetPointer(), transformedSlicePoints_RAS.GetPointer());
+    vtkIdType numberOfSlicePoints = slicePoints_RAS->GetNumberOfPoints();
+    for (vtkIdType pointIndex = 0; pointIndex < numberOfSlicePoints; pointIndex++)
     {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
-
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
+      slicePoints_RAS->GetPoint(pointIndex, point_RAS);
+      transformedSlicePoints_RAS->GetPoint(pointIndex, transformedPoint_RAS);
 
-        pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
-        pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
-        pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
+      pointDislocationVector_RAS[0] = transformedPoint_RAS[0] - point_RAS[0];
+      pointDislocationVector_RAS[1] = transformedPoint_RAS[1] - point_RAS[1];
+      pointDislocationVector_RAS[2] = transformedPoint_RAS[2] - point_RAS[2];
 
-        float mag = sqrt(
-          pointDislocationVector_RAS[0] * pointDislocationVector_RAS[0] +
-          pointDislocationVector_RAS[1] * pointDislocationVector_RAS[1] +
-          pointDislocationVector_RAS[2] * pointDislocationVector_RAS[2]);
+      float mag = sqrt(
+        pointDislocationVector_RAS[0] * pointDislocationVector_RAS[0] +
+        pointDislocationVector_RAS[1] * pointDislocationVector_RAS[1] +
+        pointDislocationVector_RAS[2] * pointDislocationVector_RAS[2]);
 
-        *(voxelPtr++) = mag;
-      }
+      *(voxelPtr++) = mag;
     }
   }
 
@@ -700,26 +757,30 @@ bool vtkSlicerTransformLogic::GetTransformedPointSamplesAsVectorImage(vtkImageDa
   // if the direction matrix is not identity.
   vectorImage->AllocateScalars(VTK_FLOAT, 3);
 
-  double point_RAS[4] = { 0, 0, 0, 1 };
-  double transformedPoint_RAS[4] = { 0, 0, 0, 1 };
-  double point_IJK[4] = { 0, 0, 0, 1 };
+  // Points are transformed slice by slice, to transform many points at once
+  // without storing the positions of all the voxels.
+  vtkNew<vtkPoints> slicePoints_RAS;
+  slicePoints_RAS->SetDataTypeToDouble();
+  vtkNew<vtkPoints> transformedSlicePoints_RAS;
+  transformedSlicePoints_RAS->SetDataTypeToDouble();
+  double point_RAS[3] = { 0, 0, 0 };
+  double transformedPoint_RAS[3] = { 0, 0, 0 };
   float* voxelPtr = static_cast<float*>(vectorImage->GetScalarPointer());
   int* extent = vectorImage->GetExtent();
-  for (point_IJK[2] = extent[4]; point_IJK[2] <= extent[5]; point_IJK[2]++)
+  for (int k = extent[4]; k <= extent[5]; k++)
   {
-    for (point_IJK[1] = extent[2]; point_IJK[1] <= extent[3]; point_IJK[1]++)
+    GetSlicePoints(vectorImage, ijkToRAS, k, slicePoints_RAS.GetPointer());
+    TransformPointBatch(inputTransform.GetPointer(), slicePoints_RAS.GetPointer(), transformedSlicePoints_RAS.GetPointer());
+    vtkIdType numberOfSlicePoints = slicePoints_RAS->GetNumberOfPoints();
+    for (vtkIdType pointIndex = 0; pointIndex < numberOfSlicePoints; pointIndex++)
     {
-      for (point_IJK[0] = extent[0]; point_IJK[0] <= extent[1]; point_IJK[0]++)
-      {
-        ijkToRAS->MultiplyPoint(point_IJK, point_RAS);
+      slicePoints_RAS->GetPoint(pointIndex, point_RAS);
+      transformedSlicePoints_RAS->GetPoint(pointIndex, transformedPoint_RAS);
 
-        inputTransform->TransformPoint(point_RAS, transformedPoint_RAS);
-
-        // store the pointDislocationVector_RAS components in the image
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[0] - point_RAS[0]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[1] - point_RAS[1]);
-        *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[2] - point_RAS[2]);
-      }
+      // store the pointDislocationVector_RAS components in the image
+      *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[0] - point_RAS[0]);
+      *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[1] - point_RAS[1]);
+      *(voxelPtr++) = static_cast<float>(transformedPoint_RAS[2] - point_RAS[2]);
     }
   }
 
@@ -609,10 +609,34 @@ vtkMRMLVolumeNode* vtkSlicerVolumesLogic::AddArchetypeVolume (
   this->GetApplicationLogic()->SetMRMLSceneDataIO(testScene.GetPointer(),
                                                   remoteIOLogic, dataIOManagerLogic);
 
+  // The factory that read the last file with the same extension is tried
+  // first, but only if the file header confirms the file matches it.
+  // Otherwise the factories are tried in the registration order.
+  std::string cacheKey = vtkMRMLStorageNode::GetLowercaseExtensionFromFileName(filename ? filename : "")
+    + (labelMap ? "|labelmap" : "");
+  NodeSetFactoryRegistry factories = volumeRegistry;
+  ArchetypeVolumeNodeSetFactory cachedFactory = nullptr;
+  std::map<std::string, ArchetypeVolumeNodeSetFactory>::iterator cacheIt =
+    this->VolumeRegistryCache.find(cacheKey);
+  if (cacheIt != this->VolumeRegistryCache.end()
+      && std::find(volumeRegistry.begin(), volumeRegistry.end(), cacheIt->second) != volumeRegistry.end())
+    {
+    cachedFactory = cacheIt->second;
+    factories.push_front(cachedFactory);
+    }
+  bool cachedFactoryRead = false;
+
   // Run through the factory list and test each factory until success
-  for (NodeSetFactoryRegistry::const_iterator fit = volumeRegistry.begin();
-       fit != volumeRegistry.end(); ++fit)
+  for (NodeSetFactoryRegistry::const_iterator fit = factories.begin();
+       fit != factories.end(); ++fit)
     {
+    bool cachedFactoryAttempt = (cachedFactory != nullptr && fit == factories.begin());
+    if (*fit == cachedFactory && !cachedFactoryAttempt && cachedFactoryRead)
+      {
+      // the data has already been read with this factory and failed
+      continue;
+      }
+
     ArchetypeVolumeNodeSet nodeSet( (*fit)(volumeName, testScene.GetPointer(), loadingOptions) );
 
     // if the labelMap flags for reader and factory are consistent
@@ -626,10 +650,23 @@ vtkMRMLVolumeNode* vtkSlicerVolumesLogic::AddArchetypeVolume (
 
       this->InitializeStorageNode(nodeSet.StorageNode, filename, fileList, testScene.GetPointer());
 
-      vtkDebugMacro("Attempt to read file as a volume of type "
-                    << nodeSet.Node->GetNodeTagName() << " using "
-                    << nodeSet.Node->GetClassName() << " [filename = " << filename << "]");
-      bool success = nodeSet.StorageNode->ReadData(nodeSet.Node);
+      // Check the file header before reading the data, so that the data is
+      // read only once even if the first factories can't handle the file.
+      int probe = nodeSet.StorageNode->ProbeData(nodeSet.Node);
+      bool success = false;
+      if (probe == 0 || (cachedFactoryAttempt && probe != 1))
+        {
+        vtkDebugMacro("File header does not match a volume of type "
+                      << nodeSet.Node->GetNodeTagName() << " [filename = " << filename << "]");
+        }
+      else
+        {
+        vtkDebugMacro("Attempt to read file as a volume of type "
+                      << nodeSet.Node->GetNodeTagName() << " using "
+                      << nodeSet.Node->GetClassName() << " [filename = " << filename << "]");
+        success = nodeSet.StorageNode->ReadData(nodeSet.Node);
+        cachedFactoryRead = cachedFactoryRead || (*fit == cachedFactory);
+        }
 
       // disconnect the observers
       errorSink->SetObservedObject(nullptr);
@@ -642,6 +679,7 @@ vtkMRMLVolumeNode* vtkSlicerVolumesLogic::AddArchetypeVolume (
         storageNode = nodeSet.StorageNode;
         vtkDebugMacro(<< "File successfully read as " << nodeSet.Node->GetNodeTagName()
                       << " [filename = " << filename << "]");
+        this->VolumeRegistryCache[cacheKey] = *fit;
         break;
         }
       }
@@ -661,6 +699,11 @@ vtkMRMLVolumeNode* vtkSlicerVolumesLogic::AddArchetypeVolume (
   // display any errors
   if (volumeNode == nullptr)
     {
+    if (errorSink->GetNumberOfMessages() == 0)
+      {
+      vtkErrorMacro("AddArchetypeVolume: No reader can read the file as a volume [filename = "
+                    << (filename ? filename : "") << "]");
+      }
     errorSink->DisplayMessages();
     }
 
@@ -1472,6 +1515,7 @@ vtkSlicerVolumesLogic
     {
     this->VolumeRegistry.push_back(factory);
     }
+  this->ClearArchetypeVolumeNodeSetFactoryCache();
 }
 
 
@@ -1491,6 +1535,13 @@ vtkSlicerVolumesLogic
     this->VolumeRegistry.erase(rit);
     this->VolumeRegistry.push_front(factory);
     }
+  this->ClearArchetypeVolumeNodeSetFactoryCache();
+}
+
+//----------------------------------------------------------------------------
+void vtkSlicerVolumesLogic::ClearArchetypeVolumeNodeSetFactoryCache()
+{
+  this->VolumeRegistryCache.clear();
 }
 
 //----------------------------------------------------------------------------
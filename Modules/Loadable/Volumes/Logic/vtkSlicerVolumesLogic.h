@@ -32,6 +32,7 @@
 // STD includes
 #include <cstdlib>
 #include <list>
+#include <map>
 
 #include "vtkSlicerVolumesModuleLogicExport.h"
 
@@ -115,6 +116,13 @@ public:
   /// the back of the list of factories.
   void PreRegisterArchetypeVolumeNodeSetFactory(ArchetypeVolumeNodeSetFactory factory);
 
+  /// Forget which factory succeeded in reading each file extension.
+  /// AddArchetypeVolume() first tries the factory that read the last file
+  /// with the same extension (and labelmap option), provided the file
+  /// header confirms that it matches. The cache is cleared when factories
+  /// are registered.
+  void ClearArchetypeVolumeNodeSetFactoryCache();
+
   /// Overloaded function of AddArchetypeVolume to provide more
   /// loading options, where variable loadingOptions is bit-coded as following:
   /// bit 0: label map
@@ -321,6 +329,10 @@ protected:
 
   NodeSetFactoryRegistry VolumeRegistry;
 
+  /// Factory that last read a file, indexed by file extension and labelmap option.
+  /// \sa ClearArchetypeVolumeNodeSetFactoryCache()
+  std::map<std::string, ArchetypeVolumeNodeSetFactory> VolumeRegistryCache;
+
   /// Allowable difference in comparing volume geometry double values.
   /// Defaults to 1 to the power of 10 to the minus 6
   double CompareVolumeGeometryEpsilon;
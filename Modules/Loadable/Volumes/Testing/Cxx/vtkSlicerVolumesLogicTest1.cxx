@@ -23,11 +23,14 @@
 #include "vtkMRMLCoreTestingMacros.h"
 
 // MRML includes
+#include <vtkMRMLDiffusionTensorVolumeNode.h>
 #include <vtkMRMLLabelMapVolumeNode.h>
+#include <vtkMRMLNRRDStorageNode.h>
 #include <vtkMRMLScalarVolumeNode.h>
 #include <vtkMRMLScene.h>
 #include <vtkMRMLScalarVolumeDisplayNode.h>
 #include <vtkMRMLLabelMapVolumeDisplayNode.h>
+#include <vtkMRMLVectorVolumeNode.h>
 #include <vtkMRMLVolumeArchetypeStorageNode.h>
 
 // VTK includes
@@ -56,6 +59,7 @@ int TestCheckForLabelVolumeValidity( vtkMRMLScalarVolumeNode* scalarVolume,
 int TestCloneVolume( vtkMRMLScalarVolumeNode* scalarVolume,
                      vtkMRMLScene* scene,
                      vtkSlicerVolumesLogic *logic);
+int TestProbeData( const char* volumeName );
 
 //-----------------------------------------------------------------------------
 int vtkSlicerVolumesLogicTest1( int argc, char * argv[] )
@@ -99,6 +103,43 @@ int vtkSlicerVolumesLogicTest1( int argc, char * argv[] )
 
   CHECK_EXIT_SUCCESS(TestCloneVolume(scalarVolume, scene.GetPointer(), logic.GetPointer()));
 
+  // Loading again uses the factory that read the same file extension last time
+  CHECK_NOT_NULL(TestScalarVolumeLoading(volumeName, logic.GetPointer()));
+  logic->ClearArchetypeVolumeNodeSetFactoryCache();
+  CHECK_NOT_NULL(TestScalarVolumeLoading(volumeName, logic.GetPointer()));
+
+  CHECK_EXIT_SUCCESS(TestProbeData(volumeName));
+
+  return EXIT_SUCCESS;
+}
+
+//-----------------------------------------------------------------------------
+int TestProbeData( const char* volumeName )
+{
+  vtkNew<vtkMRMLScalarVolumeNode> scalarVolume;
+  vtkNew<vtkMRMLVectorVolumeNode> vectorVolume;
+  vtkNew<vtkMRMLDiffusionTensorVolumeNode> tensorVolume;
+
+  // Only the header is read to tell if the file matches the node type
+  vtkNew<vtkMRMLNRRDStorageNode> nrrdStorageNode;
+  nrrdStorageNode->SetFileName(volumeName);
+  CHECK_INT(nrrdStorageNode->ProbeData(scalarVolume.GetPointer()), 1);
+  CHECK_INT(nrrdStorageNode->ProbeData(vectorVolume.GetPointer()), 0);
+  CHECK_INT(nrrdStorageNode->ProbeData(tensorVolume.GetPointer()), 0);
+  CHECK_NULL(scalarVolume->GetImageData());
+
+  vtkNew<vtkMRMLVolumeArchetypeStorageNode> archetypeStorageNode;
+  archetypeStorageNode->SetFileName(volumeName);
+  archetypeStorageNode->SetSingleFile(1);
+  CHECK_INT(archetypeStorageNode->ProbeData(scalarVolume.GetPointer()), 1);
+  CHECK_INT(archetypeStorageNode->ProbeData(vectorVolume.GetPointer()), 0);
+  CHECK_INT(archetypeStorageNode->ProbeData(tensorVolume.GetPointer()), 0);
+  CHECK_NULL(scalarVolume->GetImageData());
+
+  // Files that can't be accessed are only checked by ReadData
+  archetypeStorageNode->SetFileName("nonexistent.nrrd");
+  CHECK_INT(archetypeStorageNode->ProbeData(scalarVolume.GetPointer()), -1);
+
   return EXIT_SUCCESS;
 }
 
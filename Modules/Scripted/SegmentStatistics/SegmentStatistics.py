@@ -433,37 +433,48 @@ class SegmentStatisticsLogic(ScriptedLoadableModuleLogic):
       logging.debug("computeStatistics will not return any results: there are no visible segments")
 
     # update statistics for all segment IDs
-    for segmentIndex in range(visibleSegmentIds.GetNumberOfValues()):
-      segmentID = visibleSegmentIds.GetValue(segmentIndex)
-      self.updateStatisticsForSegment(segmentID)
+    segmentIDs = [visibleSegmentIds.GetValue(segmentIndex) for segmentIndex in range(visibleSegmentIds.GetNumberOfValues())]
+    self.updateStatisticsForSegments(segmentIDs)
 
   def updateStatisticsForSegment(self, segmentID):
     """
     Update statistical measures for specified segment.
     Note: This will not change or reset measurement results of other segments
     """
-    import vtkSegmentationCorePython as vtkSegmentationCore
-
     segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
 
     if not segmentationNode.GetSegmentation().GetSegment(segmentID):
       logging.debug("updateStatisticsForSegment will not update any results because the segment doesn't exist")
       return
 
-    segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+    self.updateStatisticsForSegments([segmentID])
+
+  def updateStatisticsForSegments(self, segmentIDs):
+    """
+    Update statistical measures for specified segments.
+    Each plugin computes the measurements of all the segments at once.
+    Note: This will not change or reset measurement results of other segments
+    """
+    segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
+
+    segmentIDs = [segmentID for segmentID in segmentIDs if segmentationNode.GetSegmentation().GetSegment(segmentID)]
     statistics = self.getStatistics()
-    if segmentID not in statistics["SegmentIDs"]:
-      statistics["SegmentIDs"].append(segmentID)
-    statistics[segmentID,"Segment"] = segment.GetName()
+    for segmentID in segmentIDs:
+      segment = segmentationNode.GetSegmentation().GetSegment(segmentID)
+      if segmentID not in statistics["SegmentIDs"]:
+        statistics["SegmentIDs"].append(segmentID)
+      statistics[segmentID,"Segment"] = segment.GetName()
 
     # apply all enabled plugins
     for plugin in self.plugins:
       pluginName = plugin.__class__.__name__
       if self.getParameterNode().GetParameter(pluginName+'.enabled')=='True':
-        stats = plugin.computeStatistics(segmentID)
-        for key in stats:
-          statistics[segmentID,pluginName+'.'+key] = stats[key]
-          statistics["MeasurementInfo"][pluginName+'.'+key] = plugin.getMeasurementInfo(key)
+        segmentsStats = plugin.computeStatisticsForSegments(segmentIDs)
+        for segmentID in segmentIDs:
+          stats = segmentsStats.get(segmentID, {})
+          for key in stats:
+            statistics[segmentID,pluginName+'.'+key] = stats[key]
+            statistics["MeasurementInfo"][pluginName+'.'+key] = plugin.getMeasurementInfo(key)
 
   def getPluginByKey(self, key):
     """Get plugin responsible for obtaining measurement value for given key"""
@@ -3,7 +3,6 @@ import slicer
 import vtkITK
 import logging
 from SegmentStatisticsPlugins import SegmentStatisticsPluginBase
-from functools import reduce
 
 class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
   """Statistical plugin for Labelmaps"""
@@ -42,59 +41,23 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     #... developer may add extra options to configure other parameters
 
   def computeStatistics(self, segmentID):
+    return self.computeStatisticsForSegments([segmentID])[segmentID]
+
+  def computeStatisticsForSegments(self, segmentIDs):
     import vtkSegmentationCorePython as vtkSegmentationCore
     requestedKeys = self.getRequestedKeys()
 
     segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
 
+    segmentsStats = {segmentID: {} for segmentID in segmentIDs}
     if len(requestedKeys)==0:
-      return {}
+      return segmentsStats
 
-    containsLabelmapRepresentation = segmentationNode.GetSegmentation().ContainsRepresentation(
-      vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
+    binaryLabelmapName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+    segmentation = segmentationNode.GetSegmentation()
+    containsLabelmapRepresentation = segmentation.ContainsRepresentation(binaryLabelmapName)
     if not containsLabelmapRepresentation:
-      return {}
-
-    segmentLabelmap = slicer.vtkOrientedImageData()
-    segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
-    if (not segmentLabelmap
-      or not segmentLabelmap.GetPointData()
-      or not segmentLabelmap.GetPointData().GetScalars()):
-      # No input label data
-      return {}
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(segmentLabelmap)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-    thresh.Update()
-
-    #  Use binary labelmap as a stencil
-    stencil = vtk.vtkImageToImageStencil()
-    stencil.SetInputData(thresh.GetOutput())
-    stencil.ThresholdByUpper(labelValue)
-    stencil.Update()
-
-    stat = vtk.vtkImageAccumulate()
-    stat.SetInputData(thresh.GetOutput())
-    stat.SetStencilData(stencil.GetOutput())
-    stat.Update()
-
-    # Add data to statistics list
-    cubicMMPerVoxel = reduce(lambda x,y: x*y, segmentLabelmap.GetSpacing())
-    ccPerCubicMM = 0.001
-    stats = {}
-    if "voxel_count" in requestedKeys:
-      stats["voxel_count"] = stat.GetVoxelCount()
-    if "volume_mm3" in requestedKeys:
-      stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-    if "volume_cm3" in requestedKeys:
-      stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
+      return segmentsStats
 
     calculateShapeStats = False
     for shapeKey in self.shapeKeys:
@@ -102,69 +65,103 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         calculateShapeStats = True
         break
 
-    if calculateShapeStats:
-      directions = vtk.vtkMatrix4x4()
-      segmentLabelmap.GetDirectionMatrix(directions)
-
-      # Remove oriented bounding box from requested keys and replace with individual keys
-      requestedOptions = requestedKeys
-      statFilterOptions = self.shapeKeys
-      calculateOBB = (
-        "obb_diameter_mm" in requestedKeys or
-        "obb_origin_ras" in requestedKeys or
-        "obb_direction_ras_x" in requestedKeys or
-        "obb_direction_ras_y" in requestedKeys or
-        "obb_direction_ras_z" in requestedKeys
-        )
-
-      if calculateOBB:
-        temp = statFilterOptions
-        statFilterOptions = []
-        for option in temp:
-          if not option in self.obbKeys:
-            statFilterOptions.append(option)
-        statFilterOptions.append("oriented_bounding_box")
-
-        temp = requestedOptions
-        requestedOptions = []
-        for option in temp:
-          if not option in self.obbKeys:
-            requestedOptions.append(option)
-        requestedOptions.append("oriented_bounding_box")
-
-      calculatePrincipalAxis = (
-        "principal_axis_x" in requestedKeys or
-        "principal_axis_y" in requestedKeys or
-        "principal_axis_z" in requestedKeys
-        )
-      if calculatePrincipalAxis:
-        temp = statFilterOptions
-        statFilterOptions = []
-        for option in temp:
-          if not option in self.principalAxisKeys:
-            statFilterOptions.append(option)
-        statFilterOptions.append("principal_axes")
-
-        temp = requestedOptions
-        requestedOptions = []
-        for option in temp:
-          if not option in self.principalAxisKeys:
-            requestedOptions.append(option)
-        requestedOptions.append("principal_axes")
-        requestedOptions.append("centroid_ras")
-
-      shapeStat = vtkITK.vtkITKLabelShapeStatistics()
-      shapeStat.SetInputData(thresh.GetOutput())
-      shapeStat.SetDirections(directions)
-      for shapeKey in statFilterOptions:
-        shapeStat.SetComputeShapeStatistic(self.keyToShapeStatisticNames[shapeKey], shapeKey in requestedOptions)
-      shapeStat.Update()
-
-      # If segmentation node is transformed, apply that transform to get RAS coordinates
-      transformSegmentToRas = vtk.vtkGeneralTransform()
-      slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(), None, transformSegmentToRas)
-
-      statTable = shapeStat.GetOutput()
+    # Remove oriented bounding box from requested keys and replace with individual keys
+    requestedOptions = requestedKeys
+    statFilterOptions = self.shapeKeys
+    calculateOBB = (
+      "obb_diameter_mm" in requestedKeys or
+      "obb_origin_ras" in requestedKeys or
+      "obb_direction_ras_x" in requestedKeys or
+      "obb_direction_ras_y" in requestedKeys or
+      "obb_direction_ras_z" in requestedKeys
+      )
+
+    if calculateOBB:
+      temp = statFilterOptions
+      statFilterOptions = []
+      for option in temp:
+        if not option in self.obbKeys:
+          statFilterOptions.append(option)
+      statFilterOptions.append("oriented_bounding_box")
+
+      temp = requestedOptions
+      requestedOptions = []
+      for option in temp:
+        if not option in self.obbKeys:
+          requestedOptions.append(option)
+      requestedOptions.append("oriented_bounding_box")
+
+    calculatePrincipalAxis = (
+      "principal_axis_x" in requestedKeys or
+      "principal_axis_y" in requestedKeys or
+      "principal_axis_z" in requestedKeys
+      )
+    if calculatePrincipalAxis:
+      temp = statFilterOptions
+      statFilterOptions = []
+      for option in temp:
+        if not option in self.principalAxisKeys:
+          statFilterOptions.append(option)
+      statFilterOptions.append("principal_axes")
+
+      temp = requestedOptions
+      requestedOptions = []
+      for option in temp:
+        if not option in self.principalAxisKeys:
+          requestedOptions.append(option)
+      requestedOptions.append("principal_axes")
+      requestedOptions.append("centroid_ras")
+
+    # Statistics of all the segments of a labelmap layer are computed in a single pass
+    layerStatTables = {}
+    for segmentID in segmentIDs:
+      layerIndex = segmentation.GetLayerIndex(segmentID, binaryLabelmapName)
+      if layerIndex < 0 or layerIndex in layerStatTables:
+        continue
+      layerLabelmap = segmentation.GetLayerDataObject(layerIndex, binaryLabelmapName)
+      if (not layerLabelmap
+        or not layerLabelmap.GetPointData()
+        or not layerLabelmap.GetPointData().GetScalars()):
+        # No input label data
+        continue
+      labelStat = vtkITK.vtkITKLabelStatistics()
+      labelStat.AddInputData(0, layerLabelmap)
+      if calculateShapeStats:
+        directions = vtk.vtkMatrix4x4()
+        layerLabelmap.GetDirectionMatrix(directions)
+        labelStat.SetDirections(directions)
+        for shapeKey in statFilterOptions:
+          labelStat.SetComputeShapeStatistic(self.keyToShapeStatisticNames[shapeKey], shapeKey in requestedOptions)
+      labelStat.Update()
+      statTable = labelStat.GetOutput()
+      layerStatTables[layerIndex] = (statTable, self.getLabelStatisticsRowIndices(statTable))
+
+    # If segmentation node is transformed, apply that transform to get RAS coordinates
+    transformSegmentToRas = vtk.vtkGeneralTransform()
+    slicer.vtkMRMLTransformNode.GetTransformBetweenNodes(segmentationNode.GetParentTransformNode(), None, transformSegmentToRas)
+
+    ccPerCubicMM = 0.001
+    for segmentID in segmentIDs:
+      layerIndex = segmentation.GetLayerIndex(segmentID, binaryLabelmapName)
+      if layerIndex not in layerStatTables:
+        continue
+      statTable, rowIndices = layerStatTables[layerIndex]
+      rowIndex = rowIndices.get((0, segmentation.GetSegment(segmentID).GetLabelValue()))
+      voxelCount = statTable.GetColumnByName("VoxelCount").GetValue(rowIndex) if rowIndex is not None else 0
+      volumeMM3 = statTable.GetColumnByName("Volume").GetValue(rowIndex) if rowIndex is not None else 0.0
+
+      # Add data to statistics list
+      stats = segmentsStats[segmentID]
+      if "voxel_count" in requestedKeys:
+        stats["voxel_count"] = voxelCount
+      if "volume_mm3" in requestedKeys:
+        stats["volume_mm3"] = volumeMM3
+      if "volume_cm3" in requestedKeys:
+        stats["volume_cm3"] = volumeMM3 * ccPerCubicMM
+
+      if not calculateShapeStats or rowIndex is None:
+        continue
+
       if "centroid_ras" in requestedKeys:
         centroidRAS = [0,0,0]
         centroidTuple = None
@@ -172,7 +169,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if centroidArray is None:
           logging.error("Could not calculate centroid_ras!")
         else:
-          centroidTuple = centroidArray.GetTuple(0)
+          centroidTuple = centroidArray.GetTuple(rowIndex)
         if centroidTuple is not None:
           transformSegmentToRas.TransformPoint(centroidTuple, centroidRAS)
           stats["centroid_ras"] = centroidRAS
@@ -183,7 +180,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if roundnessArray is None:
           logging.error("Could not calculate roundness!")
         else:
-          roundnessTuple = roundnessArray.GetTuple(0)
+          roundnessTuple = roundnessArray.GetTuple(rowIndex)
         if roundnessTuple is not None:
           roundness = roundnessTuple[0]
           stats["roundness"] = roundness
@@ -194,7 +191,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if flatnessArray is None:
           logging.error("Could not calculate flatness!")
         else:
-          flatnessTuple = flatnessArray.GetTuple(0)
+          flatnessTuple = flatnessArray.GetTuple(rowIndex)
         if flatnessTuple is not None:
           flatness = flatnessTuple[0]
           stats["flatness"] = flatness
@@ -205,7 +202,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if elongationArray is None:
           logging.error("Could not calculate elongation!")
         else:
-          elongationTuple = elongationArray.GetTuple(0)
+          elongationTuple = elongationArray.GetTuple(rowIndex)
         if elongationTuple is not None:
           elongation = elongationTuple[0]
           stats["elongation"] = elongation
@@ -216,7 +213,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if feretDiameterArray is None:
           logging.error("Could not calculate feret_diameter_mm!")
         else:
-          feretDiameterTuple = feretDiameterArray.GetTuple(0)
+          feretDiameterTuple = feretDiameterArray.GetTuple(rowIndex)
         if feretDiameterTuple is not None:
           feretDiameter = feretDiameterTuple[0]
           stats["feret_diameter_mm"] = feretDiameter
@@ -227,7 +224,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if perimeterArray is None:
           logging.error("Could not calculate surface_area_mm2!")
         else:
-          perimeterTuple = perimeterArray.GetTuple(0)
+          perimeterTuple = perimeterArray.GetTuple(rowIndex)
         if perimeterTuple is not None:
           perimeter = perimeterTuple[0]
           stats["surface_area_mm2"] = perimeter
@@ -239,7 +236,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if obbOriginArray is None:
           logging.error("Could not calculate obb_origin_ras!")
         else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
+          obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
         if obbOriginTuple is not None:
           transformSegmentToRas.TransformPoint(obbOriginTuple, obbOriginRAS)
           stats["obb_origin_ras"] = obbOriginRAS
@@ -250,7 +247,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if obbDiameterArray is None:
           logging.error("Could not calculate obb_diameter_mm!")
         else:
-          obbDiameterMMTuple = obbDiameterArray.GetTuple(0)
+          obbDiameterMMTuple = obbDiameterArray.GetTuple(rowIndex)
         if obbDiameterMMTuple is not None:
           obbDiameterMM = list(obbDiameterMMTuple)
           stats["obb_diameter_mm"] = obbDiameterMM
@@ -261,14 +258,14 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if obbOriginArray is None:
           logging.error("Could not calculate obb_direction_ras_x!")
         else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
+          obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
 
         obbDirectionXTuple = None
         obbDirectionXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_x"])
         if obbDirectionXArray is None:
           logging.error("Could not calculate obb_direction_ras_x!")
         else:
-          obbDirectionXTuple = obbDirectionXArray.GetTuple(0)
+          obbDirectionXTuple = obbDirectionXArray.GetTuple(rowIndex)
 
         if obbOriginTuple is not None and obbDirectionXTuple is not None:
           obbDirectionX = list(obbDirectionXTuple)
@@ -281,14 +278,14 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if obbOriginArray is None:
           logging.error("Could not calculate obb_direction_ras_y!")
         else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
+          obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
 
         obbDirectionYTuple = None
         obbDirectionYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_y"])
         if obbDirectionYArray is None:
           logging.error("Could not calculate obb_direction_ras_y!")
         else:
-          obbDirectionYTuple = obbDirectionYArray.GetTuple(0)
+          obbDirectionYTuple = obbDirectionYArray.GetTuple(rowIndex)
 
         if obbOriginTuple is not None and obbDirectionYTuple is not None:
           obbDirectionY = list(obbDirectionYTuple)
@@ -301,14 +298,14 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if obbOriginArray is None:
           logging.error("Could not calculate obb_direction_ras_z!")
         else:
-          obbOriginTuple = obbOriginArray.GetTuple(0)
+          obbOriginTuple = obbOriginArray.GetTuple(rowIndex)
 
         obbDirectionZTuple = None
         obbDirectionZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["obb_direction_ras_z"])
         if obbDirectionZArray is None:
           logging.error("Could not calculate obb_direction_ras_z!")
         else:
-          obbDirectionZTuple = obbDirectionZArray.GetTuple(0)
+          obbDirectionZTuple = obbDirectionZArray.GetTuple(rowIndex)
 
         if obbOriginTuple is not None and obbDirectionZTuple is not None:
           obbDirectionZ = list(obbDirectionZTuple)
@@ -321,7 +318,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if principalMomentsArray is None:
           logging.error("Could not calculate principal_moments!")
         else:    
-          principalMomentsTuple = principalMomentsArray.GetTuple(0)
+          principalMomentsTuple = principalMomentsArray.GetTuple(rowIndex)
         if principalMomentsTuple is not None:
           principalMoments = list(principalMomentsTuple)
           stats["principal_moments"] = principalMoments
@@ -332,14 +329,14 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if centroidRASArray is None:
           logging.error("Could not calculate principal_axis_x!")
         else:
-          centroidRASTuple = centroidRASArray.GetTuple(0)
+          centroidRASTuple = centroidRASArray.GetTuple(rowIndex)
 
         principalAxisXTuple = None
         principalAxisXArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_x"])
         if principalAxisXArray is None:
           logging.error("Could not calculate principal_axis_x!")
         else:
-          principalAxisXTuple = principalAxisXArray.GetTuple(0)
+          principalAxisXTuple = principalAxisXArray.GetTuple(rowIndex)
 
         if centroidRASTuple is not None and principalAxisXTuple is not None:
           principalAxisX = list(principalAxisXTuple)
@@ -352,14 +349,14 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if centroidRASArray is None:
           logging.error("Could not calculate principal_axis_y!")
         else:
-          centroidRASTuple = centroidRASArray.GetTuple(0)
+          centroidRASTuple = centroidRASArray.GetTuple(rowIndex)
 
         principalAxisYTuple = None
         principalAxisYArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_y"])
         if principalAxisYArray is None:
           logging.error("Could not calculate principal_axis_y!")
         else:
-          principalAxisYTuple = principalAxisYArray.GetTuple(0)
+          principalAxisYTuple = principalAxisYArray.GetTuple(rowIndex)
 
         if centroidRASTuple is not None and principalAxisYTuple is not None:
           principalAxisY = list(principalAxisYTuple)
@@ -372,14 +369,14 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
         if centroidRASArray is None:
           logging.error("Could not calculate principal_axis_z!")
         else:
-          centroidRASTuple = centroidRASArray.GetTuple(0)
+          centroidRASTuple = centroidRASArray.GetTuple(rowIndex)
 
         principalAxisZTuple = None
         principalAxisZArray = statTable.GetColumnByName(self.keyToShapeStatisticNames["principal_axis_z"])
         if principalAxisZArray is None:
           logging.error("Could not calculate principal_axis_z!")
         else:
-          principalAxisZTuple = principalAxisZArray.GetTuple(0)
+          principalAxisZTuple = principalAxisZArray.GetTuple(rowIndex)
 
         if centroidRASTuple is not None and principalAxisZTuple is not None:
           principalAxisZ = list(principalAxisZTuple)
@@ -387,7 +384,7 @@ class LabelmapSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
           stats["principal_axis_z"] = principalAxisZ
 
 
-    return stats
+    return segmentsStats
 
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key"""
@@ -1,4 +1,5 @@
 import vtk, slicer
+import vtkITK
 from SegmentStatisticsPlugins import SegmentStatisticsPluginBase
 from functools import reduce
 
@@ -14,26 +15,31 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     #... developer may add extra options to configure other parameters
 
   def computeStatistics(self, segmentID):
+    return self.computeStatisticsForSegments([segmentID])[segmentID]
+
+  def computeStatisticsForSegments(self, segmentIDs):
     import vtkSegmentationCorePython as vtkSegmentationCore
     requestedKeys = self.getRequestedKeys()
 
     segmentationNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("Segmentation"))
     grayscaleNode = slicer.mrmlScene.GetNodeByID(self.getParameterNode().GetParameter("ScalarVolume"))
 
+    segmentsStats = {segmentID: {} for segmentID in segmentIDs}
     if len(requestedKeys)==0:
-      return {}
+      return segmentsStats
 
-    containsLabelmapRepresentation = segmentationNode.GetSegmentation().ContainsRepresentation(
-      vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName())
+    binaryLabelmapName = vtkSegmentationCore.vtkSegmentationConverter.GetSegmentationBinaryLabelmapRepresentationName()
+    segmentation = segmentationNode.GetSegmentation()
+    containsLabelmapRepresentation = segmentation.ContainsRepresentation(binaryLabelmapName)
     if not containsLabelmapRepresentation:
-      return {}
+      return segmentsStats
 
     if (not grayscaleNode
       or not grayscaleNode.GetImageData()
       or not grayscaleNode.GetImageData().GetPointData()
       or not grayscaleNode.GetImageData().GetPointData().GetScalars()):
       # Input grayscale node does not contain valid image data
-      return {}
+      return segmentsStats
 
     # Get geometry of grayscale volume node as oriented image data
     # reference geometry in reference node coordinate system
@@ -51,68 +57,64 @@ class ScalarVolumeSegmentStatisticsPlugin(SegmentStatisticsPluginBase):
     cubicMMPerVoxel = reduce(lambda x,y: x*y, referenceGeometry_Reference.GetSpacing())
     ccPerCubicMM = 0.001
 
-    segmentLabelmap = vtkSegmentationCore.vtkOrientedImageData()
-    segmentationNode.GetBinaryLabelmapRepresentation(segmentID, segmentLabelmap)
-    if (not segmentLabelmap
-      or not segmentLabelmap.GetPointData()
-      or not segmentLabelmap.GetPointData().GetScalars()):
-      # No input label data
-      return {}
-
-    segmentLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
-    vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
-      segmentLabelmap, referenceGeometry_Reference, segmentLabelmap_Reference,
-      False, # nearest neighbor interpolation
-      False, # no padding
-      segmentationToReferenceGeometryTransform)
-
-    # We need to know exactly the value of the segment voxels, apply threshold to make force the selected label value
-    labelValue = 1
-    backgroundValue = 0
-    thresh = vtk.vtkImageThreshold()
-    thresh.SetInputData(segmentLabelmap_Reference)
-    thresh.ThresholdByLower(0)
-    thresh.SetInValue(backgroundValue)
-    thresh.SetOutValue(labelValue)
-    thresh.SetOutputScalarType(vtk.VTK_UNSIGNED_CHAR)
-    thresh.Update()
-
-    #  Use binary labelmap as a stencil
-    stencil = vtk.vtkImageToImageStencil()
-    stencil.SetInputData(thresh.GetOutput())
-    stencil.ThresholdByUpper(labelValue)
-    stencil.Update()
-
-    stat = vtk.vtkImageAccumulate()
-    stat.SetInputData(grayscaleNode.GetImageData())
-    stat.SetStencilData(stencil.GetOutput())
-    stat.Update()
-
-    medians = vtk.vtkImageHistogramStatistics()
-    medians.SetInputData(grayscaleNode.GetImageData())
-    medians.SetStencilData(stencil.GetOutput())
-    medians.Update()
-
-    # create statistics list
-    stats = {}
-    if "voxel_count" in requestedKeys:
-      stats["voxel_count"] = stat.GetVoxelCount()
-    if "volume_mm3" in requestedKeys:
-      stats["volume_mm3"] = stat.GetVoxelCount() * cubicMMPerVoxel
-    if "volume_cm3" in requestedKeys:
-      stats["volume_cm3"] = stat.GetVoxelCount() * cubicMMPerVoxel * ccPerCubicMM
-    if stat.GetVoxelCount()>0:
-      if "min" in requestedKeys:
-        stats["min"] = stat.GetMin()[0]
-      if "max" in requestedKeys:
-        stats["max"] = stat.GetMax()[0]
-      if "mean" in requestedKeys:
-        stats["mean"] = stat.GetMean()[0]
-      if "stdev" in requestedKeys:
-        stats["stdev"] = stat.GetStandardDeviation()[0]
-      if "median" in requestedKeys:
-        stats["median"] = medians.GetMedian()
-    return stats
+    # Statistics of all the segments are computed in a single pass over each
+    # labelmap layer, resampled to the geometry of the grayscale volume.
+    labelStat = vtkITK.vtkITKLabelStatistics()
+    labelStat.SetScalarInputData(grayscaleNode.GetImageData())
+    layerIndexToLabelmapIndex = {}
+    for segmentID in segmentIDs:
+      layerIndex = segmentation.GetLayerIndex(segmentID, binaryLabelmapName)
+      if layerIndex < 0 or layerIndex in layerIndexToLabelmapIndex:
+        continue
+      layerLabelmap = segmentation.GetLayerDataObject(layerIndex, binaryLabelmapName)
+      if (not layerLabelmap
+        or not layerLabelmap.GetPointData()
+        or not layerLabelmap.GetPointData().GetScalars()):
+        # No input label data
+        continue
+      layerLabelmap_Reference = vtkSegmentationCore.vtkOrientedImageData()
+      vtkSegmentationCore.vtkOrientedImageDataResample.ResampleOrientedImageToReferenceOrientedImage(
+        layerLabelmap, referenceGeometry_Reference, layerLabelmap_Reference,
+        False, # nearest neighbor interpolation
+        False, # no padding
+        segmentationToReferenceGeometryTransform)
+      layerIndexToLabelmapIndex[layerIndex] = labelStat.GetNumberOfInputConnections(0)
+      labelStat.AddInputData(0, layerLabelmap_Reference)
+    if not layerIndexToLabelmapIndex:
+      return segmentsStats
+    labelStat.Update()
+
+    statTable = labelStat.GetOutput()
+    rowIndices = self.getLabelStatisticsRowIndices(statTable)
+    medianColumnName = vtkITK.vtkITKLabelStatistics.GetPercentileColumnName(50)
+    for segmentID in segmentIDs:
+      layerIndex = segmentation.GetLayerIndex(segmentID, binaryLabelmapName)
+      if layerIndex not in layerIndexToLabelmapIndex:
+        continue
+      labelValue = segmentation.GetSegment(segmentID).GetLabelValue()
+      rowIndex = rowIndices.get((layerIndexToLabelmapIndex[layerIndex], labelValue))
+      voxelCount = statTable.GetColumnByName("VoxelCount").GetValue(rowIndex) if rowIndex is not None else 0
+
+      # create statistics list
+      stats = segmentsStats[segmentID]
+      if "voxel_count" in requestedKeys:
+        stats["voxel_count"] = voxelCount
+      if "volume_mm3" in requestedKeys:
+        stats["volume_mm3"] = voxelCount * cubicMMPerVoxel
+      if "volume_cm3" in requestedKeys:
+        stats["volume_cm3"] = voxelCount * cubicMMPerVoxel * ccPerCubicMM
+      if voxelCount>0:
+        if "min" in requestedKeys:
+          stats["min"] = statTable.GetColumnByName("Minimum").GetValue(rowIndex)
+        if "max" in requestedKeys:
+          stats["max"] = statTable.GetColumnByName("Maximum").GetValue(rowIndex)
+        if "mean" in requestedKeys:
+          stats["mean"] = statTable.GetColumnByName("Mean").GetValue(rowIndex)
+        if "stdev" in requestedKeys:
+          stats["stdev"] = statTable.GetColumnByName("StandardDeviation").GetValue(rowIndex)
+        if "median" in requestedKeys:
+          stats["median"] = statTable.GetColumnByName(medianColumnName).GetValue(rowIndex)
+    return segmentsStats
 
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key"""
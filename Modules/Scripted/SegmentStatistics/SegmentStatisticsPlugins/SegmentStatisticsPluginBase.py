@@ -57,6 +57,26 @@ class SegmentStatisticsPluginBase(object):
     """
     pass
 
+  def computeStatisticsForSegments(self, segmentIDs):
+    """Compute measurements for requested keys on all the given segments and return
+    as dictionary mapping segment IDs to the results of computeStatistics.
+    Plugins that can process all segments faster than one by one should override this method.
+    """
+    return {segmentID: self.computeStatistics(segmentID) for segmentID in segmentIDs}
+
+  @staticmethod
+  def getLabelStatisticsRowIndices(statisticsTable):
+    """Get dictionary mapping (labelmap index, label value) to row index of the
+    output table of vtkITKLabelStatistics"""
+    labelmapIndexArray = statisticsTable.GetColumnByName("LabelmapIndex")
+    labelValueArray = statisticsTable.GetColumnByName("LabelValue")
+    rowIndices = {}
+    if not labelmapIndexArray or not labelValueArray:
+      return rowIndices
+    for rowIndex in range(statisticsTable.GetNumberOfRows()):
+      rowIndices[(labelmapIndexArray.GetValue(rowIndex), labelValueArray.GetValue(rowIndex))] = rowIndex
+    return rowIndices
+
   def getMeasurementInfo(self, key):
     """Get information (name, description, units, ...) about the measurement for the given key.
     Utilize createMeasurementInfo() to create the dictionary containing the measurement information.